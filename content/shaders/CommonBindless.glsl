@@ -0,0 +1,50 @@
+#ifndef _COMMON_BINDLESS_GLSL_
+#define _COMMON_BINDLESS_GLSL_
+
+#extension GL_EXT_nonuniform_qualifier : enable
+
+// has to match BindlessTable
+#define BINDLESS_SET 1
+#define BINDLESS_INVALID_INDEX 0xffffffffu
+// material blocks are 64 bytes
+#define BINDLESS_MATERIAL_BLOCK_WORDS 16
+
+layout(set = BINDLESS_SET, binding = 0) uniform texture2D bindlessTextures[];
+
+layout(set = BINDLESS_SET, binding = 1) readonly buffer BindlessBuffer
+{
+	uint data[];
+} bindlessBuffers[];
+
+layout(set = BINDLESS_SET, binding = 2) readonly buffer BindlessMaterials
+{
+	uint data[];
+} bindlessMaterials;
+
+// word of a material block, offsets are the ones of MaterialParameterLayout divided by 4
+uint GetMaterialWordOf(uint materialIndex, uint wordOffset)
+{
+	return bindlessMaterials.data[materialIndex * BINDLESS_MATERIAL_BLOCK_WORDS + wordOffset];
+}
+
+// word of the material block of this draw
+uint GetMaterialWord(uint wordOffset)
+{
+	return GetMaterialWordOf(pushConst.materialIndex, wordOffset);
+}
+
+float GetMaterialFloat(uint wordOffset)
+{
+	return uintBitsToFloat(GetMaterialWord(wordOffset));
+}
+
+vec4 SampleBindless(uint textureIndex, sampler textureSampler, vec2 uv, vec4 fallback)
+{
+	if (textureIndex == BINDLESS_INVALID_INDEX)
+	{
+		return fallback;
+	}
+	return texture(sampler2D(bindlessTextures[nonuniformEXT(textureIndex)], textureSampler), uv);
+}
+
+#endif
@@ -4,6 +4,7 @@
 layout(push_constant) uniform PushConst
 {
 	uint transformIndexOffset;
+	uint materialIndex;
 } pushConst;
 
 layout(set = 0, binding = 0) uniform sampler repeatLinearSampler;
@@ -60,4 +61,10 @@ layout(set = 0, binding = 8) readonly buffer GlobalPreviousTransformData
 	mat4 modelToWorld[];
 } globalPreviousTransformData;
 
+// bindless material of every transform, one indirect draw covers all bindless materials of a shader
+layout(set = 0, binding = 9) readonly buffer GlobalTransformMaterialData
+{
+	uint materialIndex[];
+} globalTransformMaterialData;
+
 #endif
@@ -3,11 +3,13 @@
 #extension GL_GOOGLE_include_directive : enable
 
 #include "CommonFrameData.glsl"
+#include "CommonBindless.glsl"
 
 layout(early_fragment_tests) in;
 
-layout(set = 1, binding = 1) uniform texture2D albedo;
-layout(set = 1, binding = 2) uniform texture2D normal;
+// material block, two texture indices
+#define MATERIAL_ALBEDO 0
+#define MATERIAL_NORMAL 1
 
 layout(location = 0) in FragmentInput {
 	vec3 worldPos;
@@ -16,15 +18,23 @@ layout(location = 0) in FragmentInput {
     vec4 framePosProjected;
 	vec4 prevFramePosProjected;
 	mat3x3 TBN;
+	flat uint materialIndex;
 } fragInput;
 
 layout(location = 0) out vec4 outAlbedo;
 layout(location = 1) out vec4 outNormal;
 layout(location = 2) out vec2 outVelocity;
 
+// normal maps may be two channel BC5, so z is always rebuilt from x and y
+vec3 SampleTangentNormal()
+{
+	vec2 xy = SampleBindless( GetMaterialWordOf(fragInput.materialIndex, MATERIAL_NORMAL), repeatLinearSampler, fragInput.uv, vec4(0.5, 0.5, 1.0, 1.0) ).xy * 2.0 - 1.0;
+	return vec3(xy, sqrt(max(1.0 - dot(xy, xy), 0.0)));
+}
+
 vec3 PerturbNormal()
 {
-	vec3 tangentNormal = texture( sampler2D( normal, repeatLinearSampler ), fragInput.uv ).xyz * 2.0 - 1.0;
+	vec3 tangentNormal = SampleTangentNormal();
 
 	vec3 pos_dx = dFdx(fragInput.worldPos);
     vec3 pos_dy = dFdy(fragInput.worldPos);
@@ -42,8 +52,8 @@ vec3 PerturbNormal()
 }
 
 void main() {
-    outAlbedo = texture( sampler2D( albedo, repeatLinearSampler ), fragInput.uv );
-	vec3 tangentNormal = texture( sampler2D( normal, repeatLinearSampler ), fragInput.uv ).xyz * 2.0 - 1.0;
+    outAlbedo = SampleBindless( GetMaterialWordOf(fragInput.materialIndex, MATERIAL_ALBEDO), repeatLinearSampler, fragInput.uv, vec4(1.0) );
+	vec3 tangentNormal = SampleTangentNormal();
 	outNormal = vec4(fragInput.TBN * tangentNormal, 1.0);
 
     vec2 pos = (fragInput.framePosProjected.xy / fragInput.framePosProjected.w) * 0.5f + 0.5f;
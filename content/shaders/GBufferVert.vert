@@ -17,11 +17,15 @@ layout(location = 0) out FragmentInput {
 	vec4 framePosProjected;
 	vec4 prevFramePosProjected;
 	mat3x3 TBN;
+	flat uint materialIndex;
 } fragInput;
 
 void main() {
-	mat4 modelMatrix = globalTransformData.modelToWorld[pushConst.transformIndexOffset + gl_InstanceIndex];
-	mat4 previousModelMatrix = globalPreviousTransformData.modelToWorld[pushConst.transformIndexOffset + gl_InstanceIndex];
+	// indirect draws push 0 and carry the transform index as first instance
+	uint transformIndex = pushConst.transformIndexOffset + gl_InstanceIndex;
+	mat4 modelMatrix = globalTransformData.modelToWorld[transformIndex];
+	mat4 previousModelMatrix = globalPreviousTransformData.modelToWorld[transformIndex];
+	fragInput.materialIndex = globalTransformMaterialData.materialIndex[transformIndex];
 
 	fragInput.worldPos = (modelMatrix * vec4(inPos, 1.0)).xyz;
 	fragInput.uv = inUV;
@@ -3,7 +3,9 @@
 
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <deque>
+#include <memory>
 #include <vector>
 
 namespace CGE
@@ -23,6 +25,7 @@ namespace CGE
 			m_jobs.push_back(job);
 			m_condition.notify_one();
 		}
+		uint32_t GetPoolSize() const { return m_poolSize; }
 	private:
 		static ThreadPool* m_instance;
 	
@@ -5,6 +5,9 @@
 #include "async/ThreadPool.h"
 #include "messages/MessageBus.h"
 #include "render/ShaderRegistry.h"
+#include "render/shader/ShaderReflectionCache.h"
+#include "render/shader/ShaderPermutation.h"
+#include "utils/Singleton.h"
 
 namespace CGE
 {
@@ -95,8 +98,14 @@ namespace CGE
 		m_shaderRegistry = new ShaderRegistry();
 		m_sceneInstance = new Scene();
 	
+		auto initStartTime = std::chrono::high_resolution_clock::now();
 		m_rendererInstance->Init();
 		m_sceneInstance->Init();
+		auto initCurrentTime = std::chrono::high_resolution_clock::now();
+		double initDeltaTime = std::chrono::duration<double, std::chrono::milliseconds::period>(initCurrentTime - initStartTime).count();
+		std::printf("renderer and scene init time is %f milliseconds\n", initDeltaTime);
+		Singleton<ShaderReflectionCache>::GetInstance()->PrintStats();
+		Singleton<ShaderPermutationCache>::GetInstance()->PrintStats();
 	}
 	
 	void Engine::MainLoop()
@@ -2,15 +2,17 @@
 #include "data/DataManager.h"
 #include "core/Class.h"
 #include <assert.h>
-#include <random>
 #include <chrono>
+#include <algorithm>
 #include "async/Job.h"
 #include "async/ThreadPool.h"
 
 namespace
 {
-	static constexpr uint32_t SAMPLE_COUNT = 5;
-	static constexpr uint32_t SEQUENCE_SIZE = 10;
+	// released resources are kept this many frames so the gpu is surely done with them
+	static constexpr uint32_t RELEASE_LATENCY = 3;
+	// slots checked per type each frame for resources only the table still references
+	static constexpr uint32_t SWEEP_COUNT = 64;
 }
 
 namespace CGE
@@ -33,8 +35,11 @@ namespace CGE
 	
 	DataManager::DataManager()
 	{
-		m_resourcesTable.reserve(1024 * 128);
-		m_resourcesMap.reserve(128);
+		for (ResourcesShard& shard : m_shards)
+		{
+			shard.resources.reserve(1024 * 128 / SHARDS_COUNT);
+		}
+		m_slotTables.reserve(128);
 
 		m_messageSubscriber.AddHandler<GlobalPostFrameMessage>(this, &DataManager::HandleUpdate);
 	}
@@ -73,28 +78,40 @@ namespace CGE
 	
 	void DataManager::CleanupResources()
 	{
-		std::scoped_lock<std::mutex> lock(m_mutex);
-		auto it = m_resourcesTable.begin();
-		for (; it != m_resourcesTable.end(); it++)
 		{
-			it->second->Destroy();
+			std::scoped_lock<std::mutex> loadLock(m_loadMutex);
+			m_loadRequests.clear();
+			m_loadedRequests.clear();
+			m_createdRequests.clear();
+			m_uploadingRequests.clear();
 		}
-		m_resourcesTable.clear();
-		m_resourcesMap.clear();
-		for (auto& chain : m_cleanupChain)
+
+		std::vector<ResourcePtr> resources;
 		{
-			for (auto resPtr : chain)
+			std::unique_lock<std::shared_mutex> lock(m_tablesMutex);
+			for (auto& pair : m_slotTables)
 			{
-				resPtr->Destroy();
+				pair.second->Clear(resources);
 			}
-			chain.clear();
+		}
+		for (ResourcesShard& shard : m_shards)
+		{
+			std::unique_lock<std::shared_mutex> lock(shard.mutex);
+			shard.resources.clear();
+		}
+		for (ResourcePtr& resource : resources)
+		{
+			resource->Destroy();
 		}
 	}
 
 	bool DataManager::HasResource(HashString inKey)
 	{
-		std::scoped_lock<std::mutex> lock(m_mutex);
-		return m_resourcesTable.find(inKey) != m_resourcesTable.end();
+		ResourcesShard& shard = GetShard(inKey);
+		std::shared_lock<std::shared_mutex> lock(shard.mutex);
+		auto it = shard.resources.find(inKey);
+		// collected slot could still have its key for a moment
+		return (it != shard.resources.end()) && (it->second.table->Get(it->second.id.index, it->second.id.generation) != nullptr);
 	}
 	
 	bool DataManager::AddResource(ResourcePtr inValue)
@@ -104,18 +121,24 @@ namespace CGE
 			return false;
 		}
 
-		std::scoped_lock<std::mutex> lock(m_mutex);
-
 		HashString key = inValue->GetResourceId();
-		if (m_resourcesTable.find(key) == m_resourcesTable.end())
+		ResourceSlotTable* table = GetSlotTable(inValue->GetClass().GetName());
+
+		ResourcesShard& shard = GetShard(key);
+		std::unique_lock<std::shared_mutex> lock(shard.mutex);
+
+		auto it = shard.resources.find(key);
+		if ((it == shard.resources.end()) || !it->second.table->Get(it->second.id.index, it->second.id.generation))
 		{
-			m_resourcesTable[key] = inValue;
-			HashString className = inValue->GetClass().GetName();
-			if (m_resourcesMap.find(className) == m_resourcesMap.end())
+			ResourceLocation location;
+			location.table = table;
+			location.id = table->Insert(inValue);
+			if (location.id.index == ResourceSlotTable::INVALID_INDEX)
 			{
-				m_resourcesMap[className].reserve(1024 * 16);
+				assert(false);
+				return false;
 			}
-			m_resourcesMap[className][key] = inValue;
+			shard.resources[key] = location;
 
 			return true;
 		}
@@ -126,31 +149,71 @@ namespace CGE
 	
 	std::shared_ptr<Resource> DataManager::GetResource(HashString inKey)
 	{
-		std::scoped_lock<std::mutex> lock(m_mutex);
-		auto it = m_resourcesTable.find(inKey);
-		if (it != m_resourcesTable.end())
+		ResourceLocation location;
 		{
-			return it->second;
+			ResourcesShard& shard = GetShard(inKey);
+			std::shared_lock<std::shared_mutex> lock(shard.mutex);
+			auto it = shard.resources.find(inKey);
+			if (it == shard.resources.end())
+			{
+				return nullptr;
+			}
+			location = it->second;
 		}
-		return nullptr;
+		return location.table->GetShared(location.id.index, location.id.generation);
+	}
+
+	DataManager::ResourcesShard& DataManager::GetShard(HashString inKey)
+	{
+		return m_shards[std::hash<HashString>()(inKey) % SHARDS_COUNT];
+	}
+
+	ResourceSlotTable* DataManager::FindSlotTable(HashString inClassName)
+	{
+		std::shared_lock<std::shared_mutex> lock(m_tablesMutex);
+		auto it = m_slotTables.find(inClassName);
+		return it != m_slotTables.end() ? it->second.get() : nullptr;
 	}
 	
-	ResourcePtr DataManager::GetResource(HashString inKey, std::unordered_map<HashString, ResourcePtr>& inMap)
+	ResourceSlotTable* DataManager::GetSlotTable(HashString inClassName)
 	{
-		std::scoped_lock<std::mutex> lock(m_mutex);
-		auto it = inMap.find(inKey);
-		if (it != inMap.end())
+		ResourceSlotTable* table = FindSlotTable(inClassName);
+		if (table)
 		{
-			return it->second;
+			return table;
 		}
-		return nullptr;
+
+		std::unique_lock<std::shared_mutex> lock(m_tablesMutex);
+		std::unique_ptr<ResourceSlotTable>& newTable = m_slotTables[inClassName];
+		if (!newTable)
+		{
+			newTable = std::make_unique<ResourceSlotTable>();
+		}
+		return newTable.get();
 	}
 
 	void DataManager::DestroyHint(HashString id)
 	{
-		std::scoped_lock<std::mutex> lock(m_mutex);
+		ResourcesShard& shard = GetShard(id);
+		std::shared_lock<std::shared_mutex> lock(shard.mutex);
+
+		auto it = shard.resources.find(id);
+		if (it != shard.resources.end())
+		{
+			it->second.table->ReleaseHint(it->second.id.index, it->second.id.generation);
+		}
+	}
+
+	void DataManager::ChangedHint(HashString id)
+	{
+		ResourcesShard& shard = GetShard(id);
+		std::shared_lock<std::shared_mutex> lock(shard.mutex);
 
-		m_deletionHints.push_back(id);
+		auto it = shard.resources.find(id);
+		if (it != shard.resources.end())
+		{
+			it->second.table->MarkChanged();
+		}
 	}
 
 	bool DataManager::DeleteResource(ResourcePtr inValue)
@@ -165,83 +228,193 @@ namespace CGE
 	
 	bool DataManager::DeleteResource(HashString key)
 	{
-		std::scoped_lock<std::mutex> lock(m_mutex);
+		ResourcePtr resource;
+		{
+			ResourcesShard& shard = GetShard(key);
+			std::unique_lock<std::shared_mutex> lock(shard.mutex);
+
+			auto it = shard.resources.find(key);
+			if (it == shard.resources.end())
+			{
+				return false;
+			}
+			resource = it->second.table->Remove(it->second.id);
+			shard.resources.erase(it);
+		}
+
+		return resource != nullptr;
+	}
+
+	void DataManager::QueueLoad(ResourceLoadRequestPtr inRequest)
+	{
+		std::function func = [this, inRequest]()
+		{
+			RunLoad(inRequest);
+		};
+		ThreadPool::GetInstance()->AddJob(CreateJobPtr(std::move(func)));
+	}
 
-		auto it = m_resourcesTable.find(key);
-		if (it != m_resourcesTable.end())
+	bool DataManager::RunLoad(ResourceLoadRequestPtr inRequest)
+	{
+		if (inRequest->m_loadClaimed.exchange(true))
 		{
-			m_resourcesMap[it->second->GetClass().GetName()].erase(key);
-			m_resourcesTable.erase(key);
-			return true;
+			return false;
 		}
 
-		return false;
+		inRequest->SetState(ResourceLoadState::Loading);
+		inRequest->m_loadResult = inRequest->GetResource()->Load();
+		{
+			std::scoped_lock<std::mutex> lock(m_loadMutex);
+			m_loadedRequests.push_back(inRequest);
+		}
+		// after the push, so whoever waits for it finds it in the loaded list
+		inRequest->m_loadPromise.set_value();
+		return true;
 	}
 
-	void DataManager::HandleUpdate(std::shared_ptr<GlobalPostFrameMessage> updateMsg)
+	bool DataManager::CreateLoaded(ResourceLoadRequestPtr inRequest)
 	{
-		std::function func = [this]() { ScanForAbandonedResources(); };
-		std::shared_ptr<Job<void()>> job = std::make_shared<Job<void()>>(std::move(func));
-		ThreadPool::GetInstance()->AddJob(job);
-		//ScanForAbandonedResources();
+		// device objects are created here, data goes through the transfer list
+		if (!inRequest->m_loadResult || !inRequest->GetResource()->Create())
+		{
+			FinishLoad(inRequest, false);
+			return false;
+		}
+		inRequest->m_upload = inRequest->GetResource()->Upload();
+		inRequest->GetResource()->SetReady();
+		return true;
 	}
 
-	void DataManager::ScanForAbandonedResources()
+	bool DataManager::CompleteLoad(HashString inKey)
 	{
+		ResourceLoadRequestPtr request;
 		{
-			// process deletion hints first
-			std::scoped_lock<std::mutex> lock(m_mutex);
-			for (auto& id : m_deletionHints)
+			std::scoped_lock<std::mutex> lock(m_loadMutex);
+			auto it = m_loadRequests.find(inKey);
+			if (it == m_loadRequests.end())
 			{
-				auto it = m_resourcesTable.find(id);
-				if ((it != m_resourcesTable.end()) && (it->second.use_count() <= 2))
-				{
-					m_cleanupChain[m_cleanupChainIndex].push_back(it->second);
-					m_resourcesMap[it->second->GetClass().GetName()].erase(id);
-					m_resourcesTable.erase(id);
-				}
+				return true;
 			}
-			m_deletionHints.clear();
+			request = it->second;
 		}
+		return CompleteLoad(request);
+	}
 
-		std::random_device rd;
-		std::mt19937 rng(static_cast<uint32_t>(std::chrono::system_clock::now().time_since_epoch().count()));
-		// sample resource container randomly looking for abandoned resources
-		for (uint32_t idx = 0; idx < SAMPLE_COUNT; ++idx)
+	bool DataManager::CompleteLoad(ResourceLoadRequestPtr inRequest)
+	{
+		// not picked by a worker yet, loaded right here instead of waiting for the queue
+		if (!RunLoad(inRequest))
 		{
-			std::scoped_lock<std::mutex> lock(m_mutex);
+			inRequest->m_loaded.wait();
+		}
 
-			std::uniform_int_distribution<uint32_t> dist(0, static_cast<uint32_t>(m_resourcesTable.size()) - 1);
+		bool taken = false;
+		{
+			std::scoped_lock<std::mutex> lock(m_loadMutex);
+			auto it = std::find(m_loadedRequests.begin(), m_loadedRequests.end(), inRequest);
+			if (it != m_loadedRequests.end())
+			{
+				m_loadedRequests.erase(it);
+				taken = true;
+			}
+		}
+		// otherwise ProcessLoadRequests has created it already
+		if (taken && CreateLoaded(inRequest))
+		{
+			std::scoped_lock<std::mutex> lock(m_loadMutex);
+			m_createdRequests.push_back(inRequest);
+		}
+		return inRequest->GetState() != ResourceLoadState::Failed;
+	}
 
-			auto it = m_resourcesTable.begin();
-			uint32_t offset = dist(rng);
-			std::advance(it, offset);
+	void DataManager::ProcessLoadRequests()
+	{
+		std::vector<ResourceLoadRequestPtr> loaded;
+		{
+			std::scoped_lock<std::mutex> lock(m_loadMutex);
+			loaded.swap(m_loadedRequests);
+			m_uploadingRequests.insert(m_uploadingRequests.end(), m_createdRequests.begin(), m_createdRequests.end());
+			m_createdRequests.clear();
+		}
 
-			auto endIt = m_resourcesTable.end();
-			uint16_t counter = 0;
-			while (it != endIt)
+		// on the main thread, same as the synchronous requests
+		for (ResourceLoadRequestPtr& request : loaded)
+		{
+			if (CreateLoaded(request))
 			{
-				if (it->second.use_count() <= 2)
-				{
-					m_cleanupChain[m_cleanupChainIndex].push_back(it->second);
-					m_resourcesMap[it->second->GetClass().GetName()].erase(it->first);
-					it = m_resourcesTable.erase(it);
-				}
-				else
-				{
-					++it;
-				}
-				if (counter++ >= SEQUENCE_SIZE)
-				{
-					break;
-				}
+				m_uploadingRequests.push_back(request);
 			}
 		}
 
-		m_cleanupChainIndex = (m_cleanupChainIndex + 1) % m_cleanupChain.size();
-		m_cleanupChain[m_cleanupChainIndex].clear();
+		auto it = m_uploadingRequests.begin();
+		while (it != m_uploadingRequests.end())
+		{
+			ResourceLoadRequestPtr request = *it;
+			if (request->m_upload.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			{
+				++it;
+				continue;
+			}
+
+			bool uploaded = true;
+			try
+			{
+				request->m_upload.get();
+			}
+			catch (const std::exception&)
+			{
+				uploaded = false;
+			}
+			FinishLoad(request, uploaded);
+			it = m_uploadingRequests.erase(it);
+		}
 	}
 
-}
+	void DataManager::FinishLoad(ResourceLoadRequestPtr inRequest, bool inSuccess)
+	{
+		HashString key = inRequest->GetResource()->GetResourceId();
+		{
+			std::scoped_lock<std::mutex> lock(m_loadMutex);
+			m_loadRequests.erase(key);
+		}
+		if (!inSuccess)
+		{
+			// broken resource shouldn't be handed out to the next request for the same key
+			DeleteResource(key);
+		}
+		inRequest->SetState(inSuccess ? ResourceLoadState::Ready : ResourceLoadState::Failed);
+	}
 
+	void DataManager::HandleUpdate(std::shared_ptr<GlobalPostFrameMessage> updateMsg)
+	{
+		ProcessLoadRequests();
+		CollectResources(updateMsg->frameCount);
+	}
 
+	void DataManager::CollectResources(uint64_t inFrame)
+	{
+		std::vector<ResourcePtr> freed;
+		{
+			std::shared_lock<std::shared_mutex> lock(m_tablesMutex);
+			for (auto& pair : m_slotTables)
+			{
+				pair.second->Collect(inFrame, RELEASE_LATENCY, SWEEP_COUNT, freed);
+			}
+		}
+		for (ResourcePtr& resource : freed)
+		{
+			HashString key = resource->GetResourceId();
+			ResourcesShard& shard = GetShard(key);
+			std::unique_lock<std::shared_mutex> lock(shard.mutex);
+			// the key could already be taken by a new resource
+			auto it = shard.resources.find(key);
+			if ((it != shard.resources.end()) && !it->second.table->Get(it->second.id.index, it->second.id.generation))
+			{
+				shard.resources.erase(it);
+			}
+		}
+		// destroyed out of the locks, resources could hold handles or shared pointers to other resources
+		freed.clear();
+	}
+
+}
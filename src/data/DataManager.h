@@ -7,18 +7,24 @@
 #include <type_traits>
 #include <atomic>
 #include <mutex>
-#include <unordered_map>
+#include <shared_mutex>
 #include <array>
+#include <unordered_map>
 
 #include "core/ObjectBase.h"
 #include "core/Class.h"
 #include "common/HashString.h"
 #include "data/Resource.h"
+#include "data/ResourceRequest.h"
+#include "data/ResourceSlotTable.h"
 #include "messages/MessageSubscriber.h"
 
 namespace CGE
 {
-	
+	// versioned typed list of all live resources of a type, shared between all the readers
+	template<class T>
+	using ResourceSnapshot = std::shared_ptr<const std::vector<std::shared_ptr<T>>>;
+
 	class DataManager
 	{
 	public:
@@ -31,40 +37,81 @@ namespace CGE
 		std::shared_ptr<Resource> GetResource(HashString inKey);
 		template<class T>
 		std::vector<std::shared_ptr<T>> GetResourcesByType();
+		// no copies and no locks unless resources of the type were added or removed since the last call
+		template<class T>
+		ResourceSnapshot<T> GetResourcesSnapshot(uint64_t* outVersion = nullptr);
 		template<class T>
 		std::shared_ptr<T> GetResourceByType(HashString inKey);
 		template<class T, typename ...ArgTypes>
 		std::shared_ptr<T> RequestResourceByType(HashString inKey, ArgTypes&& ...args);
 		template<class T, typename ...ArgTypes>
 		static std::shared_ptr<T> RequestResourceType(HashString inKey, ArgTypes&& ...args);
+		template<class T, typename ...ArgTypes>
+		ResourceRequest<T> RequestResourceAsync(HashString inKey, ArgTypes&& ...args);
+		template<class T, typename ...ArgTypes>
+		static ResourceRequest<T> RequestResourceTypeAsync(HashString inKey, ArgTypes&& ...args);
+		// finishes a request still in flight on the calling thread, its upload stays on the transfer list. null if it failed
 		template<class T>
-		std::unordered_map<HashString, ResourcePtr>& GetResourcesTable();
+		std::shared_ptr<T> CompleteRequest(const ResourceRequest<T>& inRequest);
 
 		void DestroyHint(HashString id);
+		void ChangedHint(HashString id);
 	protected:
-		std::mutex m_mutex;
-		std::unordered_map<HashString, ResourcePtr> m_resourcesTable;
-		std::unordered_map<HashString, std::unordered_map<HashString, ResourcePtr>> m_resourcesMap;
-		std::vector<HashString> m_deletionHints;
+		struct ResourceLocation
+		{
+			ResourceSlotTable* table;
+			ResourceSlotTable::SlotId id;
+		};
+
+		static constexpr uint32_t SHARDS_COUNT = 16;
+
+		// key to slot lookup split by key hash, resources themselves are owned by the per type slot tables
+		struct ResourcesShard
+		{
+			std::shared_mutex mutex;
+			std::unordered_map<HashString, ResourceLocation> resources;
+		};
+
+		std::array<ResourcesShard, SHARDS_COUNT> m_shards;
+		// types are added rarely, so it's almost always a shared lock
+		std::shared_mutex m_tablesMutex;
+		std::unordered_map<HashString, std::unique_ptr<ResourceSlotTable>> m_slotTables;
+		// async loads, in flight requests by key and the ones done with cpu side work
+		std::mutex m_loadMutex;
+		std::unordered_map<HashString, ResourceLoadRequestPtr> m_loadRequests;
+		std::vector<ResourceLoadRequestPtr> m_loadedRequests;
+		// created outside of ProcessLoadRequests, waiting to join the uploading ones
+		std::vector<ResourceLoadRequestPtr> m_createdRequests;
+		std::vector<ResourceLoadRequestPtr> m_uploadingRequests;
 	private:
 		static DataManager* m_instance;
 		static std::mutex m_staticMutex;
 
 		MessageSubscriber m_messageSubscriber;
-		std::array<std::vector<ResourcePtr>, 3> m_cleanupChain;
-		uint32_t m_cleanupChainIndex = 0;
 	
 		DataManager();
 		DataManager(const DataManager& inOther) {}
 		void operator=(const DataManager& inOther) {}
 		virtual ~DataManager();
 	
-		ResourcePtr GetResource(HashString inKey, std::unordered_map<HashString, ResourcePtr>& inMap);
+		ResourcesShard& GetShard(HashString inKey);
+		ResourceSlotTable* FindSlotTable(HashString inClassName);
+		ResourceSlotTable* GetSlotTable(HashString inClassName);
+		template<class T>
+		static std::shared_ptr<const void> BuildSnapshot(const std::vector<ResourcePtr>& inResources);
 		bool DeleteResource(ResourcePtr inValue);
 		bool DeleteResource(HashString key);
 
+		void QueueLoad(ResourceLoadRequestPtr inRequest);
+		bool RunLoad(ResourceLoadRequestPtr inRequest);
+		bool CreateLoaded(ResourceLoadRequestPtr inRequest);
+		bool CompleteLoad(HashString inKey);
+		bool CompleteLoad(ResourceLoadRequestPtr inRequest);
+		void ProcessLoadRequests();
+		void FinishLoad(ResourceLoadRequestPtr inRequest, bool inSuccess);
+
 		void HandleUpdate(std::shared_ptr<GlobalPostFrameMessage> updateMsg);
-		void ScanForAbandonedResources();
+		void CollectResources(uint64_t inFrame);
 	};
 
 	//===========================================================================================
@@ -74,20 +121,42 @@ namespace CGE
 	template<class T>
 	std::vector<std::shared_ptr<T>> DataManager::GetResourcesByType()
 	{
-		std::vector< std::shared_ptr<T>> result;
+		return *GetResourcesSnapshot<T>();
+	}
+
+	//-----------------------------------------------------------------------------------
 
+	template<class T>
+	ResourceSnapshot<T> DataManager::GetResourcesSnapshot(uint64_t* outVersion /*= nullptr*/)
+	{
+		static const ResourceSnapshot<T> emptySnapshot = std::make_shared<const std::vector<std::shared_ptr<T>>>();
+
+		uint64_t version = 0;
+		ResourceSnapshot<T> snapshot = emptySnapshot;
+		ResourceSlotTable* table = FindSlotTable(Class::Get<T>().GetName());
+		if (table)
 		{
-			std::scoped_lock<std::mutex> lock(m_mutex);
-			auto it = m_resourcesMap.find(Class::Get<T>().GetName());
-			if (it != m_resourcesMap.end())
-			{
-				for (auto& pair : it->second)
-				{
-					result.push_back(std::dynamic_pointer_cast<T>(pair.second));
-				}
-			}
+			snapshot = std::static_pointer_cast<const std::vector<std::shared_ptr<T>>>(table->GetSnapshot(&DataManager::BuildSnapshot<T>, version));
+		}
+		if (outVersion)
+		{
+			*outVersion = version;
 		}
+		return snapshot;
+	}
+
+	//-----------------------------------------------------------------------------------
 
+	template<class T>
+	std::shared_ptr<const void> DataManager::BuildSnapshot(const std::vector<ResourcePtr>& inResources)
+	{
+		// slot tables are per exact type, no need for dynamic casts
+		std::shared_ptr<std::vector<std::shared_ptr<T>>> result = std::make_shared<std::vector<std::shared_ptr<T>>>();
+		result->reserve(inResources.size());
+		for (const ResourcePtr& resource : inResources)
+		{
+			result->push_back(std::static_pointer_cast<T>(resource));
+		}
 		return result;
 	}
 
@@ -96,13 +165,7 @@ namespace CGE
 	template<class T>
 	inline std::shared_ptr<T> DataManager::GetResourceByType(HashString inKey)
 	{
-		std::scoped_lock<std::mutex> lock(m_mutex);
-		auto it = m_resourcesMap.find(Class::Get<T>().GetName());
-		if (it != m_resourcesMap.end())
-		{
-			return std::dynamic_pointer_cast<T>( GetResource(inKey, it->second) );
-		}
-		return nullptr;
+		return std::dynamic_pointer_cast<T>(GetResource(inKey));
 	}
 	
 	//-----------------------------------------------------------------------------------
@@ -115,11 +178,19 @@ namespace CGE
 			return nullptr;
 		}
 
-		HashString className = Class::Get<T>().GetName();
 		{
-			std::shared_ptr<T> resource = std::dynamic_pointer_cast<T>(GetResource(inKey, m_resourcesMap[className]));
+			std::shared_ptr<T> resource = GetResourceByType<T>(inKey);
 			if (resource)
 			{
+				// almost always created already, only a resource that isn't could be an async load still in flight
+				if (!resource->IsReady())
+				{
+					if (!CompleteLoad(inKey))
+					{
+						return nullptr;
+					}
+					resource->SetReady();
+				}
 				return resource;
 			}
 		}
@@ -127,6 +198,7 @@ namespace CGE
 		if (resource)
 		{
 			resource->Create();
+			resource->SetReady();
 		}
 		return resource;
 	}
@@ -141,11 +213,61 @@ namespace CGE
 
 	//-----------------------------------------------------------------------------------
 
+	template<class T, typename ...ArgTypes>
+	ResourceRequest<T> DataManager::RequestResourceAsync(HashString inKey, ArgTypes&& ...args)
+	{
+		if (inKey.GetString().empty())
+		{
+			return ResourceRequest<T>();
+		}
+
+		ResourceLoadRequestPtr request;
+		{
+			// held through creation so concurrent requests for the same key can't both construct it
+			std::scoped_lock<std::mutex> lock(m_loadMutex);
+			auto it = m_loadRequests.find(inKey);
+			if (it != m_loadRequests.end())
+			{
+				return ResourceRequest<T>(it->second);
+			}
+
+			std::shared_ptr<T> resource = GetResourceByType<T>(inKey);
+			if (resource)
+			{
+				return ResourceRequest<T>(std::make_shared<ResourceLoadRequest>(resource, ResourceLoadState::Ready));
+			}
+
+			resource = ObjectBase::NewObject<T>(inKey, std::forward<ArgTypes>(args)...);
+			if (!resource)
+			{
+				return ResourceRequest<T>();
+			}
+			request = std::make_shared<ResourceLoadRequest>(resource);
+			m_loadRequests[inKey] = request;
+		}
+		QueueLoad(request);
+
+		return ResourceRequest<T>(request);
+	}
+
+	//-----------------------------------------------------------------------------------
+
+	template<class T, typename ...ArgTypes>
+	ResourceRequest<T> DataManager::RequestResourceTypeAsync(HashString inKey, ArgTypes&& ...args)
+	{
+		return GetInstance()->RequestResourceAsync<T>(inKey, std::forward<ArgTypes>(args)...);
+	}
+
+	//-----------------------------------------------------------------------------------
+
 	template<class T>
-	std::unordered_map<HashString, ResourcePtr>& DataManager::GetResourcesTable()
+	std::shared_ptr<T> DataManager::CompleteRequest(const ResourceRequest<T>& inRequest)
 	{
-		return m_resourcesMap[Class::Get<T>().GetName()];
+		if (!inRequest.m_request || !CompleteLoad(inRequest.m_request))
+		{
+			return nullptr;
+		}
+		return std::dynamic_pointer_cast<T>(inRequest.m_request->GetResource());
 	}
 
 }
-
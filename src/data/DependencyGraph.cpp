@@ -0,0 +1,128 @@
+#include "data/DependencyGraph.h"
+#include <algorithm>
+
+namespace CGE
+{
+	namespace
+	{
+		void EraseValue(std::vector<HashString>& inValues, HashString inValue)
+		{
+			inValues.erase(std::remove(inValues.begin(), inValues.end(), inValue), inValues.end());
+		}
+	}
+
+	void DependencyGraph::AddDependency(HashString inSource, HashString inDependent)
+	{
+		std::vector<HashString>& dependents = m_dependents[inSource];
+		if (std::find(dependents.begin(), dependents.end(), inDependent) != dependents.end())
+		{
+			return;
+		}
+		dependents.push_back(inDependent);
+		m_sources[inDependent].push_back(inSource);
+		m_dependents[inDependent];
+		m_sources[inSource];
+	}
+
+	void DependencyGraph::RemoveNode(HashString inNode)
+	{
+		auto it = m_dependents.find(inNode);
+		if (it == m_dependents.end())
+		{
+			return;
+		}
+		for (HashString& dependent : it->second)
+		{
+			EraseValue(m_sources[dependent], inNode);
+		}
+		for (HashString& source : m_sources[inNode])
+		{
+			EraseValue(m_dependents[source], inNode);
+		}
+		m_dependents.erase(it);
+		m_sources.erase(inNode);
+	}
+
+	void DependencyGraph::Clear()
+	{
+		m_dependents.clear();
+		m_sources.clear();
+	}
+
+	bool DependencyGraph::HasNode(HashString inNode) const
+	{
+		return m_dependents.find(inNode) != m_dependents.end();
+	}
+
+	const std::vector<HashString>& DependencyGraph::GetDependents(HashString inNode) const
+	{
+		static const std::vector<HashString> emptyDependents;
+		auto it = m_dependents.find(inNode);
+		return it != m_dependents.end() ? it->second : emptyDependents;
+	}
+
+	std::vector<HashString> DependencyGraph::CollectAffected(const std::vector<HashString>& inChanged) const
+	{
+		// reachable part first, then sources within it are counted and it's sorted the usual way
+		std::vector<HashString> reached;
+		std::unordered_set<HashString> visited;
+		for (const HashString& node : inChanged)
+		{
+			if (HasNode(node) && visited.insert(node).second)
+			{
+				reached.push_back(node);
+			}
+		}
+		for (size_t index = 0; index < reached.size(); index++)
+		{
+			for (const HashString& dependent : GetDependents(reached[index]))
+			{
+				if (visited.insert(dependent).second)
+				{
+					reached.push_back(dependent);
+				}
+			}
+		}
+
+		std::unordered_map<HashString, uint32_t> sourcesLeft;
+		for (const HashString& node : reached)
+		{
+			for (const HashString& dependent : GetDependents(node))
+			{
+				sourcesLeft[dependent]++;
+			}
+		}
+
+		std::vector<HashString> sorted;
+		sorted.reserve(reached.size());
+		for (const HashString& node : reached)
+		{
+			if (sourcesLeft[node] == 0)
+			{
+				sorted.push_back(node);
+			}
+		}
+		for (size_t index = 0; index < sorted.size(); index++)
+		{
+			for (const HashString& dependent : GetDependents(sorted[index]))
+			{
+				if (--sourcesLeft[dependent] == 0)
+				{
+					sorted.push_back(dependent);
+				}
+			}
+		}
+		// cycles can't be ordered, their nodes go last so they're still rebuilt
+		if (sorted.size() < reached.size())
+		{
+			for (const HashString& node : reached)
+			{
+				if (sourcesLeft[node] > 0)
+				{
+					sorted.push_back(node);
+				}
+			}
+		}
+		return sorted;
+	}
+}
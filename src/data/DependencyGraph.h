@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "common/HashString.h"
+
+namespace CGE
+{
+	// Directed graph of what has to be rebuilt when something changes: files, resources loaded from them,
+	// materials using those and pipelines made of materials. Nodes are plain keys, the graph doesn't care
+	// what they stand for.
+	class DependencyGraph
+	{
+	public:
+		// inDependent has to be rebuilt whenever inSource changes
+		void AddDependency(HashString inSource, HashString inDependent);
+		void RemoveNode(HashString inNode);
+		void Clear();
+
+		bool HasNode(HashString inNode) const;
+		const std::vector<HashString>& GetDependents(HashString inNode) const;
+		// everything reachable from the changed nodes including themselves, every node comes after all
+		// of its affected sources so it could be rebuilt in this order
+		std::vector<HashString> CollectAffected(const std::vector<HashString>& inChanged) const;
+	private:
+		std::unordered_map<HashString, std::vector<HashString>> m_dependents;
+		std::unordered_map<HashString, std::vector<HashString>> m_sources;
+	};
+}
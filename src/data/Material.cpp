@@ -3,13 +3,31 @@
 #include "core/Engine.h"
 #include "render/Renderer.h"
 #include "render/TransferList.h"
+#include "render/TextureStreamer.h"
+#include "render/BindlessTable.h"
+#include "render/MaterialConstantsArena.h"
 #include "utils/ResourceUtils.h"
+#include "utils/Singleton.h"
+#include <algorithm>
 
 namespace CGE
 {
 	using VULKAN_HPP_NAMESPACE::ShaderStageFlagBits;
 	using VULKAN_HPP_NAMESPACE::BufferUsageFlagBits;
 
+	namespace
+	{
+		void SetSpecialization(PipelineShaderStageCreateInfo& outStageInfo, Shader* inShader, const ShaderFeatures& inFeatures)
+		{
+			// the cache keeps the specialization alive for as long as the stage info may point at it
+			ShaderSpecializationPtr specialization = Singleton<ShaderPermutationCache>::GetInstance()->GetSpecialization(inShader, inFeatures);
+			if (specialization)
+			{
+				outStageInfo.setPSpecializationInfo(&specialization->info);
+			}
+		}
+	}
+
 	Material::Material(HashString inId)
 		: Resource(inId)
 		, m_vertexEntrypoint("main")
@@ -41,7 +59,9 @@ namespace CGE
 		m_fragmentShader = DataManager::RequestResourceType<Shader>(m_fragmentShaderPath);
 		m_computeShader = DataManager::RequestResourceType<Shader>(m_computeShaderPath);
 	
-		m_shaderHash = HashString(m_vertexShaderPath + m_fragmentShaderPath + m_computeShaderPath);
+		// features are part of the shader hash, each permutation is a shader group and a pipeline of its own
+		std::string featuresKey = m_features.IsEmpty() ? std::string() : "#" + std::to_string(m_features.GetHash());
+		m_shaderHash = HashString(m_vertexShaderPath + m_fragmentShaderPath + m_computeShaderPath + featuresKey);
 		m_hash = GetResourceId() + m_shaderHash;
 
 		m_resourceMapper.SetShaders({ m_vertexShader, m_fragmentShader, m_computeShader });
@@ -65,6 +85,18 @@ namespace CGE
 		{
 			m_resourceMapper.AddUniformBuffer(pair.first, pair.second);
 		}
+		BufferDataPtr arenaBuffer = Engine::GetRendererInstance()->GetConstantsArena().GetBuffer();
+		for (auto& pair : m_constantsBlocks)
+		{
+			if (pair.second.storage)
+			{
+				m_resourceMapper.AddStorageBufferRange(pair.first, arenaBuffer, pair.second.offset, pair.second.size);
+			}
+			else
+			{
+				m_resourceMapper.AddUniformBufferRange(pair.first, arenaBuffer, pair.second.offset, pair.second.size);
+			}
+		}
 		for (auto& pair : m_bufferArrays)
 		{
 			m_resourceMapper.AddUniformBufferArray(pair.first, pair.second);
@@ -86,6 +118,11 @@ namespace CGE
 			m_resourceMapper.AddAccelerationStructureArray(pair.first, pair.second);
 		}
 		m_resourceMapper.Update();
+
+		if (IsBindless())
+		{
+			UpdateBindlessParameters();
+		}
 	}
 	
 	HashString Material::GetHash()
@@ -124,6 +161,7 @@ namespace CGE
 		vertStageInfo.setStage(ShaderStageFlagBits::eVertex);
 		vertStageInfo.setModule(m_vertexShader->GetShaderModule());
 		vertStageInfo.setPName(m_vertexEntrypoint.c_str());
+		SetSpecialization(vertStageInfo, m_vertexShader.get(), m_features);
 	
 		return vertStageInfo;
 	}
@@ -134,6 +172,7 @@ namespace CGE
 		fragStageInfo.setStage(ShaderStageFlagBits::eFragment);
 		fragStageInfo.setModule(m_fragmentShader->GetShaderModule());
 		fragStageInfo.setPName(m_fragmentEntrypoint.c_str());
+		SetSpecialization(fragStageInfo, m_fragmentShader.get(), m_features);
 	
 		return fragStageInfo;
 	}
@@ -144,6 +183,7 @@ namespace CGE
 		computeStageInfo.setStage(ShaderStageFlagBits::eCompute);
 		computeStageInfo.setModule(m_computeShader->GetShaderModule());
 		computeStageInfo.setPName(m_computeEntrypoint.c_str());
+		SetSpecialization(computeStageInfo, m_computeShader.get(), m_features);
 	
 		return computeStageInfo;
 	}
@@ -168,6 +208,11 @@ namespace CGE
 	{
 		m_computeEntrypoint = inEntrypoint;
 	}
+
+	void Material::RemoveFeature(const std::string& inName)
+	{
+		m_features.Remove(inName);
+	}
 	
 	void Material::SetShaderPath(const std::string& inVertexShaderPath, const std::string& inFragmentShaderPath)
 	{
@@ -217,8 +262,12 @@ namespace CGE
 
 	void Material::SetUniformBuffer(const std::string& inName, uint64_t inSize, const char* inData)
 	{
-		VulkanDevice& vulkanDevice = Engine::GetRendererInstance()->GetVulkanDevice();
-	
+		if (SetConstantsBlock(inName, inSize, inData, false))
+		{
+			m_buffers.erase(inName);
+			return;
+		}
+
 		m_buffers[inName] = nullptr;
 		m_buffers[inName] = ResourceUtils::CreateBufferData(
 			GetResourceId() + inName, 
@@ -231,14 +280,74 @@ namespace CGE
 	
 	void Material::SetUniformBufferExternal(const std::string& inName, BufferDataPtr inBuffer)
 	{
+		ReleaseConstantsBlock(inName);
 		m_buffers[inName] = inBuffer;
 	}
 	
 	void Material::SetStorageBufferExternal(const std::string& inName, BufferDataPtr inBuffer)
 	{
+		ReleaseConstantsBlock(inName);
 		m_storageBuffers[inName] = inBuffer;
 	}
+
+	bool Material::SetConstantsBlock(const std::string& inName, uint64_t inSize, const char* inData, bool inStorage)
+	{
+		MaterialConstantsArena& arena = Engine::GetRendererInstance()->GetConstantsArena();
+
+		auto it = m_constantsBlocks.find(inName);
+		if ((it != m_constantsBlocks.end()) && ((it->second.size != inSize) || (it->second.storage != inStorage)))
+		{
+			ReleaseConstantsBlock(inName);
+			it = m_constantsBlocks.end();
+		}
+		if (it == m_constantsBlocks.end())
+		{
+			uint64_t offset = arena.Allocate(inSize);
+			if (offset == MaterialConstantsArena::INVALID_OFFSET)
+			{
+				return false;
+			}
+			it = m_constantsBlocks.emplace(inName, ConstantsBlock{ offset, inSize, inStorage }).first;
+		}
+		arena.Write(it->second.offset, inSize, inData);
+		return true;
+	}
+
+	void Material::ReleaseConstantsBlock(const std::string& inName)
+	{
+		auto it = m_constantsBlocks.find(inName);
+		if (it != m_constantsBlocks.end())
+		{
+			Engine::GetRendererInstance()->GetConstantsArena().Free(it->second.offset);
+			m_constantsBlocks.erase(it);
+		}
+	}
+
+	void Material::ReleaseConstantsBlocks()
+	{
+		MaterialConstantsArena& arena = Engine::GetRendererInstance()->GetConstantsArena();
+		for (auto& pair : m_constantsBlocks)
+		{
+			arena.Free(pair.second.offset);
+		}
+		m_constantsBlocks.clear();
+	}
 	
+	void Material::SetParameterLayout(MaterialParameterLayoutPtr inLayout)
+	{
+		m_parameterLayout = inLayout;
+	}
+
+	void Material::SetParameter(const std::string& inName, float inValue)
+	{
+		m_parameters[inName] = glm::vec4(inValue, 0.0f, 0.0f, 0.0f);
+	}
+
+	void Material::SetParameter(const std::string& inName, const glm::vec4& inValue)
+	{
+		m_parameters[inName] = inValue;
+	}
+
 	void Material::SetAccelerationStructure(const std::string& inName, vk::AccelerationStructureKHR inAccelStruct)
 	{
 		m_accelerationStructures[inName] = inAccelStruct;
@@ -246,8 +355,12 @@ namespace CGE
 
 	void Material::SetStorageBuffer(const std::string& inName, uint64_t inSize, const char* inData)
 	{
-		VulkanDevice& vulkanDevice = Engine::GetRendererInstance()->GetVulkanDevice();
-	
+		if (SetConstantsBlock(inName, inSize, inData, true))
+		{
+			m_storageBuffers.erase(inName);
+			return;
+		}
+
 		BufferDataPtr buffer = ResourceUtils::CreateBufferData(
 			GetResourceId() + inName,
 			inSize,
@@ -286,11 +399,24 @@ namespace CGE
 
 	void Material::UpdateUniformBuffer(const std::string& inName, uint64_t inSize, const char* inData)
 	{
+		// blocks only mark their range, it goes with the next frame's arena upload
+		auto it = m_constantsBlocks.find(inName);
+		if (it != m_constantsBlocks.end())
+		{
+			Engine::GetRendererInstance()->GetConstantsArena().Write(it->second.offset, std::min(inSize, it->second.size), inData);
+			return;
+		}
 		m_buffers[inName]->CopyTo(inSize, inData);
 	}
 	
 	void Material::UpdateStorageBuffer(const std::string& inName, uint64_t inSize, const char* inData)
 	{
+		auto it = m_constantsBlocks.find(inName);
+		if (it != m_constantsBlocks.end())
+		{
+			Engine::GetRendererInstance()->GetConstantsArena().Write(it->second.offset, std::min(inSize, it->second.size), inData);
+			return;
+		}
 		m_storageBuffers[inName]->CopyTo(inSize, inData);
 	}
 	
@@ -303,6 +429,12 @@ namespace CGE
 	{
 		return m_storageBuffers[inName];
 	}
+
+	uint64_t Material::GetConstantsOffset(const std::string& inName) const
+	{
+		auto it = m_constantsBlocks.find(inName);
+		return it != m_constantsBlocks.end() ? it->second.offset : MaterialConstantsArena::INVALID_OFFSET;
+	}
 	
 	TextureDataPtr Material::GetSampledTexture(const std::string& inName)
 	{
@@ -374,6 +506,132 @@ namespace CGE
 		return result;
 	}
 
+	void Material::UpdateStreamedTextures(uint64_t inFrame)
+	{
+		// bindless table writes swapped images itself
+		if (IsBindless())
+		{
+			return;
+		}
+		while (!m_retiredSets.empty() && (m_retiredSets.front().first + TextureStreamer::RELEASE_LATENCY <= inFrame))
+		{
+			for (VulkanDescriptorSet& set : m_retiredSets.front().second)
+			{
+				set.Destroy();
+			}
+			m_retiredSets.pop_front();
+		}
+
+		bool changed = false;
+		for (TextureDataPtr texture : GetAllTextures())
+		{
+			if (texture && texture->IsStreamed())
+			{
+				uint32_t& version = m_textureVersions[texture.get()];
+				changed |= version != texture->GetResidencyVersion();
+				version = texture->GetResidencyVersion();
+			}
+		}
+		if (changed)
+		{
+			m_retiredSets.push_back({ inFrame, m_resourceMapper.ReleaseDescriptorSets() });
+			m_resourceMapper.Update();
+		}
+	}
+
+	void Material::RebuildDescriptorSets()
+	{
+		for (TextureDataPtr texture : GetAllTextures())
+		{
+			if (texture && texture->IsStreamed())
+			{
+				m_textureVersions[texture.get()] = texture->GetResidencyVersion();
+			}
+		}
+		m_resourceMapper.Update();
+	}
+
+	void Material::UpdateBindlessParameters()
+	{
+		BindlessTable& bindlessTable = Engine::GetRendererInstance()->GetBindlessTable();
+
+		// new references first, so textures kept by the material keep their elements
+		std::vector<TextureData*> textures;
+		std::vector<BufferData*> buffers;
+		MaterialParameterBlock parameters(m_parameterLayout);
+		for (const MaterialParameterLayout::Field& field : m_parameterLayout->GetFields())
+		{
+			switch (field.type)
+			{
+			case MaterialParameterLayout::FieldType::TextureIndex:
+			{
+				auto it = m_sampledImages2D.find(field.name);
+				if ((it != m_sampledImages2D.end()) && it->second)
+				{
+					parameters.SetIndex(field.name, bindlessTable.AddTexture(it->second));
+					textures.push_back(it->second.get());
+				}
+				break;
+			}
+			case MaterialParameterLayout::FieldType::BufferIndex:
+			{
+				auto it = m_storageBuffers.find(field.name);
+				if ((it != m_storageBuffers.end()) && it->second)
+				{
+					parameters.SetIndex(field.name, bindlessTable.AddBuffer(it->second));
+					buffers.push_back(it->second.get());
+				}
+				break;
+			}
+			case MaterialParameterLayout::FieldType::Float:
+			{
+				auto it = m_parameters.find(field.name);
+				if (it != m_parameters.end())
+				{
+					parameters.SetFloat(field.name, it->second.x);
+				}
+				break;
+			}
+			default:
+			{
+				auto it = m_parameters.find(field.name);
+				if (it != m_parameters.end())
+				{
+					parameters.SetVector(field.name, it->second);
+				}
+				break;
+			}
+			}
+		}
+		ReleaseBindlessResources();
+		m_bindlessTextures = textures;
+		m_bindlessBuffers = buffers;
+
+		if (m_bindlessIndex == MaterialParameterLayout::INVALID_INDEX)
+		{
+			m_bindlessIndex = bindlessTable.AddMaterial(parameters);
+		}
+		else
+		{
+			bindlessTable.UpdateMaterial(m_bindlessIndex, parameters);
+		}
+	}
+
+	void Material::ReleaseBindlessResources()
+	{
+		BindlessTable& bindlessTable = Engine::GetRendererInstance()->GetBindlessTable();
+		for (TextureData* texture : m_bindlessTextures)
+		{
+			bindlessTable.RemoveTexture(texture);
+		}
+		for (BufferData* buffer : m_bindlessBuffers)
+		{
+			bindlessTable.RemoveBuffer(buffer);
+		}
+		m_bindlessTextures.clear();
+		m_bindlessBuffers.clear();
+	}
+
 	bool Material::Create()
 	{
 		return true;
@@ -391,6 +649,22 @@ namespace CGE
 //			pair.second.Destroy();
 		}
 		m_resourceMapper.Destroy();
+		ReleaseConstantsBlocks();
+		for (auto& pair : m_retiredSets)
+		{
+			for (VulkanDescriptorSet& set : pair.second)
+			{
+				set.Destroy();
+			}
+		}
+		m_retiredSets.clear();
+
+		if (m_bindlessIndex != MaterialParameterLayout::INVALID_INDEX)
+		{
+			ReleaseBindlessResources();
+			Engine::GetRendererInstance()->GetBindlessTable().RemoveMaterial(m_bindlessIndex);
+			m_bindlessIndex = MaterialParameterLayout::INVALID_INDEX;
+		}
 		return true;
 	}
 	
@@ -1,12 +1,15 @@
 #pragma once
 
 #include "vulkan/vulkan.hpp"
+#include <deque>
 
 #include "data/Resource.h"
 #include "data/Texture2D.h"
 #include "render/shader/Shader.h"
 #include "render/objects/VulkanDescriptorSet.h"
 #include "render/shader/ShaderResourceMapper.h"
+#include "render/shader/ShaderPermutation.h"
+#include "render/MaterialParameters.h"
 
 namespace CGE
 {
@@ -41,12 +44,19 @@ namespace CGE
 		void SetComputeEntrypoint(const std::string& inEntrypoint);
 		void SetShaderPath(const std::string& inVertexShaderPath, const std::string& inFragmentShaderPath);
 		void SetComputeShaderPath(const std::string& inComputeShaderPath);
+		// features are specialization constants of the shaders found by name, set them before LoadResources.
+		// materials with the same shaders and features share the permutation and land in the same shader group
+		template<typename T>
+		void SetFeature(const std::string& inName, T inValue);
+		void RemoveFeature(const std::string& inName);
+		inline const ShaderFeatures& GetFeatures() const { return m_features; }
 	
 		void SetTexture(const std::string& inName, Texture2DPtr inTexture2D);
 		void SetTextureArray(const std::string& inName, const std::vector<TextureDataPtr>& inTexture2D);
 		void SetTextureArray(const std::string& inName, const std::vector<Texture2DPtr>& inTexture2D);
 		void SetStorageTexture(const std::string& inName, Texture2DPtr inTexture2D);
 		void SetStorageTextureArray(const std::string& inName, const std::vector<Texture2DPtr>& inTexture2D);
+		// buffers set with data are blocks of the material constants arena, external ones are bound whole
 		template<typename T>
 		void SetUniformBuffer(const std::string& inName, T& inUniformBuffer);
 		template<typename T>
@@ -58,13 +68,21 @@ namespace CGE
 		void SetUniformBufferExternal(const std::string& inName, BufferDataPtr inBuffer);
 		void SetStorageBufferExternal(const std::string& inName, BufferDataPtr inBuffer);
 		void SetAccelerationStructure(const std::string& inName, vk::AccelerationStructureKHR inAccelStruct);
+		// bindless materials don't bind sets of their own, textures and storage buffers named in the layout
+		// go into the bindless table and the material is a block of their indices and the values below
+		void SetParameterLayout(MaterialParameterLayoutPtr inLayout);
+		void SetParameter(const std::string& inName, float inValue);
+		void SetParameter(const std::string& inName, const glm::vec4& inValue);
 		template<typename T>
 		void UpdateUniformBuffer(const std::string& inName, T& inUniformBuffer);
 		void UpdateUniformBuffer(const std::string& inName, uint64_t inSize, const char* inData);
 		void UpdateStorageBuffer(const std::string& inName, uint64_t inSize, const char* inData);
 	
+		// arena blocks aren't buffers of their own, these only return external and dedicated buffers
 		BufferDataPtr GetUniformBuffer(const std::string& inName);
 		BufferDataPtr GetStorageBuffer(const std::string& inName);
+		// offset of the named block in the constants arena buffer, MaterialConstantsArena::INVALID_OFFSET if there is none
+		uint64_t GetConstantsOffset(const std::string& inName) const;
 		TextureDataPtr GetSampledTexture(const std::string& inName);
 		TextureDataPtr GetStorageTexture(const std::string& inName);
 		template<typename ...Args>
@@ -78,9 +96,16 @@ namespace CGE
 		inline const std::string& GetVertexEntrypoint() const { return m_vertexEntrypoint; };
 		inline const std::string& GetFragmentEntrypoint() const { return m_fragmentEntrypoint; };
 		inline const std::string& GetComputeEntrypoint() const { return m_computeEntrypoint; };
+		inline bool IsBindless() const { return m_parameterLayout != nullptr; }
+		// block of the material in the bindless parameter buffer
+		inline uint32_t GetBindlessIndex() const { return m_bindlessIndex; }
 
-		inline std::vector<TextureDataPtr> GetAllTextures() const;
-		inline std::vector<BufferDataPtr> GetAllBuffers() const;
+		std::vector<TextureDataPtr> GetAllTextures() const;
+		// streamed textures swap their images, descriptor sets are written again once any of them did
+		void UpdateStreamedTextures(uint64_t inFrame);
+		// after a reload of its shaders or textures, nothing may use the current sets anymore
+		void RebuildDescriptorSets();
+		std::vector<BufferDataPtr> GetAllBuffers() const;
 	
 		bool Create() override;
 	protected:
@@ -92,6 +117,7 @@ namespace CGE
 		std::string m_computeEntrypoint;
 		HashString m_hash;
 		HashString m_shaderHash;
+		ShaderFeatures m_features;
 	
 		ShaderPtr m_vertexShader;
 		ShaderPtr m_fragmentShader;
@@ -106,10 +132,34 @@ namespace CGE
 		std::map<HashString, std::vector<BufferDataPtr>> m_storageBufferArrays;
 		std::map<HashString, vk::AccelerationStructureKHR> m_accelerationStructures;
 		std::map<HashString, std::vector<vk::AccelerationStructureKHR>> m_accelerationStructureArrays;
+
+		struct ConstantsBlock
+		{
+			uint64_t offset;
+			uint64_t size;
+			bool storage;
+		};
+		std::map<HashString, ConstantsBlock> m_constantsBlocks;
 	
 		VulkanDevice* m_vulkanDevice;
 		ShaderResourceMapper m_resourceMapper;
-	
+		// residency versions the descriptor sets were written with
+		std::map<TextureData*, uint32_t> m_textureVersions;
+		// replaced sets wait for the frames using them
+		std::deque<std::pair<uint64_t, std::vector<VulkanDescriptorSet>>> m_retiredSets;
+
+		MaterialParameterLayoutPtr m_parameterLayout;
+		std::map<HashString, glm::vec4> m_parameters;
+		uint32_t m_bindlessIndex = MaterialParameterLayout::INVALID_INDEX;
+		std::vector<TextureData*> m_bindlessTextures;
+		std::vector<BufferData*> m_bindlessBuffers;
+	
+		// false when the arena is full, the buffer gets a dedicated allocation then
+		bool SetConstantsBlock(const std::string& inName, uint64_t inSize, const char* inData, bool inStorage);
+		void ReleaseConstantsBlock(const std::string& inName);
+		void ReleaseConstantsBlocks();
+		void UpdateBindlessParameters();
+		void ReleaseBindlessResources();
 		bool Destroy() override;
 	};
 	
@@ -131,6 +181,12 @@ namespace CGE
 		SetStorageBuffer(inName, sizeof(T), reinterpret_cast<const char*>(&inStorageBuffer));
 	}
 	
+	template<typename T>
+	void Material::SetFeature(const std::string& inName, T inValue)
+	{
+		m_features.Set(inName, inValue);
+	}
+
 	template<typename T>
 	void Material::UpdateUniformBuffer(const std::string& inName, T& inUniformBuffer)
 	{
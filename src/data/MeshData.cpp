@@ -2,6 +2,10 @@
 #include "data/DataManager.h"
 #include "core/Engine.h"
 
+#include <limits>
+#include <algorithm>
+#include <cmath>
+
 namespace CGE
 {
 
@@ -104,14 +108,74 @@ namespace CGE
 		DestroyBuffer();
 	}
 	
+	void MeshData::SetSourceData(std::shared_ptr<const void> inOwner, const Vertex* inVertices, uint32_t inVertexCount, const uint32_t* inIndices, uint32_t inIndexCount)
+	{
+		m_sourceOwner = inOwner;
+		m_sourceVertices = inVertices;
+		m_sourceVertexCount = inVertexCount;
+		m_sourceIndices = inIndices;
+		m_sourceIndexCount = inIndexCount;
+		m_hasSourceData = true;
+	}
+
 	void MeshData::CreateBuffer()
 	{
-		m_vertexBuffer = SetupBuffer<Vertex>("_vertBuff", vertices, BufferUsageFlagBits::eVertexBuffer);
-		m_indexBuffer = SetupBuffer<uint32_t>("_idxBuff", indices, BufferUsageFlagBits::eIndexBuffer);
+		// external data goes straight into the staging copy, no intermediate vectors
+		const Vertex* sourceVertices = m_hasSourceData ? m_sourceVertices : vertices.data();
+		const uint32_t* sourceIndices = m_hasSourceData ? m_sourceIndices : indices.data();
+		GeometryPool& geometryPool = Engine::GetRendererInstance()->GetGeometryPool();
+
+		// meshes share the pool buffers, own buffers only once the pool is full
+		m_poolHandle = geometryPool.Place(sourceVertices, GetVertexCount(), sourceIndices, GetIndexCount());
+		if (!IsInGeometryPool())
+		{
+			m_vertexBuffer = SetupBuffer<Vertex>("_vertBuff", sourceVertices, GetVertexCount(), BufferUsageFlagBits::eVertexBuffer);
+			m_indexBuffer = SetupBuffer<uint32_t>("_idxBuff", sourceIndices, GetIndexCount(), BufferUsageFlagBits::eIndexBuffer);
+		}
+		CalculateBoundingSphere(sourceVertices, GetVertexCount());
+
+		if (m_hasSourceData)
+		{
+			m_sourceVertices = nullptr;
+			m_sourceIndices = nullptr;
+			m_sourceOwner = nullptr;
+		}
 	}
-	
+
+	void MeshData::CalculateBoundingSphere(const Vertex* inVertices, uint32_t inVertexCount)
+	{
+		if (inVertexCount == 0)
+		{
+			m_boundingSphere = glm::vec4(0.0f);
+			return;
+		}
+
+		// box center is not the tightest one but it is stable and cheap
+		glm::vec3 boundsMin(std::numeric_limits<float>::max());
+		glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+		for (uint32_t index = 0; index < inVertexCount; index++)
+		{
+			boundsMin = glm::min(boundsMin, inVertices[index].position);
+			boundsMax = glm::max(boundsMax, inVertices[index].position);
+		}
+		glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+		float radiusSquared = 0.0f;
+		for (uint32_t index = 0; index < inVertexCount; index++)
+		{
+			glm::vec3 offset = inVertices[index].position - center;
+			radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+		}
+		m_boundingSphere = glm::vec4(center, std::sqrt(radiusSquared));
+	}
+
 	void MeshData::DestroyBuffer()
 	{
+		// pooled data may still be drawn by frames in flight, the pool keeps the range for a while
+		if (IsInGeometryPool())
+		{
+			Engine::GetRendererInstance()->GetGeometryPool().Release(m_poolHandle);
+			m_poolHandle = GeometryPool::INVALID_HANDLE;
+		}
 		// buffers
 		m_vertexBuffer = nullptr;
 		m_indexBuffer = nullptr;
@@ -128,24 +192,49 @@ namespace CGE
 		return bindingDescription;
 	}
 	
+	BufferDataPtr MeshData::GetVertexBuffer()
+	{
+		return IsInGeometryPool() ? Engine::GetRendererInstance()->GetGeometryPool().GetVertexBuffer() : m_vertexBuffer;
+	}
+
+	BufferDataPtr MeshData::GetIndexBuffer()
+	{
+		return IsInGeometryPool() ? Engine::GetRendererInstance()->GetGeometryPool().GetIndexBuffer() : m_indexBuffer;
+	}
+
+	GeometryRange MeshData::GetPoolRange()
+	{
+		return Engine::GetRendererInstance()->GetGeometryPool().GetRange(m_poolHandle);
+	}
+
+	uint32_t MeshData::GetBaseVertex()
+	{
+		return IsInGeometryPool() ? GetPoolRange().firstVertex : 0;
+	}
+
+	uint32_t MeshData::GetFirstIndex()
+	{
+		return IsInGeometryPool() ? GetPoolRange().firstIndex : 0;
+	}
+
 	uint32_t MeshData::GetVertexBufferSizeBytes()
 	{
-		return static_cast<uint32_t>( sizeof(Vertex) * vertices.size() );
+		return static_cast<uint32_t>(sizeof(Vertex) * GetVertexCount());
 	}
 	
 	uint32_t MeshData::GetVertexCount()
 	{
-		return static_cast<uint32_t>( vertices.size() );
+		return m_hasSourceData ? m_sourceVertexCount : static_cast<uint32_t>( vertices.size() );
 	}
 	
 	uint32_t MeshData::GetIndexBufferSizeBytes()
 	{
-		return static_cast<uint32_t>(sizeof(uint32_t) * indices.size());
+		return static_cast<uint32_t>(sizeof(uint32_t) * GetIndexCount());
 	}
 	
 	uint32_t MeshData::GetIndexCount()
 	{
-		return static_cast<uint32_t>(indices.size());
+		return m_hasSourceData ? m_sourceIndexCount : static_cast<uint32_t>(indices.size());
 	}
 	
 	MeshDataPtr MeshData::FullscreenQuad()
@@ -11,7 +11,9 @@
 #include "render/resources/VulkanDeviceMemory.h"
 #include "core/Engine.h"
 #include "render/Renderer.h"
+#include "render/GeometryPool.h"
 #include "BufferData.h"
+#include "data/Meshlet.h"
 
 namespace CGE
 {
@@ -19,10 +21,6 @@ namespace CGE
 	using VULKAN_HPP_NAMESPACE::VertexInputBindingDescription;
 	//using vk::BufferUsageFlags;
 	
-	//packing should probably be considered, maybe in the future someday
-	//#pragma pack(push, 1)
-	//#pragma pack(pop)
-	
 	struct Vertex
 	{
 		glm::vec3 position;
@@ -50,15 +48,31 @@ namespace CGE
 		// Inherited via Resource
 		virtual bool Create() override;
 	
+		// points buffer creation at external data instead of the vectors, owner is kept alive until buffers are created
+		void SetSourceData(std::shared_ptr<const void> inOwner, const Vertex* inVertices, uint32_t inVertexCount, const uint32_t* inIndices, uint32_t inIndexCount);
+		// optional cluster decomposition, meshlets index into the same index buffer
+		void SetMeshlets(std::vector<Meshlet> inMeshlets) { m_meshlets = std::move(inMeshlets); }
+		const std::vector<Meshlet>& GetMeshlets() { return m_meshlets; }
+		bool HasMeshlets() { return !m_meshlets.empty(); }
 		void CreateBuffer();
 		void DestroyBuffer();
 	
-		BufferDataPtr GetVertexBuffer() { return m_vertexBuffer; }
+		// shared pool buffers for pooled meshes, draws and builds have to start at the base vertex and first index
+		BufferDataPtr GetVertexBuffer();
 		uint32_t GetVertexBufferSizeBytes();
 		uint32_t GetVertexCount();
-		BufferDataPtr GetIndexBuffer() { return m_indexBuffer; }
+		BufferDataPtr GetIndexBuffer();
 		uint32_t GetIndexBufferSizeBytes();
 		uint32_t GetIndexCount();
+		// mesh space sphere around all vertices, xyz is the center and w the radius, valid after CreateBuffer
+		const glm::vec4& GetBoundingSphere() { return m_boundingSphere; }
+		// range in the renderer geometry pool, resolved on every call since compaction moves it. Invalid with
+		// the pool full, the mesh has buffers of its own then
+		GeometryRange GetPoolRange();
+		bool IsInGeometryPool() { return m_poolHandle != GeometryPool::INVALID_HANDLE; }
+		// 0 for meshes with their own buffers
+		uint32_t GetBaseVertex();
+		uint32_t GetFirstIndex();
 	
 		static VertexInputBindingDescription GetBindingDescription(uint32_t inDesiredBinding);
 		// fullscreen quad instance to be used for screen space stuff
@@ -70,11 +84,24 @@ namespace CGE
 
 		BufferDataPtr m_vertexBuffer;
 		BufferDataPtr m_indexBuffer;
+
+		std::vector<Meshlet> m_meshlets;
+		glm::vec4 m_boundingSphere = glm::vec4(0.0f);
+		GeometryHandle m_poolHandle = GeometryPool::INVALID_HANDLE;
+
+		std::shared_ptr<const void> m_sourceOwner;
+		const Vertex* m_sourceVertices = nullptr;
+		const uint32_t* m_sourceIndices = nullptr;
+		uint32_t m_sourceVertexCount = 0;
+		uint32_t m_sourceIndexCount = 0;
+		bool m_hasSourceData = false;
 	
 		MeshData() : Resource(HashString::NONE) {}
 	
+		void CalculateBoundingSphere(const Vertex* inVertices, uint32_t inVertexCount);
+
 		template<class T>
-		BufferDataPtr SetupBuffer(HashString name, std::vector<T>& inDataVector, vk::BufferUsageFlags usage);
+		BufferDataPtr SetupBuffer(HashString name, const T* inData, uint32_t inCount, vk::BufferUsageFlags usage);
 	};
 	
 	typedef std::shared_ptr<MeshData> MeshDataPtr;
@@ -84,15 +111,15 @@ namespace CGE
 	//--------------------------------------------------------------------------------------------------------------------------
 	
 	template<class T>
-	BufferDataPtr MeshData::SetupBuffer(HashString name, std::vector<T>& inDataVector, vk::BufferUsageFlags usage)
+	BufferDataPtr MeshData::SetupBuffer(HashString name, const T* inData, uint32_t inCount, vk::BufferUsageFlags usage)
 	{	
-		DeviceSize size = static_cast<DeviceSize>(sizeof(T) * inDataVector.size());
+		DeviceSize size = static_cast<DeviceSize>(sizeof(T) * inCount);
 	
 		usage |= vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eShaderDeviceAddress;
 		usage |= vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR;
 		BufferDataPtr buffer = ObjectBase::NewObject<BufferData>(GetResourceId() + name, size, usage, true);
 		buffer->Create();
-		buffer->CopyTo(size, reinterpret_cast<const char*>(inDataVector.data()));
+		buffer->CopyTo(size, reinterpret_cast<const char*>(inData));
 
 		return buffer;
 	}
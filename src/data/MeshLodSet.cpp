@@ -0,0 +1,55 @@
+#include "data/MeshLodSet.h"
+#include "data/MeshData.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace CGE
+{
+	namespace
+	{
+		static constexpr float MIN_LOD_DISTANCE = 1e-3f;
+	}
+
+	MeshLodSet::MeshLodSet(const glm::vec3& inBoundsCenter, float inBoundsRadius)
+		: m_boundsCenter(inBoundsCenter)
+		, m_boundsRadius(inBoundsRadius)
+	{
+	}
+
+	void MeshLodSet::AddLod(MeshDataPtr inMeshData, float inError)
+	{
+		m_lods.push_back({ inMeshData, inError });
+	}
+
+	void MeshLodSet::CreateBuffers()
+	{
+		for (MeshLod& lod : m_lods)
+		{
+			lod.meshData->CreateBuffer();
+		}
+	}
+
+	uint32_t MeshLodSet::SelectLod(const glm::mat4& inTransform, const glm::vec3& inViewLocation, float inProjectionScale, float inPixelError /*= DEFAULT_PIXEL_ERROR*/) const
+	{
+		glm::vec3 center = glm::vec3(inTransform * glm::vec4(m_boundsCenter, 1.0f));
+		float scale = std::max(glm::length(glm::vec3(inTransform[0])), std::max(glm::length(glm::vec3(inTransform[1])), glm::length(glm::vec3(inTransform[2]))));
+		// distance to the bounding sphere, so the nearest part of the mesh decides
+		float distance = std::max(glm::length(center - inViewLocation) - m_boundsRadius * scale, MIN_LOD_DISTANCE);
+		float pixelsPerUnit = inProjectionScale * scale / distance;
+
+		for (uint32_t level = GetLodCount(); level > 1; level--)
+		{
+			if (m_lods[level - 1].error * pixelsPerUnit <= inPixelError)
+			{
+				return level - 1;
+			}
+		}
+		return 0;
+	}
+
+	float MeshLodSet::GetProjectionScale(float inFovDegrees, float inViewportHeight)
+	{
+		return inViewportHeight / (2.0f * std::tan(glm::radians(inFovDegrees) * 0.5f));
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+namespace CGE
+{
+	class MeshData;
+	typedef std::shared_ptr<MeshData> MeshDataPtr;
+
+	struct MeshLod
+	{
+		MeshDataPtr meshData;
+		// largest simplification error in mesh space units
+		float error = 0.0f;
+	};
+
+	// Chain of simplified versions of one mesh, level 0 is the source mesh. Levels are picked per instance
+	// from the screen space size of their simplification error.
+	class MeshLodSet
+	{
+	public:
+		static constexpr float DEFAULT_PIXEL_ERROR = 1.0f;
+
+		MeshLodSet(const glm::vec3& inBoundsCenter, float inBoundsRadius);
+
+		void AddLod(MeshDataPtr inMeshData, float inError);
+		void CreateBuffers();
+
+		uint32_t GetLodCount() const { return static_cast<uint32_t>(m_lods.size()); }
+		const MeshLod& GetLod(uint32_t inLevel) const { return m_lods[inLevel]; }
+		const glm::vec3& GetBoundsCenter() const { return m_boundsCenter; }
+		float GetBoundsRadius() const { return m_boundsRadius; }
+
+		// coarsest level with error projected to no more than inPixelError pixels
+		uint32_t SelectLod(const glm::mat4& inTransform, const glm::vec3& inViewLocation, float inProjectionScale, float inPixelError = DEFAULT_PIXEL_ERROR) const;
+		// pixels per world unit at distance 1
+		static float GetProjectionScale(float inFovDegrees, float inViewportHeight);
+	private:
+		std::vector<MeshLod> m_lods;
+		glm::vec3 m_boundsCenter;
+		float m_boundsRadius;
+	};
+
+	typedef std::shared_ptr<MeshLodSet> MeshLodSetPtr;
+}
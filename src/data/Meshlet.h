@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+namespace CGE
+{
+	// Cluster of neighbouring triangles stored as a contiguous range of the mesh index buffer, so a run of
+	// visible meshlets is still a single indexed draw. Bounds are in mesh space.
+	struct Meshlet
+	{
+		uint32_t firstIndex;
+		uint32_t triangleCount;
+		// unique vertices referenced by the range, never above MeshletBuilder::MAX_VERTICES
+		uint32_t vertexCount;
+		float radius;
+		glm::vec3 center;
+		// every triangle normal is within acos(sqrt(1 - coneCutoff^2)) of the axis, cutoff 1 disables the cone test
+		float coneCutoff;
+		glm::vec3 coneAxis;
+		uint32_t reserved;
+	};
+	static_assert(sizeof(Meshlet) == 48, "Meshlet is written to cooked files as is");
+}
@@ -52,6 +52,23 @@ namespace CGE
 		DataManager::GetInstance()->DestroyHint(m_id);
 	}
 
+	void Resource::ChangedHint()
+	{
+		DataManager::GetInstance()->ChangedHint(m_id);
+	}
+
+	bool Resource::Load()
+	{
+		return true;
+	}
+
+	std::shared_future<void> Resource::Upload()
+	{
+		std::promise<void> promise;
+		promise.set_value();
+		return promise.get_future().share();
+	}
+
 	bool Resource::IsValid()
 	{
 		return m_isValidFlag;
@@ -2,6 +2,8 @@
 
 #include <string>
 #include <memory>
+#include <future>
+#include <atomic>
 
 #include "core/ObjectBase.h"
 #include "common/HashString.h"
@@ -19,16 +21,26 @@ namespace CGE
 		HashString GetResourceId();
 	
 		virtual bool Create() = 0;
+		// async loading stages, Load runs on a worker thread and should only touch cpu side data,
+		// Create and Upload are called on the main thread afterwards
+		virtual bool Load();
+		virtual std::shared_future<void> Upload();
 		void DestroyHint();
+		// tells snapshot users of this type that the content changed, e.g. after a reload
+		void ChangedHint();
 		bool IsValid();
+		// created by a request and handed out without looking for a load still in flight
+		bool IsReady() const { return m_isReadyFlag.load(std::memory_order_acquire); }
 	protected:
 		friend class DataManager;
 		HashString m_id;
 	
 		void SetValid(bool inValid);
+		void SetReady() { m_isReadyFlag.store(true, std::memory_order_release); }
 		virtual bool Destroy() = 0;
 	private:
 		bool m_isValidFlag = false;
+		std::atomic<bool> m_isReadyFlag{ false };
 	
 		Resource() = delete;
 	};
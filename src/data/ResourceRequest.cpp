@@ -0,0 +1,34 @@
+#include "data/ResourceRequest.h"
+#include <stdexcept>
+
+namespace CGE
+{
+
+	ResourceLoadRequest::ResourceLoadRequest(ResourcePtr inResource, ResourceLoadState inState /*= ResourceLoadState::Queued*/)
+		: m_state(ResourceLoadState::Queued)
+		, m_resource(inResource)
+		, m_loadClaimed(inState != ResourceLoadState::Queued)
+	{
+		m_future = m_promise.get_future().share();
+		m_loaded = m_loadPromise.get_future().share();
+		if (m_loadClaimed)
+		{
+			m_loadPromise.set_value();
+		}
+		SetState(inState);
+	}
+
+	void ResourceLoadRequest::SetState(ResourceLoadState inState)
+	{
+		m_state.store(inState);
+		if (inState == ResourceLoadState::Ready)
+		{
+			m_promise.set_value();
+		}
+		else if (inState == ResourceLoadState::Failed)
+		{
+			m_promise.set_exception(std::make_exception_ptr(std::runtime_error("resource failed to load")));
+		}
+	}
+
+}
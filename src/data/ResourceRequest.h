@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <future>
+
+#include "data/Resource.h"
+
+namespace CGE
+{
+	enum class ResourceLoadState : uint8_t
+	{
+		Queued,
+		Loading,
+		Ready,
+		Failed
+	};
+
+	// Shared state of a single async load. All duplicate requests for the same key get the same
+	// state object, so whoever asked first or last observes the same transitions.
+	class ResourceLoadRequest
+	{
+	public:
+		ResourceLoadRequest(ResourcePtr inResource, ResourceLoadState inState = ResourceLoadState::Queued);
+
+		ResourceLoadState GetState() const { return m_state.load(); }
+		ResourcePtr GetResource() const { return m_resource; }
+		// holds an exception when load failed, waiting on it on the main thread blocks forever since
+		// DataManager finishes loads on the main thread
+		std::shared_future<void> GetFuture() const { return m_future; }
+	protected:
+		friend class DataManager;
+
+		std::atomic<ResourceLoadState> m_state;
+		ResourcePtr m_resource;
+		std::promise<void> m_promise;
+		std::shared_future<void> m_future;
+		std::shared_future<void> m_upload;
+		bool m_loadResult = false;
+		// Load runs once, on a worker or on a thread that needs the resource before the worker got to it
+		std::atomic<bool> m_loadClaimed;
+		std::promise<void> m_loadPromise;
+		std::shared_future<void> m_loaded;
+
+		void SetState(ResourceLoadState inState);
+	};
+
+	typedef std::shared_ptr<ResourceLoadRequest> ResourceLoadRequestPtr;
+
+	//-----------------------------------------------------------------------------------
+
+	template<class T>
+	class ResourceRequest
+	{
+	public:
+		ResourceRequest() {}
+		ResourceRequest(ResourceLoadRequestPtr inRequest) : m_request(inRequest) {}
+
+		// empty request is the one for an empty key, it's considered failed
+		ResourceLoadState GetState() const { return m_request ? m_request->GetState() : ResourceLoadState::Failed; }
+		bool IsReady() const { return GetState() == ResourceLoadState::Ready; }
+		bool IsFailed() const { return GetState() == ResourceLoadState::Failed; }
+		bool IsDone() const { return IsReady() || IsFailed(); }
+
+		// resource is only handed out when it's fully created and uploaded
+		std::shared_ptr<T> Get() const { return IsReady() ? std::dynamic_pointer_cast<T>(m_request->GetResource()) : nullptr; }
+		std::shared_future<void> GetFuture() const { return m_request ? m_request->GetFuture() : std::shared_future<void>(); }
+
+		explicit operator bool() const { return m_request != nullptr; }
+	private:
+		friend class DataManager;
+
+		ResourceLoadRequestPtr m_request;
+	};
+}
@@ -0,0 +1,279 @@
+#include "data/ResourceSlotTable.h"
+#include <algorithm>
+
+namespace CGE
+{
+
+	ResourceSlotTable::ResourceSlotTable()
+	{
+		for (std::atomic<Slot*>& page : m_pages)
+		{
+			page.store(nullptr);
+		}
+	}
+
+	ResourceSlotTable::~ResourceSlotTable()
+	{
+		for (std::atomic<Slot*>& page : m_pages)
+		{
+			delete[] page.load();
+			page.store(nullptr);
+		}
+	}
+
+	ResourceSlotTable::SlotId ResourceSlotTable::Insert(ResourcePtr inResource)
+	{
+		std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+		uint32_t index;
+		if (!m_freeIndices.empty())
+		{
+			index = m_freeIndices.back();
+			m_freeIndices.pop_back();
+		}
+		else
+		{
+			if (m_slotsCount >= PAGE_SIZE * MAX_PAGES)
+			{
+				return SlotId();
+			}
+			index = m_slotsCount++;
+			std::atomic<Slot*>& page = m_pages[index / PAGE_SIZE];
+			if (page.load() == nullptr)
+			{
+				page.store(new Slot[PAGE_SIZE], std::memory_order_release);
+			}
+		}
+
+		Slot* slot = GetSlot(index);
+		slot->owner = inResource;
+		slot->pending = false;
+		slot->resource.store(inResource.get(), std::memory_order_release);
+		++m_liveCount;
+		m_version.fetch_add(1, std::memory_order_acq_rel);
+
+		SlotId id;
+		id.index = index;
+		id.generation = slot->generation.load();
+		return id;
+	}
+
+	ResourcePtr ResourceSlotTable::Remove(SlotId inId)
+	{
+		std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+		Slot* slot = GetSlot(inId.index);
+		if (!slot || !slot->owner || slot->generation.load() != inId.generation)
+		{
+			return nullptr;
+		}
+		return FreeSlot(inId.index, slot);
+	}
+
+	void ResourceSlotTable::Clear(std::vector<ResourcePtr>& outResources)
+	{
+		std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+		for (uint32_t index = 0; index < m_slotsCount; index++)
+		{
+			Slot* slot = GetSlot(index);
+			if (slot->owner)
+			{
+				outResources.push_back(FreeSlot(index, slot));
+			}
+		}
+		m_releaseQueue.clear();
+		DropSnapshot();
+	}
+
+	Resource* ResourceSlotTable::Get(uint32_t inIndex, uint32_t inGeneration) const
+	{
+		Slot* slot = GetSlot(inIndex);
+		if (!slot || slot->generation.load(std::memory_order_acquire) != inGeneration)
+		{
+			return nullptr;
+		}
+		return slot->resource.load(std::memory_order_acquire);
+	}
+
+	ResourcePtr ResourceSlotTable::GetShared(uint32_t inIndex, uint32_t inGeneration)
+	{
+		std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+		Slot* slot = GetSlot(inIndex);
+		if (!slot || slot->generation.load() != inGeneration)
+		{
+			return nullptr;
+		}
+		return slot->owner;
+	}
+
+	void ResourceSlotTable::GetAll(std::vector<ResourcePtr>& outResources)
+	{
+		std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+		outResources.reserve(outResources.size() + m_liveCount);
+		for (uint32_t index = 0; index < m_slotsCount; index++)
+		{
+			Slot* slot = GetSlot(index);
+			if (slot->owner)
+			{
+				outResources.push_back(slot->owner);
+			}
+		}
+	}
+
+	std::shared_ptr<const void> ResourceSlotTable::GetSnapshot(SnapshotBuilder inBuilder, uint64_t& outVersion)
+	{
+		std::shared_ptr<const Snapshot> snapshot = std::atomic_load(&m_snapshot);
+		if (!snapshot || snapshot->version != GetVersion())
+		{
+			std::unique_lock<std::shared_mutex> lock(m_mutex);
+			snapshot = std::atomic_load(&m_snapshot);
+			uint64_t version = GetVersion();
+			if (!snapshot || snapshot->version != version)
+			{
+				std::vector<ResourcePtr> resources;
+				resources.reserve(m_liveCount);
+				for (uint32_t index = 0; index < m_slotsCount; index++)
+				{
+					Slot* slot = GetSlot(index);
+					slot->inSnapshot = slot->owner != nullptr;
+					if (slot->inSnapshot)
+					{
+						resources.push_back(slot->owner);
+					}
+				}
+
+				std::shared_ptr<Snapshot> newSnapshot = std::make_shared<Snapshot>();
+				newSnapshot->version = version;
+				newSnapshot->resources = inBuilder(resources);
+				snapshot = newSnapshot;
+				std::atomic_store(&m_snapshot, snapshot);
+			}
+		}
+
+		outVersion = snapshot->version;
+		return snapshot->resources;
+	}
+
+	uint32_t ResourceSlotTable::GetCount()
+	{
+		std::unique_lock<std::shared_mutex> lock(m_mutex);
+		return m_liveCount;
+	}
+
+	void ResourceSlotTable::ReleaseHint(uint32_t inIndex, uint32_t inGeneration)
+	{
+		std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+		Slot* slot = GetSlot(inIndex);
+		if (slot && slot->owner && slot->generation.load() == inGeneration)
+		{
+			EnqueueRelease(inIndex, slot);
+		}
+	}
+
+	void ResourceSlotTable::Collect(uint64_t inFrame, uint32_t inLatency, uint32_t inSweepCount, std::vector<ResourcePtr>& outFreed)
+	{
+		std::unique_lock<std::shared_mutex> lock(m_mutex);
+		m_frame = inFrame;
+
+		uint32_t sweepCount = std::min(inSweepCount, m_slotsCount);
+		for (uint32_t counter = 0; counter < sweepCount; counter++)
+		{
+			if (m_sweepCursor >= m_slotsCount)
+			{
+				m_sweepCursor = 0;
+			}
+			Slot* slot = GetSlot(m_sweepCursor);
+			if (!slot->pending && IsAbandoned(slot))
+			{
+				EnqueueRelease(m_sweepCursor, slot);
+			}
+			++m_sweepCursor;
+		}
+
+		while (!m_releaseQueue.empty() && (m_releaseQueue.front().frame + inLatency <= inFrame))
+		{
+			PendingRelease release = m_releaseQueue.front();
+			m_releaseQueue.pop_front();
+
+			Slot* slot = GetSlot(release.index);
+			if (!slot->pending || slot->generation.load() != release.generation)
+			{
+				continue;
+			}
+			if (slot->releaseFrame + inLatency > inFrame)
+			{
+				release.frame = slot->releaseFrame;
+				m_releaseQueue.push_back(release);
+				continue;
+			}
+			slot->pending = false;
+			if (IsAbandoned(slot))
+			{
+				outFreed.push_back(FreeSlot(release.index, slot));
+			}
+		}
+	}
+
+	ResourceSlotTable::Slot* ResourceSlotTable::GetSlot(uint32_t inIndex) const
+	{
+		if (inIndex >= PAGE_SIZE * MAX_PAGES)
+		{
+			return nullptr;
+		}
+		Slot* page = m_pages[inIndex / PAGE_SIZE].load(std::memory_order_acquire);
+		return page ? &page[inIndex % PAGE_SIZE] : nullptr;
+	}
+
+	bool ResourceSlotTable::IsAbandoned(Slot* inSlot) const
+	{
+		// the table itself holds one shared reference and the cached snapshot might hold another one
+		long tableReferences = inSlot->inSnapshot ? 2 : 1;
+		return inSlot->owner && (inSlot->owner.use_count() <= tableReferences);
+	}
+
+	void ResourceSlotTable::EnqueueRelease(uint32_t inIndex, Slot* inSlot)
+	{
+		// latency always counts from the latest release, queued entry is pushed back if needed
+		inSlot->releaseFrame = m_frame;
+		if (inSlot->pending)
+		{
+			return;
+		}
+		inSlot->pending = true;
+		m_releaseQueue.push_back({ inIndex, inSlot->generation.load(), m_frame });
+	}
+
+	ResourcePtr ResourceSlotTable::FreeSlot(uint32_t inIndex, Slot* inSlot)
+	{
+		ResourcePtr resource = std::move(inSlot->owner);
+		inSlot->owner = nullptr;
+		inSlot->resource.store(nullptr, std::memory_order_release);
+		uint32_t generation = inSlot->generation.load() + 1;
+		// zero is never a valid generation so default ids can't match anything
+		inSlot->generation.store(generation == 0 ? 1 : generation, std::memory_order_release);
+		inSlot->pending = false;
+		m_freeIndices.push_back(inIndex);
+		--m_liveCount;
+		m_version.fetch_add(1, std::memory_order_acq_rel);
+		// stale snapshot would keep the freed resource alive
+		if (inSlot->inSnapshot)
+		{
+			DropSnapshot();
+		}
+		return resource;
+	}
+
+	void ResourceSlotTable::DropSnapshot()
+	{
+		std::atomic_store(&m_snapshot, std::shared_ptr<const Snapshot>());
+		for (uint32_t index = 0; index < m_slotsCount; index++)
+		{
+			GetSlot(index)->inSnapshot = false;
+		}
+	}
+
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+#include <cstdint>
+
+#include "data/Resource.h"
+
+namespace CGE
+{
+	// Dense per type storage of resources addressed by index and generation. Slots live in pages that
+	// are never moved or freed while the table is alive, so a reader holding a valid index can check the
+	// generation and take the resource without locks. Slot is kept alive by shared_ptr owners outside of
+	// the table, when they are gone the slot goes to the release queue and is reclaimed after a fixed
+	// number of frames.
+	class ResourceSlotTable
+	{
+	public:
+		static constexpr uint32_t PAGE_SIZE = 1024;
+		static constexpr uint32_t MAX_PAGES = 256;
+		static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+		struct SlotId
+		{
+			uint32_t index = INVALID_INDEX;
+			uint32_t generation = 0;
+		};
+
+		ResourceSlotTable();
+		~ResourceSlotTable();
+
+		SlotId Insert(ResourcePtr inResource);
+		// frees the slot right away, ids still pointing to it become invalid
+		ResourcePtr Remove(SlotId inId);
+		void Clear(std::vector<ResourcePtr>& outResources);
+
+		// lock free, the result is only safe to use while some reference keeps the slot alive
+		Resource* Get(uint32_t inIndex, uint32_t inGeneration) const;
+		ResourcePtr GetShared(uint32_t inIndex, uint32_t inGeneration);
+		void GetAll(std::vector<ResourcePtr>& outResources);
+		uint32_t GetCount();
+
+		// bumped every time the set of live resources or the content of one of them changes
+		uint64_t GetVersion() const { return m_version.load(std::memory_order_acquire); }
+		// resource kept its slot but its content changed, bumps the version so snapshot users rebuild
+		void MarkChanged() { m_version.fetch_add(1, std::memory_order_acq_rel); }
+		// cached typed copy of all live resources, the builder is only called when the version changed
+		// since the last call, otherwise the cached one is returned without locking the table
+		typedef std::shared_ptr<const void>(*SnapshotBuilder)(const std::vector<ResourcePtr>&);
+		std::shared_ptr<const void> GetSnapshot(SnapshotBuilder inBuilder, uint64_t& outVersion);
+
+		void ReleaseHint(uint32_t inIndex, uint32_t inGeneration);
+
+		// reclaims slots released at least inLatency frames ago and sweeps inSweepCount slots looking
+		// for ones nobody references anymore, a full sweep takes slots count / inSweepCount frames
+		void Collect(uint64_t inFrame, uint32_t inLatency, uint32_t inSweepCount, std::vector<ResourcePtr>& outFreed);
+	private:
+		struct Slot
+		{
+			std::atomic<uint32_t> generation{ 1 };
+			std::atomic<Resource*> resource{ nullptr };
+			ResourcePtr owner;
+			uint64_t releaseFrame = 0;
+			bool pending = false;
+			// cached snapshot holds one more shared reference
+			bool inSnapshot = false;
+		};
+
+		struct Snapshot
+		{
+			uint64_t version;
+			std::shared_ptr<const void> resources;
+		};
+
+		struct PendingRelease
+		{
+			uint32_t index;
+			uint32_t generation;
+			uint64_t frame;
+		};
+
+		std::shared_mutex m_mutex;
+		std::array<std::atomic<Slot*>, MAX_PAGES> m_pages;
+		uint32_t m_slotsCount = 0;
+		uint32_t m_liveCount = 0;
+		std::vector<uint32_t> m_freeIndices;
+		std::deque<PendingRelease> m_releaseQueue;
+		uint64_t m_frame = 0;
+		uint32_t m_sweepCursor = 0;
+		std::atomic<uint64_t> m_version{ 1 };
+		std::shared_ptr<const Snapshot> m_snapshot;
+
+		ResourceSlotTable(const ResourceSlotTable& inOther) = delete;
+		void operator=(const ResourceSlotTable& inOther) = delete;
+
+		Slot* GetSlot(uint32_t inIndex) const;
+		bool IsAbandoned(Slot* inSlot) const;
+		void EnqueueRelease(uint32_t inIndex, Slot* inSlot);
+		ResourcePtr FreeSlot(uint32_t inIndex, Slot* inSlot);
+		void DropSnapshot();
+	};
+}
@@ -16,6 +16,7 @@ namespace CGE
 
 	void RtMaterial::LoadResources()
 	{
+		bool loaded = false;
 		for (uint8_t idx = 0; idx < static_cast<uint8_t>(ERtShaderType::RST_MAX); idx++)
 		{
 			RtShaderRecord& rec = m_shaderRecords[idx];
@@ -25,14 +26,26 @@ namespace CGE
 			}
 			RtShaderPtr shader = DataManager::RequestResourceType<RtShader>(rec.path, FromInt(idx));
 			rec.shader = shader;
+			loaded = true;
+		}
+		if (loaded)
+		{
+			ChangedHint();
 		}
 	}
 
 	void RtMaterial::SetShader(ERtShaderType type, std::string path, std::string entrypoint)
 	{
 		RtShaderRecord& rec = m_shaderRecords[static_cast<uint8_t>(type)];
+		if (rec.path == path && rec.entrypoint == entrypoint)
+		{
+			return;
+		}
 		rec.path = path;
 		rec.entrypoint = entrypoint;
+		// picked up by the next LoadResources
+		rec.shader = nullptr;
+		ChangedHint();
 	}
 
 	RtShaderPtr RtMaterial::GetShader(ERtShaderType type)
@@ -5,6 +5,7 @@
 
 #include "Resource.h"
 #include "render/shader/RtShader.h"
+#include "render/shader/ShaderPermutation.h"
 
 namespace CGE
 {
@@ -20,6 +21,14 @@ namespace CGE
 		void SetShader(ERtShaderType type, std::string path, std::string entrypoint);
 		RtShaderPtr GetShader(ERtShaderType type);
 		bool HasHitGroup();
+		// specialization constants of every shader in the material, the sbt adds a stage per permutation
+		template<typename T>
+		void SetFeature(const std::string& inName, T inValue)
+		{
+			m_features.Set(inName, inValue);
+			ChangedHint();
+		}
+		const ShaderFeatures& GetFeatures() const { return m_features; }
 
 		bool Create() override;
 	private:
@@ -31,6 +40,7 @@ namespace CGE
 		};
 
 		std::array<RtShaderRecord, static_cast<uint8_t>(ERtShaderType::RST_MAX)> m_shaderRecords;
+		ShaderFeatures m_features;
 	protected:
 		bool Destroy() override;
 
@@ -22,11 +22,11 @@ namespace CGE
 		ImageCreateInfo createInfo;
 	
 		createInfo.setArrayLayers(1);
-		createInfo.setFormat(Format::eR8G8B8A8Unorm);
+		createInfo.setFormat(GetImageFormat());
 		createInfo.setImageType(vk::ImageType::e2D);
 		createInfo.setInitialLayout(ImageLayout::eUndefined);
 		createInfo.setSamples(vk::SampleCountFlagBits::e1);
-		createInfo.setMipLevels(genMips ? 12 : 1); // 12 just in case
+		createInfo.setMipLevels(GetImageMips());
 		createInfo.setSharingMode(SharingMode::eExclusive);
 		// ignored if exclusive mode is used, see Vulkan 1.2 spec
 		//createInfo.setQueueFamilyIndexCount(1); 
@@ -43,5 +43,11 @@ namespace CGE
 	{
 		return image.CreateView(range, ImageViewType::e2D);
 	}
+
+	std::shared_ptr<TextureData> Texture2D::CreateEmptyCopy(const HashString& inId)
+	{
+		// not a NewObject, copies aren't registered in the data manager
+		return std::make_shared<Texture2D>(inId, useAlpha, flipVertical, linear, genMips);
+	}
 	
 }
@@ -13,6 +13,7 @@ namespace CGE
 	protected:
 		ImageCreateInfo GetImageInfo() override;
 		ImageView CreateImageView(ImageSubresourceRange range) override;
+		std::shared_ptr<TextureData> CreateEmptyCopy(const HashString& inId) override;
 	private:
 		Texture2D();
 	};
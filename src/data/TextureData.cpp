@@ -1,8 +1,14 @@
 #include "TextureData.h"
-#include "stb/stb_image.h"
 #include "core/Engine.h"
 #include "render/Renderer.h"
 #include "utils/ResourceUtils.h"
+#include "render/TransferList.h"
+#include "import/CookedMesh.h"
+#include "import/TextureCooker.h"
+#include "render/TextureStreamer.h"
+#include "render/TextureResidencyPolicy.h"
+#include "utils/Singleton.h"
+#include <algorithm>
 
 namespace CGE
 {
@@ -10,7 +16,7 @@ namespace CGE
 
 	namespace
 	{
-		static const int DESIRED_CHANNELS_COUNT = 4;
+		static const std::string COOKED_EXTENSION = ".cooked";
 	};
 	
 	TextureData::TextureData(const HashString& inPath, bool inUsesAlpha /*= false*/, bool inFlipVertical /*= true*/, bool inLinear /*= true*/, bool inGenMips /*= true*/)
@@ -31,27 +37,197 @@ namespace CGE
 		Destroy();
 	}
 	
+	bool TextureData::Load()
+	{
+		if (m_cooked || !m_pixels.empty())
+		{
+			return true;
+		}
+
+		TextureCookSettings settings;
+		settings.flipVertical = flipVertical;
+		settings.srgb = !linear;
+		settings.useAlpha = useAlpha;
+		// linear textures are the tangent space normal maps
+		settings.normalMap = linear;
+		settings.genMips = genMips;
+		settings.compress = Engine::GetRendererInstance()->GetVulkanDevice().GetPhysicalDevice().GetFeatures().textureCompressionBC == VK_TRUE;
+
+		uint64_t sourceHash = CookedMesh::HashFile(path, TextureCooker::GetCookedSeed(settings));
+		if (sourceHash == 0)
+		{
+			return false;
+		}
+
+		std::string cookedPath = path + COOKED_EXTENSION;
+		CookedTexturePtr cooked = std::make_shared<CookedTexture>();
+		if (!cooked->Open(cookedPath, sourceHash))
+		{
+			TextureCooker cooker;
+			if (!cooker.Cook(path, cookedPath, sourceHash, settings) || !cooked->Open(cookedPath, sourceHash))
+			{
+				cooked = nullptr;
+			}
+		}
+
+		m_mipRegions.clear();
+		if (cooked)
+		{
+			const CookedTextureHeader& header = cooked->GetHeader();
+			m_format = header.format;
+			m_prebuiltMips = true;
+			m_cooked = cooked;
+			// only the tail goes in with the texture, TextureStreamer brings the rest when something needs it
+			uint32_t tailMip = TextureResidencyPolicy::GetTailMip(header.width, header.height, cooked->GetMipCount());
+			m_streamed = tailMip > 0;
+			SetResidentMip(tailMip);
+			return true;
+		}
+
+		// cooked file couldn't be written, mips are generated on the gpu as before
+		uint32_t decodedWidth, decodedHeight;
+		if (!TextureCooker::Decode(path, flipVertical, m_pixels, decodedWidth, decodedHeight))
+		{
+			return false;
+		}
+		width = static_cast<int>(decodedWidth);
+		height = static_cast<int>(decodedHeight);
+		m_format = ECookedTextureFormat::CTF_RGBA8;
+		m_mipRegions.push_back({ 0, decodedWidth, decodedHeight, decodedWidth * TextureCooker::CHANNELS_COUNT, decodedHeight, 1 });
+		m_prebuiltMips = false;
+
+		return true;
+	}
+
 	bool TextureData::Create()
 	{
-		unsigned char* data;
-		stbi_set_flip_vertically_on_load(flipVertical);
-		data = stbi_load(path.c_str(), &width, &height, &numChannels, DESIRED_CHANNELS_COUNT);
-	
-		if (data == nullptr)
+		if (!Load())
 		{
 			return false;
 		}
 	
-		VulkanDevice& device = Engine::GetRendererInstance()->GetVulkanDevice();
-		image.createInfo = GetImageInfo();
-		image.Create();
-		m_staging = CreateStagingBuffer(reinterpret_cast<char*>(data));
-		imageView = CreateImageView(ImageSubresourceRange(ImageAspectFlagBits::eColor, 0, image.GetMips(), 0, 1));
+		CreateDeviceObjects();
 	
-		stbi_image_free(data);
+		// streamed textures read their other mips from the mapped file later
+		if (!m_streamed)
+		{
+			m_cooked = nullptr;
+		}
+		std::vector<uint8_t>().swap(m_pixels);
+
+		if (m_streamed)
+		{
+			Singleton<TextureStreamer>::GetInstance()->Register(get_shared_from_this<TextureData>());
+		}
 	
 		return true;
 	}
+
+	std::vector<uint64_t> TextureData::GetMipSizes() const
+	{
+		std::vector<uint64_t> sizes;
+		for (uint32_t mipIndex = 0; m_cooked && (mipIndex < m_cooked->GetMipCount()); mipIndex++)
+		{
+			sizes.push_back(m_cooked->GetMip(mipIndex).size);
+		}
+		return sizes;
+	}
+
+	std::shared_ptr<TextureData> TextureData::CreateResidencyTarget(uint32_t inMip)
+	{
+		if (!m_cooked || (inMip >= m_cooked->GetMipCount()))
+		{
+			return nullptr;
+		}
+
+		// unique ids, staging buffers are named after them and an old one could still be waiting for collection
+		std::shared_ptr<TextureData> target = CreateEmptyCopy(HashString(path + "_residency_" + std::to_string(++m_residencyTargetCount)));
+		target->m_cooked = m_cooked;
+		target->m_format = m_format;
+		target->m_prebuiltMips = true;
+		target->SetResidentMip(inMip);
+		target->CreateDeviceObjects();
+		return target;
+	}
+
+	void TextureData::SwapResidency(std::shared_ptr<TextureData> inTarget)
+	{
+		std::swap(image, inTarget->image);
+		std::swap(imageView, inTarget->imageView);
+		std::swap(m_mipRegions, inTarget->m_mipRegions);
+		std::swap(m_residentMip, inTarget->m_residentMip);
+		std::swap(width, inTarget->width);
+		std::swap(height, inTarget->height);
+		m_residencyVersion++;
+	}
+
+	std::shared_ptr<TextureData> TextureData::CreateReloadTarget()
+	{
+		std::shared_ptr<TextureData> target = CreateEmptyCopy(HashString(path + "_reload_" + std::to_string(++m_reloadTargetCount)));
+		target->path = path;
+		return target;
+	}
+
+	void TextureData::PrepareReload(std::shared_ptr<TextureData> inTarget)
+	{
+		inTarget->CreateDeviceObjects();
+		std::vector<uint8_t>().swap(inTarget->m_pixels);
+	}
+
+	void TextureData::ApplyReload(std::shared_ptr<TextureData> inTarget)
+	{
+		std::swap(image, inTarget->image);
+		std::swap(imageView, inTarget->imageView);
+		std::swap(m_mipRegions, inTarget->m_mipRegions);
+		std::swap(m_residentMip, inTarget->m_residentMip);
+		std::swap(width, inTarget->width);
+		std::swap(height, inTarget->height);
+		std::swap(m_cooked, inTarget->m_cooked);
+		std::swap(m_format, inTarget->m_format);
+		std::swap(m_prebuiltMips, inTarget->m_prebuiltMips);
+		std::swap(m_streamed, inTarget->m_streamed);
+		m_residencyVersion++;
+
+		// mip sizes could be different now, the streamer starts over with the new tail
+		TextureStreamer* streamer = Singleton<TextureStreamer>::GetInstance();
+		streamer->Unregister(this);
+		if (m_streamed)
+		{
+			streamer->Register(get_shared_from_this<TextureData>());
+		}
+		else
+		{
+			m_cooked = nullptr;
+		}
+	}
+
+	void TextureData::CreateDeviceObjects()
+	{
+		image.createInfo = GetImageInfo();
+		image.Create();
+		// cooked blob has the staging layout already and mips go from the smallest one, so the chain from the
+		// resident mip is a prefix of it and it's a single copy out of the mapped file
+		m_staging = CreateStagingBuffer(m_cooked ? m_cooked->GetData() : m_pixels.data());
+		imageView = CreateImageView(ImageSubresourceRange(ImageAspectFlagBits::eColor, 0, image.GetMips(), 0, 1));
+	}
+
+	void TextureData::SetResidentMip(uint32_t inMip)
+	{
+		m_mipRegions.clear();
+		for (uint32_t mipIndex = inMip; mipIndex < m_cooked->GetMipCount(); mipIndex++)
+		{
+			const CookedTextureMip& mip = m_cooked->GetMip(mipIndex);
+			m_mipRegions.push_back({ mip.offset, mip.width, mip.height, mip.rowPitch, mip.rowCount, CookedTexture::GetBlockDimension(m_format) });
+		}
+		width = static_cast<int>(m_cooked->GetMip(inMip).width);
+		height = static_cast<int>(m_cooked->GetMip(inMip).height);
+		m_residentMip = inMip;
+	}
+
+	std::shared_future<void> TextureData::Upload()
+	{
+		return TransferList::GetInstance()->PushImage(get_shared_from_this<TextureData>());
+	}
 	
 	bool TextureData::Destroy()
 	{
@@ -114,9 +290,98 @@ namespace CGE
 		return descriptorInfo;
 	}
 
-	BufferDataPtr TextureData::CreateStagingBuffer(char* inData)
+	DeviceSize TextureData::GetStagingSize()
+	{
+		DeviceSize size = 0;
+		for (const TextureMipRegion& region : m_mipRegions)
+		{
+			size = std::max(size, region.offset + static_cast<DeviceSize>(region.rowPitch) * region.rowCount);
+		}
+		return size;
+	}
+
+	DeviceSize TextureData::GetStagingRowPitch()
+	{
+		return m_mipRegions.empty() ? 0 : m_mipRegions[0].rowPitch;
+	}
+
+	std::vector<BufferImageCopy> TextureData::CreateStagingCopies(DeviceSize inOffset, DeviceSize inSize)
+	{
+		std::vector<BufferImageCopy> copies;
+		DeviceSize end = inOffset + inSize;
+		for (uint32_t mipIndex = 0; mipIndex < m_mipRegions.size(); mipIndex++)
+		{
+			const TextureMipRegion& region = m_mipRegions[mipIndex];
+			DeviceSize firstRow = inOffset > region.offset ? (inOffset - region.offset) / region.rowPitch : 0;
+			DeviceSize endRow = end > region.offset ? std::min<DeviceSize>((end - region.offset) / region.rowPitch, region.rowCount) : 0;
+			if (firstRow >= endRow)
+			{
+				continue;
+			}
+
+			// the last row of blocks may stick out of the mip
+			uint32_t firstTexelRow = static_cast<uint32_t>(firstRow) * region.rowHeight;
+			uint32_t texelRows = std::min(static_cast<uint32_t>(endRow) * region.rowHeight, region.height) - firstTexelRow;
+			copies.push_back(image.CreateBufferImageCopy(region.offset + firstRow * region.rowPitch, mipIndex, firstTexelRow, texelRows));
+		}
+		return copies;
+	}
+
+	std::vector<BufferImageCopy> TextureData::CreatePlaceholderCopies(DeviceSize inRowSize)
+	{
+		std::vector<BufferImageCopy> copies;
+		uint32_t blockDimension = CookedTexture::GetBlockDimension(m_format);
+		uint32_t blocksPerCopy = static_cast<uint32_t>(inRowSize / CookedTexture::GetBlockSize(m_format));
+		for (uint32_t mipIndex = 0; mipIndex < m_mipRegions.size(); mipIndex++)
+		{
+			const TextureMipRegion& region = m_mipRegions[mipIndex];
+			uint32_t texelsPerCopy = blocksPerCopy * blockDimension;
+			for (uint32_t row = 0; row < region.rowCount; row++)
+			{
+				uint32_t firstTexelRow = row * region.rowHeight;
+				uint32_t texelRows = std::min(region.rowHeight, region.height - firstTexelRow);
+				for (uint32_t x = 0; x < region.width; x += texelsPerCopy)
+				{
+					BufferImageCopy copy = image.CreateBufferImageCopy(0, mipIndex, firstTexelRow, texelRows);
+					copy.imageOffset.setX(static_cast<int32_t>(x));
+					copy.imageExtent.setWidth(std::min(texelsPerCopy, region.width - x));
+					copies.push_back(copy);
+				}
+			}
+		}
+		return copies;
+	}
+
+	vk::Format TextureData::GetImageFormat() const
+	{
+		// srgb data is kept in unorm formats, lighting and post process expect the raw values
+		switch (m_format)
+		{
+		case ECookedTextureFormat::CTF_BC1:
+			return vk::Format::eBc1RgbUnormBlock;
+		case ECookedTextureFormat::CTF_BC4:
+			return vk::Format::eBc4UnormBlock;
+		case ECookedTextureFormat::CTF_BC5:
+			return vk::Format::eBc5UnormBlock;
+		case ECookedTextureFormat::CTF_BC7:
+			return vk::Format::eBc7UnormBlock;
+		default:
+			return vk::Format::eR8G8B8A8Unorm;
+		}
+	}
+
+	uint32_t TextureData::GetImageMips() const
+	{
+		if (m_prebuiltMips)
+		{
+			return static_cast<uint32_t>(m_mipRegions.size());
+		}
+		return genMips ? 12 : 1; // 12 just in case
+	}
+
+	BufferDataPtr TextureData::CreateStagingBuffer(const uint8_t* inData)
 	{
-		DeviceSize size = image.GetWidth() * image.GetHeight() * image.GetDepth() * 4;//memoryRequirements.size;//
+		DeviceSize size = GetStagingSize();//memoryRequirements.size;//
 
 		BufferDataPtr buffer = ResourceUtils::CreateBufferData(
 			GetResourceId() + HashString("_staging"),
@@ -124,7 +389,7 @@ namespace CGE
 			vk::BufferUsageFlagBits::eTransferSrc,
 			false
 		);
-		buffer->CopyTo(size, inData);
+		buffer->CopyTo(size, reinterpret_cast<const char*>(inData));
 		return buffer;
 	}
 
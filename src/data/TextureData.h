@@ -2,12 +2,25 @@
 
 #include "data/Resource.h"
 #include "render/resources/VulkanImage.h"
+#include "import/CookedTexture.h"
 #include <string>
+#include <vector>
 #include <memory>
 #include "BufferData.h"
 
 namespace CGE
 {
+	// placement of one mip in the staging buffer, rows are rows of blocks for compressed formats
+	struct TextureMipRegion
+	{
+		DeviceSize offset;
+		uint32_t width;
+		uint32_t height;
+		uint32_t rowPitch;
+		uint32_t rowCount;
+		uint32_t rowHeight;
+	};
+
 	class TextureData : public Resource
 	{
 	public:
@@ -15,6 +28,8 @@ namespace CGE
 		virtual ~TextureData();
 	
 		virtual bool Create() override;
+		virtual bool Load() override;
+		virtual std::shared_future<void> Upload() override;
 	
 		void CreateFromExternal(const VulkanImage& inImage, ImageView inImageView, bool inCleanup = false);
 		void CreateFromExternal(std::shared_ptr<TextureData> texture, bool inCleanup = false);
@@ -26,12 +41,54 @@ namespace CGE
 		vk::DescriptorImageInfo GetDescriptorInfo(vk::ImageLayout layout) const;
 
 		BufferDataPtr GetStagingBuffer() { return m_staging; }
+		DeviceSize GetStagingSize();
+		DeviceSize GetStagingRowPitch();
 		void DiscardStaging() { m_staging = nullptr; }
+		// every row of every mip goes to the copies of the byte range holding its last byte
+		std::vector<BufferImageCopy> CreateStagingCopies(DeviceSize inOffset, DeviceSize inSize);
+		// compressed images can't be cleared, placeholders are copied block row by block row from a buffer
+		// holding inRowSize bytes of repeated placeholder blocks
+		std::vector<BufferImageCopy> CreatePlaceholderCopies(DeviceSize inRowSize);
+
+		ECookedTextureFormat GetFormat() const { return m_format; }
+		bool IsCompressed() const { return m_format != ECookedTextureFormat::CTF_RGBA8; }
+		// cooked textures come with the whole mip chain, nothing is generated on the gpu
+		bool HasPrebuiltMips() const { return m_prebuiltMips; }
+
+		// streamed textures keep the cooked file mapped and hold mips from the resident one, image mip 0 is that mip
+		bool IsStreamed() const { return m_streamed; }
+		uint32_t GetResidentMip() const { return m_residentMip; }
+		uint32_t GetMipCount() const { return m_cooked ? m_cooked->GetMipCount() : static_cast<uint32_t>(m_mipRegions.size()); }
+		std::vector<uint64_t> GetMipSizes() const;
+		// bumped every time streaming swaps the image, descriptors holding the old view have to be written again
+		uint32_t GetResidencyVersion() const { return m_residencyVersion; }
+		// separate texture with the chain from inMip, it's uploaded through the transfer list and swapped in when done
+		std::shared_ptr<TextureData> CreateResidencyTarget(uint32_t inMip);
+		// takes the image of an uploaded residency target, the target gets the old one to be destroyed later
+		void SwapResidency(std::shared_ptr<TextureData> inTarget);
+		// hot reload goes the same way: an unloaded copy reading the same file, Load on a worker, device
+		// objects on the main thread, then everything is taken over once the copy is uploaded
+		std::shared_ptr<TextureData> CreateReloadTarget();
+		void PrepareReload(std::shared_ptr<TextureData> inTarget);
+		// nothing may use the old image anymore, it goes to the target to be destroyed with it
+		void ApplyReload(std::shared_ptr<TextureData> inTarget);
 	protected:
 		VulkanImage image;
 		ImageView imageView;
 		vk::DescriptorImageInfo descriptorInfo;
 		BufferDataPtr m_staging;
+		// mapped cooked file waiting for Create
+		CookedTexturePtr m_cooked;
+		// decoded pixels waiting for Create when there's no cooked file, always 4 channels per pixel
+		std::vector<uint8_t> m_pixels;
+		ECookedTextureFormat m_format = ECookedTextureFormat::CTF_RGBA8;
+		std::vector<TextureMipRegion> m_mipRegions;
+		bool m_prebuiltMips = false;
+		bool m_streamed = false;
+		uint32_t m_residentMip = 0;
+		uint32_t m_residencyVersion = 0;
+		uint32_t m_residencyTargetCount = 0;
+		uint32_t m_reloadTargetCount = 0;
 	
 		std::string path;
 		bool useAlpha;
@@ -42,16 +99,23 @@ namespace CGE
 	
 		int width;
 		int height;
-		int numChannels;
 	
+		vk::Format GetImageFormat() const;
+		uint32_t GetImageMips() const;
+
 		virtual ImageCreateInfo GetImageInfo() = 0;
 		virtual ImageView CreateImageView(ImageSubresourceRange range) = 0;
+		// same kind of texture with nothing loaded, residency targets are made from it
+		virtual std::shared_ptr<TextureData> CreateEmptyCopy(const HashString& inId) = 0;
 
 		virtual bool Destroy() override;
 	private:
 		TextureData() = delete;
 
-		BufferDataPtr CreateStagingBuffer(char* inData);
+		BufferDataPtr CreateStagingBuffer(const uint8_t* inData);
+		void CreateDeviceObjects();
+		// mip regions, size and image mips for the chain from inMip of the cooked file
+		void SetResidentMip(uint32_t inMip);
 	};
 
 	typedef std::shared_ptr<TextureData> TextureDataPtr;
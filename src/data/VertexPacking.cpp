@@ -0,0 +1,174 @@
+#include "data/VertexPacking.h"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/packing.hpp>
+
+namespace CGE
+{
+	namespace
+	{
+		static constexpr float MIN_EXTENT = 1e-6f;
+		static constexpr float MIN_DIRECTION_LENGTH = 1e-6f;
+
+		glm::vec2 SignNotZero(const glm::vec2& inValue)
+		{
+			return glm::vec2(inValue.x >= 0.0f ? 1.0f : -1.0f, inValue.y >= 0.0f ? 1.0f : -1.0f);
+		}
+
+		// rounding both components to nearest is not always the closest direction, so every floor/ceil pair is tried
+		void PackDirection(const glm::vec3& inDirection, int16_t* outPacked)
+		{
+			glm::vec2 encoded = VertexPacking::OctahedralEncode(inDirection) * 32767.0f;
+			float bestDot = -2.0f;
+			for (uint32_t candidate = 0; candidate < 4; candidate++)
+			{
+				glm::vec2 quantized(
+					(candidate & 1) ? std::ceil(encoded.x) : std::floor(encoded.x),
+					(candidate & 2) ? std::ceil(encoded.y) : std::floor(encoded.y));
+				quantized = glm::clamp(quantized, glm::vec2(-32767.0f), glm::vec2(32767.0f));
+				float dot = glm::dot(inDirection, VertexPacking::OctahedralDecode(quantized / 32767.0f));
+				if (dot > bestDot)
+				{
+					bestDot = dot;
+					outPacked[0] = static_cast<int16_t>(quantized.x);
+					outPacked[1] = static_cast<int16_t>(quantized.y);
+				}
+			}
+		}
+
+		glm::vec3 UnpackDirection(const int16_t* inPacked)
+		{
+			return VertexPacking::OctahedralDecode(glm::vec2(glm::unpackSnorm1x16(static_cast<uint16_t>(inPacked[0])), glm::unpackSnorm1x16(static_cast<uint16_t>(inPacked[1]))));
+		}
+
+		// acos loses all precision for nearly parallel vectors
+		float GetAngle(const glm::vec3& inFirst, const glm::vec3& inSecond)
+		{
+			return std::atan2(glm::length(glm::cross(inFirst, inSecond)), glm::dot(inFirst, inSecond));
+		}
+	}
+
+	VertexQuantization VertexQuantization::FromBounds(const glm::vec3& inMin, const glm::vec3& inMax)
+	{
+		VertexQuantization quantization;
+		quantization.center = (inMin + inMax) * 0.5f;
+		quantization.extent = glm::max((inMax - inMin) * 0.5f, glm::vec3(MIN_EXTENT));
+		return quantization;
+	}
+
+	void VertexPackingError::Append(const VertexPackingError& inOther)
+	{
+		position = std::max(position, inOther.position);
+		normal = std::max(normal, inOther.normal);
+		tangent = std::max(tangent, inOther.tangent);
+		texCoord = std::max(texCoord, inOther.texCoord);
+		bitangentFlips += inOther.bitangentFlips;
+	}
+
+	bool VertexPackingError::IsWithinBounds() const
+	{
+		return (position <= VertexPacking::POSITION_ERROR_BOUND)
+			&& (normal <= VertexPacking::DIRECTION_ERROR_BOUND)
+			&& (tangent <= VertexPacking::DIRECTION_ERROR_BOUND)
+			&& (texCoord <= VertexPacking::TEXCOORD_ERROR_BOUND)
+			&& (bitangentFlips == 0);
+	}
+
+	glm::vec2 VertexPacking::OctahedralEncode(const glm::vec3& inDirection)
+	{
+		float length = std::abs(inDirection.x) + std::abs(inDirection.y) + std::abs(inDirection.z);
+		if (length < MIN_DIRECTION_LENGTH)
+		{
+			return glm::vec2(0.0f);
+		}
+		glm::vec3 direction = inDirection / length;
+		glm::vec2 encoded(direction.x, direction.y);
+		if (direction.z < 0.0f)
+		{
+			encoded = (1.0f - glm::abs(glm::vec2(encoded.y, encoded.x))) * SignNotZero(encoded);
+		}
+		return encoded;
+	}
+
+	glm::vec3 VertexPacking::OctahedralDecode(const glm::vec2& inEncoded)
+	{
+		glm::vec3 direction(inEncoded.x, inEncoded.y, 1.0f - std::abs(inEncoded.x) - std::abs(inEncoded.y));
+		if (direction.z < 0.0f)
+		{
+			glm::vec2 folded = (1.0f - glm::abs(glm::vec2(direction.y, direction.x))) * SignNotZero(glm::vec2(direction.x, direction.y));
+			direction.x = folded.x;
+			direction.y = folded.y;
+		}
+		return glm::normalize(direction);
+	}
+
+	CompactVertex VertexPacking::Pack(const UnpackedVertex& inVertex, const VertexQuantization& inQuantization)
+	{
+		CompactVertex packed;
+
+		glm::vec3 position = (inVertex.position - inQuantization.center) / inQuantization.extent;
+		for (uint32_t axis = 0; axis < 3; axis++)
+		{
+			packed.position[axis] = static_cast<int16_t>(glm::packSnorm1x16(position[axis]));
+		}
+		float handedness = glm::dot(glm::cross(inVertex.normal, inVertex.tangent), inVertex.bitangent);
+		packed.position[3] = handedness < 0.0f ? -32767 : 32767;
+
+		PackDirection(inVertex.normal, packed.normal);
+		PackDirection(inVertex.tangent, packed.tangent);
+
+		packed.texCoord[0] = glm::packHalf1x16(inVertex.texCoord.x);
+		packed.texCoord[1] = glm::packHalf1x16(inVertex.texCoord.y);
+
+		return packed;
+	}
+
+	UnpackedVertex VertexPacking::Unpack(const CompactVertex& inVertex, const VertexQuantization& inQuantization)
+	{
+		UnpackedVertex unpacked;
+
+		glm::vec3 position;
+		for (uint32_t axis = 0; axis < 3; axis++)
+		{
+			position[axis] = glm::unpackSnorm1x16(static_cast<uint16_t>(inVertex.position[axis]));
+		}
+		unpacked.position = inQuantization.center + position * inQuantization.extent;
+
+		unpacked.normal = UnpackDirection(inVertex.normal);
+		unpacked.tangent = UnpackDirection(inVertex.tangent);
+		float handedness = inVertex.position[3] < 0 ? -1.0f : 1.0f;
+		unpacked.bitangent = glm::cross(unpacked.normal, unpacked.tangent) * handedness;
+
+		unpacked.texCoord.x = glm::unpackHalf1x16(inVertex.texCoord[0]);
+		unpacked.texCoord.y = glm::unpackHalf1x16(inVertex.texCoord[1]);
+
+		return unpacked;
+	}
+
+	VertexPackingError VertexPacking::MeasureError(const UnpackedVertex& inVertex, const VertexQuantization& inQuantization)
+	{
+		UnpackedVertex unpacked = Unpack(Pack(inVertex, inQuantization), inQuantization);
+
+		VertexPackingError error;
+		glm::vec3 positionError = glm::abs(unpacked.position - inVertex.position) / inQuantization.extent;
+		error.position = std::max(positionError.x, std::max(positionError.y, positionError.z));
+		// degenerate directions from meshes without normals or tangents carry no information to lose
+		if (glm::length(inVertex.normal) > MIN_DIRECTION_LENGTH)
+		{
+			error.normal = GetAngle(glm::normalize(inVertex.normal), unpacked.normal);
+		}
+		if (glm::length(inVertex.tangent) > MIN_DIRECTION_LENGTH)
+		{
+			error.tangent = GetAngle(glm::normalize(inVertex.tangent), unpacked.tangent);
+		}
+		if ((glm::length(inVertex.bitangent) > MIN_DIRECTION_LENGTH) && (glm::dot(inVertex.bitangent, unpacked.bitangent) < 0.0f))
+		{
+			error.bitangentFlips = 1;
+		}
+		glm::vec2 texCoordError = glm::abs(unpacked.texCoord - inVertex.texCoord) / glm::max(glm::abs(inVertex.texCoord), glm::vec2(1.0f));
+		error.texCoord = std::max(texCoordError.x, texCoordError.y);
+
+		return error;
+	}
+}
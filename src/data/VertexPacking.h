@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+namespace CGE
+{
+	// Positions are stored relative to the mesh bounds: position = center + quantized * extent
+	struct VertexQuantization
+	{
+		glm::vec3 center = glm::vec3(0.0f);
+		glm::vec3 extent = glm::vec3(1.0f);
+
+		static VertexQuantization FromBounds(const glm::vec3& inMin, const glm::vec3& inMax);
+	};
+
+	// 20 bytes against 56 of the full Vertex:
+	// position - snorm16 xyz in mesh bounds, w holds the bitangent sign
+	// normal, tangent - octahedral snorm16
+	// texCoord - half floats
+	struct CompactVertex
+	{
+		int16_t position[4];
+		int16_t normal[2];
+		int16_t tangent[2];
+		uint16_t texCoord[2];
+	};
+	static_assert(sizeof(CompactVertex) == 20, "CompactVertex is expected to be tightly packed");
+
+	struct UnpackedVertex
+	{
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec2 texCoord;
+		glm::vec3 tangent;
+		glm::vec3 bitangent;
+	};
+
+	// Worst case error of a pack and unpack round trip, measured per attribute
+	struct VertexPackingError
+	{
+		// in units of the quantization extent, bound by POSITION_ERROR_BOUND
+		float position = 0.0f;
+		// radians between the original and unpacked unit vectors, bound by DIRECTION_ERROR_BOUND
+		float normal = 0.0f;
+		float tangent = 0.0f;
+		// relative to the coordinate magnitude for values above 1, absolute below, bound by TEXCOORD_ERROR_BOUND
+		float texCoord = 0.0f;
+		// count of vertices where the reconstructed bitangent points to the other side
+		uint32_t bitangentFlips = 0;
+
+		void Append(const VertexPackingError& inOther);
+		bool IsWithinBounds() const;
+	};
+
+	class VertexPacking
+	{
+	public:
+		// half a quantization step plus float rounding of the dequantization
+		static constexpr float POSITION_ERROR_BOUND = 1.0f / 32767.0f;
+		// a bit above the worst case of oct snorm16, about 0.011 degrees
+		static constexpr float DIRECTION_ERROR_BOUND = 2e-4f;
+		static constexpr float TEXCOORD_ERROR_BOUND = 1.0f / 2048.0f;
+
+		// directions are expected to be unit length
+		static glm::vec2 OctahedralEncode(const glm::vec3& inDirection);
+		static glm::vec3 OctahedralDecode(const glm::vec2& inEncoded);
+
+		static CompactVertex Pack(const UnpackedVertex& inVertex, const VertexQuantization& inQuantization);
+		static UnpackedVertex Unpack(const CompactVertex& inVertex, const VertexQuantization& inQuantization);
+		static VertexPackingError MeasureError(const UnpackedVertex& inVertex, const VertexQuantization& inQuantization);
+	};
+}
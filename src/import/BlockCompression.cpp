@@ -0,0 +1,632 @@
+#include "import/BlockCompression.h"
+
+#include <algorithm>
+#include <limits>
+#include <cstring>
+#include <cmath>
+#include <glm/glm.hpp>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define BLOCK_COMPRESSION_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace CGE
+{
+	namespace
+	{
+		static constexpr uint32_t POWER_ITERATIONS = 8;
+		static constexpr uint32_t REFINE_ITERATIONS = 2;
+		// weight of the first endpoint for every four color mode index
+		static constexpr float BC1_WEIGHTS[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+		// mode 6 is a single subset with 7 bit rgba endpoints, a p-bit per endpoint and 4 bit indices
+		static constexpr uint32_t BC7_MODE = 6;
+		static constexpr uint32_t BC7_ENDPOINT_BITS = 7;
+		static constexpr uint32_t BC7_INDEX_BITS = 4;
+		static constexpr uint32_t BC7_PALETTE_SIZE = 1 << BC7_INDEX_BITS;
+		static constexpr int32_t BC7_WEIGHTS[BC7_PALETTE_SIZE] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		// channel planes of one block, so the palette search runs over four pixels at once
+		struct BlockPixels
+		{
+			alignas(16) float channels[4][BlockCompression::BLOCK_PIXELS];
+
+			glm::vec4 Get(uint32_t inPixel) const
+			{
+				return glm::vec4(channels[0][inPixel], channels[1][inPixel], channels[2][inPixel], channels[3][inPixel]);
+			}
+		};
+
+		// 128 bits filled from the lowest one
+		struct BlockBits
+		{
+			uint64_t words[2] = {};
+			uint32_t position = 0;
+
+			void Write(uint32_t inValue, uint32_t inCount)
+			{
+				for (uint32_t bit = 0; bit < inCount; bit++, position++)
+				{
+					words[position / 64] |= static_cast<uint64_t>((inValue >> bit) & 1) << (position % 64);
+				}
+			}
+
+			uint32_t Read(uint32_t inCount)
+			{
+				uint32_t value = 0;
+				for (uint32_t bit = 0; bit < inCount; bit++, position++)
+				{
+					value |= static_cast<uint32_t>((words[position / 64] >> (position % 64)) & 1) << bit;
+				}
+				return value;
+			}
+		};
+
+		// endpoint pairs hitting an 8 bit value best with the 2/3 interpolated color, per channel bit depth
+		struct SingleColorTables
+		{
+			uint8_t red[256][2];
+			uint8_t green[256][2];
+
+			SingleColorTables()
+			{
+				Fill(red, 5);
+				Fill(green, 6);
+			}
+
+			static void Fill(uint8_t (*outTable)[2], uint32_t inBits)
+			{
+				uint32_t maxValue = (1u << inBits) - 1;
+				for (int32_t value = 0; value < 256; value++)
+				{
+					int32_t bestError = std::numeric_limits<int32_t>::max();
+					for (uint32_t first = 0; first <= maxValue; first++)
+					{
+						for (uint32_t second = 0; second <= maxValue; second++)
+						{
+							int32_t expandedFirst = static_cast<int32_t>((first << (8 - inBits)) | (first >> (2 * inBits - 8)));
+							int32_t expandedSecond = static_cast<int32_t>((second << (8 - inBits)) | (second >> (2 * inBits - 8)));
+							int32_t error = std::abs((expandedFirst * 2 + expandedSecond + 1) / 3 - value);
+							if (error < bestError)
+							{
+								bestError = error;
+								outTable[value][0] = static_cast<uint8_t>(first);
+								outTable[value][1] = static_cast<uint8_t>(second);
+							}
+						}
+					}
+				}
+			}
+		};
+
+		struct BC1Fit
+		{
+			uint16_t color0 = 0;
+			uint16_t color1 = 0;
+			uint8_t indices[BlockCompression::BLOCK_PIXELS] = {};
+			float error = std::numeric_limits<float>::max();
+		};
+
+		struct BC7Fit
+		{
+			glm::ivec4 endpoints[2] = {};
+			uint32_t pBits[2] = {};
+			uint8_t indices[BlockCompression::BLOCK_PIXELS] = {};
+			float error = std::numeric_limits<float>::max();
+		};
+
+		BlockPixels LoadPixels(const uint8_t* inRgba, bool inUseAlpha)
+		{
+			BlockPixels pixels;
+			for (uint32_t pixel = 0; pixel < BlockCompression::BLOCK_PIXELS; pixel++)
+			{
+				for (uint32_t channel = 0; channel < 3; channel++)
+				{
+					pixels.channels[channel][pixel] = inRgba[pixel * 4 + channel];
+				}
+				pixels.channels[3][pixel] = inUseAlpha ? inRgba[pixel * 4 + 3] : 0.0f;
+			}
+			return pixels;
+		}
+
+		// nearest palette entry for every pixel, returns the summed squared error
+		float FitPaletteIndices(const BlockPixels& inPixels, const glm::vec4* inPalette, uint32_t inPaletteSize, uint8_t* outIndices)
+		{
+			float totalError = 0.0f;
+#ifdef BLOCK_COMPRESSION_SSE2
+			for (uint32_t first = 0; first < BlockCompression::BLOCK_PIXELS; first += 4)
+			{
+				__m128 channels[4];
+				for (uint32_t channel = 0; channel < 4; channel++)
+				{
+					channels[channel] = _mm_load_ps(&inPixels.channels[channel][first]);
+				}
+				__m128 bestError = _mm_set1_ps(std::numeric_limits<float>::max());
+				__m128i bestIndex = _mm_setzero_si128();
+				for (uint32_t index = 0; index < inPaletteSize; index++)
+				{
+					__m128 error = _mm_setzero_ps();
+					for (uint32_t channel = 0; channel < 4; channel++)
+					{
+						__m128 delta = _mm_sub_ps(channels[channel], _mm_set1_ps(inPalette[index][channel]));
+						error = _mm_add_ps(error, _mm_mul_ps(delta, delta));
+					}
+					__m128i better = _mm_castps_si128(_mm_cmplt_ps(error, bestError));
+					bestError = _mm_min_ps(error, bestError);
+					bestIndex = _mm_or_si128(_mm_andnot_si128(better, bestIndex), _mm_and_si128(better, _mm_set1_epi32(static_cast<int32_t>(index))));
+				}
+
+				alignas(16) float errors[4];
+				alignas(16) int32_t indices[4];
+				_mm_store_ps(errors, bestError);
+				_mm_store_si128(reinterpret_cast<__m128i*>(indices), bestIndex);
+				for (uint32_t lane = 0; lane < 4; lane++)
+				{
+					outIndices[first + lane] = static_cast<uint8_t>(indices[lane]);
+					totalError += errors[lane];
+				}
+			}
+#else
+			for (uint32_t pixel = 0; pixel < BlockCompression::BLOCK_PIXELS; pixel++)
+			{
+				glm::vec4 color = inPixels.Get(pixel);
+				float bestError = std::numeric_limits<float>::max();
+				for (uint32_t index = 0; index < inPaletteSize; index++)
+				{
+					glm::vec4 delta = color - inPalette[index];
+					float error = glm::dot(delta, delta);
+					if (error < bestError)
+					{
+						bestError = error;
+						outIndices[pixel] = static_cast<uint8_t>(index);
+					}
+				}
+				totalError += bestError;
+			}
+#endif
+			return totalError;
+		}
+
+		// extremes of the pixels along their principal axis, found by power iteration over the covariance
+		void FindEndpoints(const BlockPixels& inPixels, float inInset, glm::vec4& outEndpoint0, glm::vec4& outEndpoint1)
+		{
+			glm::vec4 mean(0.0f);
+			for (uint32_t pixel = 0; pixel < BlockCompression::BLOCK_PIXELS; pixel++)
+			{
+				mean += inPixels.Get(pixel);
+			}
+			mean /= static_cast<float>(BlockCompression::BLOCK_PIXELS);
+
+			glm::mat4 covariance(0.0f);
+			for (uint32_t pixel = 0; pixel < BlockCompression::BLOCK_PIXELS; pixel++)
+			{
+				glm::vec4 delta = inPixels.Get(pixel) - mean;
+				covariance += glm::outerProduct(delta, delta);
+			}
+			glm::vec4 axis(1.0f);
+			for (uint32_t iteration = 0; iteration < POWER_ITERATIONS; iteration++)
+			{
+				glm::vec4 next = covariance * axis;
+				float length = glm::length(next);
+				if (length < 1e-6f)
+				{
+					break;
+				}
+				axis = next / length;
+			}
+			axis = glm::normalize(axis);
+
+			float minProjection = std::numeric_limits<float>::max();
+			float maxProjection = std::numeric_limits<float>::lowest();
+			for (uint32_t pixel = 0; pixel < BlockCompression::BLOCK_PIXELS; pixel++)
+			{
+				float projection = glm::dot(inPixels.Get(pixel) - mean, axis);
+				minProjection = std::min(minProjection, projection);
+				maxProjection = std::max(maxProjection, projection);
+			}
+			// pulled in a bit, extremes are rarely hit exactly by the interpolated colors
+			float inset = (maxProjection - minProjection) * inInset;
+			outEndpoint0 = mean + axis * (maxProjection - inset);
+			outEndpoint1 = mean + axis * (minProjection + inset);
+		}
+
+		// least squares endpoints for the given weight of the first endpoint per pixel
+		bool SolveEndpoints(const BlockPixels& inPixels, const float* inWeights, glm::vec4& outEndpoint0, glm::vec4& outEndpoint1)
+		{
+			float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+			glm::vec4 ax(0.0f), bx(0.0f);
+			for (uint32_t pixel = 0; pixel < BlockCompression::BLOCK_PIXELS; pixel++)
+			{
+				float a = inWeights[pixel];
+				float b = 1.0f - a;
+				aa += a * a;
+				ab += a * b;
+				bb += b * b;
+				ax += inPixels.Get(pixel) * a;
+				bx += inPixels.Get(pixel) * b;
+			}
+			float determinant = aa * bb - ab * ab;
+			if (std::abs(determinant) < 1e-6f)
+			{
+				return false;
+			}
+			outEndpoint0 = (ax * bb - bx * ab) / determinant;
+			outEndpoint1 = (bx * aa - ax * ab) / determinant;
+			return true;
+		}
+
+		uint16_t PackColor565(const glm::vec4& inColor)
+		{
+			glm::vec3 color = glm::clamp(glm::vec3(inColor), glm::vec3(0.0f), glm::vec3(255.0f));
+			uint32_t red = static_cast<uint32_t>(color.r * 31.0f / 255.0f + 0.5f);
+			uint32_t green = static_cast<uint32_t>(color.g * 63.0f / 255.0f + 0.5f);
+			uint32_t blue = static_cast<uint32_t>(color.b * 31.0f / 255.0f + 0.5f);
+			return static_cast<uint16_t>((red << 11) | (green << 5) | blue);
+		}
+
+		glm::ivec3 UnpackColor565(uint16_t inColor)
+		{
+			int32_t red = (inColor >> 11) & 31;
+			int32_t green = (inColor >> 5) & 63;
+			int32_t blue = inColor & 31;
+			return glm::ivec3((red << 3) | (red >> 2), (green << 2) | (green >> 4), (blue << 3) | (blue >> 2));
+		}
+
+		// palette as the decoder sees it, colors 2 and 3 depend on the endpoints order
+		void GetBC1Palette(uint16_t inColor0, uint16_t inColor1, glm::ivec3* outPalette, bool* outTransparent)
+		{
+			outPalette[0] = UnpackColor565(inColor0);
+			outPalette[1] = UnpackColor565(inColor1);
+			*outTransparent = inColor0 <= inColor1;
+			if (!*outTransparent)
+			{
+				outPalette[2] = (outPalette[0] * 2 + outPalette[1] + 1) / 3;
+				outPalette[3] = (outPalette[0] + outPalette[1] * 2 + 1) / 3;
+			}
+			else
+			{
+				outPalette[2] = (outPalette[0] + outPalette[1]) / 2;
+				outPalette[3] = glm::ivec3(0);
+			}
+		}
+
+		// endpoints are swapped into four color order, equal endpoints fall back to a single color
+		BC1Fit FitBC1Indices(uint16_t inColor0, uint16_t inColor1, const BlockPixels& inPixels)
+		{
+			BC1Fit fit;
+			fit.color0 = std::max(inColor0, inColor1);
+			fit.color1 = std::min(inColor0, inColor1);
+
+			glm::ivec3 colors[4];
+			bool transparent;
+			GetBC1Palette(fit.color0, fit.color1, colors, &transparent);
+			glm::vec4 palette[4];
+			for (uint32_t index = 0; index < 4; index++)
+			{
+				palette[index] = glm::vec4(glm::vec3(colors[index]), 0.0f);
+			}
+			fit.error = FitPaletteIndices(inPixels, palette, transparent ? 1 : 4, fit.indices);
+			return fit;
+		}
+
+		const SingleColorTables& GetSingleColorTables()
+		{
+			static const SingleColorTables tables;
+			return tables;
+		}
+
+		void WriteBC1(const BC1Fit& inFit, uint8_t* outBlock)
+		{
+			uint32_t indices = 0;
+			for (uint32_t pixel = 0; pixel < BlockCompression::BLOCK_PIXELS; pixel++)
+			{
+				indices |= static_cast<uint32_t>(inFit.indices[pixel]) << (pixel * 2);
+			}
+			std::memcpy(outBlock, &inFit.color0, sizeof(uint16_t));
+			std::memcpy(outBlock + 2, &inFit.color1, sizeof(uint16_t));
+			std::memcpy(outBlock + 4, &indices, sizeof(uint32_t));
+		}
+
+		// endpoint and p-bit combination closest to an 8 bit value
+		glm::ivec4 QuantizeBC7(const glm::vec4& inEndpoint, uint32_t inPBit)
+		{
+			glm::vec4 value = glm::round((glm::clamp(inEndpoint, glm::vec4(0.0f), glm::vec4(255.0f)) - static_cast<float>(inPBit)) * 0.5f);
+			return glm::clamp(glm::ivec4(value), glm::ivec4(0), glm::ivec4((1 << BC7_ENDPOINT_BITS) - 1));
+		}
+
+		void GetBC7Palette(const glm::ivec4* inEndpoints, const uint32_t* inPBits, glm::ivec4* outPalette)
+		{
+			glm::ivec4 endpoint0 = inEndpoints[0] * 2 + static_cast<int32_t>(inPBits[0]);
+			glm::ivec4 endpoint1 = inEndpoints[1] * 2 + static_cast<int32_t>(inPBits[1]);
+			for (uint32_t index = 0; index < BC7_PALETTE_SIZE; index++)
+			{
+				outPalette[index] = (endpoint0 * (64 - BC7_WEIGHTS[index]) + endpoint1 * BC7_WEIGHTS[index] + 32) / 64;
+			}
+		}
+
+		// every p-bit pair is tried, they shift the endpoints by half a quantization step
+		BC7Fit FitBC7(const glm::vec4& inEndpoint0, const glm::vec4& inEndpoint1, const BlockPixels& inPixels)
+		{
+			BC7Fit best;
+			for (uint32_t pBits = 0; pBits < 4; pBits++)
+			{
+				BC7Fit fit;
+				fit.pBits[0] = pBits & 1;
+				fit.pBits[1] = pBits >> 1;
+				fit.endpoints[0] = QuantizeBC7(inEndpoint0, fit.pBits[0]);
+				fit.endpoints[1] = QuantizeBC7(inEndpoint1, fit.pBits[1]);
+
+				glm::ivec4 colors[BC7_PALETTE_SIZE];
+				GetBC7Palette(fit.endpoints, fit.pBits, colors);
+				glm::vec4 palette[BC7_PALETTE_SIZE];
+				for (uint32_t index = 0; index < BC7_PALETTE_SIZE; index++)
+				{
+					palette[index] = glm::vec4(colors[index]);
+				}
+				fit.error = FitPaletteIndices(inPixels, palette, BC7_PALETTE_SIZE, fit.indices);
+				if (fit.error < best.error)
+				{
+					best = fit;
+				}
+			}
+			return best;
+		}
+
+		// the first index has an implicit zero top bit, endpoints are swapped to make it so
+		void WriteBC7(BC7Fit inFit, uint8_t* outBlock)
+		{
+			if (inFit.indices[0] >= BC7_PALETTE_SIZE / 2)
+			{
+				std::swap(inFit.endpoints[0], inFit.endpoints[1]);
+				std::swap(inFit.pBits[0], inFit.pBits[1]);
+				for (uint32_t pixel = 0; pixel < BlockCompression::BLOCK_PIXELS; pixel++)
+				{
+					inFit.indices[pixel] = static_cast<uint8_t>(BC7_PALETTE_SIZE - 1 - inFit.indices[pixel]);
+				}
+			}
+
+			BlockBits bits;
+			bits.Write(1 << BC7_MODE, BC7_MODE + 1);
+			for (uint32_t channel = 0; channel < 4; channel++)
+			{
+				bits.Write(inFit.endpoints[0][channel], BC7_ENDPOINT_BITS);
+				bits.Write(inFit.endpoints[1][channel], BC7_ENDPOINT_BITS);
+			}
+			bits.Write(inFit.pBits[0], 1);
+			bits.Write(inFit.pBits[1], 1);
+			for (uint32_t pixel = 0; pixel < BlockCompression::BLOCK_PIXELS; pixel++)
+			{
+				bits.Write(inFit.indices[pixel], pixel == 0 ? BC7_INDEX_BITS - 1 : BC7_INDEX_BITS);
+			}
+			std::memcpy(outBlock, bits.words, sizeof(bits.words));
+		}
+
+		void GetBC4Palette(uint8_t inValue0, uint8_t inValue1, int32_t* outPalette)
+		{
+			outPalette[0] = inValue0;
+			outPalette[1] = inValue1;
+			if (inValue0 > inValue1)
+			{
+				for (int32_t index = 2; index < 8; index++)
+				{
+					outPalette[index] = ((8 - index) * inValue0 + (index - 1) * inValue1 + 3) / 7;
+				}
+			}
+			else
+			{
+				for (int32_t index = 2; index < 6; index++)
+				{
+					outPalette[index] = ((6 - index) * inValue0 + (index - 1) * inValue1 + 2) / 5;
+				}
+				outPalette[6] = 0;
+				outPalette[7] = 255;
+			}
+		}
+	}
+
+	void BlockCompression::EncodeBC1(const uint8_t* inRgba, uint8_t* outBlock)
+	{
+		BlockPixels pixels = LoadPixels(inRgba, false);
+		bool singleColor = true;
+		for (uint32_t pixel = 1; pixel < BLOCK_PIXELS; pixel++)
+		{
+			singleColor = singleColor && (std::memcmp(inRgba, inRgba + pixel * 4, 3) == 0);
+		}
+
+		// flat blocks are common and 565 endpoints alone are too coarse for them
+		if (singleColor)
+		{
+			const SingleColorTables& tables = GetSingleColorTables();
+			uint16_t color0 = static_cast<uint16_t>((tables.red[inRgba[0]][0] << 11) | (tables.green[inRgba[1]][0] << 5) | tables.red[inRgba[2]][0]);
+			uint16_t color1 = static_cast<uint16_t>((tables.red[inRgba[0]][1] << 11) | (tables.green[inRgba[1]][1] << 5) | tables.red[inRgba[2]][1]);
+			WriteBC1(FitBC1Indices(color0, color1, pixels), outBlock);
+			return;
+		}
+
+		glm::vec4 color0, color1;
+		FindEndpoints(pixels, 1.0f / 16.0f, color0, color1);
+		BC1Fit best = FitBC1Indices(PackColor565(color0), PackColor565(color1), pixels);
+		for (uint32_t iteration = 0; (iteration < REFINE_ITERATIONS) && (best.error > 0.0f); iteration++)
+		{
+			float weights[BLOCK_PIXELS];
+			for (uint32_t pixel = 0; pixel < BLOCK_PIXELS; pixel++)
+			{
+				weights[pixel] = BC1_WEIGHTS[best.indices[pixel]];
+			}
+			if (!SolveEndpoints(pixels, weights, color0, color1))
+			{
+				break;
+			}
+			BC1Fit refined = FitBC1Indices(PackColor565(color0), PackColor565(color1), pixels);
+			if (refined.error >= best.error)
+			{
+				break;
+			}
+			best = refined;
+		}
+		WriteBC1(best, outBlock);
+	}
+
+	void BlockCompression::DecodeBC1(const uint8_t* inBlock, uint8_t* outRgba)
+	{
+		uint16_t color0, color1;
+		uint32_t indices;
+		std::memcpy(&color0, inBlock, sizeof(uint16_t));
+		std::memcpy(&color1, inBlock + 2, sizeof(uint16_t));
+		std::memcpy(&indices, inBlock + 4, sizeof(uint32_t));
+
+		glm::ivec3 palette[4];
+		bool transparent;
+		GetBC1Palette(color0, color1, palette, &transparent);
+		for (uint32_t pixel = 0; pixel < BLOCK_PIXELS; pixel++)
+		{
+			uint32_t index = (indices >> (pixel * 2)) & 3;
+			outRgba[pixel * 4 + 0] = static_cast<uint8_t>(palette[index].r);
+			outRgba[pixel * 4 + 1] = static_cast<uint8_t>(palette[index].g);
+			outRgba[pixel * 4 + 2] = static_cast<uint8_t>(palette[index].b);
+			outRgba[pixel * 4 + 3] = (transparent && (index == 3)) ? 0 : 255;
+		}
+	}
+
+	void BlockCompression::EncodeBC4(const uint8_t* inValues, uint8_t* outBlock)
+	{
+		uint8_t minValue = 255;
+		uint8_t maxValue = 0;
+		for (uint32_t pixel = 0; pixel < BLOCK_PIXELS; pixel++)
+		{
+			minValue = std::min(minValue, inValues[pixel]);
+			maxValue = std::max(maxValue, inValues[pixel]);
+		}
+
+		// eight value mode needs the first endpoint to be the larger one
+		int32_t palette[8];
+		GetBC4Palette(maxValue, minValue, palette);
+		uint32_t paletteSize = maxValue > minValue ? 8 : 1;
+		uint64_t indices = 0;
+		for (uint32_t pixel = 0; pixel < BLOCK_PIXELS; pixel++)
+		{
+			uint32_t bestIndex = 0;
+			int32_t bestError = std::numeric_limits<int32_t>::max();
+			for (uint32_t index = 0; index < paletteSize; index++)
+			{
+				int32_t error = std::abs(palette[index] - static_cast<int32_t>(inValues[pixel]));
+				if (error < bestError)
+				{
+					bestError = error;
+					bestIndex = index;
+				}
+			}
+			indices |= static_cast<uint64_t>(bestIndex) << (pixel * 3);
+		}
+
+		outBlock[0] = maxValue;
+		outBlock[1] = minValue;
+		for (uint32_t byte = 0; byte < 6; byte++)
+		{
+			outBlock[2 + byte] = static_cast<uint8_t>(indices >> (byte * 8));
+		}
+	}
+
+	void BlockCompression::DecodeBC4(const uint8_t* inBlock, uint8_t* outValues)
+	{
+		int32_t palette[8];
+		GetBC4Palette(inBlock[0], inBlock[1], palette);
+		uint64_t indices = 0;
+		for (uint32_t byte = 0; byte < 6; byte++)
+		{
+			indices |= static_cast<uint64_t>(inBlock[2 + byte]) << (byte * 8);
+		}
+		for (uint32_t pixel = 0; pixel < BLOCK_PIXELS; pixel++)
+		{
+			outValues[pixel] = static_cast<uint8_t>(palette[(indices >> (pixel * 3)) & 7]);
+		}
+	}
+
+	void BlockCompression::EncodeBC5(const uint8_t* inRgba, uint8_t* outBlock)
+	{
+		uint8_t red[BLOCK_PIXELS];
+		uint8_t green[BLOCK_PIXELS];
+		for (uint32_t pixel = 0; pixel < BLOCK_PIXELS; pixel++)
+		{
+			red[pixel] = inRgba[pixel * 4 + 0];
+			green[pixel] = inRgba[pixel * 4 + 1];
+		}
+		EncodeBC4(red, outBlock);
+		EncodeBC4(green, outBlock + 8);
+	}
+
+	void BlockCompression::DecodeBC5(const uint8_t* inBlock, uint8_t* outRgba)
+	{
+		uint8_t red[BLOCK_PIXELS];
+		uint8_t green[BLOCK_PIXELS];
+		DecodeBC4(inBlock, red);
+		DecodeBC4(inBlock + 8, green);
+		for (uint32_t pixel = 0; pixel < BLOCK_PIXELS; pixel++)
+		{
+			outRgba[pixel * 4 + 0] = red[pixel];
+			outRgba[pixel * 4 + 1] = green[pixel];
+			outRgba[pixel * 4 + 2] = 0;
+			outRgba[pixel * 4 + 3] = 255;
+		}
+	}
+
+	void BlockCompression::EncodeBC7(const uint8_t* inRgba, uint8_t* outBlock)
+	{
+		BlockPixels pixels = LoadPixels(inRgba, true);
+		glm::vec4 endpoint0, endpoint1;
+		FindEndpoints(pixels, 1.0f / 32.0f, endpoint0, endpoint1);
+
+		BC7Fit best = FitBC7(endpoint0, endpoint1, pixels);
+		for (uint32_t iteration = 0; (iteration < REFINE_ITERATIONS) && (best.error > 0.0f); iteration++)
+		{
+			float weights[BLOCK_PIXELS];
+			for (uint32_t pixel = 0; pixel < BLOCK_PIXELS; pixel++)
+			{
+				weights[pixel] = 1.0f - BC7_WEIGHTS[best.indices[pixel]] / 64.0f;
+			}
+			if (!SolveEndpoints(pixels, weights, endpoint0, endpoint1))
+			{
+				break;
+			}
+			BC7Fit refined = FitBC7(endpoint0, endpoint1, pixels);
+			if (refined.error >= best.error)
+			{
+				break;
+			}
+			best = refined;
+		}
+		WriteBC7(best, outBlock);
+	}
+
+	void BlockCompression::DecodeBC7(const uint8_t* inBlock, uint8_t* outRgba)
+	{
+		BlockBits bits;
+		std::memcpy(bits.words, inBlock, sizeof(bits.words));
+		if (bits.Read(BC7_MODE + 1) != (1 << BC7_MODE))
+		{
+			std::memset(outRgba, 0, BLOCK_PIXELS * 4);
+			return;
+		}
+
+		glm::ivec4 endpoints[2];
+		uint32_t pBits[2];
+		for (uint32_t channel = 0; channel < 4; channel++)
+		{
+			endpoints[0][channel] = static_cast<int32_t>(bits.Read(BC7_ENDPOINT_BITS));
+			endpoints[1][channel] = static_cast<int32_t>(bits.Read(BC7_ENDPOINT_BITS));
+		}
+		pBits[0] = bits.Read(1);
+		pBits[1] = bits.Read(1);
+
+		glm::ivec4 palette[BC7_PALETTE_SIZE];
+		GetBC7Palette(endpoints, pBits, palette);
+		for (uint32_t pixel = 0; pixel < BLOCK_PIXELS; pixel++)
+		{
+			const glm::ivec4& color = palette[bits.Read(pixel == 0 ? BC7_INDEX_BITS - 1 : BC7_INDEX_BITS)];
+			for (uint32_t channel = 0; channel < 4; channel++)
+			{
+				outRgba[pixel * 4 + channel] = static_cast<uint8_t>(color[channel]);
+			}
+		}
+	}
+}
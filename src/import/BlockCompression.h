@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+namespace CGE
+{
+	// CPU encoders and decoders for single 4x4 blocks. Input pixels are row major, blocks sticking out of
+	// the image are expected to be filled by replicating edge pixels. Palette search uses SSE2 when available.
+	class BlockCompression
+	{
+	public:
+		static constexpr uint32_t BLOCK_DIMENSION = 4;
+		static constexpr uint32_t BLOCK_PIXELS = 16;
+
+		// opaque four color mode, alpha is ignored, 8 bytes
+		static void EncodeBC1(const uint8_t* inRgba, uint8_t* outBlock);
+		static void DecodeBC1(const uint8_t* inBlock, uint8_t* outRgba);
+		// single channel, 8 bytes
+		static void EncodeBC4(const uint8_t* inValues, uint8_t* outBlock);
+		static void DecodeBC4(const uint8_t* inBlock, uint8_t* outValues);
+		// red and green as two BC4 blocks, blue and alpha are ignored, 16 bytes
+		static void EncodeBC5(const uint8_t* inRgba, uint8_t* outBlock);
+		static void DecodeBC5(const uint8_t* inBlock, uint8_t* outRgba);
+		// mode 6 only, a single rgba subset with 4 bit indices, 16 bytes. Decoding other modes gives zeros
+		static void EncodeBC7(const uint8_t* inRgba, uint8_t* outBlock);
+		static void DecodeBC7(const uint8_t* inBlock, uint8_t* outRgba);
+	};
+}
@@ -0,0 +1,246 @@
+#include "import/CookedMesh.h"
+
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+
+namespace CGE
+{
+	namespace
+	{
+		static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+		static constexpr uint64_t FNV_PRIME = 1099511628211ull;
+		static constexpr uint64_t BLOB_ALIGNMENT = 16;
+
+		uint64_t AlignUp(uint64_t inValue, uint64_t inAlignment)
+		{
+			return (inValue + inAlignment - 1) / inAlignment * inAlignment;
+		}
+
+		void WritePadding(std::ofstream& inStream, uint64_t inFrom, uint64_t inTo)
+		{
+			// gaps can be wider than the zero block, so write it in chunks
+			static const char zeros[BLOB_ALIGNMENT] = {};
+			for (uint64_t offset = inFrom; offset < inTo; offset += BLOB_ALIGNMENT)
+			{
+				inStream.write(zeros, static_cast<std::streamsize>(std::min(inTo - offset, BLOB_ALIGNMENT)));
+			}
+		}
+
+		void ExpandBounds(float* inOutMin, float* inOutMax, const float* inPosition)
+		{
+			for (uint32_t axis = 0; axis < 3; axis++)
+			{
+				inOutMin[axis] = std::min(inOutMin[axis], inPosition[axis]);
+				inOutMax[axis] = std::max(inOutMax[axis], inPosition[axis]);
+			}
+		}
+	}
+
+	uint64_t CookedMesh::HashFile(const std::string& inPath, uint64_t inSeed)
+	{
+		MappedFile file;
+		if (!file.Open(inPath))
+		{
+			return 0;
+		}
+
+		uint64_t hash = FNV_OFFSET_BASIS ^ inSeed;
+		const uint8_t* data = file.GetData();
+		for (uint64_t index = 0; index < file.GetSize(); index++)
+		{
+			hash ^= data[index];
+			hash *= FNV_PRIME;
+		}
+		// zero is reserved for unreadable files
+		return hash != 0 ? hash : 1;
+	}
+
+	bool CookedMesh::Write(const std::string& inPath, uint64_t inSourceHash, uint32_t inVertexStride, const std::vector<CookedSubmeshSource>& inSubmeshes, const std::vector<CookedInstance>& inInstances)
+	{
+		CookedMeshHeader header = {};
+		header.magic = MAGIC;
+		header.version = VERSION;
+		header.sourceHash = inSourceHash;
+		header.vertexStride = inVertexStride;
+		header.submeshCount = static_cast<uint32_t>(inSubmeshes.size());
+		header.instanceCount = static_cast<uint32_t>(inInstances.size());
+		std::fill_n(header.boundsMin, 3, std::numeric_limits<float>::max());
+		std::fill_n(header.boundsMax, 3, std::numeric_limits<float>::lowest());
+
+		std::vector<CookedSubmesh> submeshes(inSubmeshes.size());
+		for (uint32_t index = 0; index < inSubmeshes.size(); index++)
+		{
+			const CookedSubmeshSource& source = inSubmeshes[index];
+			CookedSubmesh& submesh = submeshes[index];
+			submesh.firstVertex = static_cast<uint32_t>(header.vertexCount);
+			submesh.vertexCount = source.vertexCount;
+			submesh.firstIndex = static_cast<uint32_t>(header.indexCount);
+			submesh.indexCount = source.indexCount;
+			submesh.lodParent = source.lodParent;
+			submesh.lodError = source.lodError;
+			submesh.firstMeshlet = header.meshletCount;
+			submesh.meshletCount = source.meshletCount;
+			std::fill_n(submesh.boundsMin, 3, std::numeric_limits<float>::max());
+			std::fill_n(submesh.boundsMax, 3, std::numeric_limits<float>::lowest());
+
+			const uint8_t* vertices = static_cast<const uint8_t*>(source.vertices);
+			for (uint32_t vertexIndex = 0; vertexIndex < source.vertexCount; vertexIndex++)
+			{
+				float position[3];
+				std::memcpy(position, vertices + static_cast<uint64_t>(vertexIndex) * inVertexStride, sizeof(position));
+				ExpandBounds(submesh.boundsMin, submesh.boundsMax, position);
+			}
+			if (source.vertexCount > 0)
+			{
+				ExpandBounds(header.boundsMin, header.boundsMax, submesh.boundsMin);
+				ExpandBounds(header.boundsMin, header.boundsMax, submesh.boundsMax);
+			}
+
+			header.vertexCount += source.vertexCount;
+			header.indexCount += source.indexCount;
+			header.meshletCount += source.meshletCount;
+		}
+
+		header.submeshTableOffset = AlignUp(sizeof(CookedMeshHeader), BLOB_ALIGNMENT);
+		header.instanceTableOffset = AlignUp(header.submeshTableOffset + sizeof(CookedSubmesh) * submeshes.size(), BLOB_ALIGNMENT);
+		header.meshletTableOffset = AlignUp(header.instanceTableOffset + sizeof(CookedInstance) * inInstances.size(), BLOB_ALIGNMENT);
+		header.verticesOffset = AlignUp(header.meshletTableOffset + sizeof(Meshlet) * header.meshletCount, BLOB_ALIGNMENT);
+		header.indicesOffset = AlignUp(header.verticesOffset + header.vertexCount * inVertexStride, BLOB_ALIGNMENT);
+
+		// written aside and moved in place, so a crash never leaves a half written file with a valid header
+		std::string tempPath = inPath + ".tmp";
+		{
+			std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+			if (!stream)
+			{
+				return false;
+			}
+
+			stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			WritePadding(stream, sizeof(header), header.submeshTableOffset);
+			stream.write(reinterpret_cast<const char*>(submeshes.data()), sizeof(CookedSubmesh) * submeshes.size());
+			WritePadding(stream, header.submeshTableOffset + sizeof(CookedSubmesh) * submeshes.size(), header.instanceTableOffset);
+			stream.write(reinterpret_cast<const char*>(inInstances.data()), sizeof(CookedInstance) * inInstances.size());
+			WritePadding(stream, header.instanceTableOffset + sizeof(CookedInstance) * inInstances.size(), header.meshletTableOffset);
+			for (const CookedSubmeshSource& source : inSubmeshes)
+			{
+				stream.write(reinterpret_cast<const char*>(source.meshlets), static_cast<std::streamsize>(sizeof(Meshlet) * source.meshletCount));
+			}
+			WritePadding(stream, header.meshletTableOffset + sizeof(Meshlet) * header.meshletCount, header.verticesOffset);
+			for (const CookedSubmeshSource& source : inSubmeshes)
+			{
+				stream.write(static_cast<const char*>(source.vertices), static_cast<std::streamsize>(static_cast<uint64_t>(source.vertexCount) * inVertexStride));
+			}
+			WritePadding(stream, header.verticesOffset + header.vertexCount * inVertexStride, header.indicesOffset);
+			for (const CookedSubmeshSource& source : inSubmeshes)
+			{
+				stream.write(reinterpret_cast<const char*>(source.indices), static_cast<std::streamsize>(sizeof(uint32_t) * source.indexCount));
+			}
+
+			if (!stream)
+			{
+				stream.close();
+				std::remove(tempPath.c_str());
+				return false;
+			}
+		}
+
+		std::remove(inPath.c_str());
+		return std::rename(tempPath.c_str(), inPath.c_str()) == 0;
+	}
+
+	bool CookedMesh::Open(const std::string& inPath, uint64_t inSourceHash, uint32_t inVertexStride)
+	{
+		Close();
+
+		if (!m_file.Open(inPath) || (m_file.GetSize() < sizeof(CookedMeshHeader)))
+		{
+			Close();
+			return false;
+		}
+
+		const CookedMeshHeader* header = reinterpret_cast<const CookedMeshHeader*>(m_file.GetData());
+		uint64_t size = m_file.GetSize();
+		bool valid = (header->magic == MAGIC)
+			&& (header->version == VERSION)
+			&& (header->sourceHash == inSourceHash)
+			&& (header->vertexStride == inVertexStride)
+			&& (header->submeshTableOffset + sizeof(CookedSubmesh) * header->submeshCount <= size)
+			&& (header->instanceTableOffset + sizeof(CookedInstance) * header->instanceCount <= size)
+			&& (header->meshletTableOffset + sizeof(Meshlet) * header->meshletCount <= size)
+			&& (header->verticesOffset + header->vertexCount * header->vertexStride <= size)
+			&& (header->indicesOffset + header->indexCount * sizeof(uint32_t) <= size)
+			&& (header->submeshTableOffset % alignof(CookedSubmesh) == 0)
+			&& (header->instanceTableOffset % alignof(CookedInstance) == 0)
+			&& (header->meshletTableOffset % alignof(Meshlet) == 0)
+			&& (header->indicesOffset % alignof(uint32_t) == 0);
+		if (!valid)
+		{
+			Close();
+			return false;
+		}
+
+		const CookedSubmesh* submeshes = reinterpret_cast<const CookedSubmesh*>(m_file.GetData() + header->submeshTableOffset);
+		const Meshlet* meshlets = reinterpret_cast<const Meshlet*>(m_file.GetData() + header->meshletTableOffset);
+		for (uint32_t index = 0; index < header->submeshCount; index++)
+		{
+			const CookedSubmesh& submesh = submeshes[index];
+			if ((static_cast<uint64_t>(submesh.firstVertex) + submesh.vertexCount > header->vertexCount)
+				|| (static_cast<uint64_t>(submesh.firstIndex) + submesh.indexCount > header->indexCount)
+				|| (static_cast<uint64_t>(submesh.firstMeshlet) + submesh.meshletCount > header->meshletCount)
+				|| (submesh.lodParent > index)
+				|| (submeshes[submesh.lodParent].lodParent != submesh.lodParent))
+			{
+				Close();
+				return false;
+			}
+			for (uint32_t meshletIndex = submesh.firstMeshlet; meshletIndex < submesh.firstMeshlet + submesh.meshletCount; meshletIndex++)
+			{
+				if (static_cast<uint64_t>(meshlets[meshletIndex].firstIndex) + meshlets[meshletIndex].triangleCount * 3ull > submesh.indexCount)
+				{
+					Close();
+					return false;
+				}
+			}
+		}
+
+		const CookedInstance* instances = reinterpret_cast<const CookedInstance*>(m_file.GetData() + header->instanceTableOffset);
+		for (uint32_t index = 0; index < header->instanceCount; index++)
+		{
+			if (instances[index].submesh >= header->submeshCount)
+			{
+				Close();
+				return false;
+			}
+		}
+
+		m_header = header;
+		m_submeshes = submeshes;
+		m_instances = instances;
+		m_meshlets = meshlets;
+		return true;
+	}
+
+	void CookedMesh::Close()
+	{
+		m_header = nullptr;
+		m_submeshes = nullptr;
+		m_instances = nullptr;
+		m_meshlets = nullptr;
+		m_file.Close();
+	}
+
+	const void* CookedMesh::GetVertices(uint32_t inSubmesh) const
+	{
+		return m_file.GetData() + m_header->verticesOffset + static_cast<uint64_t>(m_submeshes[inSubmesh].firstVertex) * m_header->vertexStride;
+	}
+
+	const uint32_t* CookedMesh::GetIndices(uint32_t inSubmesh) const
+	{
+		return reinterpret_cast<const uint32_t*>(m_file.GetData() + m_header->indicesOffset) + m_submeshes[inSubmesh].firstIndex;
+	}
+
+}
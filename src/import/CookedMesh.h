@@ -0,0 +1,105 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "utils/MappedFile.h"
+#include "data/Meshlet.h"
+
+namespace CGE
+{
+	struct CookedMeshHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		// hash of the source file contents and import settings, mismatch means the file has to be cooked again
+		uint64_t sourceHash;
+		uint32_t vertexStride;
+		uint32_t submeshCount;
+		uint32_t instanceCount;
+		uint32_t meshletCount;
+		uint64_t vertexCount;
+		uint64_t indexCount;
+		uint64_t submeshTableOffset;
+		uint64_t instanceTableOffset;
+		uint64_t meshletTableOffset;
+		uint64_t verticesOffset;
+		uint64_t indicesOffset;
+		float boundsMin[3];
+		float boundsMax[3];
+	};
+
+	struct CookedSubmesh
+	{
+		uint32_t firstVertex;
+		uint32_t vertexCount;
+		uint32_t firstIndex;
+		// indices are local to the submesh vertices
+		uint32_t indexCount;
+		float boundsMin[3];
+		float boundsMax[3];
+		// submesh this one is a simplified version of, itself for full detail submeshes that always come first
+		uint32_t lodParent;
+		float lodError;
+		// meshlet index ranges are local to the submesh indices
+		uint32_t firstMeshlet;
+		uint32_t meshletCount;
+	};
+
+	struct CookedInstance
+	{
+		uint32_t submesh;
+		// column major node transform accumulated from the root
+		float transform[16];
+	};
+
+	struct CookedSubmeshSource
+	{
+		// positions are expected to be the first three floats of a vertex
+		const void* vertices;
+		uint32_t vertexCount;
+		const uint32_t* indices;
+		uint32_t indexCount;
+		uint32_t lodParent;
+		float lodError;
+		const Meshlet* meshlets;
+		uint32_t meshletCount;
+	};
+
+	// Binary container for imported meshes: header, submesh, instance and meshlet tables, vertex blob and index blob. It's
+	// written once after import and then memory mapped, so submesh data pointers could be handed
+	// straight to buffer uploads.
+	class CookedMesh
+	{
+	public:
+		static constexpr uint32_t MAGIC = 0x4D454743; // CGEM
+		static constexpr uint32_t VERSION = 5;
+
+		// 0 if the file can't be read
+		static uint64_t HashFile(const std::string& inPath, uint64_t inSeed);
+		static bool Write(const std::string& inPath, uint64_t inSourceHash, uint32_t inVertexStride, const std::vector<CookedSubmeshSource>& inSubmeshes, const std::vector<CookedInstance>& inInstances);
+
+		// fails for missing, broken or outdated files
+		bool Open(const std::string& inPath, uint64_t inSourceHash, uint32_t inVertexStride);
+		void Close();
+
+		const CookedMeshHeader& GetHeader() const { return *m_header; }
+		uint32_t GetSubmeshCount() const { return m_header ? m_header->submeshCount : 0; }
+		const CookedSubmesh& GetSubmesh(uint32_t inIndex) const { return m_submeshes[inIndex]; }
+		uint32_t GetInstanceCount() const { return m_header ? m_header->instanceCount : 0; }
+		const CookedInstance& GetInstance(uint32_t inIndex) const { return m_instances[inIndex]; }
+		const void* GetVertices(uint32_t inSubmesh) const;
+		const uint32_t* GetIndices(uint32_t inSubmesh) const;
+		const Meshlet* GetMeshlets(uint32_t inSubmesh) const { return m_meshlets + m_submeshes[inSubmesh].firstMeshlet; }
+	private:
+		MappedFile m_file;
+		const CookedMeshHeader* m_header = nullptr;
+		const CookedSubmesh* m_submeshes = nullptr;
+		const CookedInstance* m_instances = nullptr;
+		const Meshlet* m_meshlets = nullptr;
+	};
+
+	typedef std::shared_ptr<CookedMesh> CookedMeshPtr;
+}
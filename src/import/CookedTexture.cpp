@@ -0,0 +1,178 @@
+#include "import/CookedTexture.h"
+
+#include <fstream>
+#include <cstdio>
+#include <algorithm>
+
+namespace CGE
+{
+	namespace
+	{
+		// keeps every mip offset valid as a buffer to image copy offset for any of the formats
+		static constexpr uint64_t BLOB_ALIGNMENT = 16;
+
+		uint64_t AlignUp(uint64_t inValue, uint64_t inAlignment)
+		{
+			return (inValue + inAlignment - 1) / inAlignment * inAlignment;
+		}
+
+		void WritePadding(std::ofstream& inStream, uint64_t inFrom, uint64_t inTo)
+		{
+			static const char zeros[BLOB_ALIGNMENT] = {};
+			inStream.write(zeros, static_cast<std::streamsize>(inTo - inFrom));
+		}
+	}
+
+	uint32_t CookedTexture::GetBlockSize(ECookedTextureFormat inFormat)
+	{
+		switch (inFormat)
+		{
+		case ECookedTextureFormat::CTF_BC1:
+		case ECookedTextureFormat::CTF_BC4:
+			return 8;
+		case ECookedTextureFormat::CTF_BC5:
+		case ECookedTextureFormat::CTF_BC7:
+			return 16;
+		default:
+			return 4;
+		}
+	}
+
+	uint32_t CookedTexture::GetRowPitch(ECookedTextureFormat inFormat, uint32_t inWidth)
+	{
+		uint32_t blockDimension = GetBlockDimension(inFormat);
+		return (inWidth + blockDimension - 1) / blockDimension * GetBlockSize(inFormat);
+	}
+
+	uint32_t CookedTexture::GetRowCount(ECookedTextureFormat inFormat, uint32_t inHeight)
+	{
+		uint32_t blockDimension = GetBlockDimension(inFormat);
+		return (inHeight + blockDimension - 1) / blockDimension;
+	}
+
+	bool CookedTexture::Write(const std::string& inPath, uint64_t inSourceHash, ECookedTextureFormat inFormat, const std::vector<CookedTextureMipSource>& inMips)
+	{
+		if (inMips.empty())
+		{
+			return false;
+		}
+
+		CookedTextureHeader header = {};
+		header.magic = MAGIC;
+		header.version = VERSION;
+		header.sourceHash = inSourceHash;
+		header.format = inFormat;
+		header.width = inMips[0].width;
+		header.height = inMips[0].height;
+		header.mipCount = static_cast<uint32_t>(inMips.size());
+
+		std::vector<CookedTextureMip> mips(inMips.size());
+		for (size_t index = inMips.size(); index-- > 0;)
+		{
+			const CookedTextureMipSource& source = inMips[index];
+			CookedTextureMip& mip = mips[index];
+			mip.width = source.width;
+			mip.height = source.height;
+			mip.rowPitch = GetRowPitch(inFormat, source.width);
+			mip.rowCount = GetRowCount(inFormat, source.height);
+			mip.size = source.size;
+			if (mip.size != static_cast<uint64_t>(mip.rowPitch) * mip.rowCount)
+			{
+				return false;
+			}
+			mip.offset = AlignUp(header.dataSize, BLOB_ALIGNMENT);
+			header.dataSize = mip.offset + mip.size;
+		}
+
+		header.mipTableOffset = AlignUp(sizeof(CookedTextureHeader), BLOB_ALIGNMENT);
+		header.dataOffset = AlignUp(header.mipTableOffset + sizeof(CookedTextureMip) * mips.size(), BLOB_ALIGNMENT);
+
+		// written aside and moved in place, so a crash never leaves a half written file with a valid header
+		std::string tempPath = inPath + ".tmp";
+		{
+			std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+			if (!stream)
+			{
+				return false;
+			}
+
+			stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			WritePadding(stream, sizeof(header), header.mipTableOffset);
+			stream.write(reinterpret_cast<const char*>(mips.data()), sizeof(CookedTextureMip) * mips.size());
+			WritePadding(stream, header.mipTableOffset + sizeof(CookedTextureMip) * mips.size(), header.dataOffset);
+			uint64_t written = 0;
+			for (size_t index = inMips.size(); index-- > 0;)
+			{
+				WritePadding(stream, written, mips[index].offset);
+				stream.write(reinterpret_cast<const char*>(inMips[index].data), static_cast<std::streamsize>(mips[index].size));
+				written = mips[index].offset + mips[index].size;
+			}
+
+			if (!stream)
+			{
+				stream.close();
+				std::remove(tempPath.c_str());
+				return false;
+			}
+		}
+
+		std::remove(inPath.c_str());
+		return std::rename(tempPath.c_str(), inPath.c_str()) == 0;
+	}
+
+	bool CookedTexture::Open(const std::string& inPath, uint64_t inSourceHash)
+	{
+		Close();
+
+		if (!m_file.Open(inPath) || (m_file.GetSize() < sizeof(CookedTextureHeader)))
+		{
+			Close();
+			return false;
+		}
+
+		const CookedTextureHeader* header = reinterpret_cast<const CookedTextureHeader*>(m_file.GetData());
+		uint64_t size = m_file.GetSize();
+		bool valid = (header->magic == MAGIC)
+			&& (header->version == VERSION)
+			&& (header->sourceHash == inSourceHash)
+			&& (header->format <= ECookedTextureFormat::CTF_BC7)
+			&& (header->mipCount > 0)
+			&& (header->mipTableOffset + sizeof(CookedTextureMip) * header->mipCount <= size)
+			&& (header->dataOffset + header->dataSize <= size)
+			&& (header->mipTableOffset % alignof(CookedTextureMip) == 0)
+			&& (header->dataOffset % BLOB_ALIGNMENT == 0);
+		if (!valid)
+		{
+			Close();
+			return false;
+		}
+
+		const CookedTextureMip* mips = reinterpret_cast<const CookedTextureMip*>(m_file.GetData() + header->mipTableOffset);
+		for (uint32_t index = 0; index < header->mipCount; index++)
+		{
+			const CookedTextureMip& mip = mips[index];
+			if ((mip.width != std::max(header->width >> index, 1u))
+				|| (mip.height != std::max(header->height >> index, 1u))
+				|| (mip.rowPitch != GetRowPitch(header->format, mip.width))
+				|| (mip.rowCount != GetRowCount(header->format, mip.height))
+				|| (mip.size != static_cast<uint64_t>(mip.rowPitch) * mip.rowCount)
+				|| (mip.offset % BLOB_ALIGNMENT != 0)
+				|| (mip.offset + mip.size > header->dataSize))
+			{
+				Close();
+				return false;
+			}
+		}
+
+		m_header = header;
+		m_mips = mips;
+		return true;
+	}
+
+	void CookedTexture::Close()
+	{
+		m_header = nullptr;
+		m_mips = nullptr;
+		m_file.Close();
+	}
+}
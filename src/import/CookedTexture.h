@@ -0,0 +1,90 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "utils/MappedFile.h"
+
+namespace CGE
+{
+	enum class ECookedTextureFormat : uint32_t
+	{
+		CTF_RGBA8 = 0,
+		CTF_BC1,
+		CTF_BC4,
+		CTF_BC5,
+		CTF_BC7
+	};
+
+	struct CookedTextureHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		// hash of the source file contents and cook settings, mismatch means the file has to be cooked again
+		uint64_t sourceHash;
+		ECookedTextureFormat format;
+		uint32_t width;
+		uint32_t height;
+		uint32_t mipCount;
+		uint64_t mipTableOffset;
+		uint64_t dataOffset;
+		uint64_t dataSize;
+	};
+
+	struct CookedTextureMip
+	{
+		// relative to the data blob
+		uint64_t offset;
+		uint64_t size;
+		uint32_t width;
+		uint32_t height;
+		// rows are rows of blocks for compressed formats
+		uint32_t rowPitch;
+		uint32_t rowCount;
+	};
+
+	struct CookedTextureMipSource
+	{
+		const uint8_t* data;
+		uint64_t size;
+		uint32_t width;
+		uint32_t height;
+	};
+
+	// Binary container for cooked textures: header, mip table and one blob with all the mips. Mips are stored
+	// from the smallest one, so the blob is ready to be copied into a staging buffer as is and any streamed
+	// prefix of it holds complete low resolution levels.
+	class CookedTexture
+	{
+	public:
+		static constexpr uint32_t MAGIC = 0x54454743; // CGET
+		static constexpr uint32_t VERSION = 2;
+
+		static uint32_t GetBlockDimension(ECookedTextureFormat inFormat) { return inFormat == ECookedTextureFormat::CTF_RGBA8 ? 1 : 4; }
+		static uint32_t GetBlockSize(ECookedTextureFormat inFormat);
+		static uint32_t GetRowPitch(ECookedTextureFormat inFormat, uint32_t inWidth);
+		static uint32_t GetRowCount(ECookedTextureFormat inFormat, uint32_t inHeight);
+
+		// mips go from the full resolution one
+		static bool Write(const std::string& inPath, uint64_t inSourceHash, ECookedTextureFormat inFormat, const std::vector<CookedTextureMipSource>& inMips);
+
+		// fails for missing, broken or outdated files
+		bool Open(const std::string& inPath, uint64_t inSourceHash);
+		void Close();
+
+		const CookedTextureHeader& GetHeader() const { return *m_header; }
+		uint32_t GetMipCount() const { return m_header ? m_header->mipCount : 0; }
+		// mip 0 is the full resolution one
+		const CookedTextureMip& GetMip(uint32_t inMip) const { return m_mips[inMip]; }
+		const uint8_t* GetData() const { return m_file.GetData() + m_header->dataOffset; }
+		uint64_t GetDataSize() const { return m_header ? m_header->dataSize : 0; }
+	private:
+		MappedFile m_file;
+		const CookedTextureHeader* m_header = nullptr;
+		const CookedTextureMip* m_mips = nullptr;
+	};
+
+	typedef std::shared_ptr<CookedTexture> CookedTexturePtr;
+}
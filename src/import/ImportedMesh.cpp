@@ -0,0 +1,47 @@
+#include "import/ImportedMesh.h"
+
+namespace CGE
+{
+	ImportedMesh::ImportedMesh(const HashString& inPath, bool inSmoothNormals /*= false*/, uint32_t inLodCount /*= 0*/)
+		: Resource(inPath)
+		, m_path(inPath.GetString())
+		, m_smoothNormals(inSmoothNormals)
+		, m_lodCount(inLodCount)
+	{
+	}
+
+	ImportedMesh::~ImportedMesh()
+	{
+	}
+
+	bool ImportedMesh::Load()
+	{
+		if (!m_loaded)
+		{
+			m_importer.Import(m_path, m_smoothNormals, m_lodCount);
+			m_loaded = true;
+		}
+		return !m_importer.GetMeshes().empty();
+	}
+
+	bool ImportedMesh::Create()
+	{
+		// the synchronous request skips Load
+		if (!Load())
+		{
+			return false;
+		}
+
+		for (MeshLodSetPtr& lodSet : m_importer.GetLodSets())
+		{
+			lodSet->CreateBuffers();
+		}
+		return true;
+	}
+
+	bool ImportedMesh::Destroy()
+	{
+		// mesh data are resources of their own
+		return true;
+	}
+}
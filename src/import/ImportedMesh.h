@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "data/Resource.h"
+#include "import/MeshImporter.h"
+
+namespace CGE
+{
+	// Mesh file as a resource, so it goes through the async requests of DataManager. Import runs in Load
+	// on a worker, Create puts the lod chains into the geometry pool on the calling thread.
+	class ImportedMesh : public Resource
+	{
+	public:
+		ImportedMesh(const HashString& inPath, bool inSmoothNormals = false, uint32_t inLodCount = 0);
+		virtual ~ImportedMesh();
+
+		virtual bool Load() override;
+		virtual bool Create() override;
+
+		// lod chain for every mesh of the file
+		const std::vector<MeshLodSetPtr>& GetLodSets() { return m_importer.GetLodSets(); }
+		const std::vector<MeshInstance>& GetInstances() const { return m_importer.GetInstances(); }
+	protected:
+		virtual bool Destroy() override;
+	private:
+		MeshImporter m_importer;
+		std::string m_path;
+		bool m_smoothNormals;
+		uint32_t m_lodCount;
+		bool m_loaded = false;
+	};
+
+	typedef std::shared_ptr<ImportedMesh> ImportedMeshPtr;
+}
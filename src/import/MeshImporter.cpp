@@ -1,7 +1,19 @@
 #include "import/MeshImporter.h"
+#include "import/CookedMesh.h"
+#include "import/MeshOptimizer.h"
+#include "import/MeshSimplifier.h"
+#include "import/MeshletBuilder.h"
 #include "core/ObjectBase.h"
+#include "async/ThreadPool.h"
+#include "async/Job.h"
 
 #include <iostream>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
 #include <glm/glm.hpp>
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
@@ -9,133 +21,530 @@
 
 namespace CGE
 {
+	namespace
+	{
+		static const std::string COOKED_EXTENSION = ".cooked";
+		// relative to the largest mesh dimension, simplification stops there even if the triangle target isn't reached
+		static constexpr float MAX_LOD_ERROR = 0.05f;
+		// a level has to drop at least this share of the previous level triangles to be kept
+		static constexpr float MIN_LOD_REDUCTION = 0.1f;
+
+		static_assert(sizeof(aiVector3D) == sizeof(glm::vec3), "attribute streams are copied as is, assimp has to use single precision");
+
+		struct MeshGeometry
+		{
+			std::vector<Vertex> vertices;
+			std::vector<uint32_t> indices;
+			MeshOptimizeStats optimizeStats;
+			std::vector<Meshlet> meshlets;
+			glm::vec3 boundsMin = glm::vec3(0.0f);
+			glm::vec3 boundsMax = glm::vec3(0.0f);
+			// simplified levels, error is in mesh space units
+			float lodError = 0.0f;
+			std::vector<MeshGeometry> lods;
+		};
+
+		// shared with the pool jobs, late jobs may still look at it after the conversion is over
+		struct ConvertBatch
+		{
+			const aiScene* scene = nullptr;
+			uint32_t meshCount = 0;
+			uint32_t lodCount = 0;
+			std::vector<MeshGeometry> geometries;
+			std::atomic<uint32_t> nextMesh{ 0 };
+			uint32_t doneCount = 0;
+			std::mutex mutex;
+			std::condition_variable condition;
+		};
+
+		uint32_t GetImportFlags(bool inGenerateSmoothNormals)
+		{
+			uint32_t flags = aiProcess_Triangulate
+				| aiProcess_CalcTangentSpace
+				| aiProcess_JoinIdenticalVertices
+				| aiProcess_ValidateDataStructure
+				//| aiProcess_FindDegenerates
+				| aiProcess_FindInvalidData
+				//| aiProcess_MakeLeftHanded
+				//| aiProcess_FlipWindingOrder
+				//| aiProcess_FlipUVs
+				;
+			if (inGenerateSmoothNormals)
+			{
+				flags |= aiProcess_GenSmoothNormals;
+			}
+			return flags;
+		}
+
+		// import settings and container version are part of the hash, changing any of them cooks again
+		uint64_t GetCookedSeed(uint32_t inFlags, uint32_t inLodCount)
+		{
+			return (static_cast<uint64_t>(CookedMesh::VERSION) << 48) | (static_cast<uint64_t>(inLodCount) << 32) | inFlags;
+		}
+
+		double GetElapsedMs(std::chrono::high_resolution_clock::time_point inStart)
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - inStart).count();
+		}
+
+		glm::mat4 ToMat4(const aiMatrix4x4& inMatrix)
+		{
+			// assimp matrices are row major
+			return glm::transpose(glm::make_mat4(&inMatrix.a1));
+		}
+
+		// one attribute at a time over the whole mesh, fixed size copies are lowered to plain vector loads and stores
+		template<typename TAttribute>
+		void CopyStream(std::vector<Vertex>& outVertices, TAttribute Vertex::* inAttribute, const aiVector3D* inSource)
+		{
+			static_assert(sizeof(TAttribute) <= sizeof(aiVector3D), "attribute is wider than the source stream");
+			Vertex* vertices = outVertices.data();
+			for (size_t index = 0; index < outVertices.size(); index++)
+			{
+				std::memcpy(&(vertices[index].*inAttribute), &inSource[index], sizeof(TAttribute));
+			}
+		}
+
+		template<typename TAttribute>
+		void FillStream(std::vector<Vertex>& outVertices, TAttribute Vertex::* inAttribute, const TAttribute& inValue)
+		{
+			for (Vertex& vertex : outVertices)
+			{
+				vertex.*inAttribute = inValue;
+			}
+		}
+
+		// meshlets are grown from the cache optimized order and reorder triangles once more, so the cache
+		// stats are taken again on the final order
+		void OptimizeGeometry(MeshGeometry& inOutGeometry)
+		{
+			uint32_t vertexCount = static_cast<uint32_t>(inOutGeometry.vertices.size());
+			inOutGeometry.optimizeStats = MeshOptimizer::Optimize(inOutGeometry.vertices.data(), vertexCount, sizeof(Vertex), inOutGeometry.indices.data(), inOutGeometry.indices.size());
+			inOutGeometry.vertices.resize(vertexCount);
+			inOutGeometry.meshlets = MeshletBuilder::Build(inOutGeometry.indices.data(), inOutGeometry.indices.size(), inOutGeometry.vertices.data(), vertexCount, sizeof(Vertex));
+			inOutGeometry.optimizeStats.after = MeshOptimizer::AnalyzeVertexCache(inOutGeometry.indices.data(), inOutGeometry.indices.size(), vertexCount);
+		}
+
+		void ConvertMesh(const aiMesh* inAiMesh, MeshGeometry& outGeometry)
+		{
+			std::vector<Vertex>& vertices = outGeometry.vertices;
+			vertices.resize(inAiMesh->mNumVertices);
+
+			CopyStream(vertices, &Vertex::position, inAiMesh->mVertices);
+			if (inAiMesh->HasNormals())
+			{
+				CopyStream(vertices, &Vertex::normal, inAiMesh->mNormals);
+			}
+			else
+			{
+				FillStream(vertices, &Vertex::normal, glm::vec3{ 0.0f, 0.0f, 0.0f });
+			}
+			// we use only one set of texture coordinates for one
+			if (inAiMesh->HasTextureCoords(0))
+			{
+				CopyStream(vertices, &Vertex::texCoord, inAiMesh->mTextureCoords[0]);
+			}
+			else
+			{
+				FillStream(vertices, &Vertex::texCoord, glm::vec2{ 0.0f, 0.0f });
+			}
+			if (inAiMesh->HasTangentsAndBitangents())
+			{
+				CopyStream(vertices, &Vertex::tangent, inAiMesh->mTangents);
+				CopyStream(vertices, &Vertex::bitangent, inAiMesh->mBitangents);
+			}
+			else
+			{
+				FillStream(vertices, &Vertex::tangent, glm::vec3{ 0.0f, 0.0f, 0.0f });
+				FillStream(vertices, &Vertex::bitangent, glm::vec3{ 0.0f, 0.0f, 0.0f });
+			}
+
+			size_t indexCount = 0;
+			for (uint32_t faceIndex = 0; faceIndex < inAiMesh->mNumFaces; faceIndex++)
+			{
+				indexCount += inAiMesh->mFaces[faceIndex].mNumIndices;
+			}
+			outGeometry.indices.resize(indexCount);
+			uint32_t* outIndex = outGeometry.indices.data();
+			for (uint32_t faceIndex = 0; faceIndex < inAiMesh->mNumFaces; faceIndex++)
+			{
+				const aiFace& face = inAiMesh->mFaces[faceIndex];
+				std::memcpy(outIndex, face.mIndices, sizeof(uint32_t) * face.mNumIndices);
+				outIndex += face.mNumIndices;
+			}
+
+			OptimizeGeometry(outGeometry);
+			if (!vertices.empty())
+			{
+				outGeometry.boundsMin = vertices[0].position;
+				outGeometry.boundsMax = vertices[0].position;
+				for (const Vertex& vertex : vertices)
+				{
+					outGeometry.boundsMin = glm::min(outGeometry.boundsMin, vertex.position);
+					outGeometry.boundsMax = glm::max(outGeometry.boundsMax, vertex.position);
+				}
+			}
+		}
+
+		// every level is simplified from the previous one, errors add up
+		void GenerateLods(MeshGeometry& inOutGeometry, uint32_t inLodCount)
+		{
+			glm::vec3 size = inOutGeometry.boundsMax - inOutGeometry.boundsMin;
+			float meshScale = std::max(size.x, std::max(size.y, size.z));
+			std::vector<uint32_t> previousIndices = inOutGeometry.indices;
+			float previousError = 0.0f;
+			for (uint32_t level = 1; level <= inLodCount; level++)
+			{
+				size_t targetIndexCount = (inOutGeometry.indices.size() >> level) / 3 * 3;
+				float error = 0.0f;
+				std::vector<uint32_t> indices = MeshSimplifier::Simplify(
+					previousIndices.data(),
+					previousIndices.size(),
+					inOutGeometry.vertices.data(),
+					static_cast<uint32_t>(inOutGeometry.vertices.size()),
+					sizeof(Vertex),
+					targetIndexCount,
+					MAX_LOD_ERROR,
+					&error);
+				if (indices.empty() || (indices.size() > previousIndices.size() * (1.0f - MIN_LOD_REDUCTION)))
+				{
+					break;
+				}
+
+				MeshGeometry lod;
+				lod.vertices = inOutGeometry.vertices;
+				lod.indices = indices;
+				lod.lodError = previousError + error * meshScale;
+				lod.boundsMin = inOutGeometry.boundsMin;
+				lod.boundsMax = inOutGeometry.boundsMax;
+				OptimizeGeometry(lod);
+
+				previousIndices = std::move(indices);
+				previousError = lod.lodError;
+				inOutGeometry.lods.push_back(std::move(lod));
+			}
+		}
 
-	void MeshImporter::Import(std::string inPath, bool generateSmoothNormals /*= false*/)
+		void ConvertBatchMeshes(ConvertBatch& inBatch)
+		{
+			while (true)
+			{
+				uint32_t meshIndex = inBatch.nextMesh.fetch_add(1);
+				if (meshIndex >= inBatch.meshCount)
+				{
+					return;
+				}
+				ConvertMesh(inBatch.scene->mMeshes[meshIndex], inBatch.geometries[meshIndex]);
+				GenerateLods(inBatch.geometries[meshIndex], inBatch.lodCount);
+
+				std::scoped_lock lock(inBatch.mutex);
+				if (++inBatch.doneCount == inBatch.meshCount)
+				{
+					inBatch.condition.notify_all();
+				}
+			}
+		}
+
+		// calling thread takes meshes too, so it only ever waits for meshes already being converted by a job
+		void ConvertMeshes(const aiScene* inScene, uint32_t inLodCount, std::vector<MeshGeometry>& outGeometries, bool inParallel)
+		{
+			std::shared_ptr<ConvertBatch> batch = std::make_shared<ConvertBatch>();
+			batch->scene = inScene;
+			batch->meshCount = inScene->mNumMeshes;
+			batch->lodCount = inLodCount;
+			batch->geometries.resize(inScene->mNumMeshes);
+
+			ThreadPool* pool = ThreadPool::GetInstance();
+			uint32_t jobCount = (inParallel && pool && (batch->meshCount > 1)) ? std::min(pool->GetPoolSize(), batch->meshCount - 1) : 0;
+			for (uint32_t jobIndex = 0; jobIndex < jobCount; jobIndex++)
+			{
+				pool->AddJob(CreateJobPtr(std::function<void()>([batch]() { ConvertBatchMeshes(*batch); })));
+			}
+			ConvertBatchMeshes(*batch);
+
+			{
+				std::unique_lock<std::mutex> lock(batch->mutex);
+				batch->condition.wait(lock, [&batch]() { return batch->doneCount == batch->meshCount; });
+			}
+			outGeometries = std::move(batch->geometries);
+		}
+
+		MeshLodSetPtr CreateLodSet(const glm::vec3& inBoundsMin, const glm::vec3& inBoundsMax)
+		{
+			return std::make_shared<MeshLodSet>((inBoundsMin + inBoundsMax) * 0.5f, glm::length(inBoundsMax - inBoundsMin) * 0.5f);
+		}
+
+		bool IsSceneValid(const aiScene* inScene)
+		{
+			return (inScene != nullptr) && !(inScene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) && (inScene->mRootNode != nullptr);
+		}
+	}
+
+	void MeshImporter::Import(std::string inPath, bool generateSmoothNormals /*= false*/, uint32_t inLodCount /*= 0*/)
 	{
 		path = inPath;
-		Assimp::Importer localImporter;
-		uint32_t flags = aiProcess_Triangulate
-			| aiProcess_CalcTangentSpace
-			| aiProcess_JoinIdenticalVertices
-			| aiProcess_ValidateDataStructure
-			//| aiProcess_FindDegenerates
-			| aiProcess_FindInvalidData
-			//| aiProcess_MakeLeftHanded
-			//| aiProcess_FlipWindingOrder
-			//| aiProcess_FlipUVs
-			;
-		if (generateSmoothNormals)
-		{
-			flags |= aiProcess_GenSmoothNormals;
+		meshes.clear();
+		lodSets.clear();
+		instances.clear();
+		stats = MeshImportStats();
+		uint32_t flags = GetImportFlags(generateSmoothNormals);
+
+		auto readStart = std::chrono::high_resolution_clock::now();
+		uint64_t sourceHash = CookedMesh::HashFile(inPath, GetCookedSeed(flags, inLodCount));
+		std::string cookedPath = inPath + COOKED_EXTENSION;
+		if ((sourceHash != 0) && LoadCooked(cookedPath, sourceHash))
+		{
+			stats.fromCooked = true;
+			stats.readMs = GetElapsedMs(readStart);
+			std::cout << "MeshImporter " << path << " loaded cooked in " << stats.readMs << " ms" << std::endl;
+			return;
 		}
+
+		Assimp::Importer localImporter;
 		const aiScene* scene = localImporter.ReadFile(inPath, flags);
 	
-		if ( (scene == nullptr) || (scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) || (scene->mRootNode == nullptr) )
+		if (!IsSceneValid(scene))
 		{
 			std::cout << "ASSIMP::ERROR import " << localImporter.GetErrorString() << std::endl;
-	
-			if (scene != nullptr)
+			return;
+		}
+		stats.readMs = GetElapsedMs(readStart);
+
+		auto convertStart = std::chrono::high_resolution_clock::now();
+		std::vector<MeshGeometry> geometries;
+		ConvertMeshes(scene, inLodCount, geometries, true);
+		meshes.reserve(geometries.size());
+		lodSets.reserve(geometries.size());
+		for (MeshGeometry& geometry : geometries)
+		{
+			stats.cacheBefore.Append(geometry.optimizeStats.before);
+			stats.cacheAfter.Append(geometry.optimizeStats.after);
+			stats.meshletCount += geometry.meshlets.size();
+			std::string meshId = path + std::to_string(meshes.size());
+			std::shared_ptr<MeshData> meshData = ObjectBase::NewObject<MeshData>(meshId);
+			meshData->vertices = std::move(geometry.vertices);
+			meshData->indices = std::move(geometry.indices);
+			meshData->SetMeshlets(std::move(geometry.meshlets));
+			meshes.push_back(meshData);
+
+			MeshLodSetPtr lodSet = CreateLodSet(geometry.boundsMin, geometry.boundsMax);
+			lodSet->AddLod(meshData, 0.0f);
+			for (MeshGeometry& lod : geometry.lods)
 			{
-	//			delete Scene;
+				std::shared_ptr<MeshData> lodData = ObjectBase::NewObject<MeshData, std::string>(meshId + "_lod" + std::to_string(lodSet->GetLodCount()));
+				lodData->vertices = std::move(lod.vertices);
+				lodData->indices = std::move(lod.indices);
+				stats.meshletCount += lod.meshlets.size();
+				lodData->SetMeshlets(std::move(lod.meshlets));
+				lodSet->AddLod(lodData, lod.lodError);
 			}
-			return;
+			lodSets.push_back(lodSet);
 		}
-	
-		ProcessNode(scene->mRootNode, scene);
+		GatherInstances(scene);
+		stats.convertMs = GetElapsedMs(convertStart);
+
+		if (sourceHash != 0)
+		{
+			auto cookStart = std::chrono::high_resolution_clock::now();
+			WriteCooked(cookedPath, sourceHash);
+			stats.cookMs = GetElapsedMs(cookStart);
+		}
+		std::cout << "MeshImporter " << path << " imported: read " << stats.readMs << " ms, convert " << stats.convertMs << " ms, cook " << stats.cookMs << " ms"
+			<< ", ACMR " << stats.cacheBefore.GetAcmr() << " -> " << stats.cacheAfter.GetAcmr()
+			<< ", ATVR " << stats.cacheBefore.GetAtvr() << " -> " << stats.cacheAfter.GetAtvr()
+			<< ", meshlets " << stats.meshletCount << std::endl;
 	}
 	
 	std::vector<std::shared_ptr<MeshData>>& MeshImporter::GetMeshes()
 	{
 		return meshes;
 	}
-	
-	void MeshImporter::ProcessNode(aiNode *inNode, const aiScene *inScene)
+
+	std::vector<MeshLodSetPtr>& MeshImporter::GetLodSets()
 	{
-		for (unsigned int MeshIndex = 0; MeshIndex < inNode->mNumMeshes; MeshIndex++)
-		{
-			aiMesh* Mesh = inScene->mMeshes[inNode->mMeshes[MeshIndex]];
-			meshes.push_back(ProcessMesh(Mesh));
-		}
-	
-		// recursive children processing
-		for (unsigned int ChildIndex = 0; ChildIndex < inNode->mNumChildren; ChildIndex++)
+		return lodSets;
+	}
+
+	const std::vector<MeshInstance>& MeshImporter::GetInstances() const
+	{
+		return instances;
+	}
+
+	const MeshImportStats& MeshImporter::GetStats() const
+	{
+		return stats;
+	}
+
+	void MeshImporter::RunBenchmark(const std::vector<std::string>& inPaths, uint32_t inIterations /*= 5*/)
+	{
+		uint32_t flags = GetImportFlags(false);
+		for (const std::string& benchmarkPath : inPaths)
 		{
-			ProcessNode(inNode->mChildren[ChildIndex], inScene);
+			auto readStart = std::chrono::high_resolution_clock::now();
+			Assimp::Importer localImporter;
+			const aiScene* scene = localImporter.ReadFile(benchmarkPath, flags);
+			if (!IsSceneValid(scene))
+			{
+				std::cout << "MeshImporter benchmark failed to read " << benchmarkPath << " " << localImporter.GetErrorString() << std::endl;
+				continue;
+			}
+			double readMs = GetElapsedMs(readStart);
+
+			double serialMs = 0.0;
+			double parallelMs = 0.0;
+			std::vector<MeshGeometry> geometries;
+			for (uint32_t iteration = 0; iteration < inIterations; iteration++)
+			{
+				auto serialStart = std::chrono::high_resolution_clock::now();
+				ConvertMeshes(scene, 0, geometries, false);
+				serialMs += GetElapsedMs(serialStart);
+
+				auto parallelStart = std::chrono::high_resolution_clock::now();
+				ConvertMeshes(scene, 0, geometries, true);
+				parallelMs += GetElapsedMs(parallelStart);
+			}
+			size_t vertexCount = 0;
+			for (const MeshGeometry& geometry : geometries)
+			{
+				vertexCount += geometry.vertices.size();
+			}
+
+			auto cookedStart = std::chrono::high_resolution_clock::now();
+			CookedMesh cookedMesh;
+			bool hasCooked = cookedMesh.Open(benchmarkPath + COOKED_EXTENSION, CookedMesh::HashFile(benchmarkPath, GetCookedSeed(flags, 0)), sizeof(Vertex));
+			double cookedMs = GetElapsedMs(cookedStart);
+
+			std::cout << "MeshImporter benchmark " << benchmarkPath
+				<< ": meshes " << scene->mNumMeshes
+				<< ", vertices " << vertexCount
+				<< ", assimp read " << readMs << " ms"
+				<< ", convert serial " << serialMs / std::max(inIterations, 1u) << " ms"
+				<< ", convert parallel " << parallelMs / std::max(inIterations, 1u) << " ms";
+			if (hasCooked)
+			{
+				std::cout << ", cooked load " << cookedMs << " ms";
+			}
+			std::cout << std::endl;
 		}
 	}
-	
-	std::shared_ptr<MeshData> MeshImporter::ProcessMesh(aiMesh* inAiMesh)
+
+	bool MeshImporter::LoadCooked(const std::string& inCookedPath, uint64_t inSourceHash)
 	{
-		std::vector<Vertex> vertices;
-		std::vector<unsigned int> indices;
-	
-		for (unsigned int Index = 0; Index < inAiMesh->mNumVertices; Index++)
+		CookedMeshPtr cookedMesh = std::make_shared<CookedMesh>();
+		if (!cookedMesh->Open(inCookedPath, inSourceHash, sizeof(Vertex)))
 		{
-			Vertex V;
-	
-			V.position.x = inAiMesh->mVertices[Index].x;
-			V.position.y = inAiMesh->mVertices[Index].y;
-			V.position.z = inAiMesh->mVertices[Index].z;
-	
-			if (inAiMesh->HasNormals())
+			return false;
+		}
+
+		// full detail submeshes come first, so their indices are the mesh indices
+		uint32_t meshCount = 0;
+		while ((meshCount < cookedMesh->GetSubmeshCount()) && (cookedMesh->GetSubmesh(meshCount).lodParent == meshCount))
+		{
+			meshCount++;
+		}
+		for (uint32_t index = meshCount; index < cookedMesh->GetSubmeshCount(); index++)
+		{
+			if (cookedMesh->GetSubmesh(index).lodParent >= meshCount)
 			{
-				V.normal.x = inAiMesh->mNormals[Index].x;
-				V.normal.y = inAiMesh->mNormals[Index].y;
-				V.normal.z = inAiMesh->mNormals[Index].z;
+				return false;
 			}
-	
-			// we use only one set of texture coordinates for one
-			if (inAiMesh->HasTextureCoords(0))
+		}
+
+		// mapping stays open until every mesh has its buffers created
+		meshes.reserve(meshCount);
+		lodSets.reserve(meshCount);
+		for (uint32_t index = 0; index < cookedMesh->GetSubmeshCount(); index++)
+		{
+			const CookedSubmesh& submesh = cookedMesh->GetSubmesh(index);
+			bool isLod = index >= meshCount;
+			std::string meshId = path + std::to_string(submesh.lodParent);
+			if (isLod)
 			{
-				V.texCoord.x = inAiMesh->mTextureCoords[0][Index].x;
-				V.texCoord.y = inAiMesh->mTextureCoords[0][Index].y;
+				meshId += "_lod" + std::to_string(lodSets[submesh.lodParent]->GetLodCount());
 			}
-			else
+
+			std::shared_ptr<MeshData> meshData = ObjectBase::NewObject<MeshData>(meshId);
+			meshData->SetSourceData(
+				cookedMesh,
+				static_cast<const Vertex*>(cookedMesh->GetVertices(index)),
+				submesh.vertexCount,
+				cookedMesh->GetIndices(index),
+				submesh.indexCount);
+			const Meshlet* meshlets = cookedMesh->GetMeshlets(index);
+			meshData->SetMeshlets(std::vector<Meshlet>(meshlets, meshlets + submesh.meshletCount));
+
+			if (isLod)
 			{
-				V.texCoord = glm::vec2{0.0f, 0.0f};
+				lodSets[submesh.lodParent]->AddLod(meshData, submesh.lodError);
+				continue;
 			}
-	
-			if (inAiMesh->HasTangentsAndBitangents())
+			meshes.push_back(meshData);
+			MeshLodSetPtr lodSet = CreateLodSet(glm::make_vec3(submesh.boundsMin), glm::make_vec3(submesh.boundsMax));
+			lodSet->AddLod(meshData, 0.0f);
+			lodSets.push_back(lodSet);
+		}
+
+		instances.resize(cookedMesh->GetInstanceCount());
+		for (uint32_t index = 0; index < cookedMesh->GetInstanceCount(); index++)
+		{
+			const CookedInstance& instance = cookedMesh->GetInstance(index);
+			instances[index].meshIndex = instance.submesh;
+			instances[index].transform = glm::make_mat4(instance.transform);
+		}
+		return true;
+	}
+
+	void MeshImporter::WriteCooked(const std::string& inCookedPath, uint64_t inSourceHash)
+	{
+		std::vector<CookedSubmeshSource> submeshes;
+		submeshes.reserve(meshes.size());
+		for (uint32_t index = 0; index < meshes.size(); index++)
+		{
+			std::shared_ptr<MeshData>& meshData = meshes[index];
+			const std::vector<Meshlet>& meshlets = meshData->GetMeshlets();
+			submeshes.push_back({ meshData->vertices.data(), meshData->GetVertexCount(), meshData->indices.data(), meshData->GetIndexCount(), index, 0.0f, meshlets.data(), static_cast<uint32_t>(meshlets.size()) });
+		}
+		for (uint32_t index = 0; index < lodSets.size(); index++)
+		{
+			for (uint32_t level = 1; level < lodSets[index]->GetLodCount(); level++)
 			{
-				V.tangent.x = inAiMesh->mTangents[Index].x;
-				V.tangent.y = inAiMesh->mTangents[Index].y;
-				V.tangent.z = inAiMesh->mTangents[Index].z;
-	
-				V.bitangent.x = inAiMesh->mBitangents[Index].x;
-				V.bitangent.y = inAiMesh->mBitangents[Index].y;
-				V.bitangent.z = inAiMesh->mBitangents[Index].z;
+				const MeshLod& lod = lodSets[index]->GetLod(level);
+				const std::vector<Meshlet>& meshlets = lod.meshData->GetMeshlets();
+				submeshes.push_back({ lod.meshData->vertices.data(), lod.meshData->GetVertexCount(), lod.meshData->indices.data(), lod.meshData->GetIndexCount(), index, lod.error, meshlets.data(), static_cast<uint32_t>(meshlets.size()) });
 			}
-	
-			vertices.push_back(V);
 		}
-	
-		for (unsigned int FaceIndex = 0; FaceIndex < inAiMesh->mNumFaces; FaceIndex++)
+		std::vector<CookedInstance> cookedInstances(instances.size());
+		for (size_t index = 0; index < instances.size(); index++)
 		{
-			aiFace& AiFace = inAiMesh->mFaces[FaceIndex];
-	
-			//Vertex v0 = vertices[AiFace.mIndices[0]];
-			//Vertex v1 = vertices[AiFace.mIndices[1]];
-			//Vertex v2 = vertices[AiFace.mIndices[2]];
-	
-			//CalculateTangents(v0, v1, v2);
-			//CalculateTangents(v1, v2, v0);
-			//CalculateTangents(v2, v0, v1);
-	
-			//vertices[AiFace.mIndices[0]] = v0;
-			//vertices[AiFace.mIndices[1]] = v1;
-			//vertices[AiFace.mIndices[2]] = v2;
-	
-			for (unsigned int Index = 0; Index < AiFace.mNumIndices; Index++)
+			cookedInstances[index].submesh = instances[index].meshIndex;
+			std::memcpy(cookedInstances[index].transform, glm::value_ptr(instances[index].transform), sizeof(cookedInstances[index].transform));
+		}
+		if (!CookedMesh::Write(inCookedPath, inSourceHash, sizeof(Vertex), submeshes, cookedInstances))
+		{
+			std::cout << "MeshImporter failed to write " << inCookedPath << std::endl;
+		}
+	}
+
+	void MeshImporter::GatherInstances(const aiScene* inScene)
+	{
+		// iterative depth first walk, children pushed in reverse to keep the original node order
+		std::vector<std::pair<const aiNode*, glm::mat4>> stack;
+		stack.push_back({ inScene->mRootNode, glm::mat4(1.0f) });
+		while (!stack.empty())
+		{
+			const aiNode* node = stack.back().first;
+			glm::mat4 transform = stack.back().second * ToMat4(node->mTransformation);
+			stack.pop_back();
+
+			for (uint32_t meshIndex = 0; meshIndex < node->mNumMeshes; meshIndex++)
+			{
+				instances.push_back({ node->mMeshes[meshIndex], transform });
+			}
+			for (uint32_t childIndex = node->mNumChildren; childIndex > 0; childIndex--)
 			{
-				indices.push_back(AiFace.mIndices[Index]);
+				stack.push_back({ node->mChildren[childIndex - 1], transform });
 			}
 		}
-	
-		std::shared_ptr<MeshData> OutMeshData = ObjectBase::NewObject<MeshData, std::string>(path + std::to_string(meshes.size()));
-		OutMeshData->vertices = vertices;
-		OutMeshData->indices = indices;
-	
-		return OutMeshData;
 	}
 	
 	void MeshImporter::CalculateTangents(Vertex& v0, const Vertex& v1, const Vertex& v2)
@@ -6,24 +6,60 @@
 
 #include <assimp/scene.h>
 #include "data/MeshData.h"
+#include "import/MeshOptimizer.h"
+#include "data/MeshLodSet.h"
 
 //struct aiNode;
 //struct aiScene;
 
 namespace CGE
 {
+	// one node reference of an imported mesh
+	struct MeshInstance
+	{
+		uint32_t meshIndex;
+		glm::mat4 transform;
+	};
+
+	struct MeshImportStats
+	{
+		bool fromCooked = false;
+		// assimp read or cooked file hash and open
+		double readMs = 0.0;
+		double convertMs = 0.0;
+		double cookMs = 0.0;
+		// post transform cache efficiency before and after reordering, summed over all meshes
+		VertexCacheStats cacheBefore;
+		VertexCacheStats cacheAfter;
+		// over all meshes and their lods
+		uint64_t meshletCount = 0;
+	};
+
 	class MeshImporter
 	{
 	public:
-		void Import(std::string inPath, bool generateSmoothNormals = false);
+		// inLodCount simplified levels are generated per mesh on top of the full detail one
+		void Import(std::string inPath, bool generateSmoothNormals = false, uint32_t inLodCount = 0);
 		std::vector<std::shared_ptr<MeshData>>& GetMeshes();
+		// lod chain for every mesh in GetMeshes(), level 0 is the mesh itself
+		std::vector<MeshLodSetPtr>& GetLodSets();
+		// flat list of node references with accumulated transforms, indexing into GetMeshes()
+		const std::vector<MeshInstance>& GetInstances() const;
+		const MeshImportStats& GetStats() const;
+
+		// reads every file once with assimp and times serial against parallel conversion, no resources are created
+		static void RunBenchmark(const std::vector<std::string>& inPaths, uint32_t inIterations = 5);
 	protected:
 		std::string path;
 		std::vector<std::shared_ptr<MeshData>> meshes;
-	
-		void ProcessNode(aiNode *inNode, const aiScene *inScene);
-		std::shared_ptr<MeshData> ProcessMesh(aiMesh* inAiMesh);
+		std::vector<MeshLodSetPtr> lodSets;
+		std::vector<MeshInstance> instances;
+		MeshImportStats stats;
+
+		bool LoadCooked(const std::string& inCookedPath, uint64_t inSourceHash);
+		void WriteCooked(const std::string& inCookedPath, uint64_t inSourceHash);
+		void GatherInstances(const aiScene* inScene);
 		void CalculateTangents(Vertex& v0, const Vertex& v1, const Vertex& v2);
 	};
-	
+
 }
@@ -0,0 +1,287 @@
+#include "import/MeshOptimizer.h"
+
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <cstring>
+#include <glm/glm.hpp>
+
+namespace CGE
+{
+	namespace
+	{
+		static constexpr uint32_t INVALID_VERTEX = std::numeric_limits<uint32_t>::max();
+
+		bool IsTriangleList(size_t inIndexCount)
+		{
+			return (inIndexCount >= 3) && (inIndexCount % 3 == 0);
+		}
+
+		glm::vec3 GetPosition(const uint8_t* inVertices, uint32_t inVertexStride, uint32_t inIndex)
+		{
+			glm::vec3 position;
+			std::memcpy(&position, inVertices + static_cast<size_t>(inIndex) * inVertexStride, sizeof(position));
+			return position;
+		}
+
+		// most recently used vertex that still has triangles left, or the next one in index order
+		int64_t SkipDeadEnd(std::vector<uint32_t>& inOutDeadEnd, const std::vector<uint32_t>& inLiveCount, uint32_t& inOutCursor)
+		{
+			while (!inOutDeadEnd.empty())
+			{
+				uint32_t vertex = inOutDeadEnd.back();
+				inOutDeadEnd.pop_back();
+				if (inLiveCount[vertex] > 0)
+				{
+					return vertex;
+				}
+			}
+			for (; inOutCursor < inLiveCount.size(); inOutCursor++)
+			{
+				if (inLiveCount[inOutCursor] > 0)
+				{
+					return inOutCursor;
+				}
+			}
+			return -1;
+		}
+	}
+
+	void VertexCacheStats::Append(const VertexCacheStats& inOther)
+	{
+		transformedVertices += inOther.transformedVertices;
+		triangleCount += inOther.triangleCount;
+		referencedVertices += inOther.referencedVertices;
+	}
+
+	VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const uint32_t* inIndices, size_t inIndexCount, uint32_t inVertexCount, uint32_t inCacheSize /*= CACHE_SIZE*/)
+	{
+		VertexCacheStats stats;
+		stats.triangleCount = inIndexCount / 3;
+
+		// FIFO simulated with timestamps, vertex is cached while less than cache size misses happened after it was loaded
+		std::vector<uint32_t> cacheTime(inVertexCount, 0);
+		std::vector<uint8_t> referenced(inVertexCount, 0);
+		uint32_t time = inCacheSize + 1;
+		for (size_t index = 0; index < inIndexCount; index++)
+		{
+			uint32_t vertex = inIndices[index];
+			if (time - cacheTime[vertex] > inCacheSize)
+			{
+				cacheTime[vertex] = time++;
+				stats.transformedVertices++;
+			}
+			if (!referenced[vertex])
+			{
+				referenced[vertex] = 1;
+				stats.referencedVertices++;
+			}
+		}
+		return stats;
+	}
+
+	std::vector<uint32_t> MeshOptimizer::OptimizeVertexCache(uint32_t* inOutIndices, size_t inIndexCount, uint32_t inVertexCount, uint32_t inCacheSize /*= CACHE_SIZE*/)
+	{
+		std::vector<uint32_t> clusters;
+		if (!IsTriangleList(inIndexCount))
+		{
+			return clusters;
+		}
+		uint32_t triangleCount = static_cast<uint32_t>(inIndexCount / 3);
+
+		// vertex to triangle adjacency in one flat array
+		std::vector<uint32_t> liveCount(inVertexCount, 0);
+		for (size_t index = 0; index < inIndexCount; index++)
+		{
+			liveCount[inOutIndices[index]]++;
+		}
+		std::vector<uint32_t> offsets(inVertexCount + 1, 0);
+		for (uint32_t vertex = 0; vertex < inVertexCount; vertex++)
+		{
+			offsets[vertex + 1] = offsets[vertex] + liveCount[vertex];
+		}
+		std::vector<uint32_t> adjacency(inIndexCount);
+		std::vector<uint32_t> fillOffsets(offsets.begin(), offsets.end() - 1);
+		for (size_t index = 0; index < inIndexCount; index++)
+		{
+			adjacency[fillOffsets[inOutIndices[index]]++] = static_cast<uint32_t>(index / 3);
+		}
+
+		std::vector<uint32_t> cacheTime(inVertexCount, 0);
+		std::vector<uint8_t> emitted(triangleCount, 0);
+		std::vector<uint32_t> deadEnd;
+		deadEnd.reserve(inIndexCount);
+		std::vector<uint32_t> candidates;
+		std::vector<uint32_t> output;
+		output.reserve(inIndexCount);
+
+		uint32_t time = inCacheSize + 1;
+		uint32_t cursor = 0;
+		bool flushed = true;
+		int64_t fanning = SkipDeadEnd(deadEnd, liveCount, cursor);
+		while (fanning >= 0)
+		{
+			if (flushed)
+			{
+				clusters.push_back(static_cast<uint32_t>(output.size() / 3));
+			}
+
+			candidates.clear();
+			for (uint32_t adjacent = offsets[fanning]; adjacent < offsets[fanning + 1]; adjacent++)
+			{
+				uint32_t triangle = adjacency[adjacent];
+				if (emitted[triangle])
+				{
+					continue;
+				}
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					uint32_t vertex = inOutIndices[triangle * 3 + corner];
+					output.push_back(vertex);
+					deadEnd.push_back(vertex);
+					candidates.push_back(vertex);
+					liveCount[vertex]--;
+					if (time - cacheTime[vertex] > inCacheSize)
+					{
+						cacheTime[vertex] = time++;
+					}
+				}
+				emitted[triangle] = 1;
+			}
+
+			// prefer the oldest candidate that is still going to be in the cache after its fan is emitted
+			int64_t next = -1;
+			int64_t bestPriority = -1;
+			for (uint32_t vertex : candidates)
+			{
+				if (liveCount[vertex] == 0)
+				{
+					continue;
+				}
+				int64_t priority = 0;
+				if (time - cacheTime[vertex] + 2 * liveCount[vertex] <= inCacheSize)
+				{
+					priority = time - cacheTime[vertex];
+				}
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					next = vertex;
+				}
+			}
+
+			flushed = next < 0;
+			fanning = flushed ? SkipDeadEnd(deadEnd, liveCount, cursor) : next;
+		}
+
+		std::memcpy(inOutIndices, output.data(), sizeof(uint32_t) * output.size());
+		return clusters;
+	}
+
+	void MeshOptimizer::OptimizeOverdraw(uint32_t* inOutIndices, size_t inIndexCount, const std::vector<uint32_t>& inClusters, const void* inVertices, uint32_t inVertexStride)
+	{
+		if (!IsTriangleList(inIndexCount) || (inClusters.size() < 2))
+		{
+			return;
+		}
+		const uint8_t* vertices = static_cast<const uint8_t*>(inVertices);
+		uint32_t triangleCount = static_cast<uint32_t>(inIndexCount / 3);
+		uint32_t clusterCount = static_cast<uint32_t>(inClusters.size());
+
+		// area weighted centroid and summed normal per cluster, cross product length is twice the area
+		std::vector<glm::vec3> clusterCentroids(clusterCount, glm::vec3(0.0f));
+		std::vector<glm::vec3> clusterNormals(clusterCount, glm::vec3(0.0f));
+		glm::vec3 meshCentroid(0.0f);
+		float meshArea = 0.0f;
+		for (uint32_t cluster = 0; cluster < clusterCount; cluster++)
+		{
+			uint32_t end = (cluster + 1 < clusterCount) ? inClusters[cluster + 1] : triangleCount;
+			float clusterArea = 0.0f;
+			for (uint32_t triangle = inClusters[cluster]; triangle < end; triangle++)
+			{
+				glm::vec3 p0 = GetPosition(vertices, inVertexStride, inOutIndices[triangle * 3 + 0]);
+				glm::vec3 p1 = GetPosition(vertices, inVertexStride, inOutIndices[triangle * 3 + 1]);
+				glm::vec3 p2 = GetPosition(vertices, inVertexStride, inOutIndices[triangle * 3 + 2]);
+				glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+				float area = glm::length(normal);
+				clusterCentroids[cluster] += (p0 + p1 + p2) * (area / 3.0f);
+				clusterNormals[cluster] += normal;
+				clusterArea += area;
+			}
+			meshCentroid += clusterCentroids[cluster];
+			meshArea += clusterArea;
+			if (clusterArea > 0.0f)
+			{
+				clusterCentroids[cluster] /= clusterArea;
+			}
+		}
+		if (meshArea > 0.0f)
+		{
+			meshCentroid /= meshArea;
+		}
+
+		std::vector<float> sortKeys(clusterCount);
+		for (uint32_t cluster = 0; cluster < clusterCount; cluster++)
+		{
+			float normalLength = glm::length(clusterNormals[cluster]);
+			glm::vec3 normal = normalLength > 0.0f ? clusterNormals[cluster] / normalLength : glm::vec3(0.0f);
+			sortKeys[cluster] = glm::dot(clusterCentroids[cluster] - meshCentroid, normal);
+		}
+		std::vector<uint32_t> order(clusterCount);
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&sortKeys](uint32_t inLeft, uint32_t inRight) { return sortKeys[inLeft] > sortKeys[inRight]; });
+
+		std::vector<uint32_t> sorted;
+		sorted.reserve(inIndexCount);
+		for (uint32_t cluster : order)
+		{
+			uint32_t end = (cluster + 1 < clusterCount) ? inClusters[cluster + 1] : triangleCount;
+			sorted.insert(sorted.end(), inOutIndices + inClusters[cluster] * 3, inOutIndices + end * 3);
+		}
+		std::memcpy(inOutIndices, sorted.data(), sizeof(uint32_t) * sorted.size());
+	}
+
+	uint32_t MeshOptimizer::OptimizeVertexFetch(void* inOutVertices, uint32_t inVertexCount, uint32_t inVertexStride, uint32_t* inOutIndices, size_t inIndexCount)
+	{
+		std::vector<uint32_t> remap(inVertexCount, INVALID_VERTEX);
+		uint32_t nextVertex = 0;
+		for (size_t index = 0; index < inIndexCount; index++)
+		{
+			uint32_t& newVertex = remap[inOutIndices[index]];
+			if (newVertex == INVALID_VERTEX)
+			{
+				newVertex = nextVertex++;
+			}
+			inOutIndices[index] = newVertex;
+		}
+
+		uint8_t* vertices = static_cast<uint8_t*>(inOutVertices);
+		std::vector<uint8_t> source(vertices, vertices + static_cast<size_t>(inVertexCount) * inVertexStride);
+		for (uint32_t vertex = 0; vertex < inVertexCount; vertex++)
+		{
+			if (remap[vertex] != INVALID_VERTEX)
+			{
+				std::memcpy(vertices + static_cast<size_t>(remap[vertex]) * inVertexStride, source.data() + static_cast<size_t>(vertex) * inVertexStride, inVertexStride);
+			}
+		}
+		return nextVertex;
+	}
+
+	MeshOptimizeStats MeshOptimizer::Optimize(void* inOutVertices, uint32_t& inOutVertexCount, uint32_t inVertexStride, uint32_t* inOutIndices, size_t inIndexCount)
+	{
+		MeshOptimizeStats stats;
+		stats.before = AnalyzeVertexCache(inOutIndices, inIndexCount, inOutVertexCount);
+		if (!IsTriangleList(inIndexCount))
+		{
+			stats.after = stats.before;
+			return stats;
+		}
+
+		std::vector<uint32_t> clusters = OptimizeVertexCache(inOutIndices, inIndexCount, inOutVertexCount);
+		OptimizeOverdraw(inOutIndices, inIndexCount, clusters, inOutVertices, inVertexStride);
+		inOutVertexCount = OptimizeVertexFetch(inOutVertices, inOutVertexCount, inVertexStride, inOutIndices, inIndexCount);
+
+		stats.after = AnalyzeVertexCache(inOutIndices, inIndexCount, inOutVertexCount);
+		return stats;
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace CGE
+{
+	struct VertexCacheStats
+	{
+		uint64_t transformedVertices = 0;
+		uint64_t triangleCount = 0;
+		uint64_t referencedVertices = 0;
+
+		// average cache miss ratio, transformed vertices per triangle, 0.5 is the limit for big closed meshes
+		float GetAcmr() const { return triangleCount ? float(transformedVertices) / float(triangleCount) : 0.0f; }
+		// average transform to vertex ratio, 1.0 means every vertex is transformed exactly once
+		float GetAtvr() const { return referencedVertices ? float(transformedVertices) / float(referencedVertices) : 0.0f; }
+		void Append(const VertexCacheStats& inOther);
+	};
+
+	struct MeshOptimizeStats
+	{
+		VertexCacheStats before;
+		VertexCacheStats after;
+	};
+
+	// Triangle and vertex reordering for indexed triangle lists. Everything runs on the CPU against a
+	// simulated FIFO post transform cache, positions are read as the first three floats of a vertex.
+	class MeshOptimizer
+	{
+	public:
+		static constexpr uint32_t CACHE_SIZE = 16;
+
+		static VertexCacheStats AnalyzeVertexCache(const uint32_t* inIndices, size_t inIndexCount, uint32_t inVertexCount, uint32_t inCacheSize = CACHE_SIZE);
+		// Tipsify triangle order in place, returns first triangle of every cluster, clusters are split on cache flushes
+		static std::vector<uint32_t> OptimizeVertexCache(uint32_t* inOutIndices, size_t inIndexCount, uint32_t inVertexCount, uint32_t inCacheSize = CACHE_SIZE);
+		// sorts clusters so that the ones facing away from the mesh center go first and occlude the rest
+		static void OptimizeOverdraw(uint32_t* inOutIndices, size_t inIndexCount, const std::vector<uint32_t>& inClusters, const void* inVertices, uint32_t inVertexStride);
+		// reorders vertices by first use and drops unreferenced ones, returns new vertex count
+		static uint32_t OptimizeVertexFetch(void* inOutVertices, uint32_t inVertexCount, uint32_t inVertexStride, uint32_t* inOutIndices, size_t inIndexCount);
+
+		// all of the above in order, vertex count is updated after the fetch remap
+		static MeshOptimizeStats Optimize(void* inOutVertices, uint32_t& inOutVertexCount, uint32_t inVertexStride, uint32_t* inOutIndices, size_t inIndexCount);
+	};
+}
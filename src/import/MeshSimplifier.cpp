@@ -0,0 +1,426 @@
+#include "import/MeshSimplifier.h"
+
+#include <queue>
+#include <unordered_map>
+#include <algorithm>
+#include <limits>
+#include <cstring>
+#include <cmath>
+#include <glm/glm.hpp>
+
+namespace CGE
+{
+	namespace
+	{
+		static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+		// symmetric 4x4 plane quadric scaled by area, error divided by the accumulated area is a squared distance
+		struct Quadric
+		{
+			double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+			double b2 = 0.0, bc = 0.0, bd = 0.0;
+			double c2 = 0.0, cd = 0.0;
+			double d2 = 0.0;
+			double weight = 0.0;
+
+			static Quadric FromPlane(const glm::dvec3& inNormal, double inDistance, double inWeight)
+			{
+				Quadric quadric;
+				quadric.a2 = inNormal.x * inNormal.x * inWeight;
+				quadric.ab = inNormal.x * inNormal.y * inWeight;
+				quadric.ac = inNormal.x * inNormal.z * inWeight;
+				quadric.ad = inNormal.x * inDistance * inWeight;
+				quadric.b2 = inNormal.y * inNormal.y * inWeight;
+				quadric.bc = inNormal.y * inNormal.z * inWeight;
+				quadric.bd = inNormal.y * inDistance * inWeight;
+				quadric.c2 = inNormal.z * inNormal.z * inWeight;
+				quadric.cd = inNormal.z * inDistance * inWeight;
+				quadric.d2 = inDistance * inDistance * inWeight;
+				quadric.weight = inWeight;
+				return quadric;
+			}
+
+			void Add(const Quadric& inOther)
+			{
+				a2 += inOther.a2; ab += inOther.ab; ac += inOther.ac; ad += inOther.ad;
+				b2 += inOther.b2; bc += inOther.bc; bd += inOther.bd;
+				c2 += inOther.c2; cd += inOther.cd;
+				d2 += inOther.d2;
+				weight += inOther.weight;
+			}
+
+			double Evaluate(const glm::dvec3& inPoint) const
+			{
+				double x = inPoint.x, y = inPoint.y, z = inPoint.z;
+				double error = a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x
+					+ b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y
+					+ c2 * z * z + 2.0 * cd * z
+					+ d2;
+				return std::max(error, 0.0);
+			}
+		};
+
+		struct Collapse
+		{
+			double cost;
+			uint32_t from;
+			uint32_t to;
+
+			bool operator>(const Collapse& inOther) const { return cost > inOther.cost; }
+		};
+
+		struct PositionKey
+		{
+			float x, y, z;
+			bool operator==(const PositionKey& inOther) const { return x == inOther.x && y == inOther.y && z == inOther.z; }
+		};
+
+		struct PositionKeyHash
+		{
+			size_t operator()(const PositionKey& inKey) const
+			{
+				uint32_t bits[3];
+				std::memcpy(bits, &inKey, sizeof(bits));
+				return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+			}
+		};
+
+		class Simplifier
+		{
+		public:
+			Simplifier(const uint32_t* inIndices, size_t inIndexCount, const void* inVertices, uint32_t inVertexCount, uint32_t inVertexStride);
+
+			std::vector<uint32_t> Run(size_t inTargetIndexCount, float inMaxError, float* outError);
+		private:
+			std::vector<glm::dvec3> m_positions;
+			// first vertex with the same position, topology and quadrics live on these
+			std::vector<uint32_t> m_welded;
+			std::vector<Quadric> m_quadrics;
+			std::vector<uint8_t> m_locked;
+			std::vector<uint32_t> m_triangles;
+			std::vector<uint8_t> m_triangleAlive;
+			std::vector<std::vector<uint32_t>> m_vertexTriangles;
+			std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> m_queue;
+
+			void Weld(uint32_t inVertexCount);
+			void LockBordersAndSeams(uint32_t inVertexCount);
+			void ComputeQuadrics();
+			double GetCost(uint32_t inFrom, uint32_t inTo) const;
+			void PushCollapses(uint32_t inVertex);
+			bool HasEdge(uint32_t inFrom, uint32_t inTo) const;
+			bool FlipsTriangles(uint32_t inFrom, uint32_t inTo) const;
+			uint32_t DoCollapse(uint32_t inFrom, uint32_t inTo);
+		};
+
+		Simplifier::Simplifier(const uint32_t* inIndices, size_t inIndexCount, const void* inVertices, uint32_t inVertexCount, uint32_t inVertexStride)
+			: m_triangles(inIndices, inIndices + inIndexCount)
+			, m_triangleAlive(inIndexCount / 3, 1)
+			, m_vertexTriangles(inVertexCount)
+		{
+			// normalized to the largest dimension so errors don't depend on the mesh scale
+			const uint8_t* vertices = static_cast<const uint8_t*>(inVertices);
+			glm::vec3 boundsMin(std::numeric_limits<float>::max());
+			glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+			std::vector<glm::vec3> positions(inVertexCount);
+			for (uint32_t vertex = 0; vertex < inVertexCount; vertex++)
+			{
+				std::memcpy(&positions[vertex], vertices + static_cast<size_t>(vertex) * inVertexStride, sizeof(glm::vec3));
+				boundsMin = glm::min(boundsMin, positions[vertex]);
+				boundsMax = glm::max(boundsMax, positions[vertex]);
+			}
+			glm::vec3 size = boundsMax - boundsMin;
+			double scale = 1.0 / std::max(double(std::max(size.x, std::max(size.y, size.z))), 1e-12);
+			m_positions.resize(inVertexCount);
+			for (uint32_t vertex = 0; vertex < inVertexCount; vertex++)
+			{
+				m_positions[vertex] = glm::dvec3(positions[vertex] - boundsMin) * scale;
+			}
+
+			for (uint32_t triangle = 0; triangle < m_triangleAlive.size(); triangle++)
+			{
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					m_vertexTriangles[m_triangles[triangle * 3 + corner]].push_back(triangle);
+				}
+			}
+
+			Weld(inVertexCount);
+			LockBordersAndSeams(inVertexCount);
+			ComputeQuadrics();
+		}
+
+		void Simplifier::Weld(uint32_t inVertexCount)
+		{
+			m_welded.resize(inVertexCount);
+			std::unordered_map<PositionKey, uint32_t, PositionKeyHash> firstVertex;
+			firstVertex.reserve(inVertexCount);
+			for (uint32_t vertex = 0; vertex < inVertexCount; vertex++)
+			{
+				PositionKey key{ float(m_positions[vertex].x), float(m_positions[vertex].y), float(m_positions[vertex].z) };
+				m_welded[vertex] = firstVertex.emplace(key, vertex).first->second;
+			}
+		}
+
+		void Simplifier::LockBordersAndSeams(uint32_t inVertexCount)
+		{
+			m_locked.assign(inVertexCount, 0);
+
+			// several vertices at one position means an attribute seam, moving either side would tear it
+			std::vector<uint32_t> weldCount(inVertexCount, 0);
+			for (uint32_t vertex = 0; vertex < inVertexCount; vertex++)
+			{
+				weldCount[m_welded[vertex]]++;
+			}
+
+			// edges used by a single triangle after welding are open borders
+			std::unordered_map<uint64_t, uint32_t> edgeUse;
+			edgeUse.reserve(m_triangles.size());
+			auto edgeKey = [this](uint32_t inFirst, uint32_t inSecond) -> uint64_t
+			{
+				uint32_t first = m_welded[inFirst];
+				uint32_t second = m_welded[inSecond];
+				return (static_cast<uint64_t>(std::min(first, second)) << 32) | std::max(first, second);
+			};
+			for (size_t index = 0; index < m_triangles.size(); index += 3)
+			{
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					edgeUse[edgeKey(m_triangles[index + corner], m_triangles[index + (corner + 1) % 3])]++;
+				}
+			}
+			std::vector<uint8_t> weldedBorder(inVertexCount, 0);
+			for (auto& edge : edgeUse)
+			{
+				if (edge.second == 1)
+				{
+					weldedBorder[edge.first >> 32] = 1;
+					weldedBorder[edge.first & 0xFFFFFFFF] = 1;
+				}
+			}
+
+			for (uint32_t vertex = 0; vertex < inVertexCount; vertex++)
+			{
+				uint32_t welded = m_welded[vertex];
+				m_locked[vertex] = (weldCount[welded] > 1) || weldedBorder[welded];
+			}
+		}
+
+		void Simplifier::ComputeQuadrics()
+		{
+			m_quadrics.assign(m_positions.size(), Quadric());
+			for (size_t index = 0; index < m_triangles.size(); index += 3)
+			{
+				const glm::dvec3& p0 = m_positions[m_triangles[index + 0]];
+				const glm::dvec3& p1 = m_positions[m_triangles[index + 1]];
+				const glm::dvec3& p2 = m_positions[m_triangles[index + 2]];
+				glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+				double doubleArea = glm::length(normal);
+				if (doubleArea <= 0.0)
+				{
+					continue;
+				}
+				normal /= doubleArea;
+				Quadric quadric = Quadric::FromPlane(normal, -glm::dot(normal, p0), doubleArea * 0.5);
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					m_quadrics[m_welded[m_triangles[index + corner]]].Add(quadric);
+				}
+			}
+		}
+
+		double Simplifier::GetCost(uint32_t inFrom, uint32_t inTo) const
+		{
+			Quadric quadric = m_quadrics[m_welded[inFrom]];
+			quadric.Add(m_quadrics[m_welded[inTo]]);
+			return quadric.weight > 0.0 ? quadric.Evaluate(m_positions[inTo]) / quadric.weight : 0.0;
+		}
+
+		void Simplifier::PushCollapses(uint32_t inVertex)
+		{
+			for (uint32_t triangle : m_vertexTriangles[inVertex])
+			{
+				if (!m_triangleAlive[triangle])
+				{
+					continue;
+				}
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					uint32_t other = m_triangles[triangle * 3 + corner];
+					if (other == inVertex)
+					{
+						continue;
+					}
+					if (!m_locked[inVertex])
+					{
+						m_queue.push({ GetCost(inVertex, other), inVertex, other });
+					}
+					if (!m_locked[other])
+					{
+						m_queue.push({ GetCost(other, inVertex), other, inVertex });
+					}
+				}
+			}
+		}
+
+		bool Simplifier::HasEdge(uint32_t inFrom, uint32_t inTo) const
+		{
+			for (uint32_t triangle : m_vertexTriangles[inFrom])
+			{
+				if (!m_triangleAlive[triangle])
+				{
+					continue;
+				}
+				const uint32_t* corners = &m_triangles[triangle * 3];
+				if ((corners[0] == inTo) || (corners[1] == inTo) || (corners[2] == inTo))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		bool Simplifier::FlipsTriangles(uint32_t inFrom, uint32_t inTo) const
+		{
+			for (uint32_t triangle : m_vertexTriangles[inFrom])
+			{
+				if (!m_triangleAlive[triangle])
+				{
+					continue;
+				}
+				const uint32_t* corners = &m_triangles[triangle * 3];
+				if ((corners[0] == inTo) || (corners[1] == inTo) || (corners[2] == inTo))
+				{
+					continue;
+				}
+				glm::dvec3 before[3];
+				glm::dvec3 after[3];
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					before[corner] = m_positions[corners[corner]];
+					after[corner] = corners[corner] == inFrom ? m_positions[inTo] : before[corner];
+				}
+				glm::dvec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+				glm::dvec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+				if (glm::dot(normalBefore, normalAfter) <= 0.0)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		uint32_t Simplifier::DoCollapse(uint32_t inFrom, uint32_t inTo)
+		{
+			uint32_t removed = 0;
+			for (uint32_t triangle : m_vertexTriangles[inFrom])
+			{
+				if (!m_triangleAlive[triangle])
+				{
+					continue;
+				}
+				uint32_t* corners = &m_triangles[triangle * 3];
+				if ((corners[0] == inTo) || (corners[1] == inTo) || (corners[2] == inTo))
+				{
+					m_triangleAlive[triangle] = 0;
+					removed++;
+					continue;
+				}
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					if (corners[corner] == inFrom)
+					{
+						corners[corner] = inTo;
+					}
+				}
+				m_vertexTriangles[inTo].push_back(triangle);
+			}
+			m_vertexTriangles[inFrom].clear();
+			m_quadrics[m_welded[inTo]].Add(m_quadrics[m_welded[inFrom]]);
+			return removed;
+		}
+
+		std::vector<uint32_t> Simplifier::Run(size_t inTargetIndexCount, float inMaxError, float* outError)
+		{
+			size_t targetTriangles = inTargetIndexCount / 3;
+			size_t liveTriangles = m_triangleAlive.size();
+			double maxCost = double(inMaxError) * double(inMaxError);
+			double reachedCost = 0.0;
+
+			for (uint32_t vertex = 0; vertex < m_vertexTriangles.size(); vertex++)
+			{
+				if (!m_locked[vertex])
+				{
+					PushCollapses(vertex);
+				}
+			}
+
+			while (!m_queue.empty() && (liveTriangles > targetTriangles))
+			{
+				Collapse collapse = m_queue.top();
+				m_queue.pop();
+				if (collapse.cost > maxCost)
+				{
+					break;
+				}
+				if (m_vertexTriangles[collapse.from].empty() || !HasEdge(collapse.from, collapse.to))
+				{
+					continue;
+				}
+				// quadrics grow with every collapse, stale entries are pushed back with the current cost
+				double cost = GetCost(collapse.from, collapse.to);
+				if (cost > collapse.cost * (1.0 + 1e-6) + 1e-18)
+				{
+					m_queue.push({ cost, collapse.from, collapse.to });
+					continue;
+				}
+				if (FlipsTriangles(collapse.from, collapse.to))
+				{
+					continue;
+				}
+
+				liveTriangles -= DoCollapse(collapse.from, collapse.to);
+				reachedCost = std::max(reachedCost, cost);
+				PushCollapses(collapse.to);
+			}
+
+			if (outError)
+			{
+				*outError = static_cast<float>(std::sqrt(reachedCost));
+			}
+
+			std::vector<uint32_t> indices;
+			indices.reserve(liveTriangles * 3);
+			for (uint32_t triangle = 0; triangle < m_triangleAlive.size(); triangle++)
+			{
+				if (m_triangleAlive[triangle])
+				{
+					indices.insert(indices.end(), &m_triangles[triangle * 3], &m_triangles[triangle * 3] + 3);
+				}
+			}
+			return indices;
+		}
+	}
+
+	std::vector<uint32_t> MeshSimplifier::Simplify(
+		const uint32_t* inIndices,
+		size_t inIndexCount,
+		const void* inVertices,
+		uint32_t inVertexCount,
+		uint32_t inVertexStride,
+		size_t inTargetIndexCount,
+		float inMaxError,
+		float* outError /*= nullptr*/)
+	{
+		if ((inIndexCount < 3) || (inIndexCount % 3 != 0) || (inTargetIndexCount >= inIndexCount))
+		{
+			if (outError)
+			{
+				*outError = 0.0f;
+			}
+			return std::vector<uint32_t>(inIndices, inIndices + inIndexCount);
+		}
+
+		Simplifier simplifier(inIndices, inIndexCount, inVertices, inVertexCount, inVertexStride);
+		return simplifier.Run(inTargetIndexCount, inMaxError, outError);
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace CGE
+{
+	// Quadric error metric edge collapse (Garland and Heckbert). A vertex always collapses onto one of its
+	// neighbours, so no vertices are created and attributes stay untouched, the result indexes the same vertex
+	// array. Vertices on open borders and attribute seams are locked to keep silhouettes and uv layouts intact.
+	// Positions are read as the first three floats of a vertex.
+	class MeshSimplifier
+	{
+	public:
+		// errors are distances relative to the largest mesh dimension, outError receives the largest collapse error
+		static std::vector<uint32_t> Simplify(
+			const uint32_t* inIndices,
+			size_t inIndexCount,
+			const void* inVertices,
+			uint32_t inVertexCount,
+			uint32_t inVertexStride,
+			size_t inTargetIndexCount,
+			float inMaxError,
+			float* outError = nullptr);
+	};
+}
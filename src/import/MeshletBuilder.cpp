@@ -0,0 +1,354 @@
+#include "import/MeshletBuilder.h"
+
+#include <algorithm>
+#include <limits>
+#include <cstring>
+#include <cmath>
+
+namespace CGE
+{
+	namespace
+	{
+		static constexpr uint32_t INVALID_TRIANGLE = std::numeric_limits<uint32_t>::max();
+		// wider cones reject almost nothing while still costing a test per meshlet
+		static constexpr float MIN_CONE_DOT = 0.1f;
+		static constexpr float MIN_NORMAL_LENGTH = 1e-12f;
+
+		glm::vec3 GetPosition(const uint8_t* inVertices, uint32_t inVertexStride, uint32_t inIndex)
+		{
+			glm::vec3 position;
+			std::memcpy(&position, inVertices + static_cast<size_t>(inIndex) * inVertexStride, sizeof(position));
+			return position;
+		}
+
+		class MeshletGrower
+		{
+		public:
+			MeshletGrower(const uint32_t* inIndices, size_t inIndexCount, const uint8_t* inVertices, uint32_t inVertexCount, uint32_t inVertexStride);
+
+			// next meshlet triangles in growth order, empty once every triangle is taken
+			const std::vector<uint32_t>& Grow();
+		private:
+			const uint32_t* m_indices;
+			uint32_t m_triangleCount;
+			std::vector<glm::vec3> m_centroids;
+			// vertex to triangle adjacency, triangles of vertex v are m_adjacency[m_adjacencyOffsets[v]..m_adjacencyOffsets[v + 1]]
+			std::vector<uint32_t> m_adjacencyOffsets;
+			std::vector<uint32_t> m_adjacency;
+			std::vector<uint8_t> m_used;
+			// triangles not taken yet per vertex
+			std::vector<uint32_t> m_liveCount;
+			// meshlet a vertex was last added to, avoids clearing a set per meshlet
+			std::vector<uint32_t> m_vertexMeshlet;
+			uint32_t m_meshletCounter = 0;
+			uint32_t m_scanCursor = 0;
+
+			std::vector<uint32_t> m_triangles;
+			std::vector<uint32_t> m_candidates;
+			uint32_t m_vertexCount = 0;
+			glm::vec3 m_centroidSum = glm::vec3(0.0f);
+
+			uint32_t GetLiveCount(uint32_t inTriangle) const;
+			bool IsStranding(uint32_t inTriangle) const;
+			uint32_t CountNewVertices(uint32_t inTriangle) const;
+			uint32_t PickCandidate();
+			uint32_t PickNextInScan();
+			uint32_t PickSeed();
+			void AddTriangle(uint32_t inTriangle);
+		};
+
+		MeshletGrower::MeshletGrower(const uint32_t* inIndices, size_t inIndexCount, const uint8_t* inVertices, uint32_t inVertexCount, uint32_t inVertexStride)
+			: m_indices(inIndices)
+			, m_triangleCount(static_cast<uint32_t>(inIndexCount / 3))
+			, m_centroids(inIndexCount / 3)
+			, m_adjacencyOffsets(static_cast<size_t>(inVertexCount) + 1, 0)
+			, m_adjacency(inIndexCount)
+			, m_used(inIndexCount / 3, 0)
+			, m_liveCount(inVertexCount, 0)
+			, m_vertexMeshlet(inVertexCount, std::numeric_limits<uint32_t>::max())
+		{
+			for (size_t index = 0; index < inIndexCount; index++)
+			{
+				m_adjacencyOffsets[inIndices[index] + 1]++;
+				m_liveCount[inIndices[index]]++;
+			}
+			for (uint32_t vertex = 0; vertex < inVertexCount; vertex++)
+			{
+				m_adjacencyOffsets[vertex + 1] += m_adjacencyOffsets[vertex];
+			}
+			std::vector<uint32_t> fill(m_adjacencyOffsets.begin(), m_adjacencyOffsets.end() - 1);
+			for (uint32_t triangle = 0; triangle < m_triangleCount; triangle++)
+			{
+				glm::vec3 centroid(0.0f);
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					uint32_t vertex = inIndices[triangle * 3 + corner];
+					m_adjacency[fill[vertex]++] = triangle;
+					centroid += GetPosition(inVertices, inVertexStride, vertex);
+				}
+				m_centroids[triangle] = centroid / 3.0f;
+			}
+		}
+
+		uint32_t MeshletGrower::GetLiveCount(uint32_t inTriangle) const
+		{
+			uint32_t count = 0;
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				count += m_liveCount[m_indices[inTriangle * 3 + corner]];
+			}
+			return count;
+		}
+
+		// last unused triangle around one of its vertices, skipping it would strand the triangle
+		bool MeshletGrower::IsStranding(uint32_t inTriangle) const
+		{
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				if (m_liveCount[m_indices[inTriangle * 3 + corner]] == 1)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		uint32_t MeshletGrower::CountNewVertices(uint32_t inTriangle) const
+		{
+			uint32_t count = 0;
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				count += m_vertexMeshlet[m_indices[inTriangle * 3 + corner]] != m_meshletCounter ? 1 : 0;
+			}
+			return count;
+		}
+
+		// triangles sharing a vertex with the meshlet: fewest new vertices first, then the ones that would
+		// otherwise be stranded, then the closest to the meshlet center
+		uint32_t MeshletGrower::PickCandidate()
+		{
+			glm::vec3 center = m_centroidSum / static_cast<float>(m_triangles.size());
+			uint32_t best = INVALID_TRIANGLE;
+			uint32_t bestNewVertices = 4;
+			bool bestStranding = false;
+			float bestDistance = std::numeric_limits<float>::max();
+			size_t kept = 0;
+			for (uint32_t triangle : m_candidates)
+			{
+				if (m_used[triangle])
+				{
+					continue;
+				}
+				m_candidates[kept++] = triangle;
+
+				uint32_t newVertices = CountNewVertices(triangle);
+				if (m_vertexCount + newVertices > MeshletBuilder::MAX_VERTICES)
+				{
+					continue;
+				}
+				bool stranding = IsStranding(triangle);
+				glm::vec3 offset = m_centroids[triangle] - center;
+				float distance = glm::dot(offset, offset);
+				bool better = (newVertices != bestNewVertices) ? (newVertices < bestNewVertices)
+					: (stranding != bestStranding) ? stranding
+					: (distance < bestDistance);
+				if (better)
+				{
+					best = triangle;
+					bestNewVertices = newVertices;
+					bestStranding = stranding;
+					bestDistance = distance;
+				}
+			}
+			m_candidates.resize(kept);
+			return best;
+		}
+
+		// triangle order coming from the cache optimizer is spatially coherent, so scan order makes good seeds
+		uint32_t MeshletGrower::PickNextInScan()
+		{
+			while ((m_scanCursor < m_triangleCount) && m_used[m_scanCursor])
+			{
+				m_scanCursor++;
+			}
+			return m_scanCursor < m_triangleCount ? m_scanCursor : INVALID_TRIANGLE;
+		}
+
+		// unused triangles left on the border of the previous meshlet, the most enclosed one first so that
+		// growth doesn't leave small islands behind, scan order when there is no border
+		uint32_t MeshletGrower::PickSeed()
+		{
+			uint32_t best = INVALID_TRIANGLE;
+			uint32_t bestLiveCount = std::numeric_limits<uint32_t>::max();
+			for (uint32_t triangle : m_candidates)
+			{
+				if (m_used[triangle])
+				{
+					continue;
+				}
+				uint32_t liveCount = GetLiveCount(triangle);
+				if (liveCount < bestLiveCount)
+				{
+					best = triangle;
+					bestLiveCount = liveCount;
+				}
+			}
+			return best != INVALID_TRIANGLE ? best : PickNextInScan();
+		}
+
+		void MeshletGrower::AddTriangle(uint32_t inTriangle)
+		{
+			m_used[inTriangle] = 1;
+			m_triangles.push_back(inTriangle);
+			m_centroidSum += m_centroids[inTriangle];
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				m_liveCount[m_indices[inTriangle * 3 + corner]]--;
+			}
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				uint32_t vertex = m_indices[inTriangle * 3 + corner];
+				if (m_vertexMeshlet[vertex] == m_meshletCounter)
+				{
+					continue;
+				}
+				m_vertexMeshlet[vertex] = m_meshletCounter;
+				m_vertexCount++;
+				for (uint32_t offset = m_adjacencyOffsets[vertex]; offset < m_adjacencyOffsets[vertex + 1]; offset++)
+				{
+					if (!m_used[m_adjacency[offset]])
+					{
+						m_candidates.push_back(m_adjacency[offset]);
+					}
+				}
+			}
+		}
+
+		const std::vector<uint32_t>& MeshletGrower::Grow()
+		{
+			uint32_t seed = PickSeed();
+			m_meshletCounter++;
+			m_triangles.clear();
+			m_candidates.clear();
+			m_vertexCount = 0;
+			m_centroidSum = glm::vec3(0.0f);
+			if (seed == INVALID_TRIANGLE)
+			{
+				return m_triangles;
+			}
+			AddTriangle(seed);
+			while (m_triangles.size() < MeshletBuilder::MAX_TRIANGLES)
+			{
+				uint32_t triangle = PickCandidate();
+				if (triangle == INVALID_TRIANGLE)
+				{
+					break;
+				}
+				AddTriangle(triangle);
+			}
+			return m_triangles;
+		}
+	}
+
+	std::vector<Meshlet> MeshletBuilder::Build(uint32_t* inOutIndices, size_t inIndexCount, const void* inVertices, uint32_t inVertexCount, uint32_t inVertexStride)
+	{
+		std::vector<Meshlet> meshlets;
+		if ((inIndexCount < 3) || (inIndexCount % 3 != 0))
+		{
+			return meshlets;
+		}
+
+		const uint8_t* vertices = static_cast<const uint8_t*>(inVertices);
+		std::vector<uint32_t> sourceIndices(inOutIndices, inOutIndices + inIndexCount);
+		MeshletGrower grower(sourceIndices.data(), inIndexCount, vertices, inVertexCount, inVertexStride);
+		meshlets.reserve(inIndexCount / 3 / MAX_TRIANGLES + 1);
+
+		uint32_t* outIndex = inOutIndices;
+		while (true)
+		{
+			const std::vector<uint32_t>& triangles = grower.Grow();
+			if (triangles.empty())
+			{
+				break;
+			}
+
+			Meshlet meshlet = {};
+			meshlet.firstIndex = static_cast<uint32_t>(outIndex - inOutIndices);
+			meshlet.triangleCount = static_cast<uint32_t>(triangles.size());
+			for (uint32_t triangle : triangles)
+			{
+				std::memcpy(outIndex, &sourceIndices[triangle * 3], sizeof(uint32_t) * 3);
+				outIndex += 3;
+			}
+			std::vector<uint32_t> unique(inOutIndices + meshlet.firstIndex, outIndex);
+			std::sort(unique.begin(), unique.end());
+			meshlet.vertexCount = static_cast<uint32_t>(std::unique(unique.begin(), unique.end()) - unique.begin());
+
+			ComputeBounds(meshlet, inOutIndices, inVertices, inVertexStride);
+			meshlets.push_back(meshlet);
+		}
+		return meshlets;
+	}
+
+	void MeshletBuilder::ComputeBounds(Meshlet& inOutMeshlet, const uint32_t* inIndices, const void* inVertices, uint32_t inVertexStride)
+	{
+		const uint8_t* vertices = static_cast<const uint8_t*>(inVertices);
+		const uint32_t* indices = inIndices + inOutMeshlet.firstIndex;
+		uint32_t indexCount = inOutMeshlet.triangleCount * 3;
+
+		glm::vec3 boundsMin(std::numeric_limits<float>::max());
+		glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+		for (uint32_t index = 0; index < indexCount; index++)
+		{
+			glm::vec3 position = GetPosition(vertices, inVertexStride, indices[index]);
+			boundsMin = glm::min(boundsMin, position);
+			boundsMax = glm::max(boundsMax, position);
+		}
+		inOutMeshlet.center = (boundsMin + boundsMax) * 0.5f;
+		float radiusSquared = 0.0f;
+		for (uint32_t index = 0; index < indexCount; index++)
+		{
+			glm::vec3 offset = GetPosition(vertices, inVertexStride, indices[index]) - inOutMeshlet.center;
+			radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+		}
+		inOutMeshlet.radius = std::sqrt(radiusSquared);
+
+		// degenerate triangles have no facing and can't be rejected by the cone, they are skipped here
+		std::vector<glm::vec3> normals;
+		normals.reserve(inOutMeshlet.triangleCount);
+		glm::vec3 axis(0.0f);
+		for (uint32_t index = 0; index < indexCount; index += 3)
+		{
+			glm::vec3 p0 = GetPosition(vertices, inVertexStride, indices[index + 0]);
+			glm::vec3 p1 = GetPosition(vertices, inVertexStride, indices[index + 1]);
+			glm::vec3 p2 = GetPosition(vertices, inVertexStride, indices[index + 2]);
+			glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			float length = glm::length(normal);
+			if (length > MIN_NORMAL_LENGTH)
+			{
+				normals.push_back(normal / length);
+				axis += normals.back();
+			}
+		}
+
+		inOutMeshlet.coneAxis = glm::vec3(0.0f);
+		inOutMeshlet.coneCutoff = 1.0f;
+		float axisLength = glm::length(axis);
+		if (normals.empty() || (axisLength < MIN_NORMAL_LENGTH))
+		{
+			return;
+		}
+		axis /= axisLength;
+		float minDot = 1.0f;
+		for (const glm::vec3& normal : normals)
+		{
+			minDot = std::min(minDot, glm::dot(axis, normal));
+		}
+		if (minDot <= MIN_CONE_DOT)
+		{
+			return;
+		}
+		inOutMeshlet.coneAxis = axis;
+		inOutMeshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+	}
+}
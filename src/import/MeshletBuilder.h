@@ -0,0 +1,25 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "data/Meshlet.h"
+
+namespace CGE
+{
+	// Splits an indexed triangle list into meshlets. Triangles are grown greedily over shared vertices,
+	// preferring the ones adding the fewest new vertices, then the ones closest to the meshlet center.
+	// Positions are read as the first three floats of a vertex.
+	class MeshletBuilder
+	{
+	public:
+		static constexpr uint32_t MAX_VERTICES = 64;
+		static constexpr uint32_t MAX_TRIANGLES = 124;
+
+		// reorders triangles in place so that every meshlet is a contiguous index range
+		static std::vector<Meshlet> Build(uint32_t* inOutIndices, size_t inIndexCount, const void* inVertices, uint32_t inVertexCount, uint32_t inVertexStride);
+		// bounding sphere and normal cone of the triangles in the meshlet index range
+		static void ComputeBounds(Meshlet& inOutMeshlet, const uint32_t* inIndices, const void* inVertices, uint32_t inVertexStride);
+	};
+}
@@ -0,0 +1,492 @@
+#include "import/TextureCooker.h"
+#include "import/BlockCompression.h"
+#include "stb/stb_image.h"
+#include "async/ThreadPool.h"
+#include "async/Job.h"
+
+#include <iostream>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+namespace CGE
+{
+	namespace
+	{
+		// rows of pixels or of blocks handed to a job at once
+		static constexpr uint32_t ROWS_PER_CHUNK = 16;
+		static constexpr uint32_t LINEAR_TO_SRGB_STEPS = 4096;
+
+		typedef std::function<void(uint32_t, uint32_t)> RowsWork;
+
+		// shared with the pool jobs, late jobs may still look at it after the work is over
+		struct RowBatch
+		{
+			RowsWork work;
+			uint32_t rowCount = 0;
+			uint32_t chunkCount = 0;
+			std::atomic<uint32_t> nextChunk{ 0 };
+			uint32_t doneCount = 0;
+			std::mutex mutex;
+			std::condition_variable condition;
+		};
+
+		struct SrgbTables
+		{
+			float toLinear[256];
+			uint8_t fromLinear[LINEAR_TO_SRGB_STEPS + 1];
+
+			SrgbTables()
+			{
+				for (uint32_t value = 0; value < 256; value++)
+				{
+					float srgb = value / 255.0f;
+					toLinear[value] = srgb <= 0.04045f ? srgb / 12.92f : std::pow((srgb + 0.055f) / 1.055f, 2.4f);
+				}
+				for (uint32_t step = 0; step <= LINEAR_TO_SRGB_STEPS; step++)
+				{
+					float linear = static_cast<float>(step) / LINEAR_TO_SRGB_STEPS;
+					float srgb = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+					fromLinear[step] = static_cast<uint8_t>(std::min(srgb * 255.0f + 0.5f, 255.0f));
+				}
+			}
+		};
+
+		// source texels touched by one destination texel along an axis with the covered length of each,
+		// odd sizes span three texels and rounding may add a fourth one with a zero weight
+		struct FilterTaps
+		{
+			uint32_t first;
+			uint32_t count;
+			float weights[4];
+		};
+
+		double GetElapsedMs(std::chrono::high_resolution_clock::time_point inStart)
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - inStart).count();
+		}
+
+		const SrgbTables& GetSrgbTables()
+		{
+			static const SrgbTables tables;
+			return tables;
+		}
+
+		void ProcessRowChunks(RowBatch& inBatch)
+		{
+			while (true)
+			{
+				uint32_t chunkIndex = inBatch.nextChunk.fetch_add(1);
+				if (chunkIndex >= inBatch.chunkCount)
+				{
+					return;
+				}
+				uint32_t firstRow = chunkIndex * ROWS_PER_CHUNK;
+				inBatch.work(firstRow, std::min(ROWS_PER_CHUNK, inBatch.rowCount - firstRow));
+
+				std::scoped_lock lock(inBatch.mutex);
+				if (++inBatch.doneCount == inBatch.chunkCount)
+				{
+					inBatch.condition.notify_all();
+				}
+			}
+		}
+
+		// calling thread takes chunks too, so it only ever waits for chunks already being processed by a job
+		void ForEachRowChunk(uint32_t inRowCount, RowsWork inWork)
+		{
+			std::shared_ptr<RowBatch> batch = std::make_shared<RowBatch>();
+			batch->work = std::move(inWork);
+			batch->rowCount = inRowCount;
+			batch->chunkCount = (inRowCount + ROWS_PER_CHUNK - 1) / ROWS_PER_CHUNK;
+
+			ThreadPool* pool = ThreadPool::GetInstance();
+			uint32_t jobCount = (pool && (batch->chunkCount > 1)) ? std::min(pool->GetPoolSize(), batch->chunkCount - 1) : 0;
+			for (uint32_t jobIndex = 0; jobIndex < jobCount; jobIndex++)
+			{
+				pool->AddJob(CreateJobPtr(std::function<void()>([batch]() { ProcessRowChunks(*batch); })));
+			}
+			ProcessRowChunks(*batch);
+
+			std::unique_lock<std::mutex> lock(batch->mutex);
+			batch->condition.wait(lock, [&batch]() { return batch->doneCount == batch->chunkCount; });
+		}
+
+		// stb flip flag is a global state, so it can't be used while loading from several threads
+		void FlipRows(uint8_t* inData, uint32_t inWidth, uint32_t inHeight)
+		{
+			size_t pitch = static_cast<size_t>(inWidth) * TextureCooker::CHANNELS_COUNT;
+			std::vector<uint8_t> row(pitch);
+			for (size_t top = 0, bottom = inHeight - 1; top < bottom; top++, bottom--)
+			{
+				std::memcpy(row.data(), inData + top * pitch, pitch);
+				std::memcpy(inData + top * pitch, inData + bottom * pitch, pitch);
+				std::memcpy(inData + bottom * pitch, row.data(), pitch);
+			}
+		}
+
+		// box filter over the exact source area of a destination texel, odd sizes get fractional edge weights
+		std::vector<FilterTaps> CreateFilterTaps(uint32_t inSourceSize, uint32_t inSize)
+		{
+			std::vector<FilterTaps> taps(inSize);
+			float scale = static_cast<float>(inSourceSize) / inSize;
+			for (uint32_t index = 0; index < inSize; index++)
+			{
+				float start = index * scale;
+				float end = start + scale;
+				FilterTaps& tap = taps[index];
+				tap.first = static_cast<uint32_t>(start);
+				tap.count = std::min(static_cast<uint32_t>(std::ceil(end)), inSourceSize) - tap.first;
+				for (uint32_t offset = 0; offset < tap.count; offset++)
+				{
+					float texelStart = static_cast<float>(tap.first + offset);
+					tap.weights[offset] = (std::min(texelStart + 1.0f, end) - std::max(texelStart, start)) / scale;
+				}
+			}
+			return taps;
+		}
+
+		void DownsampleRows(const uint8_t* inSource, uint32_t inSourceWidth, uint8_t* outPixels, uint32_t inWidth,
+			const std::vector<FilterTaps>& inTapsX, const std::vector<FilterTaps>& inTapsY, bool inSrgb, bool inNormalMap, uint32_t inFirstRow, uint32_t inRowCount)
+		{
+			const SrgbTables& tables = GetSrgbTables();
+			for (uint32_t y = inFirstRow; y < inFirstRow + inRowCount; y++)
+			{
+				const FilterTaps& tapY = inTapsY[y];
+				for (uint32_t x = 0; x < inWidth; x++)
+				{
+					const FilterTaps& tapX = inTapsX[x];
+					float sum[TextureCooker::CHANNELS_COUNT] = {};
+					for (uint32_t offsetY = 0; offsetY < tapY.count; offsetY++)
+					{
+						const uint8_t* row = inSource + static_cast<size_t>(tapY.first + offsetY) * inSourceWidth * TextureCooker::CHANNELS_COUNT;
+						for (uint32_t offsetX = 0; offsetX < tapX.count; offsetX++)
+						{
+							const uint8_t* texel = row + static_cast<size_t>(tapX.first + offsetX) * TextureCooker::CHANNELS_COUNT;
+							float weight = tapY.weights[offsetY] * tapX.weights[offsetX];
+							for (uint32_t channel = 0; channel < 3; channel++)
+							{
+								sum[channel] += weight * (inSrgb ? tables.toLinear[texel[channel]] : texel[channel] / 255.0f);
+							}
+							sum[3] += weight * texel[3] / 255.0f;
+						}
+					}
+
+					// averaged normals get shorter, so they are brought back to unit length
+					if (inNormalMap)
+					{
+						glm::vec3 normal = glm::vec3(sum[0], sum[1], sum[2]) * 2.0f - 1.0f;
+						float length = glm::length(normal);
+						normal = length > 1e-6f ? normal / length : glm::vec3(0.0f, 0.0f, 1.0f);
+						sum[0] = normal.x * 0.5f + 0.5f;
+						sum[1] = normal.y * 0.5f + 0.5f;
+						sum[2] = normal.z * 0.5f + 0.5f;
+					}
+
+					uint8_t* texel = outPixels + (static_cast<size_t>(y) * inWidth + x) * TextureCooker::CHANNELS_COUNT;
+					for (uint32_t channel = 0; channel < TextureCooker::CHANNELS_COUNT; channel++)
+					{
+						float value = std::clamp(sum[channel], 0.0f, 1.0f);
+						texel[channel] = (inSrgb && (channel < 3))
+							? tables.fromLinear[static_cast<uint32_t>(value * LINEAR_TO_SRGB_STEPS + 0.5f)]
+							: static_cast<uint8_t>(value * 255.0f + 0.5f);
+					}
+				}
+			}
+		}
+
+		// edge texels are repeated for blocks sticking out of the image
+		void CompressRows(const uint8_t* inPixels, uint32_t inWidth, uint32_t inHeight, ECookedTextureFormat inFormat, uint8_t* outBlocks, uint32_t inFirstRow, uint32_t inRowCount)
+		{
+			uint32_t rowPitch = CookedTexture::GetRowPitch(inFormat, inWidth);
+			uint32_t blockSize = CookedTexture::GetBlockSize(inFormat);
+			uint32_t blocksWide = rowPitch / blockSize;
+			uint8_t block[BlockCompression::BLOCK_PIXELS * TextureCooker::CHANNELS_COUNT];
+			uint8_t values[BlockCompression::BLOCK_PIXELS];
+			for (uint32_t blockY = inFirstRow; blockY < inFirstRow + inRowCount; blockY++)
+			{
+				for (uint32_t blockX = 0; blockX < blocksWide; blockX++)
+				{
+					for (uint32_t pixel = 0; pixel < BlockCompression::BLOCK_PIXELS; pixel++)
+					{
+						uint32_t x = std::min(blockX * BlockCompression::BLOCK_DIMENSION + pixel % BlockCompression::BLOCK_DIMENSION, inWidth - 1);
+						uint32_t y = std::min(blockY * BlockCompression::BLOCK_DIMENSION + pixel / BlockCompression::BLOCK_DIMENSION, inHeight - 1);
+						std::memcpy(block + pixel * TextureCooker::CHANNELS_COUNT, inPixels + (static_cast<size_t>(y) * inWidth + x) * TextureCooker::CHANNELS_COUNT, TextureCooker::CHANNELS_COUNT);
+						values[pixel] = block[pixel * TextureCooker::CHANNELS_COUNT];
+					}
+
+					uint8_t* output = outBlocks + static_cast<size_t>(blockY) * rowPitch + static_cast<size_t>(blockX) * blockSize;
+					switch (inFormat)
+					{
+					case ECookedTextureFormat::CTF_BC1:
+						BlockCompression::EncodeBC1(block, output);
+						break;
+					case ECookedTextureFormat::CTF_BC4:
+						BlockCompression::EncodeBC4(values, output);
+						break;
+					case ECookedTextureFormat::CTF_BC5:
+						BlockCompression::EncodeBC5(block, output);
+						break;
+					case ECookedTextureFormat::CTF_BC7:
+						BlockCompression::EncodeBC7(block, output);
+						break;
+					default:
+						break;
+					}
+				}
+			}
+		}
+
+		// blocks sticking out of the image are cut at the edges
+		void DecompressRows(const uint8_t* inBlocks, uint32_t inWidth, uint32_t inHeight, ECookedTextureFormat inFormat, uint8_t* outPixels, uint32_t inFirstRow, uint32_t inRowCount)
+		{
+			uint32_t rowPitch = CookedTexture::GetRowPitch(inFormat, inWidth);
+			uint32_t blockSize = CookedTexture::GetBlockSize(inFormat);
+			uint32_t blocksWide = rowPitch / blockSize;
+			uint8_t block[BlockCompression::BLOCK_PIXELS * TextureCooker::CHANNELS_COUNT];
+			uint8_t values[BlockCompression::BLOCK_PIXELS];
+			for (uint32_t blockY = inFirstRow; blockY < inFirstRow + inRowCount; blockY++)
+			{
+				for (uint32_t blockX = 0; blockX < blocksWide; blockX++)
+				{
+					const uint8_t* input = inBlocks + static_cast<size_t>(blockY) * rowPitch + static_cast<size_t>(blockX) * blockSize;
+					std::memset(block, 0, sizeof(block));
+					switch (inFormat)
+					{
+					case ECookedTextureFormat::CTF_BC1:
+						BlockCompression::DecodeBC1(input, block);
+						break;
+					case ECookedTextureFormat::CTF_BC4:
+						BlockCompression::DecodeBC4(input, values);
+						for (uint32_t pixel = 0; pixel < BlockCompression::BLOCK_PIXELS; pixel++)
+						{
+							block[pixel * TextureCooker::CHANNELS_COUNT] = values[pixel];
+						}
+						break;
+					case ECookedTextureFormat::CTF_BC5:
+						BlockCompression::DecodeBC5(input, block);
+						break;
+					case ECookedTextureFormat::CTF_BC7:
+						BlockCompression::DecodeBC7(input, block);
+						break;
+					default:
+						break;
+					}
+
+					for (uint32_t pixel = 0; pixel < BlockCompression::BLOCK_PIXELS; pixel++)
+					{
+						uint32_t x = blockX * BlockCompression::BLOCK_DIMENSION + pixel % BlockCompression::BLOCK_DIMENSION;
+						uint32_t y = blockY * BlockCompression::BLOCK_DIMENSION + pixel / BlockCompression::BLOCK_DIMENSION;
+						if ((x < inWidth) && (y < inHeight))
+						{
+							std::memcpy(outPixels + (static_cast<size_t>(y) * inWidth + x) * TextureCooker::CHANNELS_COUNT, block + pixel * TextureCooker::CHANNELS_COUNT, TextureCooker::CHANNELS_COUNT);
+						}
+					}
+				}
+			}
+		}
+
+		// over the channels the format keeps, BC5 normals are compared on red and green only
+		double GetPsnr(const std::vector<uint8_t>& inReference, const std::vector<uint8_t>& inPixels, uint32_t inChannelsCount)
+		{
+			double error = 0.0;
+			size_t count = 0;
+			for (size_t index = 0; index < inReference.size(); index += TextureCooker::CHANNELS_COUNT)
+			{
+				for (uint32_t channel = 0; channel < inChannelsCount; channel++)
+				{
+					double difference = static_cast<double>(inReference[index + channel]) - inPixels[index + channel];
+					error += difference * difference;
+					count++;
+				}
+			}
+			if (error == 0.0)
+			{
+				return 99.0;
+			}
+			return 10.0 * std::log10(255.0 * 255.0 / (error / count));
+		}
+	}
+
+	uint64_t TextureCooker::GetCookedSeed(const TextureCookSettings& inSettings)
+	{
+		uint64_t flags = (inSettings.flipVertical ? 1 : 0)
+			| (inSettings.srgb ? 2 : 0)
+			| (inSettings.useAlpha ? 4 : 0)
+			| (inSettings.genMips ? 8 : 0)
+			| (inSettings.compress ? 16 : 0)
+			| (inSettings.normalMap ? 32 : 0);
+		return (static_cast<uint64_t>(CookedTexture::VERSION) << 48) | flags;
+	}
+
+	bool TextureCooker::Decode(const std::string& inPath, bool inFlipVertical, std::vector<uint8_t>& outPixels, uint32_t& outWidth, uint32_t& outHeight)
+	{
+		int width, height, channels;
+		stbi_uc* pixels = stbi_load(inPath.c_str(), &width, &height, &channels, CHANNELS_COUNT);
+		if (pixels == nullptr)
+		{
+			return false;
+		}
+
+		outWidth = static_cast<uint32_t>(width);
+		outHeight = static_cast<uint32_t>(height);
+		outPixels.assign(pixels, pixels + static_cast<size_t>(width) * height * CHANNELS_COUNT);
+		stbi_image_free(pixels);
+		if (inFlipVertical)
+		{
+			FlipRows(outPixels.data(), outWidth, outHeight);
+		}
+		return true;
+	}
+
+	ECookedTextureFormat TextureCooker::SelectFormat(const TextureCookSettings& inSettings)
+	{
+		if (!inSettings.compress)
+		{
+			return ECookedTextureFormat::CTF_RGBA8;
+		}
+		// normals only need two channels at full precision, alpha needs BC7 since BC1 alpha is a single bit
+		if (inSettings.normalMap)
+		{
+			return ECookedTextureFormat::CTF_BC5;
+		}
+		return inSettings.useAlpha ? ECookedTextureFormat::CTF_BC7 : ECookedTextureFormat::CTF_BC1;
+	}
+
+	std::vector<uint8_t> TextureCooker::Compress(const uint8_t* inPixels, uint32_t inWidth, uint32_t inHeight, ECookedTextureFormat inFormat)
+	{
+		uint32_t rowCount = CookedTexture::GetRowCount(inFormat, inHeight);
+		std::vector<uint8_t> blocks(static_cast<size_t>(CookedTexture::GetRowPitch(inFormat, inWidth)) * rowCount);
+		uint8_t* output = blocks.data();
+		ForEachRowChunk(rowCount, [&](uint32_t inFirstRow, uint32_t inRowCount)
+		{
+			CompressRows(inPixels, inWidth, inHeight, inFormat, output, inFirstRow, inRowCount);
+		});
+		return blocks;
+	}
+
+	std::vector<uint8_t> TextureCooker::Decompress(const uint8_t* inBlocks, uint32_t inWidth, uint32_t inHeight, ECookedTextureFormat inFormat)
+	{
+		std::vector<uint8_t> pixels(static_cast<size_t>(inWidth) * inHeight * CHANNELS_COUNT);
+		uint8_t* output = pixels.data();
+		ForEachRowChunk(CookedTexture::GetRowCount(inFormat, inHeight), [&](uint32_t inFirstRow, uint32_t inRowCount)
+		{
+			DecompressRows(inBlocks, inWidth, inHeight, inFormat, output, inFirstRow, inRowCount);
+		});
+		return pixels;
+	}
+
+	void TextureCooker::RunBenchmark(const std::vector<std::string>& inPaths)
+	{
+		struct BenchmarkFormat
+		{
+			ECookedTextureFormat format;
+			const char* name;
+			uint32_t channelsCount;
+		};
+		static const BenchmarkFormat formats[] = {
+			{ ECookedTextureFormat::CTF_BC1, "BC1", 3 },
+			{ ECookedTextureFormat::CTF_BC5, "BC5", 2 },
+			{ ECookedTextureFormat::CTF_BC7, "BC7", 4 }
+		};
+
+		for (const std::string& path : inPaths)
+		{
+			std::vector<uint8_t> pixels;
+			uint32_t width, height;
+			if (!Decode(path, false, pixels, width, height))
+			{
+				std::cout << "TextureCooker benchmark failed to decode " << path << std::endl;
+				continue;
+			}
+
+			for (const BenchmarkFormat& entry : formats)
+			{
+				auto encodeStart = std::chrono::high_resolution_clock::now();
+				std::vector<uint8_t> blocks = Compress(pixels.data(), width, height, entry.format);
+				double encodeMs = GetElapsedMs(encodeStart);
+				std::vector<uint8_t> decoded = Decompress(blocks.data(), width, height, entry.format);
+
+				std::cout << "TextureCooker benchmark " << path << " " << width << "x" << height << " " << entry.name
+					<< ": PSNR " << GetPsnr(pixels, decoded, entry.channelsCount) << " dB, encode " << encodeMs << " ms, "
+					<< blocks.size() << " bytes, " << static_cast<double>(pixels.size()) / blocks.size() << "x smaller than RGBA8" << std::endl;
+			}
+		}
+	}
+
+	bool TextureCooker::Cook(const std::string& inSourcePath, const std::string& inCookedPath, uint64_t inSourceHash, const TextureCookSettings& inSettings)
+	{
+		m_stats = TextureCookStats();
+
+		auto decodeStart = std::chrono::high_resolution_clock::now();
+		std::vector<std::vector<uint8_t>> levels(1);
+		uint32_t width, height;
+		if (!Decode(inSourcePath, inSettings.flipVertical, levels[0], width, height))
+		{
+			std::cout << "TextureCooker failed to decode " << inSourcePath << std::endl;
+			return false;
+		}
+		m_stats.decodeMs = GetElapsedMs(decodeStart);
+
+		// each level is filtered from the previous one, halving with round down to the 1x1 one
+		auto mipsStart = std::chrono::high_resolution_clock::now();
+		std::vector<glm::uvec2> sizes = { glm::uvec2(width, height) };
+		while (inSettings.genMips && ((sizes.back().x > 1) || (sizes.back().y > 1)))
+		{
+			glm::uvec2 sourceSize = sizes.back();
+			glm::uvec2 size = glm::max(sourceSize / 2u, glm::uvec2(1));
+			std::vector<FilterTaps> tapsX = CreateFilterTaps(sourceSize.x, size.x);
+			std::vector<FilterTaps> tapsY = CreateFilterTaps(sourceSize.y, size.y);
+			std::vector<uint8_t> level(static_cast<size_t>(size.x) * size.y * CHANNELS_COUNT);
+			const uint8_t* source = levels.back().data();
+			uint8_t* output = level.data();
+			ForEachRowChunk(size.y, [&](uint32_t inFirstRow, uint32_t inRowCount)
+			{
+				DownsampleRows(source, sourceSize.x, output, size.x, tapsX, tapsY, inSettings.srgb, inSettings.normalMap, inFirstRow, inRowCount);
+			});
+			levels.push_back(std::move(level));
+			sizes.push_back(size);
+		}
+		m_stats.mipsMs = GetElapsedMs(mipsStart);
+
+		auto compressStart = std::chrono::high_resolution_clock::now();
+		ECookedTextureFormat format = SelectFormat(inSettings);
+		if (format != ECookedTextureFormat::CTF_RGBA8)
+		{
+			for (size_t levelIndex = 0; levelIndex < levels.size(); levelIndex++)
+			{
+				levels[levelIndex] = Compress(levels[levelIndex].data(), sizes[levelIndex].x, sizes[levelIndex].y, format);
+			}
+		}
+		m_stats.compressMs = GetElapsedMs(compressStart);
+
+		auto writeStart = std::chrono::high_resolution_clock::now();
+		std::vector<CookedTextureMipSource> mips;
+		for (size_t levelIndex = 0; levelIndex < levels.size(); levelIndex++)
+		{
+			mips.push_back({ levels[levelIndex].data(), levels[levelIndex].size(), sizes[levelIndex].x, sizes[levelIndex].y });
+			m_stats.cookedBytes += levels[levelIndex].size();
+		}
+		if (!CookedTexture::Write(inCookedPath, inSourceHash, format, mips))
+		{
+			std::cout << "TextureCooker failed to write " << inCookedPath << std::endl;
+			return false;
+		}
+		m_stats.writeMs = GetElapsedMs(writeStart);
+
+		m_stats.width = width;
+		m_stats.height = height;
+		m_stats.mipCount = static_cast<uint32_t>(levels.size());
+		m_stats.format = format;
+		std::cout << "TextureCooker " << inSourcePath << " cooked " << width << "x" << height << ", mips " << m_stats.mipCount
+			<< ", format " << static_cast<uint32_t>(format) << ", " << m_stats.cookedBytes << " bytes: decode " << m_stats.decodeMs
+			<< " ms, mips " << m_stats.mipsMs << " ms, compress " << m_stats.compressMs << " ms, write " << m_stats.writeMs << " ms" << std::endl;
+		return true;
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "import/CookedTexture.h"
+
+namespace CGE
+{
+	struct TextureCookSettings
+	{
+		bool flipVertical = true;
+		// color channels hold srgb encoded values and are filtered in linear space
+		bool srgb = false;
+		bool useAlpha = false;
+		// tangent space normals in red and green, blue is rebuilt in the shader and mips are renormalized
+		bool normalMap = false;
+		bool genMips = true;
+		// block compression is only used if the device can sample it
+		bool compress = true;
+	};
+
+	struct TextureCookStats
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t mipCount = 0;
+		ECookedTextureFormat format = ECookedTextureFormat::CTF_RGBA8;
+		double decodeMs = 0.0;
+		double mipsMs = 0.0;
+		double compressMs = 0.0;
+		double writeMs = 0.0;
+		uint64_t cookedBytes = 0;
+	};
+
+	// Offline side of the texture loading: decode, mip chain and block compression, everything after the
+	// decode is split into row ranges over the thread pool.
+	class TextureCooker
+	{
+	public:
+		static constexpr uint32_t CHANNELS_COUNT = 4;
+
+		// import settings and container version are part of the hash, changing any of them cooks again
+		static uint64_t GetCookedSeed(const TextureCookSettings& inSettings);
+		// always CHANNELS_COUNT per pixel
+		static bool Decode(const std::string& inPath, bool inFlipVertical, std::vector<uint8_t>& outPixels, uint32_t& outWidth, uint32_t& outHeight);
+		static ECookedTextureFormat SelectFormat(const TextureCookSettings& inSettings);
+		// CHANNELS_COUNT per pixel in, rows of blocks out, split over the thread pool
+		static std::vector<uint8_t> Compress(const uint8_t* inPixels, uint32_t inWidth, uint32_t inHeight, ECookedTextureFormat inFormat);
+		static std::vector<uint8_t> Decompress(const uint8_t* inBlocks, uint32_t inWidth, uint32_t inHeight, ECookedTextureFormat inFormat);
+
+		// encodes the top level of every file with each block format and prints PSNR, timings and sizes, nothing is written
+		static void RunBenchmark(const std::vector<std::string>& inPaths);
+
+		bool Cook(const std::string& inSourcePath, const std::string& inCookedPath, uint64_t inSourceHash, const TextureCookSettings& inSettings);
+		const TextureCookStats& GetStats() const { return m_stats; }
+	private:
+		TextureCookStats m_stats;
+	};
+}
@@ -0,0 +1,289 @@
+#include "render/BindlessTable.h"
+#include "render/objects/VulkanDevice.h"
+#include "render/MaterialConstantsArena.h"
+#include "utils/ResourceUtils.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+namespace CGE
+{
+
+	BindlessTable::BindlessTable()
+	{
+	}
+
+	BindlessTable::~BindlessTable()
+	{
+	}
+
+	void BindlessTable::Create(VulkanDevice* inVulkanDevice, MaterialConstantsArena* inConstantsArena)
+	{
+		m_vulkanDevice = inVulkanDevice;
+		m_constantsArena = inConstantsArena;
+		vk::Device& device = m_vulkanDevice->GetDevice();
+
+		std::array<vk::DescriptorSetLayoutBinding, 3> bindings;
+		bindings[0] = vk::DescriptorSetLayoutBinding(TEXTURES_BINDING, vk::DescriptorType::eSampledImage, MAX_TEXTURES, vk::ShaderStageFlagBits::eAll);
+		bindings[1] = vk::DescriptorSetLayoutBinding(BUFFERS_BINDING, vk::DescriptorType::eStorageBuffer, MAX_BUFFERS, vk::ShaderStageFlagBits::eAll);
+		bindings[2] = vk::DescriptorSetLayoutBinding(MATERIALS_BINDING, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eAll);
+
+		// not a layout cache one, nothing else has update after bind layouts
+		vk::StructureChain<vk::DescriptorSetLayoutCreateInfo, vk::DescriptorSetLayoutBindingFlagsCreateInfo> chain;
+		std::vector<vk::DescriptorBindingFlags> flags(bindings.size(), vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eUpdateAfterBind);
+		chain.get<vk::DescriptorSetLayoutBindingFlagsCreateInfo>().setBindingFlags(flags);
+		vk::DescriptorSetLayoutCreateInfo& layoutInfo = chain.get<vk::DescriptorSetLayoutCreateInfo>();
+		layoutInfo.setFlags(vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool);
+		layoutInfo.setBindings(bindings);
+		m_layout = device.createDescriptorSetLayout(layoutInfo);
+
+		std::array<vk::DescriptorPoolSize, 2> poolSizes;
+		poolSizes[0] = vk::DescriptorPoolSize(vk::DescriptorType::eSampledImage, MAX_TEXTURES);
+		poolSizes[1] = vk::DescriptorPoolSize(vk::DescriptorType::eStorageBuffer, MAX_BUFFERS + 1);
+		vk::DescriptorPoolCreateInfo poolInfo;
+		poolInfo.setFlags(vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind);
+		poolInfo.setPoolSizes(poolSizes);
+		poolInfo.setMaxSets(1);
+		m_pool = device.createDescriptorPool(poolInfo);
+
+		vk::DescriptorSetAllocateInfo allocInfo;
+		allocInfo.setDescriptorPool(m_pool);
+		allocInfo.setSetLayouts(m_layout);
+		m_set = device.allocateDescriptorSets(allocInfo)[0];
+
+		m_textureSlots.Reset(MAX_TEXTURES);
+		m_bufferSlots.Reset(MAX_BUFFERS);
+		m_materialSlots.Reset(MAX_MATERIALS);
+
+		m_materialsOffset = m_constantsArena->Allocate(MAX_MATERIALS * MATERIAL_BLOCK_SIZE);
+		if (m_materialsOffset == MaterialConstantsArena::INVALID_OFFSET)
+		{
+			throw std::runtime_error("material constants arena can't fit the bindless material blocks");
+		}
+
+		vk::DescriptorBufferInfo materialsInfo = m_constantsArena->GetDescriptorInfo(m_materialsOffset, MAX_MATERIALS * MATERIAL_BLOCK_SIZE);
+		vk::WriteDescriptorSet write;
+		write.setDstSet(m_set);
+		write.setDstBinding(MATERIALS_BINDING);
+		write.setDescriptorType(vk::DescriptorType::eStorageBuffer);
+		write.setDescriptorCount(1);
+		write.setPBufferInfo(&materialsInfo);
+		device.updateDescriptorSets(1, &write, 0, nullptr);
+	}
+
+	void BindlessTable::Destroy()
+	{
+		if (!m_vulkanDevice)
+		{
+			return;
+		}
+		vk::Device& device = m_vulkanDevice->GetDevice();
+		// the set goes with its pool
+		device.destroyDescriptorPool(m_pool);
+		device.destroyDescriptorSetLayout(m_layout);
+		m_pool = nullptr;
+		m_layout = nullptr;
+		m_set = nullptr;
+
+		m_textures.clear();
+		m_buffers.clear();
+		m_dirtyTextures.clear();
+		m_dirtyBuffers.clear();
+		m_retired.clear();
+		m_constantsArena->Free(m_materialsOffset);
+		m_constantsArena = nullptr;
+		m_vulkanDevice = nullptr;
+	}
+
+	uint32_t BindlessTable::AddTexture(TextureDataPtr inTexture)
+	{
+		if (!inTexture)
+		{
+			return MaterialParameterLayout::INVALID_INDEX;
+		}
+		auto it = m_textures.find(inTexture.get());
+		if (it != m_textures.end())
+		{
+			it->second.refCount++;
+			return it->second.slot;
+		}
+
+		uint32_t slot = m_textureSlots.Allocate();
+		if (slot == SlotAllocator::INVALID_SLOT)
+		{
+			return MaterialParameterLayout::INVALID_INDEX;
+		}
+		m_textures[inTexture.get()] = { inTexture, slot, 1, inTexture->GetResidencyVersion() };
+		m_dirtyTextures.push_back(inTexture.get());
+		return slot;
+	}
+
+	void BindlessTable::RemoveTexture(TextureData* inTexture)
+	{
+		auto it = m_textures.find(inTexture);
+		if ((it == m_textures.end()) || (--it->second.refCount > 0))
+		{
+			return;
+		}
+		// the element keeps pointing at the view until the slot is reused, so the texture has to stay alive
+		m_retired.push_back({ m_frame, it->second.texture, nullptr });
+		m_textureSlots.Free(it->second.slot, m_frame);
+		m_textures.erase(it);
+	}
+
+	uint32_t BindlessTable::AddBuffer(BufferDataPtr inBuffer)
+	{
+		if (!inBuffer)
+		{
+			return MaterialParameterLayout::INVALID_INDEX;
+		}
+		auto it = m_buffers.find(inBuffer.get());
+		if (it != m_buffers.end())
+		{
+			it->second.refCount++;
+			return it->second.slot;
+		}
+
+		uint32_t slot = m_bufferSlots.Allocate();
+		if (slot == SlotAllocator::INVALID_SLOT)
+		{
+			return MaterialParameterLayout::INVALID_INDEX;
+		}
+		m_buffers[inBuffer.get()] = { inBuffer, slot, 1 };
+		m_dirtyBuffers.push_back(inBuffer.get());
+		return slot;
+	}
+
+	void BindlessTable::RemoveBuffer(BufferData* inBuffer)
+	{
+		auto it = m_buffers.find(inBuffer);
+		if ((it == m_buffers.end()) || (--it->second.refCount > 0))
+		{
+			return;
+		}
+		m_retired.push_back({ m_frame, nullptr, it->second.buffer });
+		m_bufferSlots.Free(it->second.slot, m_frame);
+		m_buffers.erase(it);
+	}
+
+	uint32_t BindlessTable::AddMaterial(const MaterialParameterBlock& inParameters)
+	{
+		if (inParameters.GetData().size() * sizeof(uint32_t) > MATERIAL_BLOCK_SIZE)
+		{
+			return MaterialParameterLayout::INVALID_INDEX;
+		}
+		uint32_t slot = m_materialSlots.Allocate();
+		if (slot == SlotAllocator::INVALID_SLOT)
+		{
+			return MaterialParameterLayout::INVALID_INDEX;
+		}
+		UpdateMaterial(slot, inParameters);
+		return slot;
+	}
+
+	void BindlessTable::UpdateMaterial(uint32_t inSlot, const MaterialParameterBlock& inParameters)
+	{
+		const std::vector<uint32_t>& data = inParameters.GetData();
+		if (!m_materialSlots.IsAllocated(inSlot) || (data.size() * sizeof(uint32_t) > MATERIAL_BLOCK_SIZE))
+		{
+			return;
+		}
+		// the whole block, so nothing of a previous material is left after the data
+		std::array<uint32_t, MATERIAL_BLOCK_SIZE / sizeof(uint32_t)> block = {};
+		std::copy(data.begin(), data.end(), block.begin());
+		m_constantsArena->Write(m_materialsOffset + inSlot * MATERIAL_BLOCK_SIZE, MATERIAL_BLOCK_SIZE, block.data());
+	}
+
+	void BindlessTable::RemoveMaterial(uint32_t inSlot)
+	{
+		m_materialSlots.Free(inSlot, m_frame);
+	}
+
+	void BindlessTable::Update(uint64_t inFrame, uint64_t inCompletedFrames)
+	{
+		m_frame = inFrame;
+		m_textureSlots.Collect(inCompletedFrames, 1);
+		m_bufferSlots.Collect(inCompletedFrames, 1);
+		m_materialSlots.Collect(inCompletedFrames, 1);
+		while (!m_retired.empty() && (m_retired.front().frame < inCompletedFrames))
+		{
+			m_retired.pop_front();
+		}
+
+		// streamed and reloaded textures swap their views in place
+		for (auto& pair : m_textures)
+		{
+			if (pair.second.version != pair.second.texture->GetResidencyVersion())
+			{
+				pair.second.version = pair.second.texture->GetResidencyVersion();
+				m_dirtyTextures.push_back(pair.first);
+			}
+		}
+		WriteDescriptors();
+	}
+
+	void BindlessTable::WriteDescriptors()
+	{
+		if (m_dirtyTextures.empty() && m_dirtyBuffers.empty())
+		{
+			return;
+		}
+
+		// infos are sized up front, writes point into them
+		std::vector<vk::DescriptorImageInfo> imageInfos;
+		std::vector<vk::DescriptorBufferInfo> bufferInfos;
+		imageInfos.reserve(m_dirtyTextures.size());
+		bufferInfos.reserve(m_dirtyBuffers.size());
+		std::vector<vk::WriteDescriptorSet> writes;
+		writes.reserve(m_dirtyTextures.size() + m_dirtyBuffers.size());
+
+		std::sort(m_dirtyTextures.begin(), m_dirtyTextures.end());
+		m_dirtyTextures.erase(std::unique(m_dirtyTextures.begin(), m_dirtyTextures.end()), m_dirtyTextures.end());
+		for (TextureData* texture : m_dirtyTextures)
+		{
+			auto it = m_textures.find(texture);
+			if (it == m_textures.end())
+			{
+				continue;
+			}
+			imageInfos.push_back(it->second.texture->GetDescriptorInfo(vk::ImageLayout::eShaderReadOnlyOptimal));
+			vk::WriteDescriptorSet write;
+			write.setDstSet(m_set);
+			write.setDstBinding(TEXTURES_BINDING);
+			write.setDstArrayElement(it->second.slot);
+			write.setDescriptorType(vk::DescriptorType::eSampledImage);
+			write.setDescriptorCount(1);
+			write.setPImageInfo(&imageInfos.back());
+			writes.push_back(write);
+		}
+
+		std::sort(m_dirtyBuffers.begin(), m_dirtyBuffers.end());
+		m_dirtyBuffers.erase(std::unique(m_dirtyBuffers.begin(), m_dirtyBuffers.end()), m_dirtyBuffers.end());
+		for (BufferData* buffer : m_dirtyBuffers)
+		{
+			auto it = m_buffers.find(buffer);
+			if (it == m_buffers.end())
+			{
+				continue;
+			}
+			bufferInfos.push_back(it->second.buffer->GetBuffer().GetDescriptorInfo());
+			vk::WriteDescriptorSet write;
+			write.setDstSet(m_set);
+			write.setDstBinding(BUFFERS_BINDING);
+			write.setDstArrayElement(it->second.slot);
+			write.setDescriptorType(vk::DescriptorType::eStorageBuffer);
+			write.setDescriptorCount(1);
+			write.setPBufferInfo(&bufferInfos.back());
+			writes.push_back(write);
+		}
+
+		m_dirtyTextures.clear();
+		m_dirtyBuffers.clear();
+		if (!writes.empty())
+		{
+			m_vulkanDevice->GetDevice().updateDescriptorSets(static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+		}
+	}
+
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include "vulkan/vulkan.hpp"
+
+#include "data/TextureData.h"
+#include "data/BufferData.h"
+#include "render/MaterialParameters.h"
+#include "utils/SlotAllocator.h"
+
+namespace CGE
+{
+	class VulkanDevice;
+	class MaterialConstantsArena;
+
+	// One descriptor set shared by all bindless materials: a large array of sampled images, a large array of
+	// storage buffers and the buffer of material parameter blocks. Materials only hold indices into these,
+	// so draws of all materials of a shader go with a single bind of this set. The set is update after bind,
+	// elements are written while frames in flight use other ones, and freed elements are reused only after
+	// those frames are done. Everything here runs on the main thread.
+	class BindlessTable
+	{
+	public:
+		// replaces set 1 of the materials using it, set 0 is the per frame one
+		static constexpr uint32_t SET_INDEX = 1;
+		static constexpr uint32_t TEXTURES_BINDING = 0;
+		static constexpr uint32_t BUFFERS_BINDING = 1;
+		static constexpr uint32_t MATERIALS_BINDING = 2;
+		static constexpr uint32_t MAX_TEXTURES = 4096;
+		static constexpr uint32_t MAX_BUFFERS = 1024;
+		static constexpr uint32_t MAX_MATERIALS = 4096;
+		// bytes of a material block, layouts bigger than that don't fit
+		static constexpr uint32_t MATERIAL_BLOCK_SIZE = 64;
+
+		BindlessTable();
+		~BindlessTable();
+
+		// material blocks are one range of the constants arena, it has to outlive the table
+		void Create(VulkanDevice* inVulkanDevice, MaterialConstantsArena* inConstantsArena);
+		void Destroy();
+
+		// adding the same texture or buffer again only takes one more reference to its element
+		uint32_t AddTexture(TextureDataPtr inTexture);
+		void RemoveTexture(TextureData* inTexture);
+		uint32_t AddBuffer(BufferDataPtr inBuffer);
+		void RemoveBuffer(BufferData* inBuffer);
+		uint32_t AddMaterial(const MaterialParameterBlock& inParameters);
+		void UpdateMaterial(uint32_t inSlot, const MaterialParameterBlock& inParameters);
+		void RemoveMaterial(uint32_t inSlot);
+
+		// writes new elements and textures that swapped their images, changed material blocks go with the arena.
+		// freed elements come back once the gpu finished every frame before inCompletedFrames
+		void Update(uint64_t inFrame, uint64_t inCompletedFrames);
+
+		vk::DescriptorSet GetSet() const { return m_set; }
+		vk::DescriptorSetLayout GetLayout() const { return m_layout; }
+	private:
+		struct TextureEntry
+		{
+			TextureDataPtr texture;
+			uint32_t slot;
+			uint32_t refCount;
+			// residency version the element was written with
+			uint32_t version;
+		};
+
+		struct BufferEntry
+		{
+			BufferDataPtr buffer;
+			uint32_t slot;
+			uint32_t refCount;
+		};
+
+		struct RetiredResource
+		{
+			uint64_t frame;
+			TextureDataPtr texture;
+			BufferDataPtr buffer;
+		};
+
+		VulkanDevice* m_vulkanDevice = nullptr;
+		vk::DescriptorPool m_pool;
+		vk::DescriptorSetLayout m_layout;
+		vk::DescriptorSet m_set;
+		MaterialConstantsArena* m_constantsArena = nullptr;
+		uint64_t m_materialsOffset = 0;
+
+		SlotAllocator m_textureSlots;
+		SlotAllocator m_bufferSlots;
+		SlotAllocator m_materialSlots;
+		std::unordered_map<TextureData*, TextureEntry> m_textures;
+		std::unordered_map<BufferData*, BufferEntry> m_buffers;
+		std::vector<TextureData*> m_dirtyTextures;
+		std::vector<BufferData*> m_dirtyBuffers;
+		std::deque<RetiredResource> m_retired;
+		uint64_t m_frame = 0;
+
+		void WriteDescriptors();
+	};
+}
@@ -0,0 +1,211 @@
+#include "render/ContentReloader.h"
+#include "render/PipelineRegistry.h"
+#include "render/TransferList.h"
+#include "render/Renderer.h"
+#include "core/Engine.h"
+#include "data/DataManager.h"
+#include "async/ThreadPool.h"
+#include "async/Job.h"
+#include <thread>
+
+namespace CGE
+{
+	ContentReloader::ContentReloader()
+	{
+	}
+
+	ContentReloader::~ContentReloader()
+	{
+	}
+
+	void ContentReloader::Update(uint64_t inFrame)
+	{
+		RefreshGraph(inFrame);
+		for (const std::string& path : m_watcher.Poll())
+		{
+			StartReload(path);
+		}
+
+		std::vector<ReloadTaskPtr> ready;
+		auto it = m_tasks.begin();
+		while (it != m_tasks.end())
+		{
+			ReloadTaskPtr task = it->second;
+			if (!task->loaded.load(std::memory_order_acquire))
+			{
+				++it;
+				continue;
+			}
+			if (!task->success)
+			{
+				printf("hot reload of %s failed, keeping the old one\n", task->path.c_str());
+				it = m_tasks.erase(it);
+				continue;
+			}
+
+			if (task->target && !task->uploading)
+			{
+				ObjectBase::Cast<TextureData>(task->resource)->PrepareReload(task->target);
+				task->uploading = true;
+				std::weak_ptr<ReloadTask> weakTask = task;
+				TransferList::GetInstance()->PushImage(task->target, 0, [weakTask](TextureDataPtr inTarget)
+					{
+						ReloadTaskPtr uploadedTask = weakTask.lock();
+						if (uploadedTask)
+						{
+							uploadedTask->uploaded = true;
+						}
+					});
+			}
+			if (!task->target || task->uploaded)
+			{
+				ready.push_back(task);
+				it = m_tasks.erase(it);
+				continue;
+			}
+			++it;
+		}
+
+		if (!ready.empty())
+		{
+			ApplyReloads(ready);
+		}
+	}
+
+	void ContentReloader::Cleanup()
+	{
+		// workers could still be loading into the targets
+		for (auto& pair : m_tasks)
+		{
+			while (!pair.second->loaded.load(std::memory_order_acquire))
+			{
+				std::this_thread::yield();
+			}
+		}
+		m_tasks.clear();
+		m_materials.clear();
+		m_pipelines.clear();
+		m_graph.Clear();
+	}
+
+	void ContentReloader::RefreshGraph(uint64_t inFrame)
+	{
+		uint64_t version;
+		ResourceSnapshot<Material> materials = DataManager::GetInstance()->GetResourcesSnapshot<Material>(&version);
+		if ((version == m_materialsVersion) && (inFrame < m_graphFrame + GRAPH_REFRESH_FRAMES))
+		{
+			return;
+		}
+		m_materialsVersion = version;
+		m_graphFrame = inFrame;
+
+		m_graph.Clear();
+		m_materials.clear();
+		m_pipelines.clear();
+		std::unordered_set<std::string> files;
+		auto addSource = [this, &files](ResourcePtr inResource, MaterialPtr inMaterial)
+		{
+			if (!inResource)
+			{
+				return;
+			}
+			// render targets and other generated textures have no file behind them
+			const std::string& path = inResource->GetResourceId().GetString();
+			if (m_watcher.Watch(path))
+			{
+				files.insert(path);
+				m_graph.AddDependency(inResource->GetResourceId(), inMaterial->GetResourceId());
+			}
+		};
+		for (const MaterialPtr& material : *materials)
+		{
+			addSource(material->GetVertexShader(), material);
+			addSource(material->GetFragmentShader(), material);
+			addSource(material->GetComputeShader(), material);
+			for (TextureDataPtr texture : material->GetAllTextures())
+			{
+				addSource(texture, material);
+			}
+			m_graph.AddDependency(material->GetResourceId(), material->GetHash());
+			m_materials[material->GetResourceId()] = material;
+			m_pipelines.insert(material->GetHash());
+		}
+
+		// files nothing uses anymore aren't watched
+		for (const std::string& path : m_watchedFiles)
+		{
+			if (files.find(path) == files.end())
+			{
+				m_watcher.Unwatch(path);
+			}
+		}
+		m_watchedFiles = std::move(files);
+	}
+
+	void ContentReloader::StartReload(const std::string& inPath)
+	{
+		ResourcePtr resource = DataManager::GetInstance()->GetResource(HashString(inPath));
+		if (!resource || !m_graph.HasNode(resource->GetResourceId()))
+		{
+			return;
+		}
+
+		ReloadTaskPtr task = std::make_shared<ReloadTask>();
+		task->resource = resource;
+		task->path = inPath;
+		TextureDataPtr texture = ObjectBase::Cast<TextureData>(resource);
+		if (texture)
+		{
+			task->target = texture->CreateReloadTarget();
+		}
+		else if (!ObjectBase::Cast<Shader>(resource))
+		{
+			return;
+		}
+		// the previous task of the file is dropped along with whatever it loaded
+		m_tasks[inPath] = task;
+
+		ThreadPool::GetInstance()->AddJob(CreateJobPtr<void()>([task]()
+			{
+				task->success = task->target ? task->target->Load() : Shader::ReadCode(task->path, task->code);
+				task->loaded.store(true, std::memory_order_release);
+			}));
+	}
+
+	void ContentReloader::ApplyReloads(const std::vector<ReloadTaskPtr>& inTasks)
+	{
+		// swapping modules, images and pipelines in place is only safe with nothing in flight, it's rare enough
+		Renderer* renderer = Engine::GetRendererInstance();
+		renderer->WaitForDevice();
+
+		std::vector<HashString> changed;
+		for (const ReloadTaskPtr& task : inTasks)
+		{
+			if (task->target)
+			{
+				// the target takes the old image and destroys it with itself
+				ObjectBase::Cast<TextureData>(task->resource)->ApplyReload(task->target);
+			}
+			else
+			{
+				ObjectBase::Cast<Shader>(task->resource)->Reload(std::move(task->code));
+			}
+			changed.push_back(task->resource->GetResourceId());
+			printf("hot reloaded %s\n", task->path.c_str());
+		}
+
+		for (const HashString& node : m_graph.CollectAffected(changed))
+		{
+			auto materialIt = m_materials.find(node);
+			MaterialPtr material = materialIt != m_materials.end() ? materialIt->second.lock() : nullptr;
+			if (material)
+			{
+				material->RebuildDescriptorSets();
+			}
+			if (m_pipelines.find(node) != m_pipelines.end())
+			{
+				PipelineRegistry::GetInstance()->DestroyShaderPipelines(&renderer->GetVulkanDevice(), node);
+			}
+		}
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "utils/FileWatcher.h"
+#include "data/DependencyGraph.h"
+#include "data/Material.h"
+
+namespace CGE
+{
+	// Hot reload of shaders and textures used by materials. Changed files are loaded again on the thread pool,
+	// textures are uploaded through the transfer list into a separate image, and once everything of a change is
+	// ready it's swapped in at the start of a frame together with the descriptor sets of the materials using it
+	// and their pipelines. Everything here runs on the main thread.
+	class ContentReloader
+	{
+	public:
+		// materials are looked up again this often even if none were added, textures could be set on them later
+		static constexpr uint64_t GRAPH_REFRESH_FRAMES = 120;
+
+		ContentReloader();
+		~ContentReloader();
+
+		void Update(uint64_t inFrame);
+		void Cleanup();
+
+		const DependencyGraph& GetGraph() const { return m_graph; }
+	private:
+		struct ReloadTask
+		{
+			ResourcePtr resource;
+			std::string path;
+			std::vector<char> code;
+			TextureDataPtr target;
+			// set by the worker when it's done with the file
+			std::atomic<bool> loaded{ false };
+			bool success = false;
+			bool uploading = false;
+			bool uploaded = false;
+		};
+		typedef std::shared_ptr<ReloadTask> ReloadTaskPtr;
+
+		FileWatcher m_watcher;
+		// files and resources loaded from them share keys, then materials and the pipelines made of them
+		DependencyGraph m_graph;
+		std::unordered_map<HashString, std::weak_ptr<Material>> m_materials;
+		std::unordered_set<HashString> m_pipelines;
+		std::unordered_set<std::string> m_watchedFiles;
+		uint64_t m_materialsVersion = ~0ull;
+		uint64_t m_graphFrame = 0;
+		// one task per file, a newer change replaces the task in progress
+		std::unordered_map<std::string, ReloadTaskPtr> m_tasks;
+
+		void RefreshGraph(uint64_t inFrame);
+		void StartReload(const std::string& inPath);
+		void ApplyReloads(const std::vector<ReloadTaskPtr>& inTasks);
+	};
+}
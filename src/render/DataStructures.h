@@ -6,6 +6,10 @@
 namespace CGE
 {
 	inline constexpr uint32_t g_GlobalTransformDataSize = 256 * 1024;
+	// instances tested by the draw culling pass a frame, meshes with meshlets take one per meshlet
+	inline constexpr uint32_t g_GpuDrawInstancesSize = 256 * 1024;
+	// culling batches a frame, one per shader with gpu drawn instances
+	inline constexpr uint32_t g_GpuDrawBatchesSize = 4096;
 	inline constexpr uint32_t g_LightsListSize = 1024;
 	inline constexpr glm::u32vec3 g_ClusteringResolution = { 32,32,64 };
 	inline constexpr uint32_t g_LightsPerCluster = 256;
@@ -34,6 +38,11 @@ namespace CGE
 	{
 		alignas(16) glm::mat4 modelToWorld[g_GlobalTransformDataSize];
 	};
+
+	struct alignas(16) GlobalTransformMaterialData
+	{
+		alignas(4) uint32_t materialIndex[g_GlobalTransformDataSize];
+	};
 	
 	// per object update
 	struct alignas(16) ObjectMVPData
@@ -0,0 +1,61 @@
+#include "render/DrawCommandBuilder.h"
+
+namespace CGE
+{
+	void DrawCommandBuilder::Clear()
+	{
+		m_instances.clear();
+		m_batches.clear();
+	}
+
+	uint32_t DrawCommandBuilder::BeginBatch()
+	{
+		m_batches.push_back({ static_cast<uint32_t>(m_instances.size()), 0 });
+		return static_cast<uint32_t>(m_batches.size() - 1);
+	}
+
+	void DrawCommandBuilder::AddMesh(uint32_t inFirstIndex, uint32_t inIndexCount, int32_t inVertexOffset, const glm::vec4& inBounds, uint32_t inTransformIndex)
+	{
+		GpuDrawInstance& instance = AddInstance(inFirstIndex, inIndexCount, inVertexOffset, inTransformIndex);
+		instance.center = glm::vec3(inBounds);
+		instance.radius = inBounds.w;
+	}
+
+	void DrawCommandBuilder::AddMeshlets(const std::vector<Meshlet>& inMeshlets, uint32_t inFirstIndex, int32_t inVertexOffset, uint32_t inTransformIndex)
+	{
+		for (const Meshlet& meshlet : inMeshlets)
+		{
+			GpuDrawInstance& instance = AddInstance(inFirstIndex + meshlet.firstIndex, meshlet.triangleCount * 3, inVertexOffset, inTransformIndex);
+			instance.center = meshlet.center;
+			instance.radius = meshlet.radius;
+			instance.coneAxis = meshlet.coneAxis;
+			instance.coneCutoff = meshlet.coneCutoff;
+		}
+	}
+
+	DrawIndexedCommand DrawCommandBuilder::MakeCommand(const GpuDrawInstance& inInstance)
+	{
+		return { inInstance.indexCount, 1, inInstance.firstIndex, inInstance.vertexOffset, inInstance.transformIndex };
+	}
+
+	GpuDrawInstance& DrawCommandBuilder::AddInstance(uint32_t inFirstIndex, uint32_t inIndexCount, int32_t inVertexOffset, uint32_t inTransformIndex)
+	{
+		// instances before the first batch would have nowhere to go
+		if (m_batches.empty())
+		{
+			BeginBatch();
+		}
+		m_batches.back().maxCommands++;
+
+		GpuDrawInstance instance = {};
+		instance.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+		instance.coneCutoff = 1.0f;
+		instance.transformIndex = inTransformIndex;
+		instance.batchIndex = static_cast<uint32_t>(m_batches.size() - 1);
+		instance.firstIndex = inFirstIndex;
+		instance.indexCount = inIndexCount;
+		instance.vertexOffset = inVertexOffset;
+		m_instances.push_back(instance);
+		return m_instances.back();
+	}
+}
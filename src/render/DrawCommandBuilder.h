@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "data/Meshlet.h"
+
+namespace CGE
+{
+	// has to match DrawCulling.comp, bounds and cone are in mesh space
+	struct GpuDrawInstance
+	{
+		glm::vec3 center;
+		float radius;
+		glm::vec3 coneAxis;
+		// 1 disables the cone test, same as Meshlet
+		float coneCutoff;
+		uint32_t transformIndex;
+		uint32_t batchIndex;
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		int32_t vertexOffset;
+		uint32_t padding[3];
+	};
+	static_assert(sizeof(GpuDrawInstance) == 64, "GpuDrawInstance is read by DrawCulling.comp as is");
+
+	// commands of a batch are a fixed range of the command buffer, its count is one word of the count buffer
+	struct GpuDrawBatch
+	{
+		uint32_t firstCommand;
+		uint32_t maxCommands;
+	};
+
+	// VkDrawIndexedIndirectCommand without the vulkan header, the builder is plain cpu code
+	struct DrawIndexedCommand
+	{
+		uint32_t indexCount;
+		uint32_t instanceCount;
+		uint32_t firstIndex;
+		int32_t vertexOffset;
+		uint32_t firstInstance;
+	};
+	static_assert(sizeof(DrawIndexedCommand) == 20, "DrawIndexedCommand has to match VkDrawIndexedIndirectCommand");
+
+	// Flattens the shader, material, mesh and instance lists of a frame into the instances the culling shader
+	// tests one thread each. An instance produces at most one command, so a batch reserves as many commands
+	// as it has instances and nothing is sized on the gpu. Meshes with meshlets become an instance per meshlet.
+	// The first instance of a command is the transform index, gl_InstanceIndex finds the transform with it.
+	class DrawCommandBuilder
+	{
+	public:
+		void Clear();
+		// instances added from now on go to a new batch, returns its index
+		uint32_t BeginBatch();
+		// whole mesh, inBounds is the mesh space bounding sphere
+		void AddMesh(uint32_t inFirstIndex, uint32_t inIndexCount, int32_t inVertexOffset, const glm::vec4& inBounds, uint32_t inTransformIndex);
+		// one instance per meshlet, meshlet ranges are relative to inFirstIndex
+		void AddMeshlets(const std::vector<Meshlet>& inMeshlets, uint32_t inFirstIndex, int32_t inVertexOffset, uint32_t inTransformIndex);
+
+		const std::vector<GpuDrawInstance>& GetInstances() const { return m_instances; }
+		const std::vector<GpuDrawBatch>& GetBatches() const { return m_batches; }
+		uint32_t GetCommandCount() const { return static_cast<uint32_t>(m_instances.size()); }
+		bool IsEmpty() const { return m_instances.empty(); }
+		// command the culling shader writes for a visible instance
+		static DrawIndexedCommand MakeCommand(const GpuDrawInstance& inInstance);
+	private:
+		std::vector<GpuDrawInstance> m_instances;
+		std::vector<GpuDrawBatch> m_batches;
+
+		GpuDrawInstance& AddInstance(uint32_t inFirstIndex, uint32_t inIndexCount, int32_t inVertexOffset, uint32_t inTransformIndex);
+	};
+}
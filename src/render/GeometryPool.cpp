@@ -0,0 +1,366 @@
+#include "render/GeometryPool.h"
+#include "render/objects/VulkanDevice.h"
+#include "data/MeshData.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace CGE
+{
+	namespace
+	{
+		static constexpr uint64_t VERTEX_STRIDE = sizeof(Vertex);
+		static constexpr uint64_t INDEX_STRIDE = sizeof(uint32_t);
+		// everything reading pooled geometry, the culling pass only reads draw instances
+		static const vk::PipelineStageFlags GEOMETRY_CONSUMER_STAGES =
+			vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR;
+		static constexpr uint64_t STAGING_ALIGNMENT = 16;
+
+		// what has to fit and half of it again, in powers of two so a growing scene repacks only a few times
+		uint64_t GetTargetCapacity(uint64_t inRequired, uint64_t inMin, uint64_t inMax)
+		{
+			uint64_t capacity = inMin;
+			while ((capacity < inRequired + inRequired / 2) && (capacity < inMax))
+			{
+				capacity *= 2;
+			}
+			return std::min(capacity, inMax);
+		}
+	}
+
+	GeometryPool::GeometryPool()
+	{
+	}
+
+	GeometryPool::~GeometryPool()
+	{
+	}
+
+	void GeometryPool::Create(VulkanDevice* inVulkanDevice)
+	{
+		m_vulkanDevice = inVulkanDevice;
+
+		m_vertices.Reset(MIN_VERTEX_CAPACITY, 1);
+		m_vertexBuffer = CreateBuffer("GeometryPool_vertices", MIN_VERTEX_CAPACITY * VERTEX_STRIDE, vk::BufferUsageFlagBits::eVertexBuffer);
+		m_indices.Reset(MIN_INDEX_CAPACITY, 1);
+		m_indexBuffer = CreateBuffer("GeometryPool_indices", MIN_INDEX_CAPACITY * INDEX_STRIDE, vk::BufferUsageFlagBits::eIndexBuffer);
+		CreateStaging(STAGING_SIZE);
+	}
+
+	void GeometryPool::Destroy()
+	{
+		m_vertexBuffer = nullptr;
+		m_vertices.Reset(0, 1);
+		m_indexBuffer = nullptr;
+		m_indices.Reset(0, 1);
+		m_allocations.clear();
+		m_freeHandles.clear();
+		m_pendingUploads.clear();
+		m_pendingMoves.clear();
+		m_inFlightSources.clear();
+		m_staging = nullptr;
+		m_stagingCapacity = 0;
+		m_stagingHead = 0;
+		m_stagingTail = 0;
+		m_vulkanDevice = nullptr;
+	}
+
+	GeometryHandle GeometryPool::Place(const Vertex* inVertices, uint32_t inVertexCount, const uint32_t* inIndices, uint32_t inIndexCount)
+	{
+		if (!m_indexBuffer || !inVertices || !inIndices || (inVertexCount == 0) || (inIndexCount == 0))
+		{
+			return INVALID_HANDLE;
+		}
+
+		uint64_t requiredVertices = m_vertices.GetAllocatedBytes() + inVertexCount;
+		uint64_t requiredIndices = m_indices.GetAllocatedBytes() + inIndexCount;
+		if ((requiredVertices > VERTEX_CAPACITY) || (requiredIndices > INDEX_CAPACITY))
+		{
+			m_rejectedCount++;
+			return INVALID_HANDLE;
+		}
+		GeometryRange range;
+		if (!Allocate(inVertexCount, inIndexCount, range))
+		{
+			// buffers too small or the space is in holes left by released meshes, packing into buffers sized
+			// for everything live and the new mesh covers both
+			Repack(requiredVertices, requiredIndices);
+			if (!Allocate(inVertexCount, inIndexCount, range))
+			{
+				m_rejectedCount++;
+				return INVALID_HANDLE;
+			}
+		}
+
+		uint64_t vertexBytes = inVertexCount * VERTEX_STRIDE;
+		uint64_t indexBytes = inIndexCount * INDEX_STRIDE;
+		uint64_t stagingOffset = AllocateStaging(vertexBytes + indexBytes);
+		char* mapped = m_staging->GetBuffer().Map(stagingOffset, vertexBytes + indexBytes);
+		std::memcpy(mapped, inVertices, vertexBytes);
+		std::memcpy(mapped + vertexBytes, inIndices, indexBytes);
+		m_staging->GetBuffer().Unmap();
+
+		GeometryHandle handle;
+		if (!m_freeHandles.empty())
+		{
+			handle = m_freeHandles.back();
+			m_freeHandles.pop_back();
+		}
+		else
+		{
+			handle = static_cast<GeometryHandle>(m_allocations.size());
+			m_allocations.emplace_back();
+		}
+		Allocation& allocation = m_allocations[handle];
+		allocation.range = range;
+		allocation.live = true;
+		allocation.uploaded = false;
+
+		m_pendingUploads.push_back({ handle, m_staging, stagingOffset, stagingOffset + vertexBytes });
+		m_placedCount++;
+		return handle;
+	}
+
+	void GeometryPool::Release(GeometryHandle inHandle)
+	{
+		if ((inHandle >= m_allocations.size()) || !m_allocations[inHandle].live)
+		{
+			return;
+		}
+
+		Allocation& allocation = m_allocations[inHandle];
+		m_vertices.Free(allocation.range.firstVertex, m_frame);
+		m_indices.Free(allocation.range.firstIndex, m_frame);
+		// a mesh gone before its upload leaves nothing to copy
+		m_pendingUploads.erase(
+			std::remove_if(m_pendingUploads.begin(), m_pendingUploads.end(), [inHandle](const PendingUpload& upload) { return upload.handle == inHandle; }),
+			m_pendingUploads.end());
+
+		allocation = Allocation();
+		m_freeHandles.push_back(inHandle);
+	}
+
+	GeometryRange GeometryPool::GetRange(GeometryHandle inHandle) const
+	{
+		if ((inHandle >= m_allocations.size()) || !m_allocations[inHandle].live)
+		{
+			return GeometryRange();
+		}
+		return m_allocations[inHandle].range;
+	}
+
+	bool GeometryPool::Compact()
+	{
+		if (!m_indexBuffer)
+		{
+			return false;
+		}
+		Repack(m_vertices.GetAllocatedBytes(), m_indices.GetAllocatedBytes());
+		return true;
+	}
+
+	void GeometryPool::Update(uint64_t inFrame, uint64_t inCompletedFrames)
+	{
+		m_frame = inFrame;
+		m_vertices.Collect(inCompletedFrames, 1);
+		m_indices.Collect(inCompletedFrames, 1);
+		while (!m_inFlightSources.empty() && (m_inFlightSources.front().frame < inCompletedFrames))
+		{
+			// positions of a ring that was replaced by a bigger one mean nothing for the current one
+			if (m_inFlightSources.front().staging == m_staging)
+			{
+				m_stagingTail = m_inFlightSources.front().stagingEnd;
+			}
+			m_inFlightSources.pop_front();
+		}
+	}
+
+	void GeometryPool::RecordUploads(vk::CommandBuffer& inCmdBuffer)
+	{
+		if (m_pendingUploads.empty() && m_pendingMoves.empty())
+		{
+			return;
+		}
+
+		// moved ranges were written by the uploads of earlier frames
+		vk::MemoryBarrier sourcesBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eTransferRead);
+		inCmdBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, vk::DependencyFlags(), 1, &sourcesBarrier, 0, nullptr, 0, nullptr);
+
+		InFlightSources sources;
+		sources.frame = m_frame;
+		sources.staging = m_staging;
+		sources.stagingEnd = m_stagingHead;
+		for (size_t index = 0; index < m_pendingMoves.size(); index++)
+		{
+			const PendingMove& move = m_pendingMoves[index];
+			// a second repack in the same frame reads what the first one just wrote
+			bool written = std::any_of(m_pendingMoves.begin(), m_pendingMoves.begin() + index, [&move](const PendingMove& previous) { return previous.destination == move.source; });
+			if (written)
+			{
+				inCmdBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, vk::DependencyFlags(), 1, &sourcesBarrier, 0, nullptr, 0, nullptr);
+			}
+			if (!move.regions.empty())
+			{
+				inCmdBuffer.copyBuffer(move.source->GetNativeBuffer(), move.destination->GetNativeBuffer(), static_cast<uint32_t>(move.regions.size()), move.regions.data());
+			}
+			sources.buffers.push_back(move.source);
+		}
+		m_pendingMoves.clear();
+
+		// ranges of uploads are never part of a move, the two never overlap
+		for (const PendingUpload& upload : m_pendingUploads)
+		{
+			Allocation& allocation = m_allocations[upload.handle];
+			vk::BufferCopy vertexCopy(upload.verticesOffset, allocation.range.firstVertex * VERTEX_STRIDE, allocation.range.vertexCount * VERTEX_STRIDE);
+			vk::BufferCopy indexCopy(upload.indicesOffset, allocation.range.firstIndex * INDEX_STRIDE, allocation.range.indexCount * INDEX_STRIDE);
+			inCmdBuffer.copyBuffer(upload.staging->GetNativeBuffer(), m_vertexBuffer->GetNativeBuffer(), 1, &vertexCopy);
+			inCmdBuffer.copyBuffer(upload.staging->GetNativeBuffer(), m_indexBuffer->GetNativeBuffer(), 1, &indexCopy);
+			allocation.uploaded = true;
+			if (upload.staging != m_staging)
+			{
+				sources.buffers.push_back(upload.staging);
+			}
+		}
+		m_pendingUploads.clear();
+		m_inFlightSources.push_back(std::move(sources));
+
+		std::vector<BufferMemoryBarrier> barriers;
+		barriers.push_back(m_vertexBuffer->GetBuffer().CreateMemoryBarrier(VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eShaderRead));
+		barriers.push_back(m_indexBuffer->GetBuffer().CreateMemoryBarrier(VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eIndexRead | vk::AccessFlagBits::eShaderRead));
+		inCmdBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, GEOMETRY_CONSUMER_STAGES, vk::DependencyFlags(), 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data(), 0, nullptr);
+	}
+
+	void GeometryPool::PrintStats()
+	{
+		std::printf("geometry pool: %llu of %llu vertices, %llu of %llu indices, %llu staging bytes, %llu meshes placed, %llu rejected, %llu repacks\n",
+			static_cast<unsigned long long>(m_vertices.GetAllocatedBytes()), static_cast<unsigned long long>(m_vertices.GetCapacity()),
+			static_cast<unsigned long long>(m_indices.GetAllocatedBytes()), static_cast<unsigned long long>(m_indices.GetCapacity()),
+			static_cast<unsigned long long>(m_stagingCapacity),
+			static_cast<unsigned long long>(m_placedCount), static_cast<unsigned long long>(m_rejectedCount), static_cast<unsigned long long>(m_compactionCount));
+	}
+
+	BufferDataPtr GeometryPool::CreateBuffer(const char* inName, uint64_t inSize, vk::BufferUsageFlags inUsage)
+	{
+		// not registered anywhere, buffers replaced by a compaction go away with their last copy
+		inUsage |= vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR;
+		BufferDataPtr buffer = ObjectBase::NewObject<BufferData>(HashString(std::string(inName) + "_" + std::to_string(m_bufferGeneration)), inSize, inUsage, true);
+		buffer->Create();
+		return buffer;
+	}
+
+	void GeometryPool::CreateStaging(uint64_t inSize)
+	{
+		m_stagingCapacity = inSize;
+		m_stagingHead = 0;
+		m_stagingTail = 0;
+		m_staging = ObjectBase::NewObject<BufferData>(HashString("GeometryPool_staging_" + std::to_string(inSize)), inSize, vk::BufferUsageFlagBits::eTransferSrc, false);
+		m_staging->Create();
+	}
+
+	uint64_t GeometryPool::AllocateStaging(uint64_t inSize)
+	{
+		uint64_t size = (inSize + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT;
+		// a range never wraps, the end of the buffer is skipped instead
+		uint64_t offset = m_stagingHead % m_stagingCapacity;
+		uint64_t skipped = (offset + size > m_stagingCapacity) ? m_stagingCapacity - offset : 0;
+		if (m_stagingHead + skipped + size - m_stagingTail > m_stagingCapacity)
+		{
+			// the ring is still read by frames in flight, their uploads keep the old one alive
+			uint64_t capacity = m_stagingCapacity * 2;
+			while (capacity < size)
+			{
+				capacity *= 2;
+			}
+			CreateStaging(capacity);
+			skipped = 0;
+		}
+		m_stagingHead += skipped;
+		offset = m_stagingHead % m_stagingCapacity;
+		m_stagingHead += size;
+		return offset;
+	}
+
+	bool GeometryPool::Allocate(uint32_t inVertexCount, uint32_t inIndexCount, GeometryRange& outRange)
+	{
+		uint64_t firstVertex = m_vertices.Allocate(inVertexCount);
+		if (firstVertex == RangeAllocator::INVALID_OFFSET)
+		{
+			return false;
+		}
+		uint64_t firstIndex = m_indices.Allocate(inIndexCount);
+		if (firstIndex == RangeAllocator::INVALID_OFFSET)
+		{
+			// frees have to stay in frame order, the unused vertex range waits like any other
+			m_vertices.Free(firstVertex, m_frame);
+			return false;
+		}
+
+		outRange.firstVertex = static_cast<uint32_t>(firstVertex);
+		outRange.vertexCount = inVertexCount;
+		outRange.firstIndex = static_cast<uint32_t>(firstIndex);
+		outRange.indexCount = inIndexCount;
+		return true;
+	}
+
+	void GeometryPool::Repack(uint64_t inVertexCount, uint64_t inIndexCount)
+	{
+		m_bufferGeneration++;
+
+		std::vector<GeometryHandle> handles;
+		for (GeometryHandle handle = 0; handle < m_allocations.size(); handle++)
+		{
+			if (m_allocations[handle].live)
+			{
+				handles.push_back(handle);
+			}
+		}
+
+		// current order is kept, meshes placed together stay next to each other. Ranges in the current buffers
+		// are final even with an earlier repack still waiting for its copies, moves are recorded in order
+		std::sort(handles.begin(), handles.end(), [this](GeometryHandle left, GeometryHandle right) {
+			return m_allocations[left].range.firstVertex < m_allocations[right].range.firstVertex;
+		});
+		uint64_t vertexCapacity = GetTargetCapacity(inVertexCount, MIN_VERTEX_CAPACITY, VERTEX_CAPACITY);
+		PendingMove vertexMove;
+		vertexMove.source = m_vertexBuffer;
+		vertexMove.destination = CreateBuffer("GeometryPool_vertices", vertexCapacity * VERTEX_STRIDE, vk::BufferUsageFlagBits::eVertexBuffer);
+		m_vertices.Reset(vertexCapacity, 1);
+		for (GeometryHandle handle : handles)
+		{
+			Allocation& allocation = m_allocations[handle];
+			// capacity covers everything live, packed it fits
+			uint64_t firstVertex = m_vertices.Allocate(allocation.range.vertexCount);
+			if (allocation.uploaded)
+			{
+				vertexMove.regions.emplace_back(allocation.range.firstVertex * VERTEX_STRIDE, firstVertex * VERTEX_STRIDE, allocation.range.vertexCount * VERTEX_STRIDE);
+			}
+			allocation.range.firstVertex = static_cast<uint32_t>(firstVertex);
+		}
+		m_vertexBuffer = vertexMove.destination;
+		m_pendingMoves.push_back(std::move(vertexMove));
+
+		std::sort(handles.begin(), handles.end(), [this](GeometryHandle left, GeometryHandle right) {
+			return m_allocations[left].range.firstIndex < m_allocations[right].range.firstIndex;
+		});
+		uint64_t indexCapacity = GetTargetCapacity(inIndexCount, MIN_INDEX_CAPACITY, INDEX_CAPACITY);
+		PendingMove indexMove;
+		indexMove.source = m_indexBuffer;
+		indexMove.destination = CreateBuffer("GeometryPool_indices", indexCapacity * INDEX_STRIDE, vk::BufferUsageFlagBits::eIndexBuffer);
+		m_indices.Reset(indexCapacity, 1);
+		for (GeometryHandle handle : handles)
+		{
+			Allocation& allocation = m_allocations[handle];
+			uint64_t firstIndex = m_indices.Allocate(allocation.range.indexCount);
+			if (allocation.uploaded)
+			{
+				indexMove.regions.emplace_back(allocation.range.firstIndex * INDEX_STRIDE, firstIndex * INDEX_STRIDE, allocation.range.indexCount * INDEX_STRIDE);
+			}
+			allocation.range.firstIndex = static_cast<uint32_t>(firstIndex);
+		}
+		m_indexBuffer = indexMove.destination;
+		m_pendingMoves.push_back(std::move(indexMove));
+
+		m_compactionCount++;
+	}
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include "vulkan/vulkan.hpp"
+
+#include "data/BufferData.h"
+#include "utils/RangeAllocator.h"
+
+namespace CGE
+{
+	class VulkanDevice;
+	struct Vertex;
+
+	// vertices and indices of a mesh inside the pool, in elements so they go to draw commands as they are
+	struct GeometryRange
+	{
+		static constexpr uint32_t INVALID = UINT32_MAX;
+
+		uint32_t firstVertex = INVALID;
+		uint32_t vertexCount = 0;
+		uint32_t firstIndex = INVALID;
+		uint32_t indexCount = 0;
+
+		bool IsValid() const { return firstVertex != INVALID; }
+	};
+
+	typedef uint32_t GeometryHandle;
+
+	// Shared vertex and index megabuffers every mesh lives in, so draws of many meshes need a single bind and can go as one indirect draw. Meshes get a
+	// handle, their range is looked up through it since compaction moves ranges around. Buffers start small
+	// and are repacked into bigger ones when a mesh doesn't fit. Data goes through a staging ring, its copies
+	// are recorded once a frame. Main thread only, placing and compacting happen between frames before the
+	// scene gathers its draws.
+	class GeometryPool
+	{
+	public:
+		static constexpr GeometryHandle INVALID_HANDLE = UINT32_MAX;
+		// in elements, buffers never grow past these
+		static constexpr uint64_t VERTEX_CAPACITY = 2 * 1024 * 1024;
+		static constexpr uint64_t INDEX_CAPACITY = 8 * 1024 * 1024;
+		static constexpr uint64_t MIN_VERTEX_CAPACITY = 64 * 1024;
+		static constexpr uint64_t MIN_INDEX_CAPACITY = 256 * 1024;
+		// bytes, grows when a mesh doesn't fit next to the uploads still in flight
+		static constexpr uint64_t STAGING_SIZE = 4 * 1024 * 1024;
+
+		GeometryPool();
+		~GeometryPool();
+
+		void Create(VulkanDevice* inVulkanDevice);
+		void Destroy();
+
+		// data is copied right away. Repacks when the ranges don't fit, invalid handle when they wouldn't fit
+		// even at full capacity
+		GeometryHandle Place(const Vertex* inVertices, uint32_t inVertexCount, const uint32_t* inIndices, uint32_t inIndexCount);
+		void Release(GeometryHandle inHandle);
+		GeometryRange GetRange(GeometryHandle inHandle) const;
+
+		// packs live ranges to the front of fresh buffers sized for them, the old ones are kept for frames in
+		// flight. Copies go with the next uploads
+		bool Compact();
+		// released ranges and staging of frames before inCompletedFrames come back
+		void Update(uint64_t inFrame, uint64_t inCompletedFrames);
+		// compaction moves and copies of meshes placed since the last call
+		void RecordUploads(vk::CommandBuffer& inCmdBuffer);
+
+		BufferDataPtr GetVertexBuffer() const { return m_vertexBuffer; }
+		BufferDataPtr GetIndexBuffer() const { return m_indexBuffer; }
+		void PrintStats();
+	private:
+		struct Allocation
+		{
+			GeometryRange range;
+			bool live = false;
+			// compaction has nothing to move before the upload
+			bool uploaded = false;
+		};
+		struct PendingUpload
+		{
+			GeometryHandle handle;
+			// the ring buffer it was written to, a grown ring leaves earlier uploads in the old one
+			BufferDataPtr staging;
+			uint64_t verticesOffset;
+			uint64_t indicesOffset;
+		};
+		struct PendingMove
+		{
+			BufferDataPtr source;
+			BufferDataPtr destination;
+			std::vector<vk::BufferCopy> regions;
+		};
+		struct InFlightSources
+		{
+			std::vector<BufferDataPtr> buffers;
+			uint64_t frame;
+			// ring of the frame and its position after the uploads
+			BufferDataPtr staging;
+			uint64_t stagingEnd;
+		};
+
+		VulkanDevice* m_vulkanDevice = nullptr;
+		BufferDataPtr m_vertexBuffer;
+		RangeAllocator m_vertices;
+		BufferDataPtr m_indexBuffer;
+		RangeAllocator m_indices;
+		std::vector<Allocation> m_allocations;
+		std::vector<GeometryHandle> m_freeHandles;
+		std::vector<PendingUpload> m_pendingUploads;
+		std::vector<PendingMove> m_pendingMoves;
+		// staging and pre compaction buffers stay alive until the frames copying out of them completed
+		std::deque<InFlightSources> m_inFlightSources;
+		BufferDataPtr m_staging;
+		uint64_t m_stagingCapacity = 0;
+		// running byte positions, the ring offset is the position modulo the capacity
+		uint64_t m_stagingHead = 0;
+		uint64_t m_stagingTail = 0;
+		uint64_t m_frame = 0;
+		uint32_t m_bufferGeneration = 0;
+
+		uint64_t m_placedCount = 0;
+		uint64_t m_rejectedCount = 0;
+		uint64_t m_compactionCount = 0;
+
+		BufferDataPtr CreateBuffer(const char* inName, uint64_t inSize, vk::BufferUsageFlags inUsage);
+		void CreateStaging(uint64_t inSize);
+		uint64_t AllocateStaging(uint64_t inSize);
+		bool Allocate(uint32_t inVertexCount, uint32_t inIndexCount, GeometryRange& outRange);
+		// moves live ranges into buffers sized for the given element counts
+		void Repack(uint64_t inVertexCount, uint64_t inIndexCount);
+	};
+}
@@ -0,0 +1,184 @@
+#include "render/MaterialConstantsArena.h"
+#include "render/objects/VulkanDevice.h"
+#include "utils/ResourceUtils.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+
+namespace CGE
+{
+	namespace
+	{
+		// everything reading material constants, uploads wait for the previous frames and block the next ones
+		static const vk::PipelineStageFlags CONSTANTS_CONSUMER_STAGES = vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eFragmentShader
+			| vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eRayTracingShaderKHR;
+	}
+
+	MaterialConstantsArena::MaterialConstantsArena()
+	{
+	}
+
+	MaterialConstantsArena::~MaterialConstantsArena()
+	{
+	}
+
+	void MaterialConstantsArena::Create(VulkanDevice* inVulkanDevice)
+	{
+		m_vulkanDevice = inVulkanDevice;
+
+		const vk::PhysicalDeviceLimits& limits = m_vulkanDevice->GetPhysicalDevice().GetLimits();
+		uint64_t alignment = std::max<uint64_t>({ limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment, 16 });
+		m_blocks.Reset(CAPACITY, alignment);
+		m_data.assign(CAPACITY, 0);
+
+		m_buffer = ResourceUtils::CreateBufferData(
+			"MaterialConstantsArena",
+			CAPACITY,
+			vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+			true);
+		for (uint32_t index = 0; index < STAGING_COUNT; index++)
+		{
+			m_freeStaging.push_back(CreateStaging());
+		}
+		// the first upload brings the whole buffer to a known state
+		m_dirtyRanges.push_back(vk::BufferCopy(0, 0, CAPACITY));
+	}
+
+	void MaterialConstantsArena::Destroy()
+	{
+		m_buffer = nullptr;
+		m_freeStaging.clear();
+		m_inFlightStaging.clear();
+		m_stagingCount = 0;
+		m_data.clear();
+		m_dirtyRanges.clear();
+		m_blocks.Reset(0, 1);
+		m_vulkanDevice = nullptr;
+	}
+
+	uint64_t MaterialConstantsArena::Allocate(uint64_t inSize)
+	{
+		uint64_t offset = m_blocks.Allocate(inSize);
+		if (offset == INVALID_OFFSET)
+		{
+			return INVALID_OFFSET;
+		}
+		// whatever the previous owner left there is not uploaded again unless the new one writes it
+		std::memset(m_data.data() + offset, 0, m_blocks.GetSize(offset));
+		m_dirtyRanges.push_back(vk::BufferCopy(offset, offset, m_blocks.GetSize(offset)));
+		return offset;
+	}
+
+	void MaterialConstantsArena::Free(uint64_t inOffset)
+	{
+		m_blocks.Free(inOffset, m_frame);
+	}
+
+	void MaterialConstantsArena::Write(uint64_t inOffset, uint64_t inSize, const void* inData)
+	{
+		if ((inData == nullptr) || (inSize == 0) || (inOffset + inSize > m_data.size()))
+		{
+			return;
+		}
+		std::memcpy(m_data.data() + inOffset, inData, inSize);
+		m_dirtyRanges.push_back(vk::BufferCopy(inOffset, inOffset, inSize));
+	}
+
+	void MaterialConstantsArena::Update(uint64_t inFrame, uint64_t inCompletedFrames)
+	{
+		m_frame = inFrame;
+		m_blocks.Collect(inCompletedFrames, 1);
+		while (!m_inFlightStaging.empty() && (m_inFlightStaging.front().frame < inCompletedFrames))
+		{
+			m_freeStaging.push_back(m_inFlightStaging.front().buffer);
+			m_inFlightStaging.pop_front();
+		}
+	}
+
+	void MaterialConstantsArena::RecordUploads(vk::CommandBuffer& inCmdBuffer)
+	{
+		if (m_dirtyRanges.empty())
+		{
+			return;
+		}
+		MergeDirtyRanges();
+
+		// ranges are sorted and apart, one mapping from the first to the last covers all of them
+		if (m_freeStaging.empty())
+		{
+			m_freeStaging.push_back(CreateStaging());
+		}
+		BufferDataPtr stagingData = m_freeStaging.back();
+		m_freeStaging.pop_back();
+		m_inFlightStaging.push_back({ stagingData, m_frame });
+		VulkanBuffer& staging = stagingData->GetBuffer();
+		uint64_t mappedOffset = m_dirtyRanges.front().srcOffset;
+		uint64_t mappedSize = m_dirtyRanges.back().srcOffset + m_dirtyRanges.back().size - mappedOffset;
+		char* mapped = staging.Map(mappedOffset, mappedSize);
+		for (const vk::BufferCopy& range : m_dirtyRanges)
+		{
+			std::memcpy(mapped + range.srcOffset - mappedOffset, m_data.data() + range.srcOffset, range.size);
+			m_uploadedBytes += range.size;
+		}
+		staging.Unmap();
+
+		// frames in flight could still read the old constants, the copy waits for them
+		inCmdBuffer.pipelineBarrier(CONSTANTS_CONSUMER_STAGES, vk::PipelineStageFlagBits::eTransfer, vk::DependencyFlags(), 0, nullptr, 0, nullptr, 0, nullptr);
+		inCmdBuffer.copyBuffer(staging.GetNativeBuffer(), m_buffer->GetNativeBuffer(), static_cast<uint32_t>(m_dirtyRanges.size()), m_dirtyRanges.data());
+		BufferMemoryBarrier barrier = m_buffer->GetBuffer().CreateMemoryBarrier(
+			VK_QUEUE_FAMILY_IGNORED,
+			VK_QUEUE_FAMILY_IGNORED,
+			vk::AccessFlagBits::eTransferWrite,
+			vk::AccessFlagBits::eUniformRead | vk::AccessFlagBits::eShaderRead);
+		inCmdBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, CONSTANTS_CONSUMER_STAGES, vk::DependencyFlags(), 0, nullptr, 1, &barrier, 0, nullptr);
+
+		m_uploadCount++;
+		m_uploadedRanges += m_dirtyRanges.size();
+		m_dirtyRanges.clear();
+	}
+
+	vk::DescriptorBufferInfo MaterialConstantsArena::GetDescriptorInfo(uint64_t inOffset, uint64_t inSize) const
+	{
+		return vk::DescriptorBufferInfo(m_buffer->GetNativeBuffer(), inOffset, inSize);
+	}
+
+	void MaterialConstantsArena::PrintStats()
+	{
+		std::printf("material constants: %llu of %llu bytes in blocks, %llu uploads of %llu ranges, %llu bytes, %u staging buffers\n",
+			static_cast<unsigned long long>(m_blocks.GetAllocatedBytes()), static_cast<unsigned long long>(m_blocks.GetCapacity()),
+			static_cast<unsigned long long>(m_uploadCount), static_cast<unsigned long long>(m_uploadedRanges), static_cast<unsigned long long>(m_uploadedBytes),
+			m_stagingCount);
+	}
+
+	BufferDataPtr MaterialConstantsArena::CreateStaging()
+	{
+		return ResourceUtils::CreateBufferData(
+			HashString("MaterialConstantsArena_staging") + std::to_string(m_stagingCount++),
+			CAPACITY,
+			vk::BufferUsageFlagBits::eTransferSrc,
+			false);
+	}
+
+	void MaterialConstantsArena::MergeDirtyRanges()
+	{
+		std::sort(m_dirtyRanges.begin(), m_dirtyRanges.end(), [](const vk::BufferCopy& inLeft, const vk::BufferCopy& inRight)
+			{
+				return inLeft.srcOffset < inRight.srcOffset;
+			});
+
+		// overlapping, touching and nearly touching ranges become one, copying a few untouched bytes costs less than a region
+		size_t merged = 0;
+		for (size_t index = 1; index < m_dirtyRanges.size(); index++)
+		{
+			vk::BufferCopy& last = m_dirtyRanges[merged];
+			const vk::BufferCopy& range = m_dirtyRanges[index];
+			if (range.srcOffset <= last.srcOffset + last.size + MERGE_GAP)
+			{
+				last.size = std::max(last.size, range.srcOffset + range.size - last.srcOffset);
+				continue;
+			}
+			m_dirtyRanges[++merged] = range;
+		}
+		m_dirtyRanges.resize(merged + 1);
+	}
+}
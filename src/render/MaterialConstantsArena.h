@@ -0,0 +1,75 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <cstdint>
+#include "vulkan/vulkan.hpp"
+
+#include "data/BufferData.h"
+#include "utils/RangeAllocator.h"
+
+namespace CGE
+{
+	class VulkanDevice;
+
+	// One buffer for the constants of all materials, sub-allocated into blocks aligned for uniform and storage
+	// descriptors. Writes land in a cpu copy and mark their range, once a frame the marked ranges are merged
+	// and go with a single copy command out of a staging buffer the gpu is done with. Blocks are addressed by offset,
+	// through a descriptor of the block range or as an index into the whole buffer. Main thread only.
+	class MaterialConstantsArena
+	{
+	public:
+		static constexpr uint64_t INVALID_OFFSET = RangeAllocator::INVALID_OFFSET;
+		static constexpr uint64_t CAPACITY = 4 * 1024 * 1024;
+		// marked ranges closer than this go as one copy region
+		static constexpr uint64_t MERGE_GAP = 256;
+		// staging buffers made up front, more are added while all of them are still read by frames in flight
+		static constexpr uint32_t STAGING_COUNT = 3;
+
+		MaterialConstantsArena();
+		~MaterialConstantsArena();
+
+		void Create(VulkanDevice* inVulkanDevice);
+		void Destroy();
+
+		// zeroed block, INVALID_OFFSET once the arena is full
+		uint64_t Allocate(uint64_t inSize);
+		void Free(uint64_t inOffset);
+		void Write(uint64_t inOffset, uint64_t inSize, const void* inData);
+
+		// frees and staging buffers of frames before inCompletedFrames come back
+		void Update(uint64_t inFrame, uint64_t inCompletedFrames);
+		// copies of everything written since the last call, nothing is recorded when nothing changed
+		void RecordUploads(vk::CommandBuffer& inCmdBuffer);
+
+		BufferDataPtr GetBuffer() const { return m_buffer; }
+		vk::DescriptorBufferInfo GetDescriptorInfo(uint64_t inOffset, uint64_t inSize) const;
+		uint64_t GetAlignment() const { return m_blocks.GetAlignment(); }
+		uint64_t GetAllocatedBytes() const { return m_blocks.GetAllocatedBytes(); }
+		void PrintStats();
+	private:
+		struct InFlightStaging
+		{
+			BufferDataPtr buffer;
+			uint64_t frame;
+		};
+
+		VulkanDevice* m_vulkanDevice = nullptr;
+		BufferDataPtr m_buffer;
+		// same layout as the buffer, a range is copied from the same offset it goes to
+		std::vector<BufferDataPtr> m_freeStaging;
+		std::deque<InFlightStaging> m_inFlightStaging;
+		uint32_t m_stagingCount = 0;
+		std::vector<uint8_t> m_data;
+		RangeAllocator m_blocks;
+		std::vector<vk::BufferCopy> m_dirtyRanges;
+		uint64_t m_frame = 0;
+
+		uint64_t m_uploadCount = 0;
+		uint64_t m_uploadedRanges = 0;
+		uint64_t m_uploadedBytes = 0;
+
+		BufferDataPtr CreateStaging();
+		void MergeDirtyRanges();
+	};
+}
@@ -0,0 +1,118 @@
+#include "render/MaterialParameters.h"
+#include <cstring>
+
+namespace CGE
+{
+	namespace
+	{
+		uint32_t AlignUp(uint32_t inValue, uint32_t inAlignment)
+		{
+			return (inValue + inAlignment - 1) / inAlignment * inAlignment;
+		}
+	}
+
+	uint32_t MaterialParameterLayout::GetFieldSize(FieldType inType)
+	{
+		switch (inType)
+		{
+		case FieldType::Vector2:
+			return 8;
+		case FieldType::Vector4:
+			return 16;
+		default:
+			return 4;
+		}
+	}
+
+	MaterialParameterLayout& MaterialParameterLayout::AddField(HashString inName, FieldType inType)
+	{
+		if (FindField(inName))
+		{
+			return *this;
+		}
+		// std430, every field is aligned to its own size
+		uint32_t size = GetFieldSize(inType);
+		uint32_t offset = AlignUp(m_size, size);
+		m_fields.push_back({ inName, inType, offset });
+		m_size = offset + size;
+		return *this;
+	}
+
+	const MaterialParameterLayout::Field* MaterialParameterLayout::FindField(HashString inName) const
+	{
+		for (const Field& field : m_fields)
+		{
+			if (field.name == inName)
+			{
+				return &field;
+			}
+		}
+		return nullptr;
+	}
+
+	uint32_t MaterialParameterLayout::GetSize() const
+	{
+		return AlignUp(m_size, BLOCK_ALIGNMENT);
+	}
+
+	MaterialParameterBlock::MaterialParameterBlock(MaterialParameterLayoutPtr inLayout)
+		: m_layout(inLayout)
+	{
+		if (!m_layout)
+		{
+			return;
+		}
+		m_data.resize(m_layout->GetSize() / sizeof(uint32_t), 0);
+		for (const MaterialParameterLayout::Field& field : m_layout->GetFields())
+		{
+			if ((field.type == MaterialParameterLayout::FieldType::TextureIndex) || (field.type == MaterialParameterLayout::FieldType::BufferIndex))
+			{
+				m_data[field.offset / sizeof(uint32_t)] = MaterialParameterLayout::INVALID_INDEX;
+			}
+		}
+	}
+
+	bool MaterialParameterBlock::SetIndex(HashString inName, uint32_t inIndex)
+	{
+		const MaterialParameterLayout::Field* field = m_layout ? m_layout->FindField(inName) : nullptr;
+		if (!field || ((field->type != MaterialParameterLayout::FieldType::TextureIndex) && (field->type != MaterialParameterLayout::FieldType::BufferIndex)))
+		{
+			return false;
+		}
+		m_data[field->offset / sizeof(uint32_t)] = inIndex;
+		return true;
+	}
+
+	bool MaterialParameterBlock::SetFloat(HashString inName, float inValue)
+	{
+		const MaterialParameterLayout::Field* field = m_layout ? m_layout->FindField(inName) : nullptr;
+		if (!field || (field->type != MaterialParameterLayout::FieldType::Float))
+		{
+			return false;
+		}
+		std::memcpy(&m_data[field->offset / sizeof(uint32_t)], &inValue, sizeof(float));
+		return true;
+	}
+
+	bool MaterialParameterBlock::SetVector(HashString inName, const glm::vec4& inValue)
+	{
+		const MaterialParameterLayout::Field* field = m_layout ? m_layout->FindField(inName) : nullptr;
+		if (!field || ((field->type != MaterialParameterLayout::FieldType::Vector2) && (field->type != MaterialParameterLayout::FieldType::Vector4)))
+		{
+			return false;
+		}
+		// vec2 fields take x and y only
+		std::memcpy(&m_data[field->offset / sizeof(uint32_t)], &inValue, MaterialParameterLayout::GetFieldSize(field->type));
+		return true;
+	}
+
+	uint32_t MaterialParameterBlock::GetIndex(HashString inName) const
+	{
+		const MaterialParameterLayout::Field* field = m_layout ? m_layout->FindField(inName) : nullptr;
+		if (!field || ((field->type != MaterialParameterLayout::FieldType::TextureIndex) && (field->type != MaterialParameterLayout::FieldType::BufferIndex)))
+		{
+			return MaterialParameterLayout::INVALID_INDEX;
+		}
+		return m_data[field->offset / sizeof(uint32_t)];
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "common/HashString.h"
+
+namespace CGE
+{
+	// Named fields of a material parameter block laid out by std430 rules, so a shader reads them straight
+	// from the bindless parameter buffer. Textures and buffers are indices into the bindless arrays.
+	class MaterialParameterLayout
+	{
+	public:
+		static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+		// blocks are padded to this, the shader steps through them in vec4s
+		static constexpr uint32_t BLOCK_ALIGNMENT = 16;
+
+		enum class FieldType : uint8_t
+		{
+			TextureIndex,
+			BufferIndex,
+			Float,
+			Vector2,
+			Vector4
+		};
+
+		struct Field
+		{
+			HashString name;
+			FieldType type;
+			// in bytes from the start of the block
+			uint32_t offset;
+		};
+
+		MaterialParameterLayout& AddTexture(HashString inName) { return AddField(inName, FieldType::TextureIndex); }
+		MaterialParameterLayout& AddBuffer(HashString inName) { return AddField(inName, FieldType::BufferIndex); }
+		MaterialParameterLayout& AddFloat(HashString inName) { return AddField(inName, FieldType::Float); }
+		MaterialParameterLayout& AddVector2(HashString inName) { return AddField(inName, FieldType::Vector2); }
+		MaterialParameterLayout& AddVector4(HashString inName) { return AddField(inName, FieldType::Vector4); }
+
+		const Field* FindField(HashString inName) const;
+		const std::vector<Field>& GetFields() const { return m_fields; }
+		uint32_t GetSize() const;
+
+		static uint32_t GetFieldSize(FieldType inType);
+	private:
+		std::vector<Field> m_fields;
+		uint32_t m_size = 0;
+
+		MaterialParameterLayout& AddField(HashString inName, FieldType inType);
+	};
+
+	typedef std::shared_ptr<const MaterialParameterLayout> MaterialParameterLayoutPtr;
+
+	// Packed values of one material, indices nobody set stay INVALID_INDEX and other fields zero
+	class MaterialParameterBlock
+	{
+	public:
+		MaterialParameterBlock(MaterialParameterLayoutPtr inLayout = nullptr);
+
+		// false when the layout has no such field or it's of another kind
+		bool SetIndex(HashString inName, uint32_t inIndex);
+		bool SetFloat(HashString inName, float inValue);
+		bool SetVector(HashString inName, const glm::vec4& inValue);
+
+		uint32_t GetIndex(HashString inName) const;
+		MaterialParameterLayoutPtr GetLayout() const { return m_layout; }
+		const std::vector<uint32_t>& GetData() const { return m_data; }
+	private:
+		MaterialParameterLayoutPtr m_layout;
+		std::vector<uint32_t> m_data;
+	};
+}
@@ -39,9 +39,11 @@ namespace CGE
 		m_globalShaderData = new GlobalShaderData();
 		m_globalTransformData = new GlobalTransformData();
 		m_globalPreviousTransformData = new GlobalTransformData();
+		m_globalTransformMaterialData = new GlobalTransformMaterialData();
 
 		m_transformDataBuffer = ResourceUtils::CreateBufferData("global_transform_data_", sizeof(GlobalTransformData), vk::BufferUsageFlagBits::eStorageBuffer, true);
 		m_transformPreviousDataBuffer = ResourceUtils::CreateBufferData("global_previous_transform_data_", sizeof(GlobalTransformData), vk::BufferUsageFlagBits::eStorageBuffer, true);
+		m_transformMaterialDataBuffer = ResourceUtils::CreateBufferData("global_transform_material_data_", sizeof(GlobalTransformMaterialData), vk::BufferUsageFlagBits::eStorageBuffer, true);
 
 		m_globalDataBuffer = ResourceUtils::CreateBufferData("PerFrameShaderData_", sizeof(GlobalShaderData), BufferUsageFlagBits::eUniformBuffer, true);
 		m_globalPreviousDataBuffer = ResourceUtils::CreateBufferData("PerFramePreviousShaderData_", sizeof(GlobalShaderData), BufferUsageFlagBits::eUniformBuffer, true);
@@ -58,6 +60,7 @@ namespace CGE
 			resMapper.AddUniformBuffer("globalPreviousData", m_globalPreviousDataBuffer);
 			resMapper.AddUniformBuffer("globalTransformData", m_transformDataBuffer);
 			resMapper.AddUniformBuffer("globalPreviousTransformData", m_transformPreviousDataBuffer);
+			resMapper.AddUniformBuffer("globalTransformMaterialData", m_transformMaterialDataBuffer);
 			resMapper.AddShader(shader);
 			resMapper.Update();
 
@@ -72,6 +75,7 @@ namespace CGE
 		delete m_globalShaderData;
 		delete m_globalTransformData;
 		delete m_globalPreviousTransformData;
+		delete m_globalTransformMaterialData;
 		
 		for (auto& data : m_data)
 		{
@@ -90,6 +94,7 @@ namespace CGE
 		m_globalDataBuffer->CopyTo(sizeof(GlobalShaderData), reinterpret_cast<const char*>( m_globalShaderData ));
 		m_transformDataBuffer->CopyTo(m_relevantTransformsSize, reinterpret_cast<const char*>( m_globalTransformData ));
 		m_transformPreviousDataBuffer->CopyTo(m_relevantTransformsSize, reinterpret_cast<const char*>( m_globalPreviousTransformData ));
+		m_transformMaterialDataBuffer->CopyTo(m_relevantTransformMaterialsSize, reinterpret_cast<const char*>( m_globalTransformMaterialData ));
 	}
 
 	void PerFrameData::GatherData()
@@ -120,6 +125,8 @@ namespace CGE
 		m_relevantTransformsSize = scene->GetRelevantMatricesCount() * sizeof(glm::mat4x4);
 		std::memcpy(m_globalTransformData->modelToWorld, scene->GetModelMatrices().data(), m_relevantTransformsSize);
 		std::memcpy(m_globalPreviousTransformData->modelToWorld, scene->GetPreviousModelMatrices().data(), m_relevantTransformsSize);
+		m_relevantTransformMaterialsSize = scene->GetRelevantMatricesCount() * sizeof(uint32_t);
+		std::memcpy(m_globalTransformMaterialData->materialIndex, scene->GetTransformMaterialIndices().data(), m_relevantTransformMaterialsSize);
 	}
 }
 
@@ -30,6 +30,7 @@ namespace CGE
 		BufferDataPtr m_globalPreviousDataBuffer;
 		BufferDataPtr m_transformDataBuffer;
 		BufferDataPtr m_transformPreviousDataBuffer;
+		BufferDataPtr m_transformMaterialDataBuffer;
 	
 		struct FrameData
 		{
@@ -41,7 +42,9 @@ namespace CGE
 		GlobalShaderData* m_globalShaderData;
 		GlobalTransformData* m_globalTransformData;
 		GlobalTransformData* m_globalPreviousTransformData;
+		GlobalTransformMaterialData* m_globalTransformMaterialData;
 		uint64_t m_relevantTransformsSize = 0;
+		uint64_t m_relevantTransformMaterialsSize = 0;
 	
 		FrameData& GetData() { return m_data[Engine::GetFrameIndex(m_data.size())]; }
 		void GatherData();
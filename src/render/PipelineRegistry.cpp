@@ -4,6 +4,12 @@ namespace CGE
 {
 	PipelineRegistry* PipelineRegistry::instance = new PipelineRegistry();
 	
+	size_t PipelineRegistry::PipelineKeyHash::operator()(const PipelineKey& inKey) const
+	{
+		size_t passHash = inKey.passHash.GetHash();
+		return passHash ^ (inKey.shadersHash.GetHash() + 0x9e3779b97f4a7c15ull + (passHash << 6) + (passHash >> 2));
+	}
+
 	PipelineRegistry::PipelineRegistry()
 	{
 	}
@@ -27,56 +33,71 @@ namespace CGE
 	
 	void PipelineRegistry::DestroyPipelines(VulkanDevice* inDevice)
 	{
+		std::scoped_lock<std::mutex> lock(mutex);
 		Device& device = inDevice->GetDevice();
-		for (auto& passPair : pipelinesData)
+		for (auto& pair : pipelinesData)
 		{
-			for (auto& shaderPair : passPair.second)
-			{
-				device.destroyPipelineLayout(shaderPair.second.pipelineLayout);
-				device.destroyPipeline(shaderPair.second.pipeline);
-			}
+			device.destroyPipeline(pair.second.pipeline);
 		}
 		pipelinesData.clear();
 	}
 	
 	void PipelineRegistry::DestroyPipelines(VulkanDevice* inDevice, HashString inPassHash)
 	{
+		std::scoped_lock<std::mutex> lock(mutex);
 		Device& device = inDevice->GetDevice();
-		if (pipelinesData.find(inPassHash) != pipelinesData.end())
+		auto it = pipelinesData.begin();
+		while (it != pipelinesData.end())
 		{
-			for (auto& shaderPair : pipelinesData[inPassHash])
+			if (it->first.passHash == inPassHash)
 			{
-				device.destroyPipelineLayout(shaderPair.second.pipelineLayout);
-				device.destroyPipeline(shaderPair.second.pipeline);
+				device.destroyPipeline(it->second.pipeline);
+				it = pipelinesData.erase(it);
+				continue;
 			}
-			pipelinesData[inPassHash].clear();
+			++it;
 		}
 	}
 	
-	bool PipelineRegistry::HasPipeline(HashString inPassHash, HashString inShadersHash)
+	void PipelineRegistry::DestroyShaderPipelines(VulkanDevice* inDevice, HashString inShadersHash)
 	{
-		if (pipelinesData.find(inPassHash) != pipelinesData.end())
+		std::scoped_lock<std::mutex> lock(mutex);
+		Device& device = inDevice->GetDevice();
+		auto it = pipelinesData.begin();
+		while (it != pipelinesData.end())
 		{
-			std::map<HashString, PipelineData>& passData = pipelinesData[inPassHash];
-			return passData.find(inShadersHash) != passData.end();
+			if (it->first.shadersHash == inShadersHash)
+			{
+				device.destroyPipeline(it->second.pipeline);
+				it = pipelinesData.erase(it);
+				continue;
+			}
+			++it;
 		}
-		return false;
 	}
 	
-	bool PipelineRegistry::StorePipeline(HashString inPassHash, HashString inShadersHash, PipelineData inPipelineData)
+	bool PipelineRegistry::HasPipeline(HashString inPassHash, HashString inShadersHash)
+	{
+		return FindPipeline(inPassHash, inShadersHash) != nullptr;
+	}
+
+	PipelineData* PipelineRegistry::FindPipeline(HashString inPassHash, HashString inShadersHash)
 	{
-		pipelinesData[inPassHash][inShadersHash] = inPipelineData;
-		return true;
+		std::scoped_lock<std::mutex> lock(mutex);
+		auto it = pipelinesData.find({ inPassHash, inShadersHash });
+		return it != pipelinesData.end() ? &it->second : nullptr;
 	}
 	
-	PipelineData& PipelineRegistry::GetPipeline(HashString inPassHash, HashString inShadersHash)
+	bool PipelineRegistry::StorePipeline(HashString inPassHash, HashString inShadersHash, PipelineData inPipelineData)
 	{
-		return pipelinesData[inPassHash][inShadersHash];
+		std::scoped_lock<std::mutex> lock(mutex);
+		return pipelinesData.emplace(PipelineKey{ inPassHash, inShadersHash }, inPipelineData).second;
 	}
 	
-	std::map<HashString, PipelineData>& PipelineRegistry::operator[](HashString inShaderHash)
+	PipelineData& PipelineRegistry::GetPipeline(HashString inPassHash, HashString inShadersHash)
 	{
-		return pipelinesData[inShaderHash];
+		std::scoped_lock<std::mutex> lock(mutex);
+		return pipelinesData[{ inPassHash, inShadersHash }];
 	}
 	
 }
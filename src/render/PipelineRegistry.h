@@ -1,7 +1,8 @@
 #pragma once
 
 #include "vulkan/vulkan.hpp"
-#include <map>
+#include <mutex>
+#include <unordered_map>
 #include "common/HashString.h"
 #include "objects/VulkanDevice.h"
 #include "objects/VulkanDescriptorSet.h"
@@ -14,10 +15,14 @@ namespace CGE
 	struct PipelineData
 	{
 		vk::Pipeline pipeline;
+		// shared through the layout cache, not destroyed with the pipeline
 		vk::PipelineLayout pipelineLayout;
 		std::vector<DescriptorSet> descriptorSets;
 	};
 	
+	// Pipelines of every pass and material in one flat table. Passes compile ahead on worker threads, so
+	// lookups and stores are locked, entries never move once stored and references to them stay valid
+	// until they're destroyed.
 	class PipelineRegistry
 	{
 	public:
@@ -25,18 +30,33 @@ namespace CGE
 	
 		void DestroyPipelines(VulkanDevice* inDevice);
 		void DestroyPipelines(VulkanDevice* inDevice, HashString inPassHash);
+		// pipelines of a material in every pass, they're created again the next time a pass looks for them
+		void DestroyShaderPipelines(VulkanDevice* inDevice, HashString inShadersHash);
 	
 		bool HasPipeline(HashString inPassHash, HashString inShadersHash);
+		// null when there's no such pipeline yet
+		PipelineData* FindPipeline(HashString inPassHash, HashString inShadersHash);
+		// false when the pipeline is already there, the stored one is kept then
 		bool StorePipeline(HashString inPassHash, HashString inShadersHash, PipelineData inPipelineData);
 		PipelineData& GetPipeline(HashString inPassHash, HashString inShadersHash);
-	
-		std::map<HashString, PipelineData>& operator[](HashString inPassHash);
 	private:
+		struct PipelineKey
+		{
+			HashString passHash;
+			HashString shadersHash;
+
+			bool operator==(const PipelineKey& inOther) const { return (passHash == inOther.passHash) && (shadersHash == inOther.shadersHash); }
+		};
+
+		struct PipelineKeyHash
+		{
+			size_t operator()(const PipelineKey& inKey) const;
+		};
+
 		static PipelineRegistry* instance;
 	
-		//std::map<HashString, Pipeline> pipelines;
-		// render pass hash - shader hash - pipeline data
-		std::map<HashString, std::map<HashString, PipelineData>> pipelinesData;
+		std::mutex mutex;
+		std::unordered_map<PipelineKey, PipelineData, PipelineKeyHash> pipelinesData;
 	
 		PipelineRegistry();
 		PipelineRegistry(const PipelineRegistry& inOther);
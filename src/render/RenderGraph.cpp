@@ -0,0 +1,494 @@
+#include "render/RenderGraph.h"
+#include <algorithm>
+#include <array>
+#include <queue>
+#include <functional>
+#include <cstdio>
+
+namespace CGE
+{
+	namespace
+	{
+		struct UsageInfo
+		{
+			uint32_t stages;
+			uint32_t readAccess;
+			uint32_t writeAccess;
+			ERenderGraphLayout readLayout;
+			ERenderGraphLayout writeLayout;
+		};
+
+		// indexed by ERenderGraphUsage, shader usages take their stages from the declaration
+		static const std::array<UsageInfo, 7> USAGE_INFOS = { {
+			{ RGS_DRAW_INDIRECT, RGA_INDIRECT_READ, RGA_NONE, ERenderGraphLayout::RGL_UNDEFINED, ERenderGraphLayout::RGL_UNDEFINED },
+			{ RGS_VERTEX, RGA_VERTEX_READ, RGA_NONE, ERenderGraphLayout::RGL_UNDEFINED, ERenderGraphLayout::RGL_UNDEFINED },
+			{ RGS_NONE, RGA_SHADER_READ, RGA_NONE, ERenderGraphLayout::RGL_SHADER_READ, ERenderGraphLayout::RGL_SHADER_READ },
+			{ RGS_NONE, RGA_SHADER_READ, RGA_SHADER_READ | RGA_SHADER_WRITE, ERenderGraphLayout::RGL_GENERAL, ERenderGraphLayout::RGL_GENERAL },
+			{ RGS_COLOR_OUTPUT, RGA_COLOR_READ, RGA_COLOR_READ | RGA_COLOR_WRITE, ERenderGraphLayout::RGL_COLOR_ATTACHMENT, ERenderGraphLayout::RGL_COLOR_ATTACHMENT },
+			{ RGS_DEPTH_TESTS, RGA_DEPTH_READ, RGA_DEPTH_READ | RGA_DEPTH_WRITE, ERenderGraphLayout::RGL_DEPTH_ATTACHMENT, ERenderGraphLayout::RGL_DEPTH_ATTACHMENT },
+			{ RGS_TRANSFER, RGA_TRANSFER_READ, RGA_TRANSFER_WRITE, ERenderGraphLayout::RGL_TRANSFER_SRC, ERenderGraphLayout::RGL_TRANSFER_DST }
+		} };
+
+		uint64_t AlignUp(uint64_t inValue, uint64_t inAlignment)
+		{
+			return (inValue + inAlignment - 1) / inAlignment * inAlignment;
+		}
+	}
+
+	//-----------------------------------------------------------------------------------------------------------
+
+	RenderGraphPassBuilder& RenderGraphPassBuilder::Import(const HashString& inResource, ERenderGraphResourceType inType)
+	{
+		m_graph->AddResource(inResource, inType, false, 0, 1);
+		return *this;
+	}
+
+	RenderGraphPassBuilder& RenderGraphPassBuilder::CreateTransient(const HashString& inResource, ERenderGraphResourceType inType, uint64_t inSize, uint64_t inAlignment)
+	{
+		m_graph->AddResource(inResource, inType, true, inSize, inAlignment);
+		return *this;
+	}
+
+	RenderGraphPassBuilder& RenderGraphPassBuilder::Read(const HashString& inResource, ERenderGraphUsage inUsage, uint32_t inStages)
+	{
+		m_graph->AddUsage(m_pass, inResource, inUsage, inStages, false, false);
+		return *this;
+	}
+
+	RenderGraphPassBuilder& RenderGraphPassBuilder::ReadHistory(const HashString& inResource, ERenderGraphUsage inUsage, uint32_t inStages)
+	{
+		m_graph->AddUsage(m_pass, inResource, inUsage, inStages, false, true);
+		return *this;
+	}
+
+	RenderGraphPassBuilder& RenderGraphPassBuilder::Write(const HashString& inResource, ERenderGraphUsage inUsage, uint32_t inStages)
+	{
+		m_graph->AddUsage(m_pass, inResource, inUsage, inStages, true, false);
+		return *this;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------
+
+	void RenderGraph::Clear()
+	{
+		m_passes.clear();
+		m_resources.clear();
+		m_resourceIndices.clear();
+		m_schedule.clear();
+		m_stats = RenderGraphStats();
+		m_error.clear();
+	}
+
+	uint32_t RenderGraph::AddPass(const HashString& inName)
+	{
+		m_passes.push_back({ inName, {} });
+		return static_cast<uint32_t>(m_passes.size() - 1);
+	}
+
+	bool RenderGraph::Compile()
+	{
+		m_schedule.clear();
+		m_stats = RenderGraphStats();
+		m_error.clear();
+
+		std::vector<uint32_t> order;
+		if (!ResolveUsages() || !SortPasses(order))
+		{
+			return false;
+		}
+		for (uint32_t pass : order)
+		{
+			m_schedule.push_back({ pass, {} });
+		}
+		PlaceTransients();
+
+		// a frame starts where the previous one ended, the first run only finds out where that is
+		std::vector<ResourceState> endStates = SimulateFrame(std::vector<ResourceState>(m_resources.size()), false);
+		SimulateFrame(endStates, true);
+
+		m_stats.passCount = static_cast<uint32_t>(m_schedule.size());
+		return true;
+	}
+
+	uint32_t RenderGraph::FindResource(const HashString& inName) const
+	{
+		auto it = m_resourceIndices.find(inName);
+		return it == m_resourceIndices.end() ? UINT32_MAX : it->second;
+	}
+
+	void RenderGraph::PrintStats()
+	{
+		std::printf("render graph: %u passes, %u barriers covering %u resource dependencies, %u layout transitions\n",
+			m_stats.passCount, m_stats.barrierCount, m_stats.resourceBarrierCount, m_stats.layoutTransitionCount);
+		std::printf("render graph: %u transients, %llu bytes aliased into %llu, %llu saved\n", m_stats.transientCount,
+			static_cast<unsigned long long>(m_stats.transientBytes), static_cast<unsigned long long>(m_stats.aliasedBytes), static_cast<unsigned long long>(m_stats.GetSavedBytes()));
+	}
+
+	void RenderGraph::AddResource(const HashString& inName, ERenderGraphResourceType inType, bool inTransient, uint64_t inSize, uint64_t inAlignment)
+	{
+		// the first declaration wins
+		if (m_resourceIndices.find(inName) != m_resourceIndices.end())
+		{
+			return;
+		}
+		Resource resource;
+		resource.name = inName;
+		resource.type = inType;
+		resource.transient = inTransient;
+		resource.size = inSize;
+		resource.alignment = std::max<uint64_t>(inAlignment, 1);
+		m_resourceIndices[inName] = static_cast<uint32_t>(m_resources.size());
+		m_resources.push_back(resource);
+	}
+
+	void RenderGraph::AddUsage(uint32_t inPass, const HashString& inResource, ERenderGraphUsage inUsage, uint32_t inStages, bool inWrite, bool inHistory)
+	{
+		const UsageInfo& info = USAGE_INFOS[static_cast<uint32_t>(inUsage)];
+		Usage usage;
+		usage.resourceName = inResource;
+		usage.stages = info.stages | inStages;
+		usage.access = inWrite ? info.writeAccess : info.readAccess;
+		usage.layout = inWrite ? info.writeLayout : info.readLayout;
+		usage.write = inWrite;
+		usage.history = inHistory;
+
+		// one usage per resource and pass, a pass moving an image between layouts on its own keeps the first one
+		std::vector<Usage>& usages = m_passes[inPass].usages;
+		auto it = std::find_if(usages.begin(), usages.end(), [&](const Usage& inOther) { return inOther.resourceName == inResource && inOther.history == inHistory; });
+		if (it == usages.end())
+		{
+			usages.push_back(usage);
+			return;
+		}
+		it->stages |= usage.stages;
+		it->access |= usage.access;
+		it->write |= usage.write;
+		if (it->layout == ERenderGraphLayout::RGL_UNDEFINED)
+		{
+			it->layout = usage.layout;
+		}
+	}
+
+	bool RenderGraph::ResolveUsages()
+	{
+		for (Pass& pass : m_passes)
+		{
+			for (Usage& usage : pass.usages)
+			{
+				usage.resource = FindResource(usage.resourceName);
+				if (usage.resource == UINT32_MAX)
+				{
+					m_error = "pass " + pass.name.GetString() + " uses unknown resource " + usage.resourceName.GetString();
+					return false;
+				}
+				if (usage.stages == RGS_NONE)
+				{
+					m_error = "pass " + pass.name.GetString() + " uses " + usage.resourceName.GetString() + " in a shader without stages";
+					return false;
+				}
+				if (usage.history && m_resources[usage.resource].transient)
+				{
+					m_error = "pass " + pass.name.GetString() + " reads history of transient " + usage.resourceName.GetString();
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	bool RenderGraph::SortPasses(std::vector<uint32_t>& outOrder)
+	{
+		// writers chain in the order they were added, readers come after the last one
+		std::vector<std::vector<uint32_t>> writers(m_resources.size());
+		std::vector<std::vector<uint32_t>> readers(m_resources.size());
+		for (uint32_t passIndex = 0; passIndex < m_passes.size(); passIndex++)
+		{
+			for (const Usage& usage : m_passes[passIndex].usages)
+			{
+				if (!usage.history)
+				{
+					(usage.write ? writers : readers)[usage.resource].push_back(passIndex);
+				}
+			}
+		}
+
+		std::vector<std::vector<uint32_t>> edges(m_passes.size());
+		std::vector<uint32_t> incoming(m_passes.size(), 0);
+		auto addEdge = [&](uint32_t inFrom, uint32_t inTo)
+		{
+			std::vector<uint32_t>& passEdges = edges[inFrom];
+			if (inFrom != inTo && std::find(passEdges.begin(), passEdges.end(), inTo) == passEdges.end())
+			{
+				passEdges.push_back(inTo);
+				incoming[inTo]++;
+			}
+		};
+		for (uint32_t resource = 0; resource < m_resources.size(); resource++)
+		{
+			for (uint32_t idx = 1; idx < writers[resource].size(); idx++)
+			{
+				addEdge(writers[resource][idx - 1], writers[resource][idx]);
+			}
+			if (!writers[resource].empty())
+			{
+				for (uint32_t reader : readers[resource])
+				{
+					addEdge(writers[resource].back(), reader);
+				}
+			}
+		}
+
+		// passes free to go keep the order they were added in
+		std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> ready;
+		for (uint32_t passIndex = 0; passIndex < m_passes.size(); passIndex++)
+		{
+			if (incoming[passIndex] == 0)
+			{
+				ready.push(passIndex);
+			}
+		}
+		outOrder.clear();
+		while (!ready.empty())
+		{
+			uint32_t passIndex = ready.top();
+			ready.pop();
+			outOrder.push_back(passIndex);
+			for (uint32_t next : edges[passIndex])
+			{
+				if (--incoming[next] == 0)
+				{
+					ready.push(next);
+				}
+			}
+		}
+
+		if (outOrder.size() != m_passes.size())
+		{
+			m_error = "dependency cycle between passes";
+			for (uint32_t passIndex = 0; passIndex < m_passes.size(); passIndex++)
+			{
+				if (incoming[passIndex] > 0)
+				{
+					m_error += " " + m_passes[passIndex].name.GetString();
+				}
+			}
+			return false;
+		}
+		return true;
+	}
+
+	void RenderGraph::PlaceTransients()
+	{
+		std::vector<uint32_t> transients;
+		for (uint32_t resource = 0; resource < m_resources.size(); resource++)
+		{
+			m_resources[resource].firstStep = UINT32_MAX;
+			m_resources[resource].lastStep = 0;
+			m_resources[resource].aliasOf = UINT32_MAX;
+			m_resources[resource].offset = UINT64_MAX;
+		}
+		for (uint32_t step = 0; step < m_schedule.size(); step++)
+		{
+			for (const Usage& usage : m_passes[m_schedule[step].pass].usages)
+			{
+				Resource& resource = m_resources[usage.resource];
+				resource.firstStep = std::min(resource.firstStep, step);
+				resource.lastStep = std::max(resource.lastStep, step);
+			}
+		}
+		for (uint32_t resource = 0; resource < m_resources.size(); resource++)
+		{
+			if (m_resources[resource].transient && m_resources[resource].firstStep != UINT32_MAX)
+			{
+				transients.push_back(resource);
+				m_stats.transientBytes += m_resources[resource].size;
+			}
+		}
+		m_stats.transientCount = static_cast<uint32_t>(transients.size());
+
+		// biggest first, each goes to the first block nobody alive at the same time is in
+		std::stable_sort(transients.begin(), transients.end(), [&](uint32_t inLeft, uint32_t inRight) { return m_resources[inLeft].size > m_resources[inRight].size; });
+		struct Block
+		{
+			uint64_t size = 0;
+			uint64_t alignment = 1;
+			std::vector<uint32_t> members;
+		};
+		std::vector<Block> blocks;
+		for (uint32_t resource : transients)
+		{
+			const Resource& placed = m_resources[resource];
+			auto blockIt = std::find_if(blocks.begin(), blocks.end(), [&](const Block& inBlock)
+			{
+				return std::none_of(inBlock.members.begin(), inBlock.members.end(), [&](uint32_t inMember)
+				{
+					const Resource& member = m_resources[inMember];
+					return (placed.firstStep <= member.lastStep) && (member.firstStep <= placed.lastStep);
+				});
+			});
+			if (blockIt == blocks.end())
+			{
+				blocks.push_back(Block());
+				blockIt = blocks.end() - 1;
+			}
+			blockIt->size = std::max(blockIt->size, placed.size);
+			blockIt->alignment = std::max(blockIt->alignment, placed.alignment);
+			blockIt->members.push_back(resource);
+		}
+
+		uint64_t offset = 0;
+		for (Block& block : blocks)
+		{
+			offset = AlignUp(offset, block.alignment);
+			for (uint32_t resource : block.members)
+			{
+				Resource& placed = m_resources[resource];
+				placed.offset = offset;
+				// the previous occupant has to be done with the memory first
+				for (uint32_t member : block.members)
+				{
+					const Resource& other = m_resources[member];
+					if ((other.lastStep < placed.firstStep) && ((placed.aliasOf == UINT32_MAX) || (other.lastStep > m_resources[placed.aliasOf].lastStep)))
+					{
+						placed.aliasOf = member;
+					}
+				}
+			}
+			offset += block.size;
+		}
+		m_stats.aliasedBytes = offset;
+	}
+
+	std::vector<RenderGraph::ResourceState> RenderGraph::SimulateFrame(const std::vector<ResourceState>& inStartStates, bool inRecord)
+	{
+		std::vector<ResourceState> states = inStartStates;
+		// last frame's copies of round robin resources are tracked apart from this frame's
+		std::vector<ResourceState> historyStates = inStartStates;
+		for (ResourceState& state : historyStates)
+		{
+			state.readStages = RGS_NONE;
+			state.visibleStages = RGS_NONE;
+		}
+
+		for (uint32_t step = 0; step < m_schedule.size(); step++)
+		{
+			RenderGraphBarrierBatch batch;
+			for (const Usage& usage : m_passes[m_schedule[step].pass].usages)
+			{
+				const Resource& resource = m_resources[usage.resource];
+				ResourceState& state = usage.history ? historyStates[usage.resource] : states[usage.resource];
+				if (resource.transient && (resource.firstStep == step))
+				{
+					// contents are gone, whoever used the memory last frame or right before still counts
+					ResourceState fresh;
+					fresh.writeStages = state.writeStages;
+					fresh.writeAccess = state.writeAccess;
+					fresh.readStages = state.readStages;
+					if (resource.aliasOf != UINT32_MAX)
+					{
+						const ResourceState& previous = states[resource.aliasOf];
+						fresh.writeStages |= previous.writeStages;
+						fresh.writeAccess |= previous.writeAccess;
+						fresh.readStages |= previous.readStages;
+					}
+					state = fresh;
+				}
+
+				Usage applied = usage;
+				if (usage.history)
+				{
+					// the other copy's layout is up to the pass
+					applied.layout = ERenderGraphLayout::RGL_UNDEFINED;
+				}
+				RenderGraphBarrier barrier;
+				if (ApplyUsage(resource, applied, state, barrier))
+				{
+					batch.srcStages |= barrier.srcStages;
+					batch.dstStages |= barrier.dstStages;
+					batch.srcAccess |= barrier.srcAccess;
+					batch.dstAccess |= barrier.dstAccess;
+					batch.barriers.push_back(barrier);
+				}
+			}
+
+			if (inRecord)
+			{
+				if (!batch.IsEmpty())
+				{
+					m_stats.barrierCount++;
+				}
+				m_stats.resourceBarrierCount += static_cast<uint32_t>(batch.barriers.size());
+				for (const RenderGraphBarrier& barrier : batch.barriers)
+				{
+					m_stats.layoutTransitionCount += barrier.oldLayout != barrier.newLayout ? 1 : 0;
+				}
+				m_schedule[step].barrier = batch;
+			}
+		}
+
+		// next frame writes over what was read as history this frame
+		for (uint32_t resource = 0; resource < states.size(); resource++)
+		{
+			states[resource].readStages |= historyStates[resource].readStages;
+		}
+		return states;
+	}
+
+	bool RenderGraph::ApplyUsage(const Resource& inResource, const Usage& inUsage, ResourceState& ioState, RenderGraphBarrier& outBarrier) const
+	{
+		ERenderGraphLayout layout = inResource.type == ERenderGraphResourceType::RGR_IMAGE ? inUsage.layout : ERenderGraphLayout::RGL_UNDEFINED;
+		bool transition = (layout != ERenderGraphLayout::RGL_UNDEFINED) && (layout != ioState.layout);
+
+		uint32_t srcStages = RGS_NONE;
+		uint32_t srcAccess = RGA_NONE;
+		if ((transition || inUsage.write) && (ioState.visibleStages != RGS_NONE))
+		{
+			// readers already waited for the last write, waiting for them chains to it
+			srcStages = ioState.readStages;
+		}
+		else if (transition || inUsage.write)
+		{
+			srcStages = ioState.writeStages | ioState.readStages;
+			srcAccess = ioState.writeAccess;
+		}
+		else if ((ioState.writeStages != RGS_NONE) && ((inUsage.stages & ~ioState.visibleStages) != 0))
+		{
+			srcStages = ioState.writeStages;
+			srcAccess = ioState.writeAccess;
+		}
+
+		outBarrier.resource = static_cast<uint32_t>(&inResource - m_resources.data());
+		outBarrier.srcStages = srcStages;
+		outBarrier.dstStages = inUsage.stages;
+		outBarrier.srcAccess = srcAccess;
+		outBarrier.dstAccess = inUsage.access;
+		outBarrier.oldLayout = ioState.layout;
+		outBarrier.newLayout = transition ? layout : ioState.layout;
+		bool needed = transition || (srcStages != RGS_NONE);
+
+		if (inUsage.write)
+		{
+			ioState.writeStages = inUsage.stages;
+			ioState.writeAccess = inUsage.access & RGA_WRITE_MASK;
+			ioState.readStages = RGS_NONE;
+			ioState.visibleStages = RGS_NONE;
+		}
+		else if (transition)
+		{
+			// the transition is a write done by the barrier, later stages chain through this one
+			ioState.writeStages = inUsage.stages;
+			ioState.readStages = inUsage.stages;
+			ioState.visibleStages = inUsage.stages;
+		}
+		else
+		{
+			ioState.readStages |= inUsage.stages;
+			ioState.visibleStages |= needed ? inUsage.stages : RGS_NONE;
+		}
+		if (transition)
+		{
+			ioState.layout = layout;
+		}
+		return needed;
+	}
+}
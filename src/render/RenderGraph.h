@@ -0,0 +1,229 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <unordered_map>
+
+#include "common/HashString.h"
+
+namespace CGE
+{
+	// stages and accesses of the graph, kept apart from vulkan so the graph compiles and plans on the cpu alone.
+	// RenderPassBase maps them to pipeline stages and access flags
+	enum ERenderGraphStage : uint32_t
+	{
+		RGS_NONE = 0,
+		RGS_DRAW_INDIRECT = 1 << 0,
+		// vertex input and vertex shader
+		RGS_VERTEX = 1 << 1,
+		RGS_FRAGMENT = 1 << 2,
+		// early and late fragment tests
+		RGS_DEPTH_TESTS = 1 << 3,
+		RGS_COLOR_OUTPUT = 1 << 4,
+		RGS_COMPUTE = 1 << 5,
+		RGS_RAY_TRACING = 1 << 6,
+		RGS_TRANSFER = 1 << 7
+	};
+
+	enum ERenderGraphAccess : uint32_t
+	{
+		RGA_NONE = 0,
+		RGA_INDIRECT_READ = 1 << 0,
+		RGA_VERTEX_READ = 1 << 1,
+		RGA_SHADER_READ = 1 << 2,
+		RGA_SHADER_WRITE = 1 << 3,
+		RGA_COLOR_READ = 1 << 4,
+		RGA_COLOR_WRITE = 1 << 5,
+		RGA_DEPTH_READ = 1 << 6,
+		RGA_DEPTH_WRITE = 1 << 7,
+		RGA_TRANSFER_READ = 1 << 8,
+		RGA_TRANSFER_WRITE = 1 << 9,
+		RGA_WRITE_MASK = RGA_SHADER_WRITE | RGA_COLOR_WRITE | RGA_DEPTH_WRITE | RGA_TRANSFER_WRITE
+	};
+
+	enum class ERenderGraphLayout : uint8_t
+	{
+		RGL_UNDEFINED = 0,
+		RGL_GENERAL,
+		RGL_COLOR_ATTACHMENT,
+		RGL_DEPTH_ATTACHMENT,
+		RGL_SHADER_READ,
+		RGL_TRANSFER_SRC,
+		RGL_TRANSFER_DST
+	};
+
+	// how a pass touches a resource, stages and accesses follow from it. Shader usages run in the stages given
+	// with them, the rest have fixed ones
+	enum class ERenderGraphUsage : uint8_t
+	{
+		RGU_INDIRECT = 0,
+		RGU_VERTEX,
+		RGU_SAMPLED,
+		RGU_STORAGE,
+		RGU_COLOR_ATTACHMENT,
+		RGU_DEPTH_ATTACHMENT,
+		RGU_TRANSFER
+	};
+
+	enum class ERenderGraphResourceType : uint8_t
+	{
+		RGR_IMAGE = 0,
+		RGR_BUFFER
+	};
+
+	// dependency of one resource, only images have layouts
+	struct RenderGraphBarrier
+	{
+		uint32_t resource;
+		uint32_t srcStages;
+		uint32_t dstStages;
+		uint32_t srcAccess;
+		uint32_t dstAccess;
+		ERenderGraphLayout oldLayout;
+		ERenderGraphLayout newLayout;
+	};
+
+	// everything a pass waits for merged into a single pipeline barrier, the resource barriers are kept for
+	// layout transitions and for looking at
+	struct RenderGraphBarrierBatch
+	{
+		uint32_t srcStages = RGS_NONE;
+		uint32_t dstStages = RGS_NONE;
+		uint32_t srcAccess = RGA_NONE;
+		uint32_t dstAccess = RGA_NONE;
+		std::vector<RenderGraphBarrier> barriers;
+
+		bool IsEmpty() const { return barriers.empty(); }
+	};
+
+	struct RenderGraphStep
+	{
+		uint32_t pass;
+		RenderGraphBarrierBatch barrier;
+	};
+
+	struct RenderGraphStats
+	{
+		uint32_t passCount = 0;
+		// merged batches, one pipeline barrier each
+		uint32_t barrierCount = 0;
+		// resource dependencies folded into them
+		uint32_t resourceBarrierCount = 0;
+		uint32_t layoutTransitionCount = 0;
+		uint32_t transientCount = 0;
+		uint64_t transientBytes = 0;
+		// memory all transients take once the ones with disjoint lifetimes share it
+		uint64_t aliasedBytes = 0;
+
+		uint64_t GetSavedBytes() const { return transientBytes - aliasedBytes; }
+	};
+
+	class RenderGraph;
+
+	// declares what a pass reads and writes, handed out by RenderGraph::AddPass
+	class RenderGraphPassBuilder
+	{
+	public:
+		RenderGraphPassBuilder(RenderGraph* inGraph, uint32_t inPass) : m_graph(inGraph), m_pass(inPass) {}
+
+		// resources living across frames, their state at the end of a frame is where the next one starts
+		RenderGraphPassBuilder& Import(const HashString& inResource, ERenderGraphResourceType inType);
+		// resources only used within a frame, their memory may be shared with others not alive at the same time
+		RenderGraphPassBuilder& CreateTransient(const HashString& inResource, ERenderGraphResourceType inType, uint64_t inSize, uint64_t inAlignment);
+
+		// reads see the last write of the frame, whichever pass does it
+		RenderGraphPassBuilder& Read(const HashString& inResource, ERenderGraphUsage inUsage, uint32_t inStages = RGS_NONE);
+		// reads what the previous frame left, no ordering against this frame's writes. For round robin resources
+		// where last frame's copy is a different image
+		RenderGraphPassBuilder& ReadHistory(const HashString& inResource, ERenderGraphUsage inUsage, uint32_t inStages = RGS_NONE);
+		// several writers of a resource go in the order they were added
+		RenderGraphPassBuilder& Write(const HashString& inResource, ERenderGraphUsage inUsage, uint32_t inStages = RGS_NONE);
+
+		uint32_t GetPass() const { return m_pass; }
+	private:
+		RenderGraph* m_graph;
+		uint32_t m_pass;
+	};
+
+	// Passes declare the resources they read and write, Compile orders them by those dependencies and plans one
+	// merged barrier in front of each pass with only the stages and accesses involved. Transient resources get
+	// offsets in a shared block, those alive at different times overlap. Plain cpu code, nothing is recorded here.
+	class RenderGraph
+	{
+	public:
+		void Clear();
+
+		uint32_t AddPass(const HashString& inName);
+		RenderGraphPassBuilder GetBuilder(uint32_t inPass) { return RenderGraphPassBuilder(this, inPass); }
+		// false on unknown resources or dependency cycles, GetError says which
+		bool Compile();
+
+		const std::vector<RenderGraphStep>& GetSchedule() const { return m_schedule; }
+		const RenderGraphStats& GetStats() const { return m_stats; }
+		const std::string& GetError() const { return m_error; }
+		const HashString& GetPassName(uint32_t inPass) const { return m_passes[inPass].name; }
+		const HashString& GetResourceName(uint32_t inResource) const { return m_resources[inResource].name; }
+		uint32_t FindResource(const HashString& inName) const;
+		// offset in the shared transient block, UINT64_MAX for imported resources
+		uint64_t GetTransientOffset(uint32_t inResource) const { return m_resources[inResource].offset; }
+		void PrintStats();
+	private:
+		friend class RenderGraphPassBuilder;
+
+		struct Usage
+		{
+			HashString resourceName;
+			uint32_t resource = UINT32_MAX;
+			uint32_t stages = RGS_NONE;
+			uint32_t access = RGA_NONE;
+			ERenderGraphLayout layout = ERenderGraphLayout::RGL_UNDEFINED;
+			bool write = false;
+			bool history = false;
+		};
+		struct Pass
+		{
+			HashString name;
+			std::vector<Usage> usages;
+		};
+		struct Resource
+		{
+			HashString name;
+			ERenderGraphResourceType type;
+			bool transient = false;
+			uint64_t size = 0;
+			uint64_t alignment = 1;
+			uint64_t offset = UINT64_MAX;
+			// steps of the schedule using it, transients only
+			uint32_t firstStep = UINT32_MAX;
+			uint32_t lastStep = 0;
+			// transient using the same memory right before this one
+			uint32_t aliasOf = UINT32_MAX;
+		};
+		// where the last write went and who saw it since
+		struct ResourceState
+		{
+			uint32_t writeStages = RGS_NONE;
+			uint32_t writeAccess = RGA_NONE;
+			uint32_t readStages = RGS_NONE;
+			// stages the last write was made visible to
+			uint32_t visibleStages = RGS_NONE;
+			ERenderGraphLayout layout = ERenderGraphLayout::RGL_UNDEFINED;
+		};
+
+		std::vector<Pass> m_passes;
+		std::vector<Resource> m_resources;
+		std::unordered_map<HashString, uint32_t> m_resourceIndices;
+		std::vector<RenderGraphStep> m_schedule;
+		RenderGraphStats m_stats;
+		std::string m_error;
+
+		void AddResource(const HashString& inName, ERenderGraphResourceType inType, bool inTransient, uint64_t inSize, uint64_t inAlignment);
+		void AddUsage(uint32_t inPass, const HashString& inResource, ERenderGraphUsage inUsage, uint32_t inStages, bool inWrite, bool inHistory);
+		bool ResolveUsages();
+		bool SortPasses(std::vector<uint32_t>& outOrder);
+		void PlaceTransients();
+		std::vector<ResourceState> SimulateFrame(const std::vector<ResourceState>& inStartStates, bool inRecord);
+		bool ApplyUsage(const Resource& inResource, const Usage& inUsage, ResourceState& ioState, RenderGraphBarrier& outBarrier) const;
+	};
+}
@@ -1,6 +1,7 @@
 #include "render/Renderer.h"
 #include <iostream>
 #include <map>
+#include <unordered_map>
 #include <GLFW/glfw3.h>
 
 #define GLFW_EXPOSE_NATIVE_WIN32
@@ -8,6 +9,7 @@
 #include <GLFW/glfw3native.h>
 #include "glm/gtc/matrix_transform.hpp"
 #include <chrono>
+#include <stdexcept>
 #include "core/Engine.h"
 #include <vector>
 #include <algorithm>
@@ -33,12 +35,19 @@
 #include "ClusteringManager.h"
 #include "passes/RenderPassBase.h"
 #include "passes/DepthPrepass.h"
+#include "passes/DrawCullingPass.h"
 #include "data/TextureData.h"
 #include "passes/ClusterComputePass.h"
 #include "passes/RTGIPass.h"
 #include "passes/LightCompositingPass.h"
 #include "passes/LightPropagationComputePass.h"
 #include "passes/UpdateGIProbesPass.h"
+#include "import/BlockCompression.h"
+#include "TextureStreamer.h"
+#include "ContentReloader.h"
+#include "async/ThreadPool.h"
+#include "async/Job.h"
+#include <future>
 
 namespace CGE
 {
@@ -55,6 +64,19 @@ namespace CGE
 	using VULKAN_HPP_NAMESPACE::Offset3D;
 	using VULKAN_HPP_NAMESPACE::ImageSubresourceLayers;
 	using VULKAN_HPP_NAMESPACE::Filter;
+	using VULKAN_HPP_NAMESPACE::ClearColorValue;
+	using VULKAN_HPP_NAMESPACE::AccessFlags;
+
+	namespace
+	{
+		// flat normal map friendly color for images still waiting for their data
+		static const ClearColorValue PLACEHOLDER_COLOR(std::array<float, 4>{ 0.5f, 0.5f, 1.0f, 1.0f });
+		static const uint8_t PLACEHOLDER_TEXEL[4] = { 128, 128, 255, 255 };
+		// one row of blocks of a 16K wide image in the largest block format
+		static constexpr vk::DeviceSize PLACEHOLDER_ROW_SIZE = 64 * 1024;
+		static const PipelineStageFlags IMAGE_CONSUMER_STAGES = 
+			PipelineStageFlagBits::eFragmentShader | PipelineStageFlagBits::eComputeShader | PipelineStageFlagBits::eRayTracingShaderKHR;
+	};
 
 	const std::vector<Vertex> verticesTest = {
 		{{0.0f, -0.5f, 0.0f}, {1.0f, 1.0f, 1.0f}},
@@ -91,7 +113,20 @@ namespace CGE
 		swapChain.Create(&device, 2);
 		swapChain.CreateForResolution(width, height);
 		commandBuffers.Create(&device, 2, 1);
-		descriptorPools.Create(&device);
+		descriptorPools.Create(&device, static_cast<uint32_t>(swapChain.GetImages().size()));
+		layoutCache.Create(&device);
+		constantsArena.Create(&device);
+		geometryPool.Create(&device);
+		bindlessTable.Create(&device, &constantsArena);
+		m_gpuDrivenDraws = device.SupportsDrawIndirectCount();
+
+		m_useTransferQueue = device.HasDedicatedTransferQueue();
+		TransferList::GetInstance()->SetWholeImageUploads(m_useTransferQueue);
+		for (uint32_t index = 0; index < 2; index++)
+		{
+			m_transferFinishedSemaphores.push_back(device.GetDevice().createSemaphore(vk::SemaphoreCreateInfo()));
+			m_graphicsFinishedSemaphores.push_back(device.GetDevice().createSemaphore(vk::SemaphoreCreateInfo()));
+		}
 	
 		perFrameData = new PerFrameData();
 		perFrameData->Create(&device);
@@ -102,6 +137,8 @@ namespace CGE
 
 		///////////////////////////////////////////////////////
 
+		m_drawCullingPass = new DrawCullingPass(HashString("DrawCullingPass"));
+		m_drawCullingPass->Init();
 		m_depthPrepass = new DepthPrepass();
 		m_depthPrepass->Init();	
 		m_clusterComputePass = new ClusterComputePass(HashString("LightClusteringPass"));
@@ -122,8 +159,48 @@ namespace CGE
 		compositingPass->Init();
 		postProcessPass = new PostProcessPass(HashString("PostProcessPass"));
 		postProcessPass->Init();
+
+		BuildRenderGraph();
+		m_renderGraph.PrintStats();
 	}
 	
+	void Renderer::CompilePipelines(const std::vector<MaterialPtr>& inMaterials)
+	{
+		auto startTime = std::chrono::high_resolution_clock::now();
+
+		// scene materials are drawn by the depth prepass and the gbuffer, both passes go to the workers at once
+		std::vector<RenderPassBase*> passes = { m_depthPrepass, gBufferPass };
+		std::vector<std::future<void>> compiled;
+		for (RenderPassBase* pass : passes)
+		{
+			for (MaterialPtr material : inMaterials)
+			{
+				std::shared_ptr<std::promise<void>> promise = std::make_shared<std::promise<void>>();
+				compiled.push_back(promise->get_future());
+				ThreadPool::GetInstance()->AddJob(CreateJobPtr<void()>([pass, material, promise]()
+					{
+						try
+						{
+							pass->CompilePipeline(material);
+							promise->set_value();
+						}
+						catch (...)
+						{
+							promise->set_exception(std::current_exception());
+						}
+					}));
+			}
+		}
+		// the first frame would wait for them anyway, failures are rethrown here on the main thread
+		for (std::future<void>& future : compiled)
+		{
+			future.get();
+		}
+
+		double deltaTime = std::chrono::duration<double, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - startTime).count();
+		std::printf("compiled %u pipelines ahead in %f milliseconds\n", static_cast<uint32_t>(compiled.size()), deltaTime);
+	}
+
 	void Renderer::RenderFrame()
 	{
 		if (framebufferResized)
@@ -140,6 +217,22 @@ namespace CGE
 			return;
 		}
 	
+		// fence of this image was waited for, its frame descriptor sets are free again
+		CompleteImageFrames(imageIndex);
+		descriptorPools.BeginFrame(imageIndex);
+		// constants blocks freed a few frames ago come back before anything allocates this frame
+		constantsArena.Update(Engine::GetInstance()->GetFrameCount(), m_completedFrames);
+		geometryPool.Update(Engine::GetInstance()->GetFrameCount(), m_completedFrames);
+
+		// uploads of the frames behind the waited fences are done, their users could be notified
+		TransferList::GetInstance()->ProcessCompleted(m_completedFrames);
+		// swaps in streamed mips uploaded by now and starts the next residency changes
+		Singleton<TextureStreamer>::GetInstance()->Update(Engine::GetInstance()->GetFrameCount());
+		// changed shaders and textures loaded by now go in before anything is recorded
+		Singleton<ContentReloader>::GetInstance()->Update(Engine::GetInstance()->GetFrameCount());
+		// after both of the above, textures could have swapped their views
+		bindlessTable.Update(Engine::GetInstance()->GetFrameCount(), m_completedFrames);
+
 		perFrameData->UpdateBufferData();
 	
 		CommandBuffer& cmdBuffer = commandBuffers.GetBufferForFrame();
@@ -152,6 +245,11 @@ namespace CGE
 		cmdBuffer.begin(beginInfo);
 
 		TransferResources(cmdBuffer, device.GetPhysicalDevice().GetCachedQueueFamiliesIndices().graphicsFamily.value());
+		// material constants written since the last upload, merged into a few copy regions. Writes made
+		// while passes record go with the next frame
+		constantsArena.RecordUploads(cmdBuffer);
+		// meshes created since the last frame and ranges moved by a compaction, blas builds below read them
+		geometryPool.RecordUploads(cmdBuffer);
 
 		Singleton<RtScene>::GetInstance()->UpdateShaders();
 		Singleton<RtScene>::GetInstance()->BuildMeshBlases(&cmdBuffer);
@@ -162,55 +260,47 @@ namespace CGE
 		Singleton<RtScene>::GetInstance()->BuildSceneTlas(&cmdBuffer);
 
 		// render passes
-		// depth prepass
-		m_depthPrepass->Execute(&cmdBuffer);
-		//----------------------------------------------------------
-		// light clustering pass
-		m_clusterComputePass->Execute(&cmdBuffer);
-		//--------------------------------------------------------
-		// gbuffer pass
-		gBufferPass->Execute(&cmdBuffer);
-		//--------------------------------------------------------
-		// update GI probes pass
-		m_updateGIProbesPass->Execute(&cmdBuffer);
-		//--------------------------------------------------------
-		// rt shadows light visibility pass
+		// ray tracing passes pick up shader and scene changes before any pass records
 		rtShadowPass->Update();
-		rtShadowPass->Execute(&cmdBuffer);
-		//--------------------------------------------------------
-		// deferred lighting pass
-		deferredLightingPass->Execute(&cmdBuffer);
-		//--------------------------------------------------------
-		// rt GI pass
 		rtGIPass->Update();
-		rtGIPass->Execute(&cmdBuffer);
-		//--------------------------------------------------------
-		// light propagation pass
-		//propagationPass->Execute(&cmdBuffer);
-		//--------------------------------------------------------
-		// light compositing pass
-		compositingPass->Execute(&cmdBuffer);
-		//--------------------------------------------------------
-		// post process pass
-		postProcessPass->Execute(&cmdBuffer);
+		// in the order of the compiled graph, each pass behind the single barrier planned for it
+		for (const RenderGraphStep& step : m_renderGraph.GetSchedule())
+		{
+			m_graphPasses[step.pass]->Execute(&cmdBuffer, &step.barrier);
+		}
 		// end commands recording
 		cmdBuffer.end();
 
+		std::vector<Semaphore> waitSemaphores = { swapChain.GetImageAvailableSemaphore() };
+		std::vector<PipelineStageFlags> waitStages = { PipelineStageFlagBits::eColorAttachmentOutput | PipelineStageFlagBits::eRayTracingShaderKHR | PipelineStageFlagBits::eComputeShader };
+		std::vector<Semaphore> signalSemaphores = { swapChain.GetRenderingFinishedSemaphore() };
+		if (m_useTransferQueue)
+		{
+			SubmitTransfer(waitSemaphores, waitStages);
+			// images waiting for upload have placeholders sampled by this frame, transfer queue has to wait for it
+			if (TransferList::GetInstance()->HasPendingImages())
+			{
+				m_graphicsSignaledIndex = Engine::GetFrameIndex(static_cast<uint32_t>( m_graphicsFinishedSemaphores.size() ));
+				signalSemaphores.push_back(m_graphicsFinishedSemaphores[m_graphicsSignaledIndex.value()]);
+			}
+		}
+
 		SubmitInfo submitInfo{};
-		Semaphore waitSemaphores[] = { swapChain.GetImageAvailableSemaphore() };
-		PipelineStageFlags waitStages[] = { PipelineStageFlagBits::eColorAttachmentOutput | PipelineStageFlagBits::eRayTracingShaderKHR | PipelineStageFlagBits::eComputeShader };
-		submitInfo.setWaitSemaphoreCount(1);
-		submitInfo.setPWaitSemaphores(waitSemaphores);
-		submitInfo.setPWaitDstStageMask(waitStages);
+		submitInfo.setWaitSemaphoreCount(static_cast<uint32_t>( waitSemaphores.size() ));
+		submitInfo.setPWaitSemaphores(waitSemaphores.data());
+		submitInfo.setPWaitDstStageMask(waitStages.data());
 		submitInfo.setCommandBufferCount(1);
 		submitInfo.setPCommandBuffers(&cmdBuffer);
-	
-		Semaphore signalSemaphores[] = { swapChain.GetRenderingFinishedSemaphore() };
-		submitInfo.setSignalSemaphoreCount(1);
-		submitInfo.setPSignalSemaphores(signalSemaphores);
+		submitInfo.setSignalSemaphoreCount(static_cast<uint32_t>( signalSemaphores.size() ));
+		submitInfo.setPSignalSemaphores(signalSemaphores.data());
 	
 		ArrayProxy<const SubmitInfo> submitInfoArray(1, &submitInfo);
 		device.GetGraphicsQueue().submit(submitInfoArray, swapChain.GetGraphicsQueueFence());
+		if (imageIndex >= m_imageSubmittedFrames.size())
+		{
+			m_imageSubmittedFrames.resize(imageIndex + 1, 0);
+		}
+		m_imageSubmittedFrames[imageIndex] = Engine::GetInstance()->GetFrameCount() + 1;
 	
 		if (!swapChain.Present())
 		{
@@ -229,6 +319,7 @@ namespace CGE
 	{
 		WaitForDevice();
 
+		delete m_drawCullingPass;
 		delete m_depthPrepass;
 		delete postProcessPass;
 		delete deferredLightingPass;
@@ -249,8 +340,25 @@ namespace CGE
 	
 		PipelineRegistry::GetInstance()->DestroyPipelines(&device);
 		Singleton<RtScene>::GetInstance()->Cleanup();
+		Singleton<TextureStreamer>::GetInstance()->Cleanup();
+		Singleton<ContentReloader>::GetInstance()->Cleanup();
 	
+		for (uint32_t index = 0; index < m_transferFinishedSemaphores.size(); index++)
+		{
+			device.GetDevice().destroySemaphore(m_transferFinishedSemaphores[index]);
+			device.GetDevice().destroySemaphore(m_graphicsFinishedSemaphores[index]);
+		}
+		m_transferFinishedSemaphores.clear();
+		m_graphicsFinishedSemaphores.clear();
+
+		bindlessTable.Destroy();
+		constantsArena.PrintStats();
+		constantsArena.Destroy();
+		geometryPool.PrintStats();
+		geometryPool.Destroy();
+		descriptorPools.PrintStats();
 		descriptorPools.Destroy();
+		layoutCache.Destroy();
 		commandBuffers.Destroy();
 		swapChain.Destroy();
 		device.Destroy();
@@ -298,6 +406,26 @@ namespace CGE
 	{
 		return descriptorPools;
 	}
+
+	VulkanLayoutCache& Renderer::GetLayoutCache()
+	{
+		return layoutCache;
+	}
+
+	BindlessTable& Renderer::GetBindlessTable()
+	{
+		return bindlessTable;
+	}
+
+	MaterialConstantsArena& Renderer::GetConstantsArena()
+	{
+		return constantsArena;
+	}
+
+	GeometryPool& Renderer::GetGeometryPool()
+	{
+		return geometryPool;
+	}
 	
 	Queue Renderer::GetGraphicsQueue()
 	{
@@ -307,6 +435,11 @@ namespace CGE
 	void Renderer::OnResolutionChange()
 	{
 		device.GetDevice().waitIdle();
+		// nothing is in flight anymore
+		for (uint64_t submittedFrames : m_imageSubmittedFrames)
+		{
+			m_completedFrames = std::max(m_completedFrames, submittedFrames);
+		}
 	
 		GLFWwindow* window = Engine::GetInstance()->GetGlfwWindow();
 		glfwGetFramebufferSize(window, &width, &height);
@@ -317,26 +450,58 @@ namespace CGE
 		swapChain.CreateForResolution(width, height);
 		postProcessPass = new PostProcessPass("PostProcessPass");
 		postProcessPass->Init();
+		BuildRenderGraph();
+	}
+
+	void Renderer::CompleteImageFrames(uint32_t inImageIndex)
+	{
+		if (inImageIndex < m_imageSubmittedFrames.size())
+		{
+			m_completedFrames = std::max(m_completedFrames, m_imageSubmittedFrames[inImageIndex]);
+		}
+	}
+
+	void Renderer::BuildRenderGraph()
+	{
+		// the light propagation pass is not run, the rest goes in the order of the old hand written schedule
+		std::vector<RenderPassBase*> passes = { m_drawCullingPass, m_depthPrepass, m_clusterComputePass, gBufferPass, m_updateGIProbesPass,
+			rtShadowPass, deferredLightingPass, rtGIPass, compositingPass, postProcessPass };
+
+		m_renderGraph.Clear();
+		m_graphPasses.clear();
+		for (RenderPassBase* pass : passes)
+		{
+			pass->AddToGraph(m_renderGraph);
+			m_graphPasses.push_back(pass);
+		}
+		// a pass declaring something wrong would leave nothing to render
+		if (!m_renderGraph.Compile())
+		{
+			throw std::runtime_error("render graph: " + m_renderGraph.GetError());
+		}
 	}
 	
 	void Renderer::TransferResources(CommandBuffer& inCmdBuffer, uint32_t inQueueFamilyIndex)
 	{
 		TransferList* TL = TransferList::GetInstance();
 	
-		// get new resources to copy
-		std::vector<BufferDataPtr> buffers = TL->GetBuffers();
-		std::vector<TextureDataPtr> images = TL->GetImages();
-		TL->ClearBuffers();
-		TL->ClearImages();
+		// get new resources to copy, buffers are flushed on every call and images are streamed once a frame
+		std::vector<BufferDataPtr> buffers = TL->TakeBuffers();
+		ImageTransferBatch imageBatch;
+		uint64_t frameCount = Engine::GetInstance()->GetFrameCount();
+		if (m_imagesScheduledFrame != frameCount)
+		{
+			m_imagesScheduledFrame = frameCount;
+			imageBatch = TL->ScheduleImages(frameCount);
+		}
 	
-		if ( (buffers.size() == 0) && (images.size() == 0) )
+		if ( (buffers.size() == 0) && imageBatch.IsEmpty() )
 		{
 			return;
 		}
 	
 		// buffers
 		std::vector<BufferMemoryBarrier> buffersTransferBarriers;
-		std::vector<vk::BufferCopy> bufferCopies;
 		for (BufferDataPtr buffer : buffers)
 		{
 			vk::BufferCopy copy = buffer->GetStaging()->GetBuffer().CreateBufferCopy();
@@ -350,71 +515,401 @@ namespace CGE
 		}
 	
 		// images
-		// prepare memory barriers first
-		std::vector<ImageMemoryBarrier> beforeTransferBarriers;
 		std::vector<ImageMemoryBarrier> afterTransferBarriers;
-		beforeTransferBarriers.resize(images.size());
-		afterTransferBarriers.resize(images.size());
-		for (uint32_t index = 0; index < images.size(); index++)
+		if (!imageBatch.IsEmpty())
 		{
-			beforeTransferBarriers[index] = images[index]->GetImage().CreateLayoutBarrier(
-				ImageLayout::eUndefined,
+			if (m_useTransferQueue)
+			{
+				TransferImagesDedicated(inCmdBuffer, inQueueFamilyIndex, imageBatch, afterTransferBarriers);
+			}
+			else
+			{
+				TransferImages(inCmdBuffer, imageBatch, afterTransferBarriers);
+			}
+		}
+	
+		PipelineStageFlags dstStages = PipelineStageFlagBits::eVertexInput | PipelineStageFlagBits::eVertexShader;
+		if (afterTransferBarriers.size() > 0)
+		{
+			dstStages |= IMAGE_CONSUMER_STAGES;
+		}
+	
+		// final barriers for buffers and images
+		inCmdBuffer.pipelineBarrier(
+			PipelineStageFlagBits::eTransfer,
+			dstStages,
+			DependencyFlags(),
+			0, nullptr, 
+			static_cast<uint32_t>( buffersTransferBarriers.size() ),
+			buffersTransferBarriers.data(),
+			static_cast<uint32_t>( afterTransferBarriers.size() ),
+			afterTransferBarriers.data());
+	}
+	
+	void Renderer::TransferImages(CommandBuffer& inCmdBuffer, ImageTransferBatch& inBatch, std::vector<ImageMemoryBarrier>& outFinalBarriers)
+	{
+		// every touched image goes to transfer dst with a single barrier, placeholders are fresh and
+		// images already having one could be sampled by previous frames
+		std::vector<TextureDataPtr> touchedImages;
+		std::unordered_map<TextureData*, ImageLayout> oldLayouts;
+		for (TextureDataPtr image : inBatch.newImages)
+		{
+			oldLayouts[image.get()] = ImageLayout::eUndefined;
+			touchedImages.push_back(image);
+		}
+		for (ImageTransferSlice& slice : inBatch.slices)
+		{
+			if (oldLayouts.find(slice.image.get()) == oldLayouts.end())
+			{
+				oldLayouts[slice.image.get()] = slice.placeholder ? ImageLayout::eShaderReadOnlyOptimal : ImageLayout::eUndefined;
+				touchedImages.push_back(slice.image);
+			}
+		}
+	
+		std::vector<ImageMemoryBarrier> beforeTransferBarriers;
+		for (TextureDataPtr image : touchedImages)
+		{
+			beforeTransferBarriers.push_back(image->GetImage().CreateLayoutBarrier(
+				oldLayouts[image.get()],
 				ImageLayout::eTransferDstOptimal,
-				AccessFlagBits::eHostWrite,
-				AccessFlagBits::eTransferWrite | AccessFlagBits::eTransferRead,
-				ImageAspectFlagBits::eColor,
-				0, images[index]->GetImage().GetMips(), 0, 1);
-			afterTransferBarriers[index] = images[index]->GetImage().CreateLayoutBarrier(
-				ImageLayout::eUndefined,
-				ImageLayout::eShaderReadOnlyOptimal,
+				AccessFlags(),
 				AccessFlagBits::eTransferWrite,
-				AccessFlagBits::eShaderRead,
 				ImageAspectFlagBits::eColor,
-				0, images[index]->GetImage().GetMips(), 0, 1);
+				0, image->GetImage().GetMips(), 0, 1));
 		}
 	
 		inCmdBuffer.pipelineBarrier(
-			PipelineStageFlagBits::eHost,
+			IMAGE_CONSUMER_STAGES,
 			PipelineStageFlagBits::eTransfer,
 			DependencyFlags(),
 			0, nullptr, 0, nullptr,
 			static_cast<uint32_t>( beforeTransferBarriers.size() ), 
 			beforeTransferBarriers.data());
 	
+		for (TextureDataPtr image : inBatch.newImages)
+		{
+			ClearToPlaceholder(inCmdBuffer, image);
+		}
+	
+		if (inBatch.newImages.size() > 0 && inBatch.slices.size() > 0)
+		{
+			// partially uploaded images get both a placeholder and the first rows
+			vk::MemoryBarrier clearBarrier(AccessFlagBits::eTransferWrite, AccessFlagBits::eTransferWrite);
+			inCmdBuffer.pipelineBarrier(
+				PipelineStageFlagBits::eTransfer,
+				PipelineStageFlagBits::eTransfer,
+				DependencyFlags(),
+				1, &clearBarrier, 0, nullptr, 0, nullptr);
+		}
+	
 		//submit copy
-		for (TextureDataPtr image : images)
+		std::vector<TextureDataPtr> completedImages;
+		for (ImageTransferSlice& slice : inBatch.slices)
 		{
-			// copy
-			vk::BufferImageCopy copy = image->GetImage().CreateBufferImageCopy();
-			inCmdBuffer.copyBufferToImage(
-				image->GetStagingBuffer()->GetNativeBuffer(),
-				image->GetImage(), ImageLayout::eTransferDstOptimal, 
-				1, &copy);
-			image->DiscardStaging();
+			TextureDataPtr image = slice.image;
+			std::vector<vk::BufferImageCopy> copies = image->CreateStagingCopies(slice.offset, slice.size);
+			if (copies.size() > 0)
+			{
+				inCmdBuffer.copyBufferToImage(
+					image->GetStagingBuffer()->GetNativeBuffer(),
+					image->GetImage(), ImageLayout::eTransferDstOptimal, 
+					static_cast<uint32_t>(copies.size()), copies.data());
+			}
+			if (slice.isLast)
+			{
+				image->DiscardStaging();
+				completedImages.push_back(image);
+			}
 		}
 	
-		GenerateMips(inCmdBuffer, images);
+		GenerateMips(inCmdBuffer, completedImages);
+		AppendShaderReadBarriers(touchedImages, completedImages, outFinalBarriers);
+	}
+	
+	void Renderer::TransferImagesDedicated(CommandBuffer& inCmdBuffer, uint32_t inQueueFamilyIndex, ImageTransferBatch& inBatch, std::vector<ImageMemoryBarrier>& outFinalBarriers)
+	{
+		uint32_t transferFamilyIndex = device.GetTransferQueueIndex();
+	
+		// copies on the transfer queue, images are uploaded whole so there's nothing to preserve
+		std::vector<TextureDataPtr> completedImages;
+		std::vector<ImageMemoryBarrier> beforeTransferBarriers;
+		std::vector<ImageMemoryBarrier> releaseBarriers;
+		std::vector<ImageMemoryBarrier> acquireBarriers;
+		for (ImageTransferSlice& slice : inBatch.slices)
+		{
+			VulkanImage& image = slice.image->GetImage();
+			beforeTransferBarriers.push_back(image.CreateLayoutBarrier(
+				ImageLayout::eUndefined,
+				ImageLayout::eTransferDstOptimal,
+				AccessFlags(),
+				AccessFlagBits::eTransferWrite,
+				ImageAspectFlagBits::eColor,
+				0, image.GetMips(), 0, 1));
+			releaseBarriers.push_back(image.CreateBarrier(
+				ImageLayout::eTransferDstOptimal,
+				ImageLayout::eTransferDstOptimal,
+				transferFamilyIndex,
+				inQueueFamilyIndex,
+				AccessFlagBits::eTransferWrite,
+				AccessFlags(),
+				ImageAspectFlagBits::eColor,
+				0, image.GetMips(), 0, 1));
+			acquireBarriers.push_back(image.CreateBarrier(
+				ImageLayout::eTransferDstOptimal,
+				ImageLayout::eTransferDstOptimal,
+				transferFamilyIndex,
+				inQueueFamilyIndex,
+				AccessFlags(),
+				AccessFlagBits::eTransferWrite | AccessFlagBits::eTransferRead,
+				ImageAspectFlagBits::eColor,
+				0, image.GetMips(), 0, 1));
+			completedImages.push_back(slice.image);
+		}
+	
+		if (completedImages.size() > 0)
+		{
+			CommandBuffer& transferCmdBuffer = commandBuffers.GetTransferBufferForFrame();
+	
+			CommandBufferBeginInfo beginInfo;
+			beginInfo.setFlags(CommandBufferUsageFlagBits::eOneTimeSubmit);
+			transferCmdBuffer.begin(beginInfo);
+	
+			transferCmdBuffer.pipelineBarrier(
+				PipelineStageFlagBits::eTopOfPipe,
+				PipelineStageFlagBits::eTransfer,
+				DependencyFlags(),
+				0, nullptr, 0, nullptr,
+				static_cast<uint32_t>( beforeTransferBarriers.size() ),
+				beforeTransferBarriers.data());
+			for (TextureDataPtr image : completedImages)
+			{
+				std::vector<vk::BufferImageCopy> copies = image->CreateStagingCopies(0, image->GetStagingSize());
+				transferCmdBuffer.copyBufferToImage(
+					image->GetStagingBuffer()->GetNativeBuffer(),
+					image->GetImage(), ImageLayout::eTransferDstOptimal,
+					static_cast<uint32_t>(copies.size()), copies.data());
+				image->DiscardStaging();
+			}
+			transferCmdBuffer.pipelineBarrier(
+				PipelineStageFlagBits::eTransfer,
+				PipelineStageFlagBits::eBottomOfPipe,
+				DependencyFlags(),
+				0, nullptr, 0, nullptr,
+				static_cast<uint32_t>( releaseBarriers.size() ),
+				releaseBarriers.data());
+	
+			transferCmdBuffer.end();
+			m_transferRecorded = true;
+		}
+	
+		// graphics queue side, placeholders for waiting images and ownership acquire for uploaded ones
+		std::vector<ImageMemoryBarrier> graphicsBarriers = acquireBarriers;
+		for (TextureDataPtr image : inBatch.newImages)
+		{
+			graphicsBarriers.push_back(image->GetImage().CreateLayoutBarrier(
+				ImageLayout::eUndefined,
+				ImageLayout::eTransferDstOptimal,
+				AccessFlags(),
+				AccessFlagBits::eTransferWrite,
+				ImageAspectFlagBits::eColor,
+				0, image->GetImage().GetMips(), 0, 1));
+		}
 	
-		// final barriers for buffers and images
 		inCmdBuffer.pipelineBarrier(
+			PipelineStageFlagBits::eTopOfPipe,
 			PipelineStageFlagBits::eTransfer,
-			PipelineStageFlagBits::eVertexInput | PipelineStageFlagBits::eVertexShader,
 			DependencyFlags(),
-			0, nullptr, 
-			static_cast<uint32_t>( buffersTransferBarriers.size() ),
-			buffersTransferBarriers.data(),
-			static_cast<uint32_t>( afterTransferBarriers.size() ),
-			afterTransferBarriers.data());
+			0, nullptr, 0, nullptr,
+			static_cast<uint32_t>( graphicsBarriers.size() ),
+			graphicsBarriers.data());
+	
+		for (TextureDataPtr image : inBatch.newImages)
+		{
+			ClearToPlaceholder(inCmdBuffer, image);
+		}
+	
+		GenerateMips(inCmdBuffer, completedImages);
+	
+		std::vector<TextureDataPtr> touchedImages = inBatch.newImages;
+		touchedImages.insert(touchedImages.end(), completedImages.begin(), completedImages.end());
+		AppendShaderReadBarriers(touchedImages, completedImages, outFinalBarriers);
+	}
+	
+	void Renderer::SubmitTransfer(std::vector<Semaphore>& outWaitSemaphores, std::vector<vk::PipelineStageFlags>& outWaitStages)
+	{
+		if (!m_transferRecorded && !m_graphicsSignaledIndex.has_value())
+		{
+			return;
+		}
+	
+		SubmitInfo submitInfo{};
+		PipelineStageFlags transferWaitStage = PipelineStageFlagBits::eTransfer;
+		if (m_graphicsSignaledIndex.has_value())
+		{
+			// previous frame could sample placeholders of the images being uploaded now
+			submitInfo.setWaitSemaphoreCount(1);
+			submitInfo.setPWaitSemaphores(&m_graphicsFinishedSemaphores[m_graphicsSignaledIndex.value()]);
+			submitInfo.setPWaitDstStageMask(&transferWaitStage);
+			m_graphicsSignaledIndex.reset();
+		}
+	
+		if (m_transferRecorded)
+		{
+			Semaphore& transferFinished = m_transferFinishedSemaphores[Engine::GetFrameIndex(static_cast<uint32_t>(m_transferFinishedSemaphores.size()))];
+			submitInfo.setCommandBufferCount(1);
+			submitInfo.setPCommandBuffers(&commandBuffers.GetTransferBufferForFrame());
+			submitInfo.setSignalSemaphoreCount(1);
+			submitInfo.setPSignalSemaphores(&transferFinished);
+	
+			outWaitSemaphores.push_back(transferFinished);
+			outWaitStages.push_back(PipelineStageFlagBits::eTransfer);
+			m_transferRecorded = false;
+		}
+	
+		ArrayProxy<const SubmitInfo> submitInfoArray(1, &submitInfo);
+		device.GetTransferQueue().submit(submitInfoArray, vk::Fence());
 	}
 	
+	void Renderer::AppendShaderReadBarriers(std::vector<TextureDataPtr>& inImages, std::vector<TextureDataPtr>& inCompletedImages, std::vector<ImageMemoryBarrier>& outBarriers)
+	{
+		for (TextureDataPtr image : inImages)
+		{
+			uint32_t mips = image->GetImage().GetMips();
+			bool completed = std::find(inCompletedImages.begin(), inCompletedImages.end(), image) != inCompletedImages.end();
+			// mips generation leaves every level but the last one as a transfer source
+			uint32_t srcMips = (completed && !image->HasPrebuiltMips()) ? mips - 1 : 0;
+			if (srcMips > 0)
+			{
+				outBarriers.push_back(image->GetImage().CreateLayoutBarrier(
+					ImageLayout::eTransferSrcOptimal,
+					ImageLayout::eShaderReadOnlyOptimal,
+					AccessFlagBits::eTransferRead,
+					AccessFlagBits::eShaderRead,
+					ImageAspectFlagBits::eColor,
+					0, srcMips, 0, 1));
+			}
+			outBarriers.push_back(image->GetImage().CreateLayoutBarrier(
+				ImageLayout::eTransferDstOptimal,
+				ImageLayout::eShaderReadOnlyOptimal,
+				AccessFlagBits::eTransferWrite,
+				AccessFlagBits::eShaderRead,
+				ImageAspectFlagBits::eColor,
+				srcMips, mips - srcMips, 0, 1));
+		}
+	}
+	
+	void Renderer::ClearToPlaceholder(CommandBuffer& inCmdBuffer, TextureDataPtr inImage)
+	{
+		if (!inImage->IsCompressed())
+		{
+			inCmdBuffer.clearColorImage(
+				inImage->GetImage(),
+				ImageLayout::eTransferDstOptimal,
+				PLACEHOLDER_COLOR,
+				ResourceUtils::CreateColorSubresRange(0, inImage->GetImage().GetMips(), 0, 1));
+			return;
+		}
+
+		// block formats can't be cleared, every row of blocks is copied from the same encoded placeholder row
+		BufferDataPtr& placeholder = m_compressedPlaceholders[inImage->GetFormat()];
+		if (!placeholder)
+		{
+			uint8_t texels[BlockCompression::BLOCK_PIXELS * 4];
+			for (uint32_t pixel = 0; pixel < BlockCompression::BLOCK_PIXELS; pixel++)
+			{
+				std::copy(PLACEHOLDER_TEXEL, PLACEHOLDER_TEXEL + 4, texels + pixel * 4);
+			}
+			uint8_t block[16];
+			uint8_t values[BlockCompression::BLOCK_PIXELS];
+			std::fill(values, values + BlockCompression::BLOCK_PIXELS, PLACEHOLDER_TEXEL[0]);
+			switch (inImage->GetFormat())
+			{
+			case ECookedTextureFormat::CTF_BC1:
+				BlockCompression::EncodeBC1(texels, block);
+				break;
+			case ECookedTextureFormat::CTF_BC4:
+				BlockCompression::EncodeBC4(values, block);
+				break;
+			case ECookedTextureFormat::CTF_BC7:
+				BlockCompression::EncodeBC7(texels, block);
+				break;
+			default:
+				BlockCompression::EncodeBC5(texels, block);
+				break;
+			}
+
+			uint32_t blockSize = CookedTexture::GetBlockSize(inImage->GetFormat());
+			std::vector<char> row(PLACEHOLDER_ROW_SIZE);
+			for (vk::DeviceSize offset = 0; offset < PLACEHOLDER_ROW_SIZE; offset += blockSize)
+			{
+				std::copy(block, block + blockSize, row.begin() + offset);
+			}
+			placeholder = ResourceUtils::CreateBufferData(
+				HashString("placeholder_blocks_" + std::to_string(static_cast<uint32_t>(inImage->GetFormat()))),
+				PLACEHOLDER_ROW_SIZE,
+				vk::BufferUsageFlagBits::eTransferSrc,
+				false);
+			placeholder->CopyTo(PLACEHOLDER_ROW_SIZE, row.data());
+		}
+
+		std::vector<vk::BufferImageCopy> copies = inImage->CreatePlaceholderCopies(PLACEHOLDER_ROW_SIZE);
+		inCmdBuffer.copyBufferToImage(
+			placeholder->GetNativeBuffer(),
+			inImage->GetImage(), ImageLayout::eTransferDstOptimal,
+			static_cast<uint32_t>(copies.size()), copies.data());
+	}
+
 	void Renderer::GenerateMips(CommandBuffer& inCmdBuffer, std::vector<TextureDataPtr>& inImages)
 	{
-		for (uint32_t index = 0; index < inImages.size(); index++)
+		// all the mips are expected to be in transfer dst layout, images are processed level by level
+		// to have one barrier per level for the whole batch, cooked images come with their mips
+		std::vector<TextureDataPtr> images;
+		uint32_t maxMips = 0;
+		for (TextureDataPtr image : inImages)
 		{
-			VulkanImage* image = &inImages[index]->GetImage();
+			if (!image->HasPrebuiltMips())
+			{
+				images.push_back(image);
+				maxMips = std::max(maxMips, image->GetImage().GetMips());
+			}
+		}
 	
-			for (uint32_t mipIndex = 1; mipIndex < image->GetMips(); mipIndex++)
+		for (uint32_t mipIndex = 1; mipIndex < maxMips; mipIndex++)
+		{
+			std::vector<ImageMemoryBarrier> barriers;
+			for (TextureDataPtr image : images)
 			{
+				if (image->GetImage().GetMips() <= mipIndex)
+				{
+					continue;
+				}
+				// change layout for source mip to prepare for copy
+				barriers.push_back(image->GetImage().CreateLayoutBarrier(
+					ImageLayout::eTransferDstOptimal,
+					ImageLayout::eTransferSrcOptimal,
+					AccessFlagBits::eTransferWrite,
+					AccessFlagBits::eTransferRead,
+					ImageAspectFlagBits::eColor,
+					mipIndex - 1, 1, 0, 1));
+			}
+	
+			inCmdBuffer.pipelineBarrier(
+				PipelineStageFlagBits::eTransfer,
+				PipelineStageFlagBits::eTransfer,
+				DependencyFlags(),
+				0, nullptr,
+				0, nullptr,
+				static_cast<uint32_t>( barriers.size() ), 
+				barriers.data());
+	
+			for (TextureDataPtr imageData : images)
+			{
+				VulkanImage* image = &imageData->GetImage();
+				if (image->GetMips() <= mipIndex)
+				{
+					continue;
+				}
+	
 				uint32_t previousWidth = std::max(image->GetWidth() >> (mipIndex - 1), (uint32_t)1);
 				uint32_t previousHeight = std::max(image->GetHeight() >> (mipIndex - 1), (uint32_t)1);
 				uint32_t currentWidth = std::max(previousWidth >> 1, (uint32_t)1);
@@ -428,31 +923,6 @@ namespace CGE
 				blit.setDstOffsets(dstOffsets);
 				blit.setDstSubresource(ImageSubresourceLayers(ImageAspectFlagBits::eColor, mipIndex, 0, 1));
 	
-				// change layout for source and destination mip to prepare for copy
-				ImageMemoryBarrier previousMipBarrier = image->CreateLayoutBarrier(
-					ImageLayout::eUndefined,
-					ImageLayout::eTransferSrcOptimal,
-					AccessFlagBits::eTransferWrite,
-					AccessFlagBits::eTransferRead,
-					ImageAspectFlagBits::eColor,
-					mipIndex - 1, 1, 0, 1);
-				ImageMemoryBarrier currentMipBarrier = image->CreateLayoutBarrier(
-					ImageLayout::eUndefined,
-					ImageLayout::eTransferDstOptimal,
-					AccessFlagBits::eTransferRead,
-					AccessFlagBits::eTransferWrite,
-					ImageAspectFlagBits::eColor,
-					mipIndex, 1, 0, 1);
-	
-				ImageMemoryBarrier barriers[] = { previousMipBarrier, currentMipBarrier };
-				inCmdBuffer.pipelineBarrier(
-					PipelineStageFlagBits::eTransfer,
-					PipelineStageFlagBits::eTransfer,
-					DependencyFlags(),
-					0, nullptr,
-					0, nullptr,
-					2, barriers);
-	
 				inCmdBuffer.blitImage(*image, ImageLayout::eTransferSrcOptimal, *image, ImageLayout::eTransferDstOptimal, { blit }, Filter::eLinear);
 			}
 		}
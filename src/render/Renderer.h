@@ -6,6 +6,7 @@
 #include <core/ObjectBase.h>
 #include "glm/fwd.hpp"
 #include <set>
+#include <map>
 #include "data/MeshData.h"
 #include "objects/VulkanPhysicalDevice.h"
 #include "objects/VulkanDevice.h"
@@ -14,6 +15,11 @@
 #include "memory/DeviceMemoryManager.h"
 #include "resources/VulkanImage.h"
 #include "objects/VulkanDescriptorPools.h"
+#include "objects/VulkanLayoutCache.h"
+#include "BindlessTable.h"
+#include "MaterialConstantsArena.h"
+#include "GeometryPool.h"
+#include "RenderGraph.h"
 #include "data/TextureData.h"
 
 
@@ -41,6 +47,8 @@ namespace CGE
 	using VULKAN_HPP_NAMESPACE::Viewport;
 	
 	class PerFrameData;
+	class RenderPassBase;
+	class DrawCullingPass;
 	class DepthPrepass;
 	class ClusterComputePass;
 	class GBufferPass;
@@ -51,6 +59,9 @@ namespace CGE
 	class DeferredLightingPass;
 	class LightCompositingPass;
 	class PostProcessPass;
+	struct ImageTransferBatch;
+	class Material;
+	typedef std::shared_ptr<Material> MaterialPtr;
 	
 	//=======================================================================================================
 	//=======================================================================================================
@@ -65,6 +76,8 @@ namespace CGE
 		void RenderFrame();
 		void WaitForDevice();
 		void Cleanup();
+		// pipelines of scene materials are created on the worker threads, returns once all of them are done
+		void CompilePipelines(const std::vector<MaterialPtr>& inMaterials);
 	
 		void SetResolution(int InWidth, int InHeight);
 		int GetWidth() const;
@@ -75,7 +88,16 @@ namespace CGE
 		VulkanSwapChain& GetSwapChain();
 		VulkanCommandBuffers& GetCommandBuffers();
 		VulkanDescriptorPools& GetDescriptorPools();
+		VulkanLayoutCache& GetLayoutCache();
+		BindlessTable& GetBindlessTable();
+		MaterialConstantsArena& GetConstantsArena();
+		GeometryPool& GetGeometryPool();
 		Queue GetGraphicsQueue();
+		// bindless materials on pooled meshes are culled and drawn indirectly, needs count draws on the device
+		bool IsGpuDrivenDraws() const { return m_gpuDrivenDraws; }
+		void SetGpuDrivenDraws(bool inEnabled) { m_gpuDrivenDraws = inEnabled && device.SupportsDrawIndirectCount(); }
+		// frames with a lower count are executed by now, moves when the fence of an acquired image was waited for
+		uint64_t GetCompletedFrames() const { return m_completedFrames; }
 	
 		PerFrameData* GetPerFrameData() { return perFrameData; }
 		GBufferPass* GetGBufferPass() { return gBufferPass; }
@@ -103,12 +125,17 @@ namespace CGE
 		VulkanSwapChain swapChain;
 		VulkanCommandBuffers commandBuffers;
 		VulkanDescriptorPools descriptorPools;
+		VulkanLayoutCache layoutCache;
+		MaterialConstantsArena constantsArena;
+		GeometryPool geometryPool;
+		BindlessTable bindlessTable;
 		Viewport viewport;
 	
 		PerFrameData* perFrameData;
 	
 		//////////////////////////////////////////////////////////////////////
 
+		DrawCullingPass* m_drawCullingPass;
 		DepthPrepass* m_depthPrepass;
 		ClusterComputePass* m_clusterComputePass;
 		GBufferPass* gBufferPass;
@@ -119,12 +146,41 @@ namespace CGE
 		LightPropagationComputePass* propagationPass;
 		LightCompositingPass* compositingPass;
 		PostProcessPass* postProcessPass;
+
+		RenderGraph m_renderGraph;
+		// graph pass index to the pass
+		std::vector<RenderPassBase*> m_graphPasses;
+
+		//////////////////////////////////////////////////////////////////////
+
+		// images uploads could go through a dedicated transfer queue with ownership transfer
+		bool m_useTransferQueue = false;
+		bool m_gpuDrivenDraws = false;
+		bool m_transferRecorded = false;
+		uint64_t m_imagesScheduledFrame = 0;
+		std::optional<uint32_t> m_graphicsSignaledIndex;
+		std::vector<Semaphore> m_transferFinishedSemaphores;
+		std::vector<Semaphore> m_graphicsFinishedSemaphores;
+		// per swap chain image, count of frames up to the last one submitted with its fence, 0 when none was
+		std::vector<uint64_t> m_imageSubmittedFrames;
+		uint64_t m_completedFrames = 0;
+		// rows of encoded placeholder blocks per compressed format
+		std::map<ECookedTextureFormat, BufferDataPtr> m_compressedPlaceholders;
 	
 		//==================== METHODS ===============================
 	
 		void TransferResources(CommandBuffer& inCmdBuffer, uint32_t inQueueFamilyIndex);
+		void TransferImages(CommandBuffer& inCmdBuffer, ImageTransferBatch& inBatch, std::vector<ImageMemoryBarrier>& outFinalBarriers);
+		void TransferImagesDedicated(CommandBuffer& inCmdBuffer, uint32_t inQueueFamilyIndex, ImageTransferBatch& inBatch, std::vector<ImageMemoryBarrier>& outFinalBarriers);
+		void SubmitTransfer(std::vector<Semaphore>& outWaitSemaphores, std::vector<vk::PipelineStageFlags>& outWaitStages);
+		void AppendShaderReadBarriers(std::vector<TextureDataPtr>& inImages, std::vector<TextureDataPtr>& inCompletedImages, std::vector<ImageMemoryBarrier>& outBarriers);
+		void ClearToPlaceholder(CommandBuffer& inCmdBuffer, TextureDataPtr inImage);
 		void GenerateMips(CommandBuffer& inCmdBuffer, std::vector<TextureDataPtr>& inImages);
+		// passes in order of their dependencies, barriers between them planned from what they declare
+		void BuildRenderGraph();
 		void OnResolutionChange();
+		// the frame last submitted with the image and all submitted before it on the graphics queue are done
+		void CompleteImageFrames(uint32_t inImageIndex);
 	};
 	
 }
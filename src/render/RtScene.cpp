@@ -21,6 +21,7 @@ namespace CGE
 		: m_frameIndexTruncated(0)
 	{
 		m_shaderBindingTables.resize(2);
+		m_sbtVersions.resize(2);
 		m_blasTable.reserve(1024 * 8);
 		// message handlers
 		m_messageSubscriber.AddHandler<GlobalUpdateMessage>(this, &RtScene::HandleUpdate);
@@ -80,10 +81,23 @@ namespace CGE
 
 	void RtScene::UpdateShaders()
 	{
-		auto& sbt = m_shaderBindingTables[Engine::GetFrameIndex(m_shaderBindingTables.size())];
+		uint32_t frameIndex = Engine::GetFrameIndex(static_cast<uint32_t>(m_shaderBindingTables.size()));
+		auto& sbt = m_shaderBindingTables[frameIndex];
+		SbtVersions& versions = m_sbtVersions[frameIndex];
+
+		SbtVersions currentVersions;
+		ResourceSnapshot<RtShader> shaders = DataManager::GetInstance()->GetResourcesSnapshot<RtShader>(&currentVersions.shaders);
+		ResourceSnapshot<RtMaterial> materials = DataManager::GetInstance()->GetResourcesSnapshot<RtMaterial>(&currentVersions.materials);
+		// no shader or material was added, removed, reloaded or changed features since this table was built
+		if ((versions.shaders == currentVersions.shaders) && (versions.materials == currentVersions.materials))
+		{
+			return;
+		}
+		versions = currentVersions;
+
 		sbt.Clear();
-		sbt.AddShaders(DataManager::GetInstance()->GetResourcesByType<RtShader>());
-		sbt.AddRtMaterials(DataManager::GetInstance()->GetResourcesByType<RtMaterial>());
+		sbt.AddShaders(*shaders);
+		sbt.AddRtMaterials(*materials);
 		sbt.Update();
 	}
 
@@ -137,11 +151,10 @@ namespace CGE
 		AccelStructuresBuildInfos& accBuildInfos = m_buildInfosArray[m_frameIndexTruncated];
 
 		uint32_t counter = 0;
-		std::unordered_map<HashString, ResourcePtr>& meshesTable = DataManager::GetInstance()->GetResourcesTable<MeshData>();
-		for (auto& pair : meshesTable)
+		std::vector<MeshDataPtr> meshes = DataManager::GetInstance()->GetResourcesByType<MeshData>();
+		for (MeshDataPtr& meshData : meshes)
 		{
-			MeshDataPtr meshData = ObjectBase::Cast<MeshData>(pair.second);
-			HashString resId = pair.first;
+			HashString resId = meshData->GetResourceId();
 			if (m_blasTable.find(resId) != m_blasTable.end())
 			{
 				continue;
@@ -43,7 +43,14 @@ namespace CGE
 		AccelStructure m_tlas;
 		AccelStructureBuildInfo m_tlasBuildInfo;
 		// shaders data
+		struct SbtVersions
+		{
+			// snapshot versions never get this far, so new tables are always built
+			uint64_t shaders = UINT64_MAX;
+			uint64_t materials = UINT64_MAX;
+		};
 		std::vector<ShaderBindingTable> m_shaderBindingTables;
+		std::vector<SbtVersions> m_sbtVersions;
 
 		std::vector<vk::AccelerationStructureInstanceKHR> m_instances;
 		BufferDataPtr m_instancesBuffer;
@@ -0,0 +1,255 @@
+#include "render/TextureResidencyPolicy.h"
+#include <algorithm>
+#include <queue>
+#include <cmath>
+
+namespace CGE
+{
+	namespace
+	{
+		static constexpr float MIN_STREAMING_DISTANCE = 1e-3f;
+	}
+
+	uint64_t TextureResidencyPolicy::TextureState::GetFootprint(uint32_t inMip) const
+	{
+		uint64_t bytes = 0;
+		for (uint32_t mip = inMip; mip < mipSizes.size(); mip++)
+		{
+			bytes += mipSizes[mip];
+		}
+		return bytes;
+	}
+
+	TextureResidencyPolicy::TextureResidencyPolicy(uint64_t inMemoryBudget, uint64_t inFrameUploadBudget)
+		: m_memoryBudget(inMemoryBudget)
+		, m_frameUploadBudget(inFrameUploadBudget)
+	{
+	}
+
+	uint32_t TextureResidencyPolicy::GetTailMip(uint32_t inWidth, uint32_t inHeight, uint32_t inMipCount)
+	{
+		uint32_t mip = 0;
+		while ((mip + 1 < inMipCount) && (std::max(inWidth >> mip, inHeight >> mip) > TAIL_SIZE))
+		{
+			mip++;
+		}
+		return mip;
+	}
+
+	uint32_t TextureResidencyPolicy::GetRequiredMip(uint32_t inTextureSize, float inWorldSize, float inDistance, float inProjectionScale)
+	{
+		float texelsPerUnit = inTextureSize / std::max(inWorldSize, MIN_STREAMING_DISTANCE);
+		float pixelsPerUnit = inProjectionScale / std::max(inDistance, MIN_STREAMING_DISTANCE);
+		float ratio = texelsPerUnit / pixelsPerUnit;
+		// rounded down to the finer mip, so there's never less than a texel per pixel
+		return ratio > 1.0f ? static_cast<uint32_t>(std::floor(std::log2(ratio))) : 0;
+	}
+
+	uint64_t TextureResidencyPolicy::AddTexture(const std::vector<uint64_t>& inMipSizes, uint32_t inResidentMip)
+	{
+		TextureState state;
+		state.mipSizes = inMipSizes;
+		state.tailMip = inResidentMip;
+		state.residentMip = inResidentMip;
+		state.targetMip = inResidentMip;
+		state.keptMip = inResidentMip;
+
+		uint64_t id = m_nextId++;
+		m_textures[id] = state;
+		return id;
+	}
+
+	void TextureResidencyPolicy::RemoveTexture(uint64_t inId)
+	{
+		m_textures.erase(inId);
+	}
+
+	void TextureResidencyPolicy::RequestMip(uint64_t inId, uint32_t inMip, float inPriority, uint64_t inFrame)
+	{
+		auto it = m_textures.find(inId);
+		if (it == m_textures.end())
+		{
+			return;
+		}
+
+		TextureState& state = it->second;
+		if (state.frameRequested != inFrame)
+		{
+			state.frameRequested = inFrame;
+			state.frameMip = inMip;
+			state.priority = inPriority;
+			return;
+		}
+		state.frameMip = std::min(state.frameMip, inMip);
+		state.priority = std::max(state.priority, inPriority);
+	}
+
+	void TextureResidencyPolicy::UpdateTargets(uint64_t inFrame)
+	{
+		uint64_t totalBytes = 0;
+		for (auto& pair : m_textures)
+		{
+			TextureState& state = pair.second;
+			if (state.frameRequested == inFrame)
+			{
+				// finer requests are taken right away, coarser ones only once the finer one is old enough
+				if (!state.requested || (state.frameMip <= state.keptMip) || (inFrame - state.keptFrame > EVICT_LATENCY))
+				{
+					state.keptMip = state.frameMip;
+					state.keptFrame = inFrame;
+				}
+				state.requested = true;
+			}
+			else if (state.requested && (inFrame - state.keptFrame > EVICT_LATENCY))
+			{
+				state.requested = false;
+				state.priority = 0.0f;
+			}
+
+			state.targetMip = state.requested ? std::min(state.keptMip, state.tailMip) : state.tailMip;
+			totalBytes += state.GetFootprint(state.targetMip);
+		}
+
+		if ((m_memoryBudget == 0) || (totalBytes <= m_memoryBudget))
+		{
+			return;
+		}
+
+		// over budget, levels are dropped one at a time starting from the smallest loss per byte saved. Loss is
+		// the projected size and every level already lost makes the next one four times as bad, so detail goes
+		// away evenly in screen space
+		struct DropCandidate
+		{
+			float key;
+			float loss;
+			uint64_t id;
+			bool operator<(const DropCandidate& inOther) const { return key > inOther.key; }
+		};
+		std::priority_queue<DropCandidate> candidates;
+		auto pushCandidate = [&candidates](uint64_t inId, const TextureState& inState, float inLoss)
+		{
+			float bytes = static_cast<float>(std::max<uint64_t>(inState.mipSizes[inState.targetMip], 1));
+			candidates.push({ inLoss / bytes, inLoss, inId });
+		};
+		for (auto& pair : m_textures)
+		{
+			if (pair.second.targetMip < pair.second.tailMip)
+			{
+				pushCandidate(pair.first, pair.second, pair.second.priority);
+			}
+		}
+		while ((totalBytes > m_memoryBudget) && !candidates.empty())
+		{
+			DropCandidate candidate = candidates.top();
+			candidates.pop();
+			TextureState& state = m_textures[candidate.id];
+			totalBytes -= state.mipSizes[state.targetMip];
+			state.targetMip++;
+			if (state.targetMip < state.tailMip)
+			{
+				pushCandidate(candidate.id, state, candidate.loss * 4.0f);
+			}
+		}
+	}
+
+	std::vector<MipResidencyChange> TextureResidencyPolicy::Update(uint64_t inFrame)
+	{
+		UpdateTargets(inFrame);
+
+		// evictions go first and all at once, they only upload the few levels left
+		std::vector<MipResidencyChange> changes;
+		std::vector<uint64_t> streamIns;
+		uint64_t uploadBytes = 0;
+		for (auto& pair : m_textures)
+		{
+			TextureState& state = pair.second;
+			if (state.pending || (state.targetMip == state.residentMip))
+			{
+				continue;
+			}
+			if (state.targetMip < state.residentMip)
+			{
+				streamIns.push_back(pair.first);
+				continue;
+			}
+			MipResidencyChange change{ pair.first, state.targetMip, state.GetFootprint(state.targetMip) };
+			state.pending = true;
+			state.pendingMip = change.mip;
+			uploadBytes += change.uploadBytes;
+			changes.push_back(change);
+		}
+
+		// streaming goes a level at a time, most important textures first
+		std::sort(streamIns.begin(), streamIns.end(), [this](uint64_t inLeft, uint64_t inRight)
+			{
+				const TextureState& left = m_textures[inLeft];
+				const TextureState& right = m_textures[inRight];
+				return left.priority != right.priority ? left.priority > right.priority : inLeft < inRight;
+			});
+		bool streamed = false;
+		for (uint64_t id : streamIns)
+		{
+			TextureState& state = m_textures[id];
+			MipResidencyChange change{ id, state.residentMip - 1, state.GetFootprint(state.residentMip - 1) };
+			// at least one texture moves forward every frame, so large levels can't starve
+			if ((m_frameUploadBudget > 0) && streamed && (uploadBytes + change.uploadBytes > m_frameUploadBudget))
+			{
+				break;
+			}
+			state.pending = true;
+			state.pendingMip = change.mip;
+			uploadBytes += change.uploadBytes;
+			streamed = true;
+			changes.push_back(change);
+		}
+
+		return changes;
+	}
+
+	void TextureResidencyPolicy::CompleteChange(uint64_t inId)
+	{
+		auto it = m_textures.find(inId);
+		if ((it != m_textures.end()) && it->second.pending)
+		{
+			it->second.residentMip = it->second.pendingMip;
+			it->second.pending = false;
+		}
+	}
+
+	void TextureResidencyPolicy::CancelChange(uint64_t inId)
+	{
+		auto it = m_textures.find(inId);
+		if (it != m_textures.end())
+		{
+			it->second.pending = false;
+		}
+	}
+
+	uint32_t TextureResidencyPolicy::GetResidentMip(uint64_t inId) const
+	{
+		auto it = m_textures.find(inId);
+		return it != m_textures.end() ? it->second.residentMip : 0;
+	}
+
+	uint32_t TextureResidencyPolicy::GetTargetMip(uint64_t inId) const
+	{
+		auto it = m_textures.find(inId);
+		return it != m_textures.end() ? it->second.targetMip : 0;
+	}
+
+	bool TextureResidencyPolicy::IsPending(uint64_t inId) const
+	{
+		auto it = m_textures.find(inId);
+		return (it != m_textures.end()) && it->second.pending;
+	}
+
+	uint64_t TextureResidencyPolicy::GetResidentBytes() const
+	{
+		uint64_t bytes = 0;
+		for (auto& pair : m_textures)
+		{
+			bytes += pair.second.GetFootprint(pair.second.residentMip);
+		}
+		return bytes;
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+namespace CGE
+{
+	// Policy side of the mip streaming, it works with mip sizes only and knows nothing about vulkan objects,
+	// so it could be driven by a simulated camera. Views request the finest mip they need every frame, textures
+	// get it within a memory budget and detail nobody asked for in a while is evicted back to the tail.
+	struct MipResidencyChange
+	{
+		uint64_t id = 0;
+		// finest resident mip after the change
+		uint32_t mip = 0;
+		uint64_t uploadBytes = 0;
+	};
+
+	class TextureResidencyPolicy
+	{
+	public:
+		// mips up to this size are the tail, always resident and loaded along with the texture
+		static constexpr uint32_t TAIL_SIZE = 128;
+		// frames detail is kept after the last request for it
+		static constexpr uint64_t EVICT_LATENCY = 60;
+
+		// budgets of 0 mean no limits
+		TextureResidencyPolicy(uint64_t inMemoryBudget = 0, uint64_t inFrameUploadBudget = 0);
+
+		static uint32_t GetTailMip(uint32_t inWidth, uint32_t inHeight, uint32_t inMipCount);
+		// mip with about one texel per pixel, inWorldSize is the world space length the whole uv range is spread over
+		static uint32_t GetRequiredMip(uint32_t inTextureSize, float inWorldSize, float inDistance, float inProjectionScale);
+
+		void SetMemoryBudget(uint64_t inBytes) { m_memoryBudget = inBytes; }
+		uint64_t GetMemoryBudget() const { return m_memoryBudget; }
+		void SetFrameUploadBudget(uint64_t inBytes) { m_frameUploadBudget = inBytes; }
+		uint64_t GetFrameUploadBudget() const { return m_frameUploadBudget; }
+
+		// mip sizes go from mip 0, the texture comes with everything from inResidentMip already resident
+		uint64_t AddTexture(const std::vector<uint64_t>& inMipSizes, uint32_t inResidentMip);
+		void RemoveTexture(uint64_t inId);
+		// the finest of all the requests of a frame wins, priority is the projected size in pixels
+		void RequestMip(uint64_t inId, uint32_t inMip, float inPriority, uint64_t inFrame);
+		// changes to record this frame, a texture has at most one change in flight until it's completed or canceled
+		std::vector<MipResidencyChange> Update(uint64_t inFrame);
+		void CompleteChange(uint64_t inId);
+		void CancelChange(uint64_t inId);
+
+		uint32_t GetResidentMip(uint64_t inId) const;
+		uint32_t GetTargetMip(uint64_t inId) const;
+		bool IsPending(uint64_t inId) const;
+		uint64_t GetResidentBytes() const;
+		uint64_t GetTextureCount() const { return m_textures.size(); }
+	private:
+		struct TextureState
+		{
+			std::vector<uint64_t> mipSizes;
+			uint32_t tailMip = 0;
+			uint32_t residentMip = 0;
+			uint32_t targetMip = 0;
+			uint32_t pendingMip = 0;
+			bool pending = false;
+			// finest mip requested during the current frame
+			uint32_t frameMip = 0;
+			uint64_t frameRequested = 0;
+			bool requested = false;
+			// finest mip requested within EVICT_LATENCY frames and the frame it was last asked for
+			uint32_t keptMip = 0;
+			uint64_t keptFrame = 0;
+			float priority = 0.0f;
+
+			uint64_t GetFootprint(uint32_t inMip) const;
+		};
+
+		std::unordered_map<uint64_t, TextureState> m_textures;
+		uint64_t m_memoryBudget;
+		uint64_t m_frameUploadBudget;
+		uint64_t m_nextId = 1;
+
+		void UpdateTargets(uint64_t inFrame);
+	};
+}
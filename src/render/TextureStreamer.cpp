@@ -0,0 +1,148 @@
+#include "render/TextureStreamer.h"
+#include "render/TransferList.h"
+#include "data/Material.h"
+#include <algorithm>
+
+namespace CGE
+{
+	namespace
+	{
+		// fresh resources are uploaded before streamed detail
+		static constexpr int32_t STREAMING_TRANSFER_PRIORITY = -1;
+		static constexpr float MIN_PRIORITY_DISTANCE = 1e-3f;
+	}
+
+	TextureStreamer::TextureStreamer()
+		: m_policy(DEFAULT_MEMORY_BUDGET, DEFAULT_FRAME_UPLOAD_BUDGET)
+	{
+	}
+
+	TextureStreamer::~TextureStreamer()
+	{
+	}
+
+	void TextureStreamer::Register(TextureDataPtr inTexture)
+	{
+		auto idIt = m_textureIds.find(inTexture.get());
+		if (idIt != m_textureIds.end())
+		{
+			if (!m_textures[idIt->second].texture.expired())
+			{
+				return;
+			}
+			// the address belongs to a new texture now
+			m_policy.RemoveTexture(idIt->second);
+			m_textures.erase(idIt->second);
+		}
+
+		StreamedTexture streamed;
+		streamed.texture = inTexture;
+		streamed.pointer = inTexture.get();
+		streamed.size = std::max(inTexture->GetImage().GetWidth(), inTexture->GetImage().GetHeight()) << inTexture->GetResidentMip();
+		uint64_t id = m_policy.AddTexture(inTexture->GetMipSizes(), inTexture->GetResidentMip());
+		m_textures[id] = streamed;
+		m_textureIds[inTexture.get()] = id;
+	}
+
+	void TextureStreamer::Unregister(TextureData* inTexture)
+	{
+		auto idIt = m_textureIds.find(inTexture);
+		if (idIt == m_textureIds.end())
+		{
+			return;
+		}
+		m_policy.RemoveTexture(idIt->second);
+		m_textures.erase(idIt->second);
+		m_textureIds.erase(idIt);
+	}
+
+	void TextureStreamer::RequestMaterial(MaterialPtr inMaterial, float inWorldSize, float inDistance, float inProjectionScale, uint64_t inFrame)
+	{
+		float priority = inWorldSize * inProjectionScale / std::max(inDistance, MIN_PRIORITY_DISTANCE);
+		for (TextureDataPtr texture : inMaterial->GetAllTextures())
+		{
+			if (!texture || !texture->IsStreamed())
+			{
+				continue;
+			}
+			auto idIt = m_textureIds.find(texture.get());
+			if (idIt == m_textureIds.end())
+			{
+				continue;
+			}
+			uint32_t mip = TextureResidencyPolicy::GetRequiredMip(m_textures[idIt->second].size, inWorldSize, inDistance, inProjectionScale);
+			m_policy.RequestMip(idIt->second, mip, priority, inFrame);
+		}
+	}
+
+	void TextureStreamer::Update(uint64_t inFrame)
+	{
+		while (!m_retired.empty() && (m_retired.front().frame + RELEASE_LATENCY <= inFrame))
+		{
+			m_retired.pop_front();
+		}
+
+		auto it = m_textures.begin();
+		while (it != m_textures.end())
+		{
+			StreamedTexture& streamed = it->second;
+			TextureDataPtr texture = streamed.texture.lock();
+			if (!texture)
+			{
+				// a target still in the transfer list is dropped with it
+				m_policy.RemoveTexture(it->first);
+				auto idIt = m_textureIds.find(streamed.pointer);
+				if ((idIt != m_textureIds.end()) && (idIt->second == it->first))
+				{
+					m_textureIds.erase(idIt);
+				}
+				it = m_textures.erase(it);
+				continue;
+			}
+
+			if (streamed.target && streamed.uploaded)
+			{
+				// frames recorded before this one could still sample the old image
+				texture->SwapResidency(streamed.target);
+				m_retired.push_back({ inFrame, streamed.target });
+				streamed.target = nullptr;
+				streamed.uploaded = false;
+				m_policy.CompleteChange(it->first);
+			}
+			++it;
+		}
+
+		for (const MipResidencyChange& change : m_policy.Update(inFrame))
+		{
+			StreamedTexture& streamed = m_textures[change.id];
+			TextureDataPtr target = streamed.texture.lock()->CreateResidencyTarget(change.mip);
+			if (!target)
+			{
+				m_policy.CancelChange(change.id);
+				continue;
+			}
+
+			streamed.target = target;
+			uint64_t id = change.id;
+			TransferList::GetInstance()->PushImage(target, STREAMING_TRANSFER_PRIORITY, [this, id](TextureDataPtr inTarget)
+				{
+					auto it = m_textures.find(id);
+					if ((it != m_textures.end()) && (it->second.target == inTarget))
+					{
+						it->second.uploaded = true;
+					}
+				});
+		}
+	}
+
+	void TextureStreamer::Cleanup()
+	{
+		m_retired.clear();
+		for (auto& pair : m_textures)
+		{
+			m_policy.RemoveTexture(pair.first);
+		}
+		m_textures.clear();
+		m_textureIds.clear();
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+#include "render/TextureResidencyPolicy.h"
+#include "data/TextureData.h"
+
+namespace CGE
+{
+	class Material;
+	typedef std::shared_ptr<Material> MaterialPtr;
+
+	// Device side of the mip streaming. Streamed textures are created with their tail mips only, a residency
+	// change uploads the chain from the new mip into a separate image through the transfer list and the texture
+	// swaps it in once the upload is finished. Old images are kept until frames using them are done.
+	// Everything here runs on the main thread.
+	class TextureStreamer
+	{
+	public:
+		// frames an old image or descriptor set could still be used by
+		static constexpr uint64_t RELEASE_LATENCY = 3;
+		static constexpr uint64_t DEFAULT_MEMORY_BUDGET = 256 * 1024 * 1024;
+		static constexpr uint64_t DEFAULT_FRAME_UPLOAD_BUDGET = 16 * 1024 * 1024;
+
+		TextureStreamer();
+		~TextureStreamer();
+
+		void Register(TextureDataPtr inTexture);
+		// a residency target still in flight is dropped
+		void Unregister(TextureData* inTexture);
+		// textures of the material are spread over inWorldSize world units of a mesh seen from inDistance
+		void RequestMaterial(MaterialPtr inMaterial, float inWorldSize, float inDistance, float inProjectionScale, uint64_t inFrame);
+		void Update(uint64_t inFrame);
+		void Cleanup();
+
+		TextureResidencyPolicy& GetPolicy() { return m_policy; }
+	private:
+		struct StreamedTexture
+		{
+			std::weak_ptr<TextureData> texture;
+			// key of m_textureIds, the texture could be gone already
+			TextureData* pointer = nullptr;
+			// largest dimension of mip 0
+			uint32_t size = 0;
+			// residency target being uploaded
+			TextureDataPtr target;
+			bool uploaded = false;
+		};
+
+		struct RetiredTexture
+		{
+			uint64_t frame;
+			TextureDataPtr texture;
+		};
+
+		TextureResidencyPolicy m_policy;
+		std::unordered_map<uint64_t, StreamedTexture> m_textures;
+		std::unordered_map<TextureData*, uint64_t> m_textureIds;
+		std::deque<RetiredTexture> m_retired;
+	};
+}
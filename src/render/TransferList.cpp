@@ -1,52 +1,166 @@
 #include "TransferList.h"
+#include <stdexcept>
 
 namespace CGE
 {
+	namespace
+	{
+		// 4K RGBA8 texture goes in two frames
+		static constexpr uint64_t DEFAULT_FRAME_BUDGET = 32 * 1024 * 1024;
+	};
+
 	TransferList TransferList::instance;
-	
+
 	TransferList* TransferList::GetInstance()
 	{
 		return &instance;
 	}
-	
+
 	void TransferList::PushBuffer(BufferDataPtr inBuffer)
 	{
+		std::scoped_lock<std::mutex> lock(mutex);
 		buffers.push_back(inBuffer);
 	}
-	
-	void TransferList::PushImage(TextureDataPtr inImage)
+
+	std::shared_future<void> TransferList::PushImage(TextureDataPtr inImage, int32_t inPriority /*= 0*/, TransferCallback inCallback /*= nullptr*/)
+	{
+		std::scoped_lock<std::mutex> lock(mutex);
+
+		auto idIt = imageIds.find(inImage.get());
+		if (idIt != imageIds.end())
+		{
+			ImageUpload& upload = images[idIt->second];
+			if (inCallback)
+			{
+				upload.callbacks.push_back(inCallback);
+			}
+			return upload.future;
+		}
+
+		ImageUpload upload;
+		upload.image = inImage;
+		upload.promise = std::make_shared<std::promise<void>>();
+		upload.future = upload.promise->get_future().share();
+		if (!inImage->GetStagingBuffer())
+		{
+			upload.promise->set_exception(std::make_exception_ptr(std::runtime_error("image has no staging data to transfer")));
+			return upload.future;
+		}
+		if (inCallback)
+		{
+			upload.callbacks.push_back(inCallback);
+		}
+
+		TransferRequest request;
+		request.id = nextImageId++;
+		request.size = inImage->GetStagingSize();
+		request.granularity = wholeImageUploads ? 0 : inImage->GetStagingRowPitch();
+		request.priority = inPriority;
+		scheduler.Push(request);
+
+		imageIds[inImage.get()] = request.id;
+		images[request.id] = upload;
+
+		return upload.future;
+	}
+
+	std::vector<BufferDataPtr> TransferList::TakeBuffers()
+	{
+		std::scoped_lock<std::mutex> lock(mutex);
+		std::vector<BufferDataPtr> result;
+		result.swap(buffers);
+		return result;
+	}
+
+	ImageTransferBatch TransferList::ScheduleImages(uint64_t inFrame)
+	{
+		std::scoped_lock<std::mutex> lock(mutex);
+
+		ImageTransferBatch batch;
+		if (images.empty())
+		{
+			return batch;
+		}
+
+		std::vector<TransferSlice> slices = scheduler.Schedule();
+		for (TransferSlice& slice : slices)
+		{
+			ImageUpload& upload = images[slice.id];
+			batch.slices.push_back({ upload.image, slice.offset, slice.size, slice.isFirst, slice.isLast, upload.placeholder });
+			if (slice.isLast)
+			{
+				recordedImages.push_back({ inFrame, upload });
+				imageIds.erase(upload.image.get());
+				images.erase(slice.id);
+			}
+		}
+
+		// the rest of images should be valid for sampling while waiting
+		for (auto& pair : images)
+		{
+			if (!pair.second.placeholder)
+			{
+				pair.second.placeholder = true;
+				batch.newImages.push_back(pair.second.image);
+			}
+		}
+
+		return batch;
+	}
+
+	void TransferList::ProcessCompleted(uint64_t inCompletedFrames)
 	{
-		images.push_back(inImage);
-	}	
-	
-	void TransferList::ClearBuffers()
+		std::vector<ImageUpload> completed;
+		{
+			std::scoped_lock<std::mutex> lock(mutex);
+			while (!recordedImages.empty() && recordedImages.front().frame < inCompletedFrames)
+			{
+				completed.push_back(recordedImages.front().upload);
+				recordedImages.pop_front();
+			}
+		}
+
+		for (ImageUpload& upload : completed)
+		{
+			upload.promise->set_value();
+			for (TransferCallback& callback : upload.callbacks)
+			{
+				callback(upload.image);
+			}
+		}
+	}
+
+	bool TransferList::HasPendingImages()
 	{
-		buffers.clear();
+		std::scoped_lock<std::mutex> lock(mutex);
+		return !images.empty();
 	}
-	
-	void TransferList::ClearImages()
+
+	void TransferList::SetFrameBudget(uint64_t inBytes)
 	{
-		images.clear();
+		std::scoped_lock<std::mutex> lock(mutex);
+		scheduler.SetFrameBudget(inBytes);
 	}
-	
+
 	TransferList::TransferList()
+		: scheduler(DEFAULT_FRAME_BUDGET)
 	{
-	
+
 	}
-	
+
 	TransferList::TransferList(const TransferList& inOther)
 	{
-	
+
 	}
-	
+
 	TransferList::~TransferList()
 	{
-	
+
 	}
-	
+
 	void TransferList::operator=(const TransferList& inOther)
 	{
-	
+
 	}
-	
+
 }
@@ -1,29 +1,86 @@
 #pragma once
 #include <vector>
+#include <deque>
+#include <mutex>
+#include <future>
+#include <functional>
+#include <unordered_map>
 #include "data/MeshData.h"
 #include "data/TextureData.h"
+#include "render/TransferScheduler.h"
 
 namespace CGE
 {
+	typedef std::function<void(TextureDataPtr)> TransferCallback;
+
+	struct ImageTransferSlice
+	{
+		TextureDataPtr image;
+		// range of bytes in image staging buffer, always whole rows of mip 0
+		uint64_t offset;
+		uint64_t size;
+		bool isFirst;
+		bool isLast;
+		// image was cleared to a placeholder on some earlier frame and could be sampled already
+		bool placeholder;
+	};
+
+	struct ImageTransferBatch
+	{
+		// images seen for the first time and not finished this frame, they get a placeholder clear
+		std::vector<TextureDataPtr> newImages;
+		std::vector<ImageTransferSlice> slices;
+
+		bool IsEmpty() const { return newImages.empty() && slices.empty(); }
+	};
+
+	// Buffers are usually a per frame data needed right away so they are always flushed. Images
+	// are streamed through TransferScheduler within a per frame bytes budget and report completion
+	// once the fence of the frame that recorded the last part of the upload was waited for.
 	class TransferList
 	{
 	public:
 		static TransferList* GetInstance();
-	
+
 		void PushBuffer(BufferDataPtr inBuffer);
-		void PushImage(TextureDataPtr inImage);
-	
-		const std::vector<BufferDataPtr>& GetBuffers() { return buffers; }
-		const std::vector<TextureDataPtr>& GetImages() { return images; }
-	
-		void ClearBuffers();
-		void ClearImages();
+		std::shared_future<void> PushImage(TextureDataPtr inImage, int32_t inPriority = 0, TransferCallback inCallback = nullptr);
+
+		std::vector<BufferDataPtr> TakeBuffers();
+		ImageTransferBatch ScheduleImages(uint64_t inFrame);
+		// everything recorded before this frame is executed by now
+		void ProcessCompleted(uint64_t inCompletedFrames);
+		bool HasPendingImages();
+
+		void SetFrameBudget(uint64_t inBytes);
+		// whole image uploads are needed when copies are recorded for another queue family
+		void SetWholeImageUploads(bool inWholeImages) { wholeImageUploads = inWholeImages; }
 	private:
+		struct ImageUpload
+		{
+			TextureDataPtr image;
+			std::shared_ptr<std::promise<void>> promise;
+			std::shared_future<void> future;
+			std::vector<TransferCallback> callbacks;
+			bool placeholder = false;
+		};
+
+		struct RecordedUpload
+		{
+			uint64_t frame;
+			ImageUpload upload;
+		};
+
 		static TransferList instance;
-	
+
+		std::mutex mutex;
 		std::vector<BufferDataPtr> buffers;
-		std::vector<TextureDataPtr> images;
-	
+		std::unordered_map<uint64_t, ImageUpload> images;
+		std::unordered_map<TextureData*, uint64_t> imageIds;
+		std::deque<RecordedUpload> recordedImages;
+		TransferScheduler scheduler;
+		uint64_t nextImageId = 1;
+		bool wholeImageUploads = false;
+
 		TransferList();
 		TransferList(const TransferList& inOther);
 		void operator=(const TransferList& inOther);
@@ -0,0 +1,114 @@
+#include "render/TransferScheduler.h"
+#include <algorithm>
+#include <limits>
+
+namespace CGE
+{
+
+	TransferScheduler::TransferScheduler(uint64_t inFrameBudget)
+		: m_frameBudget(inFrameBudget)
+	{
+	}
+
+	bool TransferScheduler::Push(const TransferRequest& inRequest)
+	{
+		for (PendingTransfer& pending : m_pending)
+		{
+			if (pending.request.id == inRequest.id)
+			{
+				return false;
+			}
+		}
+
+		PendingTransfer pending;
+		pending.request = inRequest;
+		pending.offset = 0;
+		pending.sequence = m_sequence++;
+		m_pending.push_back(pending);
+
+		return true;
+	}
+
+	bool TransferScheduler::Cancel(uint64_t inId)
+	{
+		auto it = std::find_if(m_pending.begin(), m_pending.end(), [inId](const PendingTransfer& pending) { return pending.request.id == inId; });
+		if (it == m_pending.end())
+		{
+			return false;
+		}
+		m_pending.erase(it);
+		return true;
+	}
+
+	std::vector<TransferSlice> TransferScheduler::Schedule()
+	{
+		std::vector<TransferSlice> slices;
+		if (m_pending.empty())
+		{
+			return slices;
+		}
+
+		std::sort(m_pending.begin(), m_pending.end(), [](const PendingTransfer& left, const PendingTransfer& right)
+			{
+				if (left.request.priority != right.request.priority)
+				{
+					return left.request.priority > right.request.priority;
+				}
+				return left.sequence < right.sequence;
+			});
+
+		uint64_t budgetLeft = m_frameBudget > 0 ? m_frameBudget : std::numeric_limits<uint64_t>::max();
+		for (PendingTransfer& pending : m_pending)
+		{
+			const TransferRequest& request = pending.request;
+			uint64_t remaining = request.size - pending.offset;
+			uint64_t take = remaining;
+			if (take > budgetLeft)
+			{
+				take = request.granularity > 0 ? (budgetLeft / request.granularity) * request.granularity : 0;
+				if (take == 0 && slices.empty())
+				{
+					// nothing fits, push at least something to move forward
+					take = request.granularity > 0 ? std::min(request.granularity, remaining) : remaining;
+				}
+			}
+			// strict ordering, lower priority requests don't jump over the ones that didn't fit
+			if (take == 0 && remaining > 0)
+			{
+				break;
+			}
+
+			TransferSlice slice;
+			slice.id = request.id;
+			slice.offset = pending.offset;
+			slice.size = take;
+			slice.isFirst = pending.offset == 0;
+			slice.isLast = pending.offset + take == request.size;
+			slices.push_back(slice);
+
+			pending.offset += take;
+			budgetLeft -= std::min(take, budgetLeft);
+			if (budgetLeft == 0)
+			{
+				break;
+			}
+		}
+
+		m_pending.erase(
+			std::remove_if(m_pending.begin(), m_pending.end(), [](const PendingTransfer& pending) { return pending.offset >= pending.request.size; }),
+			m_pending.end());
+
+		return slices;
+	}
+
+	uint64_t TransferScheduler::GetPendingBytes() const
+	{
+		uint64_t bytes = 0;
+		for (const PendingTransfer& pending : m_pending)
+		{
+			bytes += pending.request.size - pending.offset;
+		}
+		return bytes;
+	}
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace CGE
+{
+	// Scheduler works with plain byte ranges and knows nothing about vulkan objects, so
+	// the uploads policy could be checked without a device. Requests are ordered by priority
+	// first and by push order second, each frame takes slices of them within a bytes budget.
+	struct TransferRequest
+	{
+		uint64_t id = 0;
+		uint64_t size = 0;
+		// slices are cut in multiples of granularity, 0 means the request can't be split
+		uint64_t granularity = 0;
+		int32_t priority = 0;
+	};
+
+	struct TransferSlice
+	{
+		uint64_t id = 0;
+		uint64_t offset = 0;
+		uint64_t size = 0;
+		bool isFirst = false;
+		bool isLast = false;
+	};
+
+	class TransferScheduler
+	{
+	public:
+		// budget of 0 means no limits
+		TransferScheduler(uint64_t inFrameBudget = 0);
+
+		void SetFrameBudget(uint64_t inBytes) { m_frameBudget = inBytes; }
+		uint64_t GetFrameBudget() const { return m_frameBudget; }
+
+		bool Push(const TransferRequest& inRequest);
+		bool Cancel(uint64_t inId);
+		// at least one slice is produced if anything is pending, so oversized requests can't starve
+		std::vector<TransferSlice> Schedule();
+
+		bool IsEmpty() const { return m_pending.empty(); }
+		uint64_t GetPendingCount() const { return m_pending.size(); }
+		uint64_t GetPendingBytes() const;
+	private:
+		struct PendingTransfer
+		{
+			TransferRequest request;
+			uint64_t offset;
+			uint64_t sequence;
+		};
+
+		std::vector<PendingTransfer> m_pending;
+		uint64_t m_frameBudget;
+		uint64_t m_sequence = 0;
+	};
+}
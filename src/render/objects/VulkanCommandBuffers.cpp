@@ -34,7 +34,8 @@ namespace CGE
 	
 		CommandBufferAllocateInfo buffersInfo;
 		buffersInfo.setCommandPool(m_transferPool);
-		buffersInfo.setCommandBufferCount(cmdBuffersPerPool);
+		// one per frame, transfer buffers are submitted once a frame the same way as graphics ones
+		buffersInfo.setCommandBufferCount(poolsCount);
 		buffersInfo.setLevel(CommandBufferLevel::ePrimary);
 		m_transferBuffers = device->GetDevice().allocateCommandBuffers(buffersInfo);
 	
@@ -64,7 +65,7 @@ namespace CGE
 	{
 		if (device)
 		{
-			device->GetDevice().freeCommandBuffers(m_transferPool, cmdBuffersPerPool, m_transferBuffers.data());
+			device->GetDevice().freeCommandBuffers(m_transferPool, static_cast<uint32_t>(m_transferBuffers.size()), m_transferBuffers.data());
 			device->GetDevice().destroyCommandPool(m_transferPool);
 	
 			for (uint32_t index = 0; index < poolsCount; index++)
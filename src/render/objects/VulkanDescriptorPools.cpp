@@ -1,16 +1,39 @@
 #include "VulkanDescriptorPools.h"
 #include "VulkanDevice.h"
+#include "core/Engine.h"
+#include "../Renderer.h"
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
 
 namespace CGE
 {
 	using VULKAN_HPP_NAMESPACE::DescriptorSetAllocateInfo;
 	using VULKAN_HPP_NAMESPACE::Result;
-	using VULKAN_HPP_NAMESPACE::DescriptorPoolSize;
 	using VULKAN_HPP_NAMESPACE::DescriptorType;
 	using VULKAN_HPP_NAMESPACE::DescriptorPoolCreateInfo;
 	using VULKAN_HPP_NAMESPACE::DescriptorPoolCreateFlagBits;
 
+	namespace
+	{
+		// per set of a frame pool, frame sets are small short lived ones
+		static const DescriptorPoolSize FRAME_SET_SIZES[] = {
+			DescriptorPoolSize(DescriptorType::eUniformBuffer, 8),
+			DescriptorPoolSize(DescriptorType::eStorageBuffer, 4),
+			DescriptorPoolSize(DescriptorType::eSampler, 1),
+			DescriptorPoolSize(DescriptorType::eSampledImage, 8),
+			DescriptorPoolSize(DescriptorType::eStorageImage, 2)
+		};
+
+		bool IsPoolExhausted(Result inResult)
+		{
+			return (inResult == Result::eErrorOutOfPoolMemory) || (inResult == Result::eErrorFragmentedPool);
+		}
+	}
+
 	VulkanDescriptorPools::VulkanDescriptorPools()
+		: vulkanDevice(nullptr)
+		, imageIndex(0)
 	{
 	
 	}
@@ -20,89 +43,230 @@ namespace CGE
 	
 	}
 	
-	void VulkanDescriptorPools::Create(VulkanDevice* inVulkanDevice)
+	void VulkanDescriptorPools::Create(VulkanDevice* inVulkanDevice, uint32_t inImageCount)
 	{
 		vulkanDevice = inVulkanDevice;
-		pools.push_back(ConstructDescriptorPool());
+		framePools.resize(inImageCount);
 	}
 	
 	void VulkanDescriptorPools::Destroy()
 	{
-		for (DescriptorPool pool : pools)
+		for (auto& pair : buckets)
 		{
-			vulkanDevice->GetDevice().destroyDescriptorPool(pool);
+			for (BucketPool& bucketPool : pair.second.pools)
+			{
+				vulkanDevice->GetDevice().destroyDescriptorPool(bucketPool.pool);
+			}
+		}
+		buckets.clear();
+		for (FramePools& frame : framePools)
+		{
+			for (FramePool& framePool : frame.pools)
+			{
+				vulkanDevice->GetDevice().destroyDescriptorPool(framePool.pool);
+			}
 		}
+		framePools.clear();
 	}
 	
-	std::vector<DescriptorSet> VulkanDescriptorPools::AllocateSet(const std::vector<DescriptorSetLayout>& inLayouts, DescriptorPool& outPool)
+	DescriptorSet VulkanDescriptorPools::AllocateSet(DescriptorSetLayout inLayout)
 	{
-		for (uint32_t index = 0; index < pools.size(); index++)
+		Bucket& bucket = buckets[static_cast<VkDescriptorSetLayout>(inLayout)];
+		if (bucket.pools.empty())
 		{
+			bucket.setSizes = GetSetSizes(inLayout);
+		}
+
+		DescriptorSet set;
+		if (!bucket.freeSets.empty())
+		{
+			set = bucket.freeSets.back();
+			bucket.freeSets.pop_back();
+		}
+		else
+		{
+			// every pool of a bucket has room for exactly its capacity in sets, only the last one could have room
+			if (bucket.pools.empty() || (bucket.pools.back().allocated == bucket.pools.back().capacity))
+			{
+				uint32_t capacity = bucket.pools.empty() ? BUCKET_FIRST_POOL_SETS : std::min(bucket.pools.back().capacity * 2, BUCKET_MAX_POOL_SETS);
+				bucket.pools.push_back({ ConstructPool(bucket.setSizes, capacity), capacity, 0 });
+			}
+			BucketPool& bucketPool = bucket.pools.back();
+
 			DescriptorSetAllocateInfo descSetAllocInfo;
-			descSetAllocInfo.setDescriptorPool(pools[index]);
-			descSetAllocInfo.setDescriptorSetCount(static_cast<uint32_t>( inLayouts.size() ));
-			descSetAllocInfo.setPSetLayouts( inLayouts.data() );
-	
-			std::vector<DescriptorSet> sets;
-			sets.resize(inLayouts.size());
-			Result result = vulkanDevice->GetDevice().allocateDescriptorSets(&descSetAllocInfo, sets.data());
+			descSetAllocInfo.setDescriptorPool(bucketPool.pool);
+			descSetAllocInfo.setDescriptorSetCount(1);
+			descSetAllocInfo.setPSetLayouts(&inLayout);
+			Result result = vulkanDevice->GetDevice().allocateDescriptorSets(&descSetAllocInfo, &set);
+			if (result != Result::eSuccess)
+			{
+				throw std::runtime_error("failed to allocate descriptor set");
+			}
+			bucketPool.allocated++;
+		}
+
+		bucket.used++;
+		bucket.peak = std::max(bucket.peak, bucket.used);
+		return set;
+	}
+
+	void VulkanDescriptorPools::FreeSet(DescriptorSetLayout inLayout, DescriptorSet inSet)
+	{
+		auto it = buckets.find(static_cast<VkDescriptorSetLayout>(inLayout));
+		if ((it == buckets.end()) || !inSet)
+		{
+			return;
+		}
+		it->second.freeSets.push_back(inSet);
+		it->second.used--;
+	}
+
+	void VulkanDescriptorPools::BeginFrame(uint32_t inImageIndex)
+	{
+		// a recreated swapchain could come with more images than asked for
+		if (inImageIndex >= framePools.size())
+		{
+			framePools.resize(inImageIndex + 1);
+		}
+		imageIndex = inImageIndex;
+		FramePools& frame = framePools[imageIndex];
+		for (FramePool& framePool : frame.pools)
+		{
+			if (framePool.used > 0)
+			{
+				vulkanDevice->GetDevice().resetDescriptorPool(framePool.pool);
+				framePool.used = 0;
+			}
+		}
+		frame.current = 0;
+	}
+
+	DescriptorSet VulkanDescriptorPools::AllocateFrameSet(DescriptorSetLayout inLayout)
+	{
+		FramePools& frame = framePools[imageIndex];
+
+		DescriptorSetAllocateInfo descSetAllocInfo;
+		descSetAllocInfo.setDescriptorSetCount(1);
+		descSetAllocInfo.setPSetLayouts(&inLayout);
+		DescriptorSet set;
+		// pools are only ever filled one after another, a full one is left for the rest of the frame
+		while (true)
+		{
+			if (frame.current == frame.pools.size())
+			{
+				frame.pools.push_back({ ConstructFramePool() });
+			}
+			FramePool& framePool = frame.pools[frame.current];
+			descSetAllocInfo.setDescriptorPool(framePool.pool);
+			Result result = vulkanDevice->GetDevice().allocateDescriptorSets(&descSetAllocInfo, &set);
 			if (result == Result::eSuccess)
 			{
-				outPool = pools[index];
-				return sets;
+				framePool.used++;
+				framePool.peak = std::max(framePool.peak, framePool.used);
+				return set;
+			}
+			// a fresh pool that can't take it never will
+			if (!IsPoolExhausted(result) || (framePool.used == 0))
+			{
+				throw std::runtime_error("failed to allocate frame descriptor set");
+			}
+			frame.current++;
+		}
+	}
+
+	std::vector<DescriptorPoolStats> VulkanDescriptorPools::GetStats() const
+	{
+		std::vector<DescriptorPoolStats> stats;
+		for (auto& pair : buckets)
+		{
+			const Bucket& bucket = pair.second;
+			DescriptorPoolStats bucketStats{ pair.first, UINT32_MAX, 0, bucket.used, bucket.peak };
+			for (const BucketPool& bucketPool : bucket.pools)
+			{
+				bucketStats.capacity += bucketPool.capacity;
+			}
+			stats.push_back(bucketStats);
+		}
+		for (uint32_t frame = 0; frame < framePools.size(); frame++)
+		{
+			for (const FramePool& framePool : framePools[frame].pools)
+			{
+				stats.push_back({ VK_NULL_HANDLE, frame, FRAME_POOL_SETS, framePool.used, framePool.peak });
+			}
+		}
+		return stats;
+	}
+
+	void VulkanDescriptorPools::PrintStats() const
+	{
+		std::vector<DescriptorPoolStats> stats = GetStats();
+		for (const DescriptorPoolStats& poolStats : stats)
+		{
+			if (poolStats.frame == UINT32_MAX)
+			{
+				std::printf("descriptor sets of layout %llx: %u used, %u peak, %u capacity\n",
+					static_cast<unsigned long long>(reinterpret_cast<uint64_t>(poolStats.layout)), poolStats.used, poolStats.peak, poolStats.capacity);
 			}
 			else
 			{
-				if (index < (pools.size() - 1))
-				{
-					continue;
-				}
-				if (result == Result::eErrorOutOfHostMemory || result == Result::eErrorOutOfDeviceMemory)
-				{
-					// we're out of memory on device or host
-					throw std::exception("Cannot create descriptor pool. Out of memory");
-				}
-				
-				pools.push_back(ConstructDescriptorPool());
-				descSetAllocInfo.setDescriptorPool(pools.back());
-				Result result = vulkanDevice->GetDevice().allocateDescriptorSets(&descSetAllocInfo, sets.data());
-				if (result == Result::eSuccess)
-				{
-					outPool = pools.back();
-					return sets;
-				}
-				else
-				{
-					throw std::exception("Failure. Cannot create descriptor pool.");
-				}
+				std::printf("image %u frame descriptor pool: %u used, %u peak, %u capacity\n",
+					poolStats.frame, poolStats.used, poolStats.peak, poolStats.capacity);
 			}
 		}
+	}
 
-		throw std::exception("Failure. Cannot create descriptor pool.");
+	std::vector<DescriptorPoolSize> VulkanDescriptorPools::GetSetSizes(DescriptorSetLayout inLayout) const
+	{
+		std::vector<DescriptorPoolSize> sizes;
+		for (const DescriptorSetLayoutBinding& binding : Engine::GetRendererInstance()->GetLayoutCache().GetSetLayoutBindings(inLayout))
+		{
+			if (binding.descriptorCount == 0)
+			{
+				continue;
+			}
+			auto it = std::find_if(sizes.begin(), sizes.end(), [&binding](const DescriptorPoolSize& inSize) { return inSize.type == binding.descriptorType; });
+			if (it != sizes.end())
+			{
+				it->descriptorCount += binding.descriptorCount;
+			}
+			else
+			{
+				sizes.push_back(DescriptorPoolSize(binding.descriptorType, binding.descriptorCount));
+			}
+		}
+		return sizes;
 	}
-	
-	DescriptorPool VulkanDescriptorPools::ConstructDescriptorPool()
+
+	DescriptorPool VulkanDescriptorPools::ConstructPool(const std::vector<DescriptorPoolSize>& inSetSizes, uint32_t inSetCount)
 	{
-		DescriptorPoolSize uniformPoolSize;
-		uniformPoolSize.setDescriptorCount(2048);
-		uniformPoolSize.setType(DescriptorType::eUniformBuffer);
-		DescriptorPoolSize storageBufferPoolSize;
-		storageBufferPoolSize.setDescriptorCount(64);
-		storageBufferPoolSize.setType(DescriptorType::eStorageBuffer);
-		DescriptorPoolSize samplerPoolSize;
-		samplerPoolSize.setDescriptorCount(16);
-		samplerPoolSize.setType(DescriptorType::eSampler);
-		DescriptorPoolSize imagePoolSize;
-		imagePoolSize.setDescriptorCount(2048);
-		imagePoolSize.setType(DescriptorType::eSampledImage);
-	
-		DescriptorPoolSize poolSizes[] = { uniformPoolSize, storageBufferPoolSize, samplerPoolSize, imagePoolSize };
+		std::vector<DescriptorPoolSize> poolSizes = inSetSizes;
+		for (DescriptorPoolSize& size : poolSizes)
+		{
+			size.descriptorCount *= inSetCount;
+		}
+		// sets without descriptors still need a pool that isn't empty
+		if (poolSizes.empty())
+		{
+			poolSizes.push_back(DescriptorPoolSize(DescriptorType::eUniformBuffer, 1));
+		}
+
 		DescriptorPoolCreateInfo descPoolInfo;
-		descPoolInfo.setFlags(DescriptorPoolCreateFlagBits::eFreeDescriptorSet | DescriptorPoolCreateFlagBits::eUpdateAfterBind);
-		descPoolInfo.setPoolSizeCount(4);
-		descPoolInfo.setPPoolSizes(poolSizes);
-		descPoolInfo.setMaxSets(512);
-	
+		descPoolInfo.setPoolSizes(poolSizes);
+		descPoolInfo.setMaxSets(inSetCount);
+		return vulkanDevice->GetDevice().createDescriptorPool(descPoolInfo);
+	}
+
+	DescriptorPool VulkanDescriptorPools::ConstructFramePool()
+	{
+		std::vector<DescriptorPoolSize> poolSizes(std::begin(FRAME_SET_SIZES), std::end(FRAME_SET_SIZES));
+		for (DescriptorPoolSize& size : poolSizes)
+		{
+			size.descriptorCount *= FRAME_POOL_SETS;
+		}
+
+		DescriptorPoolCreateInfo descPoolInfo;
+		descPoolInfo.setPoolSizes(poolSizes);
+		descPoolInfo.setMaxSets(FRAME_POOL_SETS);
 		return vulkanDevice->GetDevice().createDescriptorPool(descPoolInfo);
 	}
 	
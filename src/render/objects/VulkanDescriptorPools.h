@@ -1,29 +1,99 @@
 #pragma once
 
 #include "vulkan/vulkan.hpp"
+#include <vector>
+#include <unordered_map>
 
 namespace CGE
 {
 	using VULKAN_HPP_NAMESPACE::DescriptorSet;
 	using VULKAN_HPP_NAMESPACE::DescriptorSetLayout;
+	using VULKAN_HPP_NAMESPACE::DescriptorSetLayoutBinding;
 	using VULKAN_HPP_NAMESPACE::DescriptorPool;
+	using VULKAN_HPP_NAMESPACE::DescriptorPoolSize;
 	
 	class VulkanDevice;
+
+	struct DescriptorPoolStats
+	{
+		// layout the bucket is for, null for frame pools
+		VkDescriptorSetLayout layout;
+		// swapchain image the pool belongs to, UINT32_MAX for persistent pools
+		uint32_t frame;
+		uint32_t capacity;
+		uint32_t used;
+		uint32_t peak;
+	};
 	
+	// Two kinds of descriptor set allocations. Persistent sets come from pools bucketed by layout, every
+	// pool of a bucket holds a fixed number of sets of exactly that layout, so freed sets go to a free list
+	// and are handed out again as they are, no pool fragmentation. Frame sets come from linear pools of the
+	// swapchain image, nothing is freed one by one, all pools of the image are reset once its fence was waited for.
 	class VulkanDescriptorPools
 	{
 	public:
+		// sets in the first pool of a bucket, every next pool is twice as big up to the max
+		static constexpr uint32_t BUCKET_FIRST_POOL_SETS = 16;
+		static constexpr uint32_t BUCKET_MAX_POOL_SETS = 256;
+		static constexpr uint32_t FRAME_POOL_SETS = 256;
+
 		VulkanDescriptorPools();
 		virtual ~VulkanDescriptorPools();
 	
-		void Create(VulkanDevice* inVulkanDevice);
+		// one set of frame pools per swapchain image, every image has its own fence
+		void Create(VulkanDevice* inVulkanDevice, uint32_t inImageCount);
 		void Destroy();
 	
-		std::vector<DescriptorSet> AllocateSet(const std::vector<DescriptorSetLayout>& inLayouts, DescriptorPool& outPool);
+		// persistent sets, kept until freed
+		DescriptorSet AllocateSet(DescriptorSetLayout inLayout);
+		// the set may be reused right away, nothing should be using it anymore
+		void FreeSet(DescriptorSetLayout inLayout, DescriptorSet inSet);
+
+		// resets pools of the acquired image, its fence has to be waited for already, all sets allocated
+		// during its previous use are gone
+		void BeginFrame(uint32_t inImageIndex);
+		// valid until the same image begins again
+		DescriptorSet AllocateFrameSet(DescriptorSetLayout inLayout);
+
+		std::vector<DescriptorPoolStats> GetStats() const;
+		void PrintStats() const;
 	private:
+		struct BucketPool
+		{
+			DescriptorPool pool;
+			uint32_t capacity;
+			uint32_t allocated;
+		};
+
+		struct Bucket
+		{
+			std::vector<DescriptorPoolSize> setSizes;
+			std::vector<BucketPool> pools;
+			std::vector<DescriptorSet> freeSets;
+			uint32_t used = 0;
+			uint32_t peak = 0;
+		};
+
+		struct FramePool
+		{
+			DescriptorPool pool;
+			uint32_t used = 0;
+			uint32_t peak = 0;
+		};
+
+		struct FramePools
+		{
+			std::vector<FramePool> pools;
+			uint32_t current = 0;
+		};
+
 		VulkanDevice* vulkanDevice;
-		std::vector<DescriptorPool> pools;
-	
-		DescriptorPool ConstructDescriptorPool();
+		std::unordered_map<VkDescriptorSetLayout, Bucket> buckets;
+		std::vector<FramePools> framePools;
+		uint32_t imageIndex;
+
+		std::vector<DescriptorPoolSize> GetSetSizes(DescriptorSetLayout inLayout) const;
+		DescriptorPool ConstructPool(const std::vector<DescriptorPoolSize>& inSetSizes, uint32_t inSetCount);
+		DescriptorPool ConstructFramePool();
 	};
 }
@@ -24,7 +24,7 @@ namespace CGE
 		m_vulkanDevice = inVulkanDevice;
 		CreateLayout();
 	
-		m_set = Engine::GetRendererInstance()->GetDescriptorPools().AllocateSet({m_layout}, m_pool)[0];
+		m_set = Engine::GetRendererInstance()->GetDescriptorPools().AllocateSet(m_layout);
 	}
 	
 	void VulkanDescriptorSet::Create(VulkanDevice* inVulkanDevice, std::vector<VulkanDescriptorSet*>& inSets)
@@ -34,20 +34,12 @@ namespace CGE
 	
 	void VulkanDescriptorSet::Create(VulkanDevice* inVulkanDevice, uint32_t inCount, VulkanDescriptorSet** inSets)
 	{
-		std::vector<DescriptorSetLayout> layouts;
+		// sets come from the pools of their layouts, one by one
+		VulkanDescriptorPools& descriptorPools = Engine::GetRendererInstance()->GetDescriptorPools();
 		for (uint32_t index = 0; index < inCount; index++)
 		{
 			inSets[index]->m_vulkanDevice = inVulkanDevice;
-			layouts.push_back(inSets[index]->CreateLayout());
-		}
-	
-		DescriptorPool pool;
-		std::vector<DescriptorSet> sets = Engine::GetRendererInstance()->GetDescriptorPools().AllocateSet({ layouts }, pool);
-	
-		for (uint32_t index = 0; index < inCount; index++)
-		{
-			inSets[index]->m_set = sets[index];
-			inSets[index]->m_pool = pool;
+			inSets[index]->m_set = descriptorPools.AllocateSet(inSets[index]->CreateLayout());
 		}
 	}
 	
@@ -154,16 +146,12 @@ namespace CGE
 
 	void VulkanDescriptorSet::Destroy()
 	{
-		if (m_layout)
-		{
-			m_vulkanDevice->GetDevice().destroyDescriptorSetLayout(m_layout);
-			m_layout = nullptr;
-		}
 		if (m_set)
 		{
-			m_vulkanDevice->GetDevice().freeDescriptorSets(m_pool, { m_set });
+			Engine::GetRendererInstance()->GetDescriptorPools().FreeSet(m_layout, m_set);
 			m_set = nullptr;
 		}
+		m_layout = nullptr;
 	}
 	
 	void VulkanDescriptorSet::SetBindings(const std::vector<DescriptorSetLayoutBinding>& inBindings)
@@ -193,17 +181,8 @@ namespace CGE
 			return m_layout;
 		}
 
-		vk::StructureChain<vk::DescriptorSetLayoutCreateInfo, vk::DescriptorSetLayoutBindingFlagsCreateInfo> chain;
-		auto& flagsStruct = chain.get<vk::DescriptorSetLayoutBindingFlagsCreateInfo>();
-
-		// maybe use vk::DescriptorBindingFlagBits::eVariableDescriptorCount in the future
-		std::vector<vk::DescriptorBindingFlags> flags(m_bindings.size(), vk::DescriptorBindingFlagBits::ePartiallyBound);
-		flagsStruct.setBindingFlags(flags);
-	
-		vk::DescriptorSetLayoutCreateInfo& layoutInfo = chain.get<vk::DescriptorSetLayoutCreateInfo>();
-		layoutInfo.setBindingCount(static_cast<uint32_t>(m_bindings.size()));
-		layoutInfo.setPBindings(m_bindings.data());
-		m_layout = m_vulkanDevice->GetDevice().createDescriptorSetLayout(layoutInfo);
+		// identical bindings share one layout owned by the cache
+		m_layout = Engine::GetRendererInstance()->GetLayoutCache().GetSetLayout(m_bindings);
 	
 		return m_layout;
 	}
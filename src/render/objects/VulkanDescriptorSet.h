@@ -9,7 +9,6 @@ namespace CGE
 	using VULKAN_HPP_NAMESPACE::DescriptorSet;
 	using VULKAN_HPP_NAMESPACE::DescriptorSetLayout;
 	using VULKAN_HPP_NAMESPACE::DescriptorSetLayoutBinding;
-	using VULKAN_HPP_NAMESPACE::DescriptorPool;
 	
 	class VulkanDevice;
 	
@@ -41,7 +40,6 @@ namespace CGE
 	private:
 		VulkanDevice* m_vulkanDevice;
 	
-		DescriptorPool m_pool;
 		DescriptorSet m_set;
 		DescriptorSetLayout m_layout;
 		std::vector<DescriptorSetLayoutBinding> m_bindings;
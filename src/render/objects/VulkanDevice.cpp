@@ -2,7 +2,11 @@
 #include "core/Engine.h"
 #include "GLFW/glfw3.h"
 #include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include "../memory/DeviceMemoryManager.h"
+#include "utils/MappedFile.h"
 
 VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
 
@@ -16,6 +20,12 @@ namespace CGE
 	using VULKAN_HPP_NAMESPACE::PipelineCacheCreateInfo;
 	using VULKAN_HPP_NAMESPACE::LayerProperties;
 
+	namespace
+	{
+		// driver blob of the pipeline cache, relative to the working directory like content paths
+		static const std::string PIPELINE_CACHE_PATH = "pipeline.cache";
+	}
+
 	VulkanDevice::VulkanDevice()
 	{
 	
@@ -90,6 +100,8 @@ namespace CGE
 		
 		std::vector<DeviceQueueCreateInfo> queueCreateInfoVector;
 		std::set<uint32_t> indicesSet = physicalDevice.GetQueueFamiliesIndicesSet(QueueFlagBits::eGraphics | QueueFlagBits::eCompute, surface);
+		// transfer family could be a dedicated one
+		indicesSet.insert(queueFamilyIndices.transferFamily.value());
 		for (uint32_t queueFamiltIndex : indicesSet)
 		{
 			DeviceQueueCreateInfo queueCreateInfo;
@@ -110,6 +122,8 @@ namespace CGE
 			vk::PhysicalDeviceAccelerationStructureFeaturesKHR,
 			vk::PhysicalDeviceRayTracingPipelineFeaturesKHR,
 			vk::PhysicalDeviceRayQueryFeaturesKHR>();
+		const vk::PhysicalDeviceFeatures& coreFeatures = chain.get<vk::PhysicalDeviceFeatures2>().features;
+		drawIndirectCount = chain.get<vk::PhysicalDeviceVulkan12Features>().drawIndirectCount && coreFeatures.multiDrawIndirect && coreFeatures.drawIndirectFirstInstance;
 	
 		DeviceCreateInfo deviceCreateInfo;
 		deviceCreateInfo.setPQueueCreateInfos(queueCreateInfoVector.data());
@@ -128,13 +142,17 @@ namespace CGE
 		presentQueue = device.getQueue(queueFamilyIndices.presentFamily.value(), 0);
 		transferQueue = device.getQueue(queueFamilyIndices.transferFamily.value(), 0);
 	
+		// pipelines compiled by the previous run come back from the driver blob
+		std::vector<uint8_t> pipelineCacheData = LoadPipelineCacheData();
 		PipelineCacheCreateInfo pipelineCacheInfo;
-		// TODO configure initial size for cache of whatever
+		pipelineCacheInfo.setInitialDataSize(pipelineCacheData.size());
+		pipelineCacheInfo.setPInitialData(pipelineCacheData.data());
 		pipelineCache = device.createPipelineCache(pipelineCacheInfo);
 	}
 	
 	void VulkanDevice::Destroy()
 	{
+		SavePipelineCache();
 		device.destroyPipelineCache(pipelineCache);
 	
 		DeviceMemoryManager::GetInstance()->CleanupMemory();
@@ -144,6 +162,58 @@ namespace CGE
 		instance.destroy();
 	}
 	
+	bool VulkanDevice::SavePipelineCache()
+	{
+		std::vector<uint8_t> data = device.getPipelineCacheData(pipelineCache);
+		if (data.empty())
+		{
+			return false;
+		}
+
+		// written aside and moved in place, a crash while saving leaves the old blob
+		std::string tempPath = PIPELINE_CACHE_PATH + ".tmp";
+		{
+			std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+			if (!stream)
+			{
+				return false;
+			}
+			stream.write(reinterpret_cast<const char*>(data.data()), data.size());
+			if (!stream)
+			{
+				stream.close();
+				std::remove(tempPath.c_str());
+				return false;
+			}
+		}
+
+		std::remove(PIPELINE_CACHE_PATH.c_str());
+		return std::rename(tempPath.c_str(), PIPELINE_CACHE_PATH.c_str()) == 0;
+	}
+
+	std::vector<uint8_t> VulkanDevice::LoadPipelineCacheData()
+	{
+		MappedFile file;
+		if (!file.Open(PIPELINE_CACHE_PATH) || (file.GetSize() < sizeof(VkPipelineCacheHeaderVersionOne)))
+		{
+			return {};
+		}
+
+		// drivers are supposed to reject foreign blobs themselves, not all of them do it gracefully
+		VkPipelineCacheHeaderVersionOne header;
+		std::memcpy(&header, file.GetData(), sizeof(header));
+		const PhysicalDeviceProperties& properties = physicalDevice.GetProperties();
+		if ((header.headerSize < sizeof(header)) || (header.headerSize > file.GetSize())
+			|| (header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+			|| (header.vendorID != properties.vendorID) || (header.deviceID != properties.deviceID)
+			|| (std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID.data(), VK_UUID_SIZE) != 0))
+		{
+			std::printf("pipeline cache %s is from another device or driver, starting empty\n", PIPELINE_CACHE_PATH.c_str());
+			return {};
+		}
+		return std::vector<uint8_t>(file.GetData(), file.GetData() + file.GetSize());
+	}
+
 	bool VulkanDevice::CheckValidationLayerSupport()
 	{
 		std::vector<LayerProperties> layerProps = VULKAN_HPP_NAMESPACE::enumerateInstanceLayerProperties();
@@ -21,6 +21,8 @@ namespace CGE
 	
 		void Create(const char* inAppName, const char* inEngine, bool inValidationEnabled, HWND inHwnd);
 		void Destroy();
+		// the pipeline cache is loaded in Create and saved in Destroy, this only saves it earlier
+		bool SavePipelineCache();
 	
 		Instance& GetInstance() { return instance; }
 		VulkanPhysicalDevice& GetPhysicalDevice() { return physicalDevice; }
@@ -36,6 +38,9 @@ namespace CGE
 		uint32_t GetComputeQueueIndex() { return queueFamilyIndices.computeFamily.value(); }
 		uint32_t GetPresentQueueIndex() { return queueFamilyIndices.presentFamily.value(); }
 		uint32_t GetTransferQueueIndex() { return queueFamilyIndices.transferFamily.value(); }
+		bool HasDedicatedTransferQueue() { return GetTransferQueueIndex() != GetGraphicsQueueIndex(); }
+		// count buffer draws with many commands and first instance set from the buffer, gpu driven draws need all three
+		bool SupportsDrawIndirectCount() { return drawIndirectCount; }
 	
 		operator Instance() { return instance; }
 		operator Device() { return device; }
@@ -70,7 +75,9 @@ namespace CGE
 		Queue transferQueue;
 	
 		PipelineCache pipelineCache;
+		bool drawIndirectCount = false;
 	
+		std::vector<uint8_t> LoadPipelineCacheData();
 		bool CheckValidationLayerSupport();
 		VulkanPhysicalDevice PickPhysicalDevice(std::vector<PhysicalDevice>& inDevices);
 		int ScoreDeviceSuitability(VulkanPhysicalDevice& inPhysicalDevice);
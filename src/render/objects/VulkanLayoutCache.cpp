@@ -0,0 +1,176 @@
+#include "VulkanLayoutCache.h"
+#include "VulkanDevice.h"
+#include <algorithm>
+
+namespace CGE
+{
+	namespace
+	{
+		static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+		static constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+		void AppendPushConstants(const std::vector<PushConstantRange>& inPushConstants, std::vector<uint64_t>& outKey)
+		{
+			for (const PushConstantRange& range : inPushConstants)
+			{
+				outKey.push_back(range.offset);
+				outKey.push_back(range.size);
+				outKey.push_back(static_cast<uint32_t>(range.stageFlags));
+			}
+		}
+	}
+
+	size_t VulkanLayoutCache::LayoutKeyHash::operator()(const LayoutKey& inKey) const
+	{
+		uint64_t hash = FNV_OFFSET_BASIS;
+		for (uint64_t value : inKey)
+		{
+			hash ^= value;
+			hash *= FNV_PRIME;
+		}
+		return static_cast<size_t>(hash);
+	}
+
+	VulkanLayoutCache::VulkanLayoutCache()
+		: vulkanDevice(nullptr)
+	{
+	}
+
+	VulkanLayoutCache::~VulkanLayoutCache()
+	{
+	}
+
+	void VulkanLayoutCache::Create(VulkanDevice* inVulkanDevice)
+	{
+		vulkanDevice = inVulkanDevice;
+	}
+
+	void VulkanLayoutCache::Destroy()
+	{
+		std::scoped_lock<std::mutex> lock(mutex);
+		for (auto& pair : pipelineLayouts)
+		{
+			vulkanDevice->GetDevice().destroyPipelineLayout(pair.second);
+		}
+		for (auto& pair : setLayouts)
+		{
+			vulkanDevice->GetDevice().destroyDescriptorSetLayout(pair.second);
+		}
+		pipelineLayouts.clear();
+		pipelineLayoutInfos.clear();
+		setLayouts.clear();
+		setLayoutBindings.clear();
+	}
+
+	DescriptorSetLayout VulkanLayoutCache::GetSetLayout(const std::vector<DescriptorSetLayoutBinding>& inBindings)
+	{
+		// bindings come from hash maps in no particular order, the key has them sorted by index
+		std::vector<DescriptorSetLayoutBinding> sorted = inBindings;
+		std::sort(sorted.begin(), sorted.end(), [](const DescriptorSetLayoutBinding& inLeft, const DescriptorSetLayoutBinding& inRight)
+			{
+				return inLeft.binding < inRight.binding;
+			});
+
+		LayoutKey key;
+		key.reserve(sorted.size() * 5);
+		for (const DescriptorSetLayoutBinding& binding : sorted)
+		{
+			key.push_back(binding.binding);
+			key.push_back(static_cast<uint64_t>(binding.descriptorType));
+			key.push_back(binding.descriptorCount);
+			key.push_back(static_cast<uint32_t>(binding.stageFlags));
+			// immutable samplers are part of the layout
+			key.push_back(binding.pImmutableSamplers ? reinterpret_cast<uint64_t>(static_cast<VkSampler>(*binding.pImmutableSamplers)) : 0);
+		}
+
+		std::scoped_lock<std::mutex> lock(mutex);
+		auto it = setLayouts.find(key);
+		if (it != setLayouts.end())
+		{
+			return it->second;
+		}
+
+		vk::StructureChain<vk::DescriptorSetLayoutCreateInfo, vk::DescriptorSetLayoutBindingFlagsCreateInfo> chain;
+		auto& flagsStruct = chain.get<vk::DescriptorSetLayoutBindingFlagsCreateInfo>();
+
+		// maybe use vk::DescriptorBindingFlagBits::eVariableDescriptorCount in the future
+		std::vector<vk::DescriptorBindingFlags> flags(sorted.size(), vk::DescriptorBindingFlagBits::ePartiallyBound);
+		flagsStruct.setBindingFlags(flags);
+
+		vk::DescriptorSetLayoutCreateInfo& layoutInfo = chain.get<vk::DescriptorSetLayoutCreateInfo>();
+		layoutInfo.setBindingCount(static_cast<uint32_t>(sorted.size()));
+		layoutInfo.setPBindings(sorted.data());
+		DescriptorSetLayout layout = vulkanDevice->GetDevice().createDescriptorSetLayout(layoutInfo);
+
+		setLayouts[key] = layout;
+		setLayoutBindings[static_cast<VkDescriptorSetLayout>(layout)] = sorted;
+		return layout;
+	}
+
+	std::vector<DescriptorSetLayoutBinding> VulkanLayoutCache::GetSetLayoutBindings(DescriptorSetLayout inLayout)
+	{
+		std::scoped_lock<std::mutex> lock(mutex);
+		auto it = setLayoutBindings.find(static_cast<VkDescriptorSetLayout>(inLayout));
+		return it != setLayoutBindings.end() ? it->second : std::vector<DescriptorSetLayoutBinding>();
+	}
+
+	PipelineLayout VulkanLayoutCache::GetPipelineLayout(const std::vector<DescriptorSetLayout>& inSetLayouts, const std::vector<PushConstantRange>& inPushConstants)
+	{
+		// set layouts are unique per bindings already, their handles are enough
+		LayoutKey key;
+		for (const DescriptorSetLayout& setLayout : inSetLayouts)
+		{
+			key.push_back(reinterpret_cast<uint64_t>(static_cast<VkDescriptorSetLayout>(setLayout)));
+		}
+		LayoutKey pushConstantsKey;
+		AppendPushConstants(inPushConstants, pushConstantsKey);
+		key.push_back(~0ull);
+		key.insert(key.end(), pushConstantsKey.begin(), pushConstantsKey.end());
+
+		std::scoped_lock<std::mutex> lock(mutex);
+		auto it = pipelineLayouts.find(key);
+		if (it != pipelineLayouts.end())
+		{
+			return it->second;
+		}
+
+		vk::PipelineLayoutCreateInfo pipelineLayoutInfo;
+		pipelineLayoutInfo.setFlags(vk::PipelineLayoutCreateFlags());
+		pipelineLayoutInfo.setSetLayouts(inSetLayouts);
+		pipelineLayoutInfo.setPushConstantRanges(inPushConstants);
+		PipelineLayout layout = vulkanDevice->GetDevice().createPipelineLayout(pipelineLayoutInfo);
+
+		pipelineLayouts[key] = layout;
+		pipelineLayoutInfos[static_cast<VkPipelineLayout>(layout)] = { inSetLayouts, pushConstantsKey };
+		return layout;
+	}
+
+	bool VulkanLayoutCache::IsCompatible(PipelineLayout inFirst, PipelineLayout inSecond, uint32_t inSetIndex)
+	{
+		if (!inFirst || !inSecond)
+		{
+			return false;
+		}
+		if (inFirst == inSecond)
+		{
+			return true;
+		}
+
+		std::scoped_lock<std::mutex> lock(mutex);
+		auto firstIt = pipelineLayoutInfos.find(static_cast<VkPipelineLayout>(inFirst));
+		auto secondIt = pipelineLayoutInfos.find(static_cast<VkPipelineLayout>(inSecond));
+		if ((firstIt == pipelineLayoutInfos.end()) || (secondIt == pipelineLayoutInfos.end()))
+		{
+			return false;
+		}
+
+		// same push constant ranges and the same set layouts up to the set, handles are unique per bindings
+		const PipelineLayoutInfo& first = firstIt->second;
+		const PipelineLayoutInfo& second = secondIt->second;
+		if ((first.pushConstantsKey != second.pushConstantsKey) || (first.setLayouts.size() <= inSetIndex) || (second.setLayouts.size() <= inSetIndex))
+		{
+			return false;
+		}
+		return std::equal(first.setLayouts.begin(), first.setLayouts.begin() + inSetIndex + 1, second.setLayouts.begin());
+	}
+}
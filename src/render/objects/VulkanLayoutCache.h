@@ -0,0 +1,59 @@
+#pragma once
+
+#include "vulkan/vulkan.hpp"
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+
+namespace CGE
+{
+	using VULKAN_HPP_NAMESPACE::DescriptorSetLayout;
+	using VULKAN_HPP_NAMESPACE::DescriptorSetLayoutBinding;
+	using VULKAN_HPP_NAMESPACE::PipelineLayout;
+	using VULKAN_HPP_NAMESPACE::PushConstantRange;
+
+	class VulkanDevice;
+
+	// Descriptor set layouts and pipeline layouts shared by everything with the same bindings. Set layouts
+	// are keyed by the bindings sorted by index, so materials built from the same shaders end up with the same
+	// handles and then with the same pipeline layouts. Layouts live until Destroy, users never destroy them.
+	class VulkanLayoutCache
+	{
+	public:
+		VulkanLayoutCache();
+		virtual ~VulkanLayoutCache();
+
+		void Create(VulkanDevice* inVulkanDevice);
+		void Destroy();
+
+		DescriptorSetLayout GetSetLayout(const std::vector<DescriptorSetLayoutBinding>& inBindings);
+		// bindings a layout of the cache was made of, empty for unknown ones
+		std::vector<DescriptorSetLayoutBinding> GetSetLayoutBindings(DescriptorSetLayout inLayout);
+		PipelineLayout GetPipelineLayout(const std::vector<DescriptorSetLayout>& inSetLayouts, const std::vector<PushConstantRange>& inPushConstants);
+		// sets bound with one layout stay valid with the other up to and including inSetIndex
+		bool IsCompatible(PipelineLayout inFirst, PipelineLayout inSecond, uint32_t inSetIndex);
+
+		uint32_t GetSetLayoutCount() const { return static_cast<uint32_t>(setLayouts.size()); }
+		uint32_t GetPipelineLayoutCount() const { return static_cast<uint32_t>(pipelineLayouts.size()); }
+	private:
+		typedef std::vector<uint64_t> LayoutKey;
+
+		struct LayoutKeyHash
+		{
+			size_t operator()(const LayoutKey& inKey) const;
+		};
+
+		struct PipelineLayoutInfo
+		{
+			std::vector<DescriptorSetLayout> setLayouts;
+			LayoutKey pushConstantsKey;
+		};
+
+		VulkanDevice* vulkanDevice;
+		std::mutex mutex;
+		std::unordered_map<LayoutKey, DescriptorSetLayout, LayoutKeyHash> setLayouts;
+		std::unordered_map<LayoutKey, PipelineLayout, LayoutKeyHash> pipelineLayouts;
+		std::unordered_map<VkPipelineLayout, PipelineLayoutInfo> pipelineLayoutInfos;
+		std::unordered_map<VkDescriptorSetLayout, std::vector<DescriptorSetLayoutBinding>> setLayoutBindings;
+	};
+}
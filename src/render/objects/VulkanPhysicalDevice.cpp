@@ -145,7 +145,11 @@ namespace CGE
 	
 		indices.graphicsFamily = (inFlags & QueueFlagBits::eGraphics) ? GetQueueFamilyIndex(QueueFlagBits::eGraphics) : std::nullopt;
 		indices.computeFamily = (inFlags & QueueFlagBits::eCompute) ? GetQueueFamilyIndex(QueueFlagBits::eCompute) : std::nullopt;
-		indices.transferFamily = (inFlags & QueueFlagBits::eTransfer) ? GetQueueFamilyIndex(QueueFlagBits::eTransfer) : std::nullopt;
+		indices.transferFamily = (inFlags & QueueFlagBits::eTransfer) ? GetDedicatedQueueFamilyIndex(QueueFlagBits::eTransfer, QueueFlagBits::eGraphics | QueueFlagBits::eCompute) : std::nullopt;
+		if ((inFlags & QueueFlagBits::eTransfer) && !indices.transferFamily.has_value())
+		{
+			indices.transferFamily = GetQueueFamilyIndex(QueueFlagBits::eTransfer);
+		}
 		indices.sparseBindingFamily = (inFlags & QueueFlagBits::eSparseBinding) ? GetQueueFamilyIndex(QueueFlagBits::eSparseBinding) : std::nullopt;
 		indices.protectedFamily = (inFlags & QueueFlagBits::eProtected) ? GetQueueFamilyIndex(QueueFlagBits::eProtected) : std::nullopt;
 	
@@ -183,6 +187,18 @@ namespace CGE
 		return SupportsQueueFamily(inFlag, inOrder + 1) ? std::optional<uint32_t>(queueFamilyIndices[inFlag][inOrder]) : std::nullopt;
 	}
 	
+	std::optional<uint32_t> VulkanPhysicalDevice::GetDedicatedQueueFamilyIndex(QueueFlagBits inFlag, QueueFlags inExcludedFlags)
+	{
+		for (uint32_t index : queueFamilyIndices[inFlag])
+		{
+			if (!SupportsQueueFamilyAny(index, inExcludedFlags))
+			{
+				return index;
+			}
+		}
+		return std::nullopt;
+	}
+	
 	bool VulkanPhysicalDevice::IsDeviceType(PhysicalDeviceType inType)
 	{
 		return properties.deviceType == inType;
@@ -84,6 +84,8 @@ namespace CGE
 		QueueFamilyIndices GetQueueFamiliesIndices(SurfaceKHR inSurface, bool inCacheResults = false);
 		const QueueFamilyIndices& GetCachedQueueFamiliesIndices() const;
 		std::optional<uint32_t> GetQueueFamilyIndex(QueueFlagBits inFlag, uint32_t inOrder = 0);
+		// family supporting the flag and none of the excluded ones, e.g. DMA only transfer queue
+		std::optional<uint32_t> GetDedicatedQueueFamilyIndex(QueueFlagBits inFlag, QueueFlags inExcludedFlags);
 	
 		bool IsDeviceType(PhysicalDeviceType inType);
 		PhysicalDeviceType GetDeviceType() const;
@@ -43,24 +43,15 @@ namespace CGE
 			vk::AccessFlagBits::eShaderRead,
 			vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil,
 			0, 1, 0, 1);
-		BufferMemoryBarrier clusterDataBarrier = computeData->clusterLightsData->GetBuffer().CreateMemoryBarrier(
-			0, 0,
-			vk::AccessFlagBits::eShaderRead,
-			vk::AccessFlagBits::eShaderWrite);
-		BufferMemoryBarrier gridDataBarrier = computeData->gridLightsData->GetBuffer().CreateMemoryBarrier(
-			0, 0,
-			vk::AccessFlagBits::eShaderRead,
-			vk::AccessFlagBits::eShaderWrite);
-
+		// readers of last frame's cluster and grid data are waited for by the graph barrier
 		std::vector<ImageMemoryBarrier> imagesBarriers{ depthTextureBarrier };
-		std::vector<BufferMemoryBarrier> buffersBarriers{ clusterDataBarrier, gridDataBarrier };
 
 		commandBuffer->pipelineBarrier(
 			vk::PipelineStageFlagBits::eAllGraphics,
 			vk::PipelineStageFlagBits::eComputeShader,
 			vk::DependencyFlags(),
 			0, nullptr,
-			static_cast<uint32_t>(buffersBarriers.size()), buffersBarriers.data(),
+			0, nullptr,
 			static_cast<uint32_t>(imagesBarriers.size()), imagesBarriers.data());
 
 		{
@@ -85,6 +76,15 @@ namespace CGE
 		}
 	}
 
+	void ClusterComputePass::DeclareResources(RenderGraphPassBuilder& builder, RenderPassDataTable& dataTable)
+	{
+		builder.Import("clusterLights", ERenderGraphResourceType::RGR_BUFFER);
+		builder.Import("gridLights", ERenderGraphResourceType::RGR_BUFFER);
+		builder.Read("depth", ERenderGraphUsage::RGU_SAMPLED, RGS_COMPUTE);
+		builder.Write("clusterLights", ERenderGraphUsage::RGU_STORAGE, RGS_COMPUTE);
+		builder.Write("gridLights", ERenderGraphUsage::RGU_STORAGE, RGS_COMPUTE);
+	}
+
 	void ClusterComputePass::InitPass(RenderPassDataTable& dataTable, PassInitContext& initContext)
 	{
 		m_lightsList = new LightsList();
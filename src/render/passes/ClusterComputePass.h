@@ -34,6 +34,7 @@ namespace CGE
 
 		void ExecutePass(vk::CommandBuffer* commandBuffer, PassExecuteContext& executeContext, RenderPassDataTable& dataTable) override;
 		void InitPass(RenderPassDataTable& dataTable, PassInitContext& initContext) override;
+		void DeclareResources(RenderGraphPassBuilder& builder, RenderPassDataTable& dataTable) override;
 
 		void HandleUpdate(const std::shared_ptr<GlobalPostSceneMessage> msg);
 		BufferDataPtr CreateLightsGrid();
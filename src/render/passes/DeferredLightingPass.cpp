@@ -24,14 +24,12 @@ namespace CGE
 	void DeferredLightingPass::ExecutePass(vk::CommandBuffer* commandBuffer, PassExecuteContext& executeContext, RenderPassDataTable& dataTable)
 	{
 		auto depthData = dataTable.GetPassData<DepthPrepassData>();
-		auto clusterData = dataTable.GetPassData<ClusterComputeData>();
 		auto gbufferData = dataTable.GetPassData<GBufferPassData>();
 		auto rtShadowsData = dataTable.GetPassData<RTShadowsData>();
 //		auto rtGIData = dataTable.GetPassData<RTGIPassData>();
 
 		uint32_t frameIndex = Engine::GetFrameIndex(m_lightingMaterials.size());
 		MaterialPtr lightingMat = m_lightingMaterials[frameIndex];
-		BufferDataPtr buffer = clusterData->clusterLightsData;
 		TextureDataPtr depthTex = lightingMat->GetSampledTexture("depthTex");
 
 		auto textures = lightingMat->GetSampledTextures("albedoTex", "normalsTex");
@@ -39,10 +37,7 @@ namespace CGE
 		RTShadowPass* rtPass = Engine::GetRendererInstance()->GetRTShadowPass();
 	
 		// barriers ----------------------------------------------
-		BufferMemoryBarrier clusterDataBarrier = buffer->GetBuffer().CreateMemoryBarrier(
-			0, 0, 
-			AccessFlagBits::eShaderWrite, 
-			AccessFlagBits::eShaderRead);
+		// cluster data is made visible by the graph barrier
 		ImageMemoryBarrier depthTextureBarrier = depthTex->GetImage().CreateLayoutBarrier(
 			ImageLayout::eUndefined,
 			ImageLayout::eShaderReadOnlyOptimal,
@@ -83,7 +78,7 @@ namespace CGE
 			PipelineStageFlagBits::eAllGraphics,
 			DependencyFlags(),
 			0, nullptr,
-			1, &clusterDataBarrier,
+			0, nullptr,
 			static_cast<uint32_t>(barriers.size()), barriers.data());
 	
 		MeshDataPtr meshData = MeshData::FullscreenQuad();
@@ -107,10 +102,24 @@ namespace CGE
 	
 		commandBuffer->bindVertexBuffers(0, 1, meshData->GetVertexBuffer()->GetNativeBufferPtr(), &offset);
 		commandBuffer->bindIndexBuffer(meshData->GetIndexBuffer()->GetNativeBuffer(), 0, IndexType::eUint32);
-		commandBuffer->drawIndexed(meshData->GetIndexCount(), 1, 0, 0, 0);
+		commandBuffer->drawIndexed(meshData->GetIndexCount(), 1, meshData->GetFirstIndex(), static_cast<int32_t>(meshData->GetBaseVertex()), 0);
 		commandBuffer->endRenderPass();
 	}
 
+	void DeferredLightingPass::DeclareResources(RenderGraphPassBuilder& builder, RenderPassDataTable& dataTable)
+	{
+		auto lightingData = dataTable.GetPassData<DeferredLightingData>();
+		DeclareTransientImage(builder, "directLighting", lightingData->hdrRenderTargets[0]);
+
+		builder.Read("depth", ERenderGraphUsage::RGU_SAMPLED, RGS_FRAGMENT);
+		builder.Read("gbufferAlbedo", ERenderGraphUsage::RGU_SAMPLED, RGS_FRAGMENT);
+		builder.Read("gbufferNormals", ERenderGraphUsage::RGU_SAMPLED, RGS_FRAGMENT);
+		builder.Read("shadowVisibility", ERenderGraphUsage::RGU_SAMPLED, RGS_FRAGMENT);
+		builder.Read("shadowVisibilityLayers", ERenderGraphUsage::RGU_SAMPLED, RGS_FRAGMENT);
+		builder.Read("clusterLights", ERenderGraphUsage::RGU_STORAGE, RGS_FRAGMENT);
+		builder.Write("directLighting", ERenderGraphUsage::RGU_COLOR_ATTACHMENT);
+	}
+
 	void DeferredLightingPass::InitPass(RenderPassDataTable& dataTable, PassInitContext& initContext)
 	{
 		auto depthData = dataTable.GetPassData<DepthPrepassData>();
@@ -20,5 +20,6 @@ namespace CGE
 
 		void ExecutePass(vk::CommandBuffer* commandBuffer, PassExecuteContext& executeContext, RenderPassDataTable& dataTable) override;
 		void InitPass(RenderPassDataTable& dataTable, PassInitContext& initContext) override;
+		void DeclareResources(RenderGraphPassBuilder& builder, RenderPassDataTable& dataTable) override;
 	};
 }
@@ -1,6 +1,7 @@
 #include "DepthPrepass.h"
 #include "core/Engine.h"
 #include "../Renderer.h"
+#include "DrawCullingPass.h"
 #include "../objects/VulkanDevice.h"
 #include "utils/ResourceUtils.h"
 
@@ -25,33 +26,83 @@ namespace CGE
 		commandBuffer->beginRenderPass(passBeginInfo, vk::SubpassContents::eInline);
 
 		//------------------------------------------------------------------------------------------------------------
+		// per frame set stays bound across pipelines with compatible layouts
+		vk::PipelineLayout frameSetLayout;
+		// pooled meshes share their buffers, only meshes outside the pool or of another vertex format rebind
+		vk::Buffer boundVertexBuffer;
+		vk::Buffer boundIndexBuffer;
+		VulkanLayoutCache& layoutCache = Engine::GetRendererInstance()->GetLayoutCache();
 		for (HashString& shaderHash : scene->GetShadersList())
 		{
 			PipelineData& pipelineData = executeContext.FindPipeline(scene->GetShaderToMaterial()[shaderHash][0]);
 
 			commandBuffer->bindPipeline(vk::PipelineBindPoint::eGraphics, pipelineData.pipeline);
-			commandBuffer->bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineData.pipelineLayout, 0, pipelineData.descriptorSets, {});
+			if (!layoutCache.IsCompatible(frameSetLayout, pipelineData.pipelineLayout, 0))
+			{
+				commandBuffer->bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineData.pipelineLayout, 0, 1, pipelineData.descriptorSets.data(), 0, nullptr);
+				frameSetLayout = pipelineData.pipelineLayout;
+			}
+
+			// meshes culled on the gpu go first as a single draw, the rest is recorded mesh by mesh below
+			bool bindlessBound = DrawCullingPass::DrawBatch(commandBuffer, pipelineData, dataTable, shaderHash, boundVertexBuffer, boundIndexBuffer);
 
+			// bindless materials of a shader share one set and differ only by the parameter block
 			for (MaterialPtr material : scene->GetShaderToMaterial()[shaderHash])
 			{
 				HashString materialId = material->GetResourceId();
 
-				commandBuffer->bindDescriptorSets(
-					vk::PipelineBindPoint::eGraphics,
-					pipelineData.pipelineLayout,
-					1,
-					material->GetDescriptorSets().size() - 1,
-					material->GetDescriptorSets().data() + 1,
-					0, nullptr);
+				if (material->IsBindless())
+				{
+					if (!bindlessBound)
+					{
+						commandBuffer->bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineData.pipelineLayout, BindlessTable::SET_INDEX, 1, pipelineData.descriptorSets.data() + BindlessTable::SET_INDEX, 0, nullptr);
+						bindlessBound = true;
+					}
+					uint32_t bindlessIndex = material->GetBindlessIndex();
+					commandBuffer->pushConstants(pipelineData.pipelineLayout, vk::ShaderStageFlagBits::eAll, sizeof(uint32_t), sizeof(uint32_t), &bindlessIndex);
+				}
+				else
+				{
+					commandBuffer->bindDescriptorSets(
+						vk::PipelineBindPoint::eGraphics,
+						pipelineData.pipelineLayout,
+						1,
+						material->GetDescriptorSets().size() - 1,
+						material->GetDescriptorSets().data() + 1,
+						0, nullptr);
+				}
 
 				for (MeshDataPtr meshData : scene->GetMaterialToMeshData()[material->GetResourceId()])
 				{
 					HashString meshId = meshData->GetResourceId();
 
 					commandBuffer->pushConstants(pipelineData.pipelineLayout, vk::ShaderStageFlagBits::eAll, 0, sizeof(uint32_t), &scene->GetMeshDataToIndex(materialId)[meshId]);
-					commandBuffer->bindVertexBuffers(0, 1, meshData->GetVertexBuffer()->GetNativeBufferPtr(), &offset);
-					commandBuffer->bindIndexBuffer(meshData->GetIndexBuffer()->GetNativeBuffer(), 0, vk::IndexType::eUint32);
-					commandBuffer->drawIndexed(meshData->GetIndexCount(), static_cast<uint32_t>(scene->GetMeshDataToTransform(materialId)[meshId].size()), 0, 0, 0);
+					vk::Buffer vertexBuffer = meshData->GetVertexBuffer()->GetNativeBuffer();
+					if (vertexBuffer != boundVertexBuffer)
+					{
+						commandBuffer->bindVertexBuffers(0, 1, &vertexBuffer, &offset);
+						boundVertexBuffer = vertexBuffer;
+					}
+					vk::Buffer indexBuffer = meshData->GetIndexBuffer()->GetNativeBuffer();
+					if (indexBuffer != boundIndexBuffer)
+					{
+						commandBuffer->bindIndexBuffer(indexBuffer, 0, vk::IndexType::eUint32);
+						boundIndexBuffer = indexBuffer;
+					}
+					uint32_t firstIndex = meshData->GetFirstIndex();
+					int32_t vertexOffset = static_cast<int32_t>(meshData->GetBaseVertex());
+					// meshlet ranges are per instance, first instance keeps gl_InstanceIndex pointing at the right transform
+					auto& drawRanges = scene->GetMeshDataToDrawRanges(materialId);
+					auto rangesIt = drawRanges.find(meshId);
+					if (rangesIt == drawRanges.end())
+					{
+						commandBuffer->drawIndexed(meshData->GetIndexCount(), static_cast<uint32_t>(scene->GetMeshDataToTransform(materialId)[meshId].size()), firstIndex, vertexOffset, 0);
+						continue;
+					}
+					for (const MeshDrawRange& range : rangesIt->second)
+					{
+						commandBuffer->drawIndexed(range.indexCount, 1, firstIndex + range.firstIndex, vertexOffset, range.instance);
+					}
 				}
 			}
 		}
@@ -59,6 +110,14 @@ namespace CGE
 		commandBuffer->endRenderPass();
 	}
 
+	void DepthPrepass::DeclareResources(RenderGraphPassBuilder& builder, RenderPassDataTable& dataTable)
+	{
+		builder.Import("depth", ERenderGraphResourceType::RGR_IMAGE);
+		builder.Read("drawCommands", ERenderGraphUsage::RGU_INDIRECT);
+		builder.Read("drawCounts", ERenderGraphUsage::RGU_INDIRECT);
+		builder.Write("depth", ERenderGraphUsage::RGU_DEPTH_ATTACHMENT);
+	}
+
 	void DepthPrepass::InitPass(RenderPassDataTable& dataTable, PassInitContext& initContext)
 	{
 		initContext.depthInfo.depthWriteEnable = VK_TRUE;
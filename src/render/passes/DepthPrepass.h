@@ -23,6 +23,7 @@ namespace CGE
 	protected:
 		void ExecutePass(vk::CommandBuffer* commandBuffer, PassExecuteContext& executeContext, RenderPassDataTable& dataTable) override;
 		void InitPass(RenderPassDataTable& dataTable, PassInitContext& initContext) override;
+		void DeclareResources(RenderGraphPassBuilder& builder, RenderPassDataTable& dataTable) override;
 	};
 
 	//----------------------------------------------------------------------
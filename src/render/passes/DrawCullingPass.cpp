@@ -0,0 +1,176 @@
+#include "DrawCullingPass.h"
+#include "scene/Scene.h"
+#include "core/Engine.h"
+#include "../Renderer.h"
+#include "../DataStructures.h"
+#include "../DrawCommandBuilder.h"
+#include "data/DataManager.h"
+#include "utils/ResourceUtils.h"
+#include <cstring>
+#include <cassert>
+
+namespace CGE
+{
+	namespace
+	{
+		// instance count and padding up to the instance alignment
+		static constexpr uint64_t INSTANCES_HEADER_SIZE = 16;
+		static constexpr uint32_t GROUP_SIZE = 64;
+		// set of the culling buffers, bindings in the order of DrawCulling.comp
+		static constexpr uint32_t BUFFERS_SET_INDEX = 1;
+		static constexpr uint32_t BUFFERS_COUNT = 4;
+	}
+
+	DrawCullingPass::DrawCullingPass(const HashString& name)
+		: RenderPassBase(name)
+	{
+	}
+
+	DrawCullingPass::~DrawCullingPass()
+	{
+	}
+
+	bool DrawCullingPass::DrawBatch(vk::CommandBuffer* commandBuffer, PipelineData& pipelineData, RenderPassDataTable& dataTable, const HashString& shaderHash,
+		vk::Buffer& ioBoundVertexBuffer, vk::Buffer& ioBoundIndexBuffer)
+	{
+		Scene* scene = Engine::GetSceneInstance();
+		auto cullingData = dataTable.GetPassData<DrawCullingData>();
+		auto batchIt = scene->GetShaderToDrawBatch().find(shaderHash);
+		if (!cullingData || (batchIt == scene->GetShaderToDrawBatch().end()) || (batchIt->second >= cullingData->batchCount))
+		{
+			return false;
+		}
+
+		uint32_t frameIndex = Engine::GetFrameIndex(cullingData->commands.size());
+		const GpuDrawBatch& batch = scene->GetDrawCommands().GetBatches()[batchIt->second];
+		GeometryPool& geometryPool = Engine::GetRendererInstance()->GetGeometryPool();
+
+		// materials come from the transform slots, the commands carry those as first instance
+		commandBuffer->bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineData.pipelineLayout, BindlessTable::SET_INDEX, 1, pipelineData.descriptorSets.data() + BindlessTable::SET_INDEX, 0, nullptr);
+		uint32_t transformIndexOffset = 0;
+		commandBuffer->pushConstants(pipelineData.pipelineLayout, vk::ShaderStageFlagBits::eAll, 0, sizeof(uint32_t), &transformIndexOffset);
+
+		vk::DeviceSize offset = 0;
+		vk::Buffer vertexBuffer = geometryPool.GetVertexBuffer()->GetNativeBuffer();
+		if (vertexBuffer != ioBoundVertexBuffer)
+		{
+			commandBuffer->bindVertexBuffers(0, 1, &vertexBuffer, &offset);
+			ioBoundVertexBuffer = vertexBuffer;
+		}
+		vk::Buffer indexBuffer = geometryPool.GetIndexBuffer()->GetNativeBuffer();
+		if (indexBuffer != ioBoundIndexBuffer)
+		{
+			commandBuffer->bindIndexBuffer(indexBuffer, 0, vk::IndexType::eUint32);
+			ioBoundIndexBuffer = indexBuffer;
+		}
+		commandBuffer->drawIndexedIndirectCount(
+			cullingData->commands[frameIndex]->GetNativeBuffer(),
+			batch.firstCommand * sizeof(DrawIndexedCommand),
+			cullingData->counts[frameIndex]->GetNativeBuffer(),
+			batchIt->second * sizeof(uint32_t),
+			batch.maxCommands,
+			sizeof(DrawIndexedCommand));
+		return true;
+	}
+
+	void DrawCullingPass::ExecutePass(vk::CommandBuffer* commandBuffer, PassExecuteContext& executeContext, RenderPassDataTable& dataTable)
+	{
+		Scene* scene = Engine::GetSceneInstance();
+		auto cullingData = dataTable.GetPassData<DrawCullingData>();
+		const DrawCommandBuilder& drawCommands = scene->GetDrawCommands();
+		const std::vector<GpuDrawBatch>& batches = drawCommands.GetBatches();
+
+		// the scene keeps instances past either capacity on the cpu path, nothing here is ever dropped
+		uint32_t batchCount = static_cast<uint32_t>(batches.size());
+		uint32_t instanceCount = drawCommands.GetCommandCount();
+		assert((batchCount <= MAX_BATCHES) && (instanceCount <= g_GpuDrawInstancesSize) && "Scene produced more draw instances than the culling buffers hold");
+		cullingData->batchCount = batchCount;
+		if (instanceCount == 0)
+		{
+			return;
+		}
+
+		uint32_t frameIndex = Engine::GetFrameIndex(m_instances.size());
+
+		// host visible and per frame index, the fence of this frame index was waited for
+		m_instanceData.resize(INSTANCES_HEADER_SIZE + instanceCount * sizeof(GpuDrawInstance));
+		std::memset(m_instanceData.data(), 0, INSTANCES_HEADER_SIZE);
+		std::memcpy(m_instanceData.data(), &instanceCount, sizeof(instanceCount));
+		std::memcpy(m_instanceData.data() + INSTANCES_HEADER_SIZE, drawCommands.GetInstances().data(), instanceCount * sizeof(GpuDrawInstance));
+		m_instances[frameIndex]->CopyTo(m_instanceData.size(), m_instanceData.data());
+		m_batches[frameIndex]->CopyTo(batchCount * sizeof(GpuDrawBatch), reinterpret_cast<const char*>(batches.data()));
+
+		// counts start from zero, the graph barrier waited for the last indirect reads of them
+		BufferDataPtr counts = cullingData->counts[frameIndex];
+		commandBuffer->fillBuffer(counts->GetNativeBuffer(), 0, batchCount * sizeof(uint32_t), 0);
+		BufferMemoryBarrier clearBarrier = counts->GetBuffer().CreateMemoryBarrier(
+			VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+			vk::AccessFlagBits::eTransferWrite,
+			vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+		// transforms were copied in by the transfer list, its barrier only covers the vertex stages
+		vk::MemoryBarrier transformsBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead);
+		commandBuffer->pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, vk::DependencyFlags(), 1, &transformsBarrier, 1, &clearBarrier, 0, nullptr);
+
+		// buffers of this frame index go in a frame set, it lives until the fence of the acquired image comes around again
+		Renderer* renderer = Engine::GetRendererInstance();
+		vk::DescriptorSet buffersSet = renderer->GetDescriptorPools().AllocateFrameSet(m_computeMaterial->GetDescriptorSetLayouts()[BUFFERS_SET_INDEX]);
+		vk::DescriptorBufferInfo bufferInfos[BUFFERS_COUNT] = {
+			vk::DescriptorBufferInfo(m_instances[frameIndex]->GetNativeBuffer(), 0, VK_WHOLE_SIZE),
+			vk::DescriptorBufferInfo(m_batches[frameIndex]->GetNativeBuffer(), 0, VK_WHOLE_SIZE),
+			vk::DescriptorBufferInfo(cullingData->commands[frameIndex]->GetNativeBuffer(), 0, VK_WHOLE_SIZE),
+			vk::DescriptorBufferInfo(counts->GetNativeBuffer(), 0, VK_WHOLE_SIZE)
+		};
+		vk::WriteDescriptorSet writes[BUFFERS_COUNT];
+		for (uint32_t idx = 0; idx < BUFFERS_COUNT; ++idx)
+		{
+			writes[idx].setDstSet(buffersSet);
+			writes[idx].setDstBinding(idx);
+			writes[idx].setDescriptorType(vk::DescriptorType::eStorageBuffer);
+			writes[idx].setDescriptorCount(1);
+			writes[idx].setPBufferInfo(&bufferInfos[idx]);
+		}
+		renderer->GetDevice().updateDescriptorSets(BUFFERS_COUNT, writes, 0, nullptr);
+
+		PipelineData& pipelineData = executeContext.FindPipeline(m_computeMaterial);
+		std::vector<vk::DescriptorSet> sets = pipelineData.descriptorSets;
+		sets[BUFFERS_SET_INDEX] = buffersSet;
+		commandBuffer->bindPipeline(vk::PipelineBindPoint::eCompute, pipelineData.pipeline);
+		commandBuffer->bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipelineData.pipelineLayout, 0, sets, {});
+		// the draw passes read the commands after the graph barrier in front of them
+		commandBuffer->dispatch((instanceCount + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+	}
+
+	void DrawCullingPass::DeclareResources(RenderGraphPassBuilder& builder, RenderPassDataTable& dataTable)
+	{
+		auto cullingData = dataTable.GetPassData<DrawCullingData>();
+		DeclareTransientBuffer(builder, "drawCommands", cullingData->commands[0]);
+		DeclareTransientBuffer(builder, "drawCounts", cullingData->counts[0]);
+		builder.Write("drawCommands", ERenderGraphUsage::RGU_STORAGE, RGS_COMPUTE);
+		builder.Write("drawCounts", ERenderGraphUsage::RGU_TRANSFER);
+		builder.Write("drawCounts", ERenderGraphUsage::RGU_STORAGE, RGS_COMPUTE);
+	}
+
+	void DrawCullingPass::InitPass(RenderPassDataTable& dataTable, PassInitContext& initContext)
+	{
+		initContext.compute = true;
+
+		auto cullingData = dataTable.CreatePassData<DrawCullingData>();
+		cullingData->commands = ResourceUtils::CreateBufferDataArray("drawCommands", 2, g_GpuDrawInstancesSize * sizeof(DrawIndexedCommand),
+			vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer, true);
+		cullingData->counts = ResourceUtils::CreateBufferDataArray("drawCounts", 2, MAX_BATCHES * sizeof(uint32_t),
+			vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst, true);
+		// written by the cpu every frame, no staging copy for them
+		m_instances = ResourceUtils::CreateBufferDataArray("drawInstances", 2, INSTANCES_HEADER_SIZE + g_GpuDrawInstancesSize * sizeof(GpuDrawInstance), vk::BufferUsageFlagBits::eStorageBuffer, false);
+		m_batches = ResourceUtils::CreateBufferDataArray("drawBatches", 2, MAX_BATCHES * sizeof(GpuDrawBatch), vk::BufferUsageFlagBits::eStorageBuffer, false);
+
+		// only gives the pipeline and the set layouts, the buffers set is a frame set written on every execute
+		m_computeMaterial = DataManager::RequestResourceType<Material>("DrawCullingMaterial");
+		m_computeMaterial->SetComputeShaderPath("content/shaders/DrawCulling.spv");
+		m_computeMaterial->SetStorageBufferExternal("drawInstances", m_instances[0]);
+		m_computeMaterial->SetStorageBufferExternal("drawBatches", m_batches[0]);
+		m_computeMaterial->SetStorageBufferExternal("drawCommands", cullingData->commands[0]);
+		m_computeMaterial->SetStorageBufferExternal("drawCounts", cullingData->counts[0]);
+		m_computeMaterial->LoadResources();
+	}
+
+}
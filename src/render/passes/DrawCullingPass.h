@@ -0,0 +1,49 @@
+#ifndef __DRAW_CULLING_PASS_H__
+#define __DRAW_CULLING_PASS_H__
+
+#include "RenderPassBase.h"
+#include "data/Material.h"
+#include "utils/Identifiable.h"
+#include "render/DataStructures.h"
+#include <vector>
+
+namespace CGE
+{
+
+	struct DrawCullingData : public Identifiable<DrawCullingData>
+	{
+		// per frame index, commands of a batch are a fixed range and its count is one word
+		std::vector<BufferDataPtr> commands;
+		std::vector<BufferDataPtr> counts;
+		// batches of the scene draw commands culled this frame
+		uint32_t batchCount = 0;
+	};
+
+	// Tests the scene draw instances against the frustum and their normal cones, one thread each, and compacts
+	// the visible ones into indirect draw commands with a count per batch. Draw passes then submit a single
+	// count draw per shader out of the geometry pool, whatever the number of meshes and materials.
+	class DrawCullingPass : public RenderPassBase
+	{
+	public:
+		static constexpr uint32_t MAX_BATCHES = g_GpuDrawBatchesSize;
+
+		DrawCullingPass(const HashString& name);
+		~DrawCullingPass();
+
+		// binds the geometry pool unless already bound and draws the batch of the shader, false when the shader has no culled batch
+		static bool DrawBatch(vk::CommandBuffer* commandBuffer, PipelineData& pipelineData, RenderPassDataTable& dataTable, const HashString& shaderHash,
+			vk::Buffer& ioBoundVertexBuffer, vk::Buffer& ioBoundIndexBuffer);
+	protected:
+		MaterialPtr m_computeMaterial;
+		std::vector<BufferDataPtr> m_instances;
+		std::vector<BufferDataPtr> m_batches;
+		std::vector<char> m_instanceData;
+
+		void ExecutePass(vk::CommandBuffer* commandBuffer, PassExecuteContext& executeContext, RenderPassDataTable& dataTable) override;
+		void InitPass(RenderPassDataTable& dataTable, PassInitContext& initContext) override;
+		void DeclareResources(RenderGraphPassBuilder& builder, RenderPassDataTable& dataTable) override;
+	};
+
+}
+
+#endif
@@ -3,6 +3,9 @@
 #include "data/MeshData.h"
 #include "scene/mesh/MeshComponent.h"
 #include "DepthPrepass.h"
+#include "core/Engine.h"
+#include "../Renderer.h"
+#include "DrawCullingPass.h"
 
 namespace CGE
 {
@@ -28,33 +31,83 @@ namespace CGE
 		commandBuffer->beginRenderPass(passBeginInfo, SubpassContents::eInline);
 			
 		//------------------------------------------------------------------------------------------------------------
+		// per frame set stays bound across pipelines with compatible layouts
+		vk::PipelineLayout frameSetLayout;
+		// pooled meshes share their buffers, only meshes outside the pool or of another vertex format rebind
+		vk::Buffer boundVertexBuffer;
+		vk::Buffer boundIndexBuffer;
+		VulkanLayoutCache& layoutCache = Engine::GetRendererInstance()->GetLayoutCache();
 		for (HashString& shaderHash : scene->GetShadersList())
 		{
 			PipelineData& pipelineData = executeContext.FindPipeline(scene->GetShaderToMaterial()[shaderHash][0]);
 			
 			commandBuffer->bindPipeline(PipelineBindPoint::eGraphics, pipelineData.pipeline);
-			commandBuffer->bindDescriptorSets(PipelineBindPoint::eGraphics, pipelineData.pipelineLayout, 0, pipelineData.descriptorSets, {});
+			if (!layoutCache.IsCompatible(frameSetLayout, pipelineData.pipelineLayout, 0))
+			{
+				commandBuffer->bindDescriptorSets(PipelineBindPoint::eGraphics, pipelineData.pipelineLayout, 0, 1, pipelineData.descriptorSets.data(), 0, nullptr);
+				frameSetLayout = pipelineData.pipelineLayout;
+			}
 			
+			// meshes culled on the gpu go first as a single draw, the rest is recorded mesh by mesh below
+			bool bindlessBound = DrawCullingPass::DrawBatch(commandBuffer, pipelineData, dataTable, shaderHash, boundVertexBuffer, boundIndexBuffer);
+
+			// bindless materials of a shader share one set and differ only by the parameter block
 			for (MaterialPtr material : scene->GetShaderToMaterial()[shaderHash])
 			{
 				HashString materialId = material->GetResourceId();
 			
-				commandBuffer->bindDescriptorSets(
-					PipelineBindPoint::eGraphics,
-					pipelineData.pipelineLayout,
-					1,
-					material->GetDescriptorSets().size()-1,
-					material->GetDescriptorSets().data()+1,
-					0, nullptr);
+				if (material->IsBindless())
+				{
+					if (!bindlessBound)
+					{
+						commandBuffer->bindDescriptorSets(PipelineBindPoint::eGraphics, pipelineData.pipelineLayout, BindlessTable::SET_INDEX, 1, pipelineData.descriptorSets.data() + BindlessTable::SET_INDEX, 0, nullptr);
+						bindlessBound = true;
+					}
+					uint32_t bindlessIndex = material->GetBindlessIndex();
+					commandBuffer->pushConstants(pipelineData.pipelineLayout, ShaderStageFlagBits::eAll, sizeof(uint32_t), sizeof(uint32_t), &bindlessIndex);
+				}
+				else
+				{
+					commandBuffer->bindDescriptorSets(
+						PipelineBindPoint::eGraphics,
+						pipelineData.pipelineLayout,
+						1,
+						material->GetDescriptorSets().size()-1,
+						material->GetDescriptorSets().data()+1,
+						0, nullptr);
+				}
 			
 				for (MeshDataPtr meshData : scene->GetMaterialToMeshData()[material->GetResourceId()])
 				{
 					HashString meshId = meshData->GetResourceId();
 			
 					commandBuffer->pushConstants(pipelineData.pipelineLayout, ShaderStageFlagBits::eAll, 0, sizeof(uint32_t), & scene->GetMeshDataToIndex(materialId)[meshId]);
-					commandBuffer->bindVertexBuffers(0, 1, meshData->GetVertexBuffer()->GetNativeBufferPtr(), &offset);
-					commandBuffer->bindIndexBuffer(meshData->GetIndexBuffer()->GetNativeBuffer(), 0, IndexType::eUint32);
-					commandBuffer->drawIndexed(meshData->GetIndexCount(), static_cast<uint32_t>(scene->GetMeshDataToTransform(materialId)[meshId].size()), 0, 0, 0);
+					vk::Buffer vertexBuffer = meshData->GetVertexBuffer()->GetNativeBuffer();
+					if (vertexBuffer != boundVertexBuffer)
+					{
+						commandBuffer->bindVertexBuffers(0, 1, &vertexBuffer, &offset);
+						boundVertexBuffer = vertexBuffer;
+					}
+					vk::Buffer indexBuffer = meshData->GetIndexBuffer()->GetNativeBuffer();
+					if (indexBuffer != boundIndexBuffer)
+					{
+						commandBuffer->bindIndexBuffer(indexBuffer, 0, IndexType::eUint32);
+						boundIndexBuffer = indexBuffer;
+					}
+					uint32_t firstIndex = meshData->GetFirstIndex();
+					int32_t vertexOffset = static_cast<int32_t>(meshData->GetBaseVertex());
+					// meshlet ranges are per instance, first instance keeps gl_InstanceIndex pointing at the right transform
+					auto& drawRanges = scene->GetMeshDataToDrawRanges(materialId);
+					auto rangesIt = drawRanges.find(meshId);
+					if (rangesIt == drawRanges.end())
+					{
+						commandBuffer->drawIndexed(meshData->GetIndexCount(), static_cast<uint32_t>(scene->GetMeshDataToTransform(materialId)[meshId].size()), firstIndex, vertexOffset, 0);
+						continue;
+					}
+					for (const MeshDrawRange& range : rangesIt->second)
+					{
+						commandBuffer->drawIndexed(range.indexCount, 1, firstIndex + range.firstIndex, vertexOffset, range.instance);
+					}
 				}
 			}		
 		}
@@ -62,6 +115,23 @@ namespace CGE
 		commandBuffer->endRenderPass();
 	}
 
+	void GBufferPass::DeclareResources(RenderGraphPassBuilder& builder, RenderPassDataTable& dataTable)
+	{
+		auto gbufferData = dataTable.GetPassData<GBufferPassData>();
+		DeclareTransientImage(builder, "gbufferAlbedo", gbufferData->albedos[0]);
+		DeclareTransientImage(builder, "gbufferVelocity", gbufferData->velocity[0]);
+		// last frame's normals are read for reprojection
+		builder.Import("gbufferNormals", ERenderGraphResourceType::RGR_IMAGE);
+
+		builder.Read("drawCommands", ERenderGraphUsage::RGU_INDIRECT);
+		builder.Read("drawCounts", ERenderGraphUsage::RGU_INDIRECT);
+		// depth equal test of the prepass depth, no writes
+		builder.Read("depth", ERenderGraphUsage::RGU_DEPTH_ATTACHMENT);
+		builder.Write("gbufferAlbedo", ERenderGraphUsage::RGU_COLOR_ATTACHMENT);
+		builder.Write("gbufferNormals", ERenderGraphUsage::RGU_COLOR_ATTACHMENT);
+		builder.Write("gbufferVelocity", ERenderGraphUsage::RGU_COLOR_ATTACHMENT);
+	}
+
 	void GBufferPass::InitPass(RenderPassDataTable& dataTable, PassInitContext& initContext)
 	{
 		// just init clear values
@@ -36,18 +36,14 @@ namespace CGE
 		imageBarriers.emplace_back(rtgiData->probeGridTexture->GetImage().CreateLayoutBarrierColor(vk::ImageLayout::eUndefined, vk::ImageLayout::eShaderReadOnlyOptimal, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead));
 		imageBarriers.emplace_back(rtgiData->probeGridDepthTexture->GetImage().CreateLayoutBarrierColor(ImageLayout::eUndefined, ImageLayout::eShaderReadOnlyOptimal, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead));
 		imageBarriers.emplace_back(depthData->depthTextures[rtIndex]->GetImage().CreateLayoutBarrierDepthStencil(ImageLayout::eUndefined, ImageLayout::eDepthAttachmentOptimal, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead));
-		// buffer barriers
-		vk::BufferMemoryBarrier probesBufferBarrier = rtgiData->probeGridBuffer->GetBuffer().CreateMemoryBarrier(
-			0, 0, 
-			vk::AccessFlagBits::eShaderWrite, 
-			vk::AccessFlagBits::eShaderRead);
+		// the probe grid buffer is made visible by the graph barrier
 
 		commandBuffer->pipelineBarrier(
 			vk::PipelineStageFlagBits::eAllCommands | vk::PipelineStageFlagBits::eRayTracingShaderKHR,
 			vk::PipelineStageFlagBits::eFragmentShader,
 			vk::DependencyFlags(),
-			0, nullptr, 
-			1, &probesBufferBarrier,
+			0, nullptr,
+			0, nullptr,
 			static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
 
 		//------------------------------------------------------------------------------------------------------------------------------------------------
@@ -74,10 +70,27 @@ namespace CGE
 
 		commandBuffer->bindVertexBuffers(0, 1, meshData->GetVertexBuffer()->GetNativeBufferPtr(), &offset);
 		commandBuffer->bindIndexBuffer(meshData->GetIndexBuffer()->GetNativeBuffer(), 0, vk::IndexType::eUint32);
-		commandBuffer->drawIndexed(meshData->GetIndexCount(), 1, 0, 0, 0);
+		commandBuffer->drawIndexed(meshData->GetIndexCount(), 1, meshData->GetFirstIndex(), static_cast<int32_t>(meshData->GetBaseVertex()), 0);
 		commandBuffer->endRenderPass();
 	}
 
+	void LightCompositingPass::DeclareResources(RenderGraphPassBuilder& builder, RenderPassDataTable& dataTable)
+	{
+		auto compositingData = dataTable.GetPassData<LightCompositingPassData>();
+		DeclareTransientImage(builder, "frameImage", compositingData->frameImages[0]);
+
+		builder.Read("depth", ERenderGraphUsage::RGU_SAMPLED, RGS_FRAGMENT);
+		builder.Read("gbufferAlbedo", ERenderGraphUsage::RGU_SAMPLED, RGS_FRAGMENT);
+		builder.Read("gbufferNormals", ERenderGraphUsage::RGU_SAMPLED, RGS_FRAGMENT);
+		builder.Read("directLighting", ERenderGraphUsage::RGU_SAMPLED, RGS_FRAGMENT);
+		builder.Read("screenProbes", ERenderGraphUsage::RGU_SAMPLED, RGS_FRAGMENT);
+		builder.Read("screenIrradiance", ERenderGraphUsage::RGU_SAMPLED, RGS_FRAGMENT);
+		builder.Read("probeGridTexture", ERenderGraphUsage::RGU_SAMPLED, RGS_FRAGMENT);
+		builder.Read("probeGridDepth", ERenderGraphUsage::RGU_SAMPLED, RGS_FRAGMENT);
+		builder.Read("probeGridBuffer", ERenderGraphUsage::RGU_STORAGE, RGS_FRAGMENT);
+		builder.Write("frameImage", ERenderGraphUsage::RGU_COLOR_ATTACHMENT);
+	}
+
 	void LightCompositingPass::InitPass(RenderPassDataTable& dataTable, PassInitContext& initContext)
 	{
 		auto compositingData = dataTable.CreatePassData<LightCompositingPassData>();
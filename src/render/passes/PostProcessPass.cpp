@@ -64,7 +64,7 @@ namespace CGE
 
 		commandBuffer->bindVertexBuffers(0, 1, meshData->GetVertexBuffer()->GetNativeBufferPtr(), &offset);
 		commandBuffer->bindIndexBuffer(meshData->GetIndexBuffer()->GetNativeBuffer(), 0, IndexType::eUint32);
-		commandBuffer->drawIndexed(meshData->GetIndexCount(), 1, 0, 0, 0);
+		commandBuffer->drawIndexed(meshData->GetIndexCount(), 1, meshData->GetFirstIndex(), static_cast<int32_t>(meshData->GetBaseVertex()), 0);
 		commandBuffer->endRenderPass();
 
 		ImageMemoryBarrier presentBarrier;
@@ -86,6 +86,13 @@ namespace CGE
 			1, &presentBarrier);
 	}
 
+	void PostProcessPass::DeclareResources(RenderGraphPassBuilder& builder, RenderPassDataTable& dataTable)
+	{
+		builder.Import("swapChain", ERenderGraphResourceType::RGR_IMAGE);
+		builder.Read("frameImage", ERenderGraphUsage::RGU_SAMPLED, RGS_FRAGMENT);
+		builder.Write("swapChain", ERenderGraphUsage::RGU_COLOR_ATTACHMENT);
+	}
+
 	void PostProcessPass::InitPass(RenderPassDataTable& dataTable, PassInitContext& initContext)
 	{
 		auto compositingData = dataTable.GetPassData<LightCompositingPassData>();
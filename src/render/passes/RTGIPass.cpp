@@ -53,7 +53,6 @@ namespace CGE
 		}
 
 		auto depthData = dataTable.GetPassData<DepthPrepassData>();
-		auto clusterComputeData = dataTable.GetPassData<ClusterComputeData>();
 		auto gbufferData = dataTable.GetPassData<GBufferPassData>();
 		auto rtShadowData = dataTable.GetPassData<RTShadowsData>();
 		auto directLightingData = dataTable.GetPassData<DeferredLightingData>();
@@ -62,16 +61,7 @@ namespace CGE
 		uint32_t prevDepthIndex = Engine::GetPreviousFrameIndex(depthData->depthTextures.size());
 
 		// barriers ----------------------------------------------
-		BufferMemoryBarrier clusterDataBarrier = clusterComputeData->clusterLightsData->GetBuffer().CreateMemoryBarrier(
-			0, 0,
-			vk::AccessFlagBits::eShaderWrite,
-			vk::AccessFlagBits::eShaderRead);
-		BufferMemoryBarrier gridDataBarrier = clusterComputeData->gridLightsData->GetBuffer().CreateMemoryBarrier(
-			0, 0,
-			vk::AccessFlagBits::eShaderWrite,
-			vk::AccessFlagBits::eShaderRead);
-		std::vector<BufferMemoryBarrier> buffersBarriers { clusterDataBarrier, gridDataBarrier };
-
+		// buffers and the memory of everything written before are covered by the graph barrier, only layouts are left
 		std::vector<ImageMemoryBarrier> imageBarriers;
 		ImageMemoryBarrier depthTextureBarrier = depthData->depthTextures[depthIndex]->GetImage().CreateLayoutBarrier(
 			ImageLayout::eUndefined,
@@ -131,12 +121,6 @@ namespace CGE
 
 		//---------------------------------------------------------------------------------------------------------------------------
 		// ddgi data
-		vk::BufferMemoryBarrier probesBufferBarrier = m_probeGridBuffer->GetBuffer().CreateMemoryBarrier(
-			0, 0,
-			vk::AccessFlagBits::eShaderRead,
-			vk::AccessFlagBits::eShaderWrite);
-		buffersBarriers.push_back(probesBufferBarrier);
-
 		vk::ImageMemoryBarrier probesImageBarrier = m_probeGridTexture->GetImage().CreateLayoutBarrier(
 			ImageLayout::eUndefined,
 			ImageLayout::eGeneral,
@@ -150,8 +134,8 @@ namespace CGE
 			vk::PipelineStageFlagBits::eAllCommands | vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eRayTracingShaderKHR,
 			vk::PipelineStageFlagBits::eRayTracingShaderKHR,
 			vk::DependencyFlags(),
-			1, &m_memBar,
-			static_cast<uint32_t>(buffersBarriers.size()), buffersBarriers.data(),
+			0, nullptr,
+			0, nullptr,
 			static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
 
 		auto nativeSets = frameData.resourceMapper.GetNativeDescriptorSets();
@@ -175,21 +159,39 @@ namespace CGE
 		commandBuffer->traceRaysKHR(rayGenRegion, rayMissRegion, rayHitRegion, { 0,0,0 }, executeContext.GetWidth() / 4, executeContext.GetHeight() / 4, 1);
 		// dispatch ddgi tracing
 		//commandBuffer->traceRaysKHR(rayGenDDGIRegion, rayMissRegion, rayHitRegion, { 0,0,0 }, 32, 16, 32);
+	}
 
-		commandBuffer->pipelineBarrier(
-			vk::PipelineStageFlagBits::eAllCommands | vk::PipelineStageFlagBits::eComputeShader,
-			vk::PipelineStageFlagBits::eRayTracingShaderKHR,
-			vk::DependencyFlags(),
-			1, &m_memBar,
-			0, nullptr,
-			0, nullptr);
+	void RTGIPass::DeclareResources(RenderGraphPassBuilder& builder, RenderPassDataTable& dataTable)
+	{
+		builder.Import("giDepth", ERenderGraphResourceType::RGR_IMAGE);
+		builder.Import("giTemporalCounter", ERenderGraphResourceType::RGR_IMAGE);
+		builder.Import("probeGridBuffer", ERenderGraphResourceType::RGR_BUFFER);
+		builder.Import("probeGridTexture", ERenderGraphResourceType::RGR_IMAGE);
+		builder.Import("probeGridDepth", ERenderGraphResourceType::RGR_IMAGE);
+
+		builder.Read("depth", ERenderGraphUsage::RGU_SAMPLED, RGS_RAY_TRACING);
+		builder.Read("gbufferAlbedo", ERenderGraphUsage::RGU_SAMPLED, RGS_RAY_TRACING);
+		builder.Read("gbufferNormals", ERenderGraphUsage::RGU_SAMPLED, RGS_RAY_TRACING);
+		builder.Read("gbufferVelocity", ERenderGraphUsage::RGU_SAMPLED, RGS_RAY_TRACING);
+		builder.Read("shadowVisibilityLayers", ERenderGraphUsage::RGU_SAMPLED, RGS_RAY_TRACING);
+		builder.Read("directLighting", ERenderGraphUsage::RGU_SAMPLED, RGS_RAY_TRACING);
+		builder.Read("giDepth", ERenderGraphUsage::RGU_SAMPLED, RGS_RAY_TRACING);
+		builder.Read("gridLights", ERenderGraphUsage::RGU_STORAGE, RGS_RAY_TRACING);
+		builder.ReadHistory("depth", ERenderGraphUsage::RGU_SAMPLED, RGS_RAY_TRACING);
+		builder.ReadHistory("gbufferNormals", ERenderGraphUsage::RGU_SAMPLED, RGS_RAY_TRACING);
+		builder.ReadHistory("giDepth", ERenderGraphUsage::RGU_SAMPLED, RGS_RAY_TRACING);
+		builder.ReadHistory("screenProbes", ERenderGraphUsage::RGU_SAMPLED, RGS_RAY_TRACING);
+		// traces on top of the probes the compute pass updated
+		builder.Write("screenProbes", ERenderGraphUsage::RGU_STORAGE, RGS_RAY_TRACING);
+		builder.Write("screenIrradiance", ERenderGraphUsage::RGU_STORAGE, RGS_RAY_TRACING);
+		builder.Write("giTemporalCounter", ERenderGraphUsage::RGU_STORAGE, RGS_RAY_TRACING);
+		builder.Write("probeGridBuffer", ERenderGraphUsage::RGU_STORAGE, RGS_RAY_TRACING);
+		builder.Write("probeGridTexture", ERenderGraphUsage::RGU_STORAGE, RGS_RAY_TRACING);
+		builder.Write("probeGridDepth", ERenderGraphUsage::RGU_STORAGE, RGS_RAY_TRACING);
 	}
 
 	void RTGIPass::InitPass(RenderPassDataTable& dataTable, PassInitContext& initContext)
 	{
-		m_memBar.setSrcAccessMask(vk::AccessFlagBits::eMemoryWrite | vk::AccessFlagBits::eMemoryRead);
-		m_memBar.setDstAccessMask(vk::AccessFlagBits::eMemoryWrite | vk::AccessFlagBits::eMemoryRead);
-
 		CreateProbeGridData();
 
 		m_rayGen = DataManager::GetInstance()->RequestResourceByType<RtShader>("content/shaders/RayGenGI.spv", ERtShaderType::RST_RAY_GEN);
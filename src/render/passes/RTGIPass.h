@@ -56,10 +56,9 @@ namespace CGE
 		RtShaderPtr m_closestHit;
 		RtMaterialPtr m_globalRTGIMaterial;
 
-		vk::MemoryBarrier m_memBar;
-
 		void ExecutePass(vk::CommandBuffer* commandBuffer, PassExecuteContext& executeContext, RenderPassDataTable& dataTable) override;
 		void InitPass(RenderPassDataTable& dataTable, PassInitContext& initContext) override;
+		void DeclareResources(RenderGraphPassBuilder& builder, RenderPassDataTable& dataTable) override;
 
 		void HandleUpdate(std::shared_ptr<GlobalPostSceneMessage> msg);
 
@@ -50,15 +50,11 @@ namespace CGE
 		}
 
 		auto depthData = dataTable.GetPassData<DepthPrepassData>();
-		auto clusterComputeData = dataTable.GetPassData<ClusterComputeData>();
 		auto gbufferData = dataTable.GetPassData<GBufferPassData>();
 		uint32_t depthIndex = Engine::GetFrameIndex(depthData->depthTextures.size());
 
 		// barriers ----------------------------------------------
-		BufferMemoryBarrier clusterDataBarrier = clusterComputeData->clusterLightsData->GetBuffer().CreateMemoryBarrier(
-			0, 0,
-			vk::AccessFlagBits::eShaderWrite,
-			vk::AccessFlagBits::eShaderRead);
+		// cluster data written by the compute pass is made visible by the graph barrier
 		ImageMemoryBarrier attachmentBarrier = m_visibilityTex->GetImage().CreateLayoutBarrier(
 			ImageLayout::eUndefined,
 			ImageLayout::eGeneral,
@@ -100,7 +96,7 @@ namespace CGE
 			vk::PipelineStageFlagBits::eRayTracingShaderKHR,
 			vk::DependencyFlags(),
 			0, nullptr,
-			1, &clusterDataBarrier,
+			0, nullptr,
 			static_cast<uint32_t>(barriers.size()), barriers.data());
 
 		commandBuffer->bindPipeline(vk::PipelineBindPoint::eRayTracingKHR, frameData.rtPipeline);
@@ -120,6 +116,19 @@ namespace CGE
 		commandBuffer->traceRaysKHR(rayGenRegion, rayMissRegion, rayHitRegion, { 0,0,0 }, executeContext.GetWidth() / 2, executeContext.GetHeight() / 2, 1);
 	}
 
+	void RTShadowPass::DeclareResources(RenderGraphPassBuilder& builder, RenderPassDataTable& dataTable)
+	{
+		DeclareTransientImage(builder, "shadowVisibility", m_visibilityTex);
+		DeclareTransientImage(builder, "shadowVisibilityLayers", m_visibilityTextures[0], static_cast<uint32_t>(m_visibilityTextures.size()));
+
+		builder.Read("depth", ERenderGraphUsage::RGU_SAMPLED, RGS_RAY_TRACING);
+		builder.Read("gbufferAlbedo", ERenderGraphUsage::RGU_SAMPLED, RGS_RAY_TRACING);
+		builder.Read("gbufferNormals", ERenderGraphUsage::RGU_SAMPLED, RGS_RAY_TRACING);
+		builder.Read("clusterLights", ERenderGraphUsage::RGU_STORAGE, RGS_RAY_TRACING);
+		builder.Write("shadowVisibility", ERenderGraphUsage::RGU_STORAGE, RGS_RAY_TRACING);
+		builder.Write("shadowVisibilityLayers", ERenderGraphUsage::RGU_STORAGE, RGS_RAY_TRACING);
+	}
+
 	void RTShadowPass::InitPass(RenderPassDataTable& dataTable, PassInitContext& initContext)
 	{
 		RtScene* rtScene = Singleton<RtScene>::GetInstance();
@@ -249,7 +258,7 @@ namespace CGE
 		pipelineInfo.setFlags({});
 		pipelineInfo.setLayout(frameData.rtPipelineLayout);
 
-		auto pipelineResult = nativeDevice.createRayTracingPipelineKHR(nullptr, nullptr, pipelineInfo);
+		auto pipelineResult = nativeDevice.createRayTracingPipelineKHR(nullptr, device->GetPipelineCache(), pipelineInfo);
 		if (pipelineResult.result != vk::Result::eSuccess)
 		{
 			return;
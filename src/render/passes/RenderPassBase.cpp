@@ -7,6 +7,38 @@
 
 namespace CGE
 {
+	namespace
+	{
+		vk::PipelineStageFlags ToPipelineStages(uint32_t stages)
+		{
+			vk::PipelineStageFlags flags;
+			flags |= (stages & RGS_DRAW_INDIRECT) ? vk::PipelineStageFlagBits::eDrawIndirect : vk::PipelineStageFlags();
+			flags |= (stages & RGS_VERTEX) ? vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eVertexShader : vk::PipelineStageFlags();
+			flags |= (stages & RGS_FRAGMENT) ? vk::PipelineStageFlagBits::eFragmentShader : vk::PipelineStageFlags();
+			flags |= (stages & RGS_DEPTH_TESTS) ? vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests : vk::PipelineStageFlags();
+			flags |= (stages & RGS_COLOR_OUTPUT) ? vk::PipelineStageFlagBits::eColorAttachmentOutput : vk::PipelineStageFlags();
+			flags |= (stages & RGS_COMPUTE) ? vk::PipelineStageFlagBits::eComputeShader : vk::PipelineStageFlags();
+			flags |= (stages & RGS_RAY_TRACING) ? vk::PipelineStageFlagBits::eRayTracingShaderKHR : vk::PipelineStageFlags();
+			flags |= (stages & RGS_TRANSFER) ? vk::PipelineStageFlagBits::eTransfer : vk::PipelineStageFlags();
+			return flags;
+		}
+
+		vk::AccessFlags ToAccessFlags(uint32_t access)
+		{
+			vk::AccessFlags flags;
+			flags |= (access & RGA_INDIRECT_READ) ? vk::AccessFlagBits::eIndirectCommandRead : vk::AccessFlags();
+			flags |= (access & RGA_VERTEX_READ) ? vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead : vk::AccessFlags();
+			flags |= (access & RGA_SHADER_READ) ? vk::AccessFlagBits::eShaderRead : vk::AccessFlags();
+			flags |= (access & RGA_SHADER_WRITE) ? vk::AccessFlagBits::eShaderWrite : vk::AccessFlags();
+			flags |= (access & RGA_COLOR_READ) ? vk::AccessFlagBits::eColorAttachmentRead : vk::AccessFlags();
+			flags |= (access & RGA_COLOR_WRITE) ? vk::AccessFlagBits::eColorAttachmentWrite : vk::AccessFlags();
+			flags |= (access & RGA_DEPTH_READ) ? vk::AccessFlagBits::eDepthStencilAttachmentRead : vk::AccessFlags();
+			flags |= (access & RGA_DEPTH_WRITE) ? vk::AccessFlagBits::eDepthStencilAttachmentWrite : vk::AccessFlags();
+			flags |= (access & RGA_TRANSFER_READ) ? vk::AccessFlagBits::eTransferRead : vk::AccessFlags();
+			flags |= (access & RGA_TRANSFER_WRITE) ? vk::AccessFlagBits::eTransferWrite : vk::AccessFlags();
+			return flags;
+		}
+	}
 
 	//-----------------------------------------------------------------------------------------------------------
 	//-----------------------------------------------------------------------------------------------------------
@@ -58,33 +90,60 @@ namespace CGE
 
 	//-----------------------------------------------------------------------------------------------------------
 
-	void RenderPassBase::Execute(vk::CommandBuffer* commandBuffer)
+	uint32_t RenderPassBase::AddToGraph(RenderGraph& graph)
+	{
+		uint32_t pass = graph.AddPass(m_name);
+		RenderGraphPassBuilder builder = graph.GetBuilder(pass);
+		DeclareResources(builder, *Singleton<RenderPassDataTable>::GetInstance());
+		return pass;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------
+
+	void RenderPassBase::Execute(vk::CommandBuffer* commandBuffer, const RenderGraphBarrierBatch* graphBarrier)
 	{
 		// barriers ----------------------------------------------
+		// attachments start undefined, with the graph barrier ordering them nothing has to be made available
+		vk::AccessFlags attachmentSrcAccess = graphBarrier ? vk::AccessFlags() : vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite;
+		vk::PipelineStageFlags attachmentStages;
 		std::vector<ImageMemoryBarrier> barriers;
 		if (!m_executeContext->m_depthAttachments.empty())
 		{
 			ImageMemoryBarrier depthTextureBarrier = m_executeContext->GetDepthAttachment()->GetImage().CreateLayoutBarrier(
 				vk::ImageLayout::eUndefined,
 				vk::ImageLayout::eDepthStencilAttachmentOptimal,
-				vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite,
+				attachmentSrcAccess,
 				vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite,
 				vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil,
 				0, 1, 0, 1);
 			barriers.emplace_back(depthTextureBarrier);
+			attachmentStages |= vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
 		}
 		for (const Texture2DPtr& texture : m_executeContext->GetFrameAttachments())
 		{
 			ImageMemoryBarrier textureBarrier = texture->GetImage().CreateLayoutBarrier(
 				vk::ImageLayout::eUndefined,
 				vk::ImageLayout::eColorAttachmentOptimal,
-				vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite,
+				attachmentSrcAccess,
 				vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite,
 				vk::ImageAspectFlagBits::eColor,
 				0, 1, 0, 1);
 			barriers.emplace_back(textureBarrier);
+			attachmentStages |= vk::PipelineStageFlagBits::eColorAttachmentOutput;
 		}
-		if (!barriers.empty())
+		if (graphBarrier && (!graphBarrier->IsEmpty() || !barriers.empty()))
+		{
+			vk::PipelineStageFlags srcStages = ToPipelineStages(graphBarrier->srcStages);
+			vk::MemoryBarrier memoryBarrier(ToAccessFlags(graphBarrier->srcAccess), ToAccessFlags(graphBarrier->dstAccess));
+			commandBuffer->pipelineBarrier(
+				srcStages ? srcStages : vk::PipelineStageFlags(vk::PipelineStageFlagBits::eTopOfPipe),
+				ToPipelineStages(graphBarrier->dstStages) | attachmentStages,
+				vk::DependencyFlags(),
+				graphBarrier->IsEmpty() ? 0 : 1, &memoryBarrier,
+				0, nullptr,
+				static_cast<uint32_t>(barriers.size()), barriers.data());
+		}
+		else if (!barriers.empty())
 		{
 			commandBuffer->pipelineBarrier(
 				vk::PipelineStageFlagBits::eAllCommands,
@@ -99,6 +158,22 @@ namespace CGE
 
 	//-----------------------------------------------------------------------------------------------------------
 
+	void RenderPassBase::DeclareTransientImage(RenderGraphPassBuilder& builder, const HashString& resource, TextureDataPtr image, uint32_t count)
+	{
+		vk::MemoryRequirements requirements = image->GetImage().GetMemoryRequirements();
+		builder.CreateTransient(resource, ERenderGraphResourceType::RGR_IMAGE, requirements.size * count, requirements.alignment);
+	}
+
+	//-----------------------------------------------------------------------------------------------------------
+
+	void RenderPassBase::DeclareTransientBuffer(RenderGraphPassBuilder& builder, const HashString& resource, BufferDataPtr buffer)
+	{
+		vk::MemoryRequirements requirements = buffer->GetBuffer().GetMemoryRequirements();
+		builder.CreateTransient(resource, ERenderGraphResourceType::RGR_BUFFER, requirements.size, requirements.alignment);
+	}
+
+	//-----------------------------------------------------------------------------------------------------------
+
 	vk::RenderPass RenderPassBase::CreateRenderPass(const PassInitContext& initContext)
 	{
 		std::vector<vk::AttachmentDescription> attachDescArray;
@@ -309,50 +384,62 @@ namespace CGE
 
 	vk::PipelineLayout RenderPassBase::CreatePipelineLayout(std::vector<DescriptorSetLayout>& descriptorSetLayouts)
 	{
-		vk::PipelineLayoutCreateInfo pipelineLayoutInfo;
-		pipelineLayoutInfo.setFlags(vk::PipelineLayoutCreateFlags());
-		pipelineLayoutInfo.setSetLayouts(descriptorSetLayouts);
-
 		vk::PushConstantRange pushConstRange;
 		pushConstRange.setOffset(0);
-		pushConstRange.setSize(sizeof(uint32_t));
+		// transform offset of the draw and bindless index of its material
+		pushConstRange.setSize(sizeof(uint32_t) * 2);
 		pushConstRange.setStageFlags(vk::ShaderStageFlagBits::eAll);
 
-		pipelineLayoutInfo.setPushConstantRangeCount(1);
-		pipelineLayoutInfo.setPPushConstantRanges(&pushConstRange);
+		// materials with the same bindings get the same layout, no matter the pass
+		return Engine::GetRendererInstance()->GetLayoutCache().GetPipelineLayout(descriptorSetLayouts, { pushConstRange });
+	}
 
-		return m_device->GetDevice().createPipelineLayout(pipelineLayoutInfo);
+	void RenderPassBase::CompilePipeline(MaterialPtr material)
+	{
+		CreateOrFindPipeline(*m_initContext, material);
 	}
 
 	PipelineData& RenderPassBase::CreateOrFindPipeline(const PassInitContext& initContext, MaterialPtr material)
 	{
-		Device& device = m_device->GetDevice();
-
 		PipelineRegistry& pipelineRegistry = *PipelineRegistry::GetInstance();
 		// check pipeline storage and create new pipeline in case it was not created before
-		if (!pipelineRegistry.HasPipeline(m_name, material->GetHash()))
+		PipelineData* foundData = pipelineRegistry.FindPipeline(m_name, material->GetHash());
+		if (foundData)
 		{
-			PipelineData pipelineData;
+			return *foundData;
+		}
 
-			PerFrameData* frameData = Engine::GetRendererInstance()->GetPerFrameData();
+		PipelineData pipelineData;
 
-			std::vector<vk::DescriptorSet> sets = material->GetDescriptorSets();
-			sets[0] = frameData->GetSet();
-			pipelineData.descriptorSets = sets;
+		PerFrameData* frameData = Engine::GetRendererInstance()->GetPerFrameData();
 
-			std::vector<vk::DescriptorSetLayout> layouts = material->GetDescriptorSetLayouts();
-			layouts[0] = frameData->GetLayout();
-			pipelineData.pipelineLayout = CreatePipelineLayout(layouts);
-			if (initContext.compute)
-			{
-				pipelineData.pipeline = CreateComputePipeline(initContext, material, pipelineData.pipelineLayout);
-			}
-			else
-			{
-				pipelineData.pipeline = CreateGraphicsPipeline(initContext, material, pipelineData.pipelineLayout);
-			}
+		std::vector<vk::DescriptorSet> sets = material->GetDescriptorSets();
+		sets[0] = frameData->GetSet();
+		pipelineData.descriptorSets = sets;
 
-			pipelineRegistry.StorePipeline(m_name, material->GetHash(), pipelineData);
+		std::vector<vk::DescriptorSetLayout> layouts = material->GetDescriptorSetLayouts();
+		layouts[0] = frameData->GetLayout();
+		// same as the per frame set, whatever the material made for the bindless set is replaced
+		if (material->IsBindless() && (layouts.size() > BindlessTable::SET_INDEX))
+		{
+			BindlessTable& bindlessTable = Engine::GetRendererInstance()->GetBindlessTable();
+			pipelineData.descriptorSets[BindlessTable::SET_INDEX] = bindlessTable.GetSet();
+			layouts[BindlessTable::SET_INDEX] = bindlessTable.GetLayout();
+		}
+		pipelineData.pipelineLayout = CreatePipelineLayout(layouts);
+		if (initContext.compute)
+		{
+			pipelineData.pipeline = CreateComputePipeline(initContext, material, pipelineData.pipelineLayout);
+		}
+		else
+		{
+			pipelineData.pipeline = CreateGraphicsPipeline(initContext, material, pipelineData.pipelineLayout);
+		}
+
+		// compile ahead jobs could race on the same material, the first one stored wins
+		if (!pipelineRegistry.StorePipeline(m_name, material->GetHash(), pipelineData))
+		{
+			m_device->GetDevice().destroyPipeline(pipelineData.pipeline);
 		}
 
 		return pipelineRegistry.GetPipeline(m_name, material->GetHash());
@@ -11,6 +11,7 @@
 #include "data/Texture2D.h"
 #include "data/Material.h"
 #include "../PipelineRegistry.h"
+#include "../RenderGraph.h"
 
 namespace CGE
 {
@@ -30,10 +31,21 @@ namespace CGE
 		~RenderPassBase();
 
 		void Init();
-		void Execute(vk::CommandBuffer* commandBuffer);
+		// adds the pass and what it reads and writes to the graph, after Init. Returns the pass index in the graph
+		uint32_t AddToGraph(RenderGraph& graph);
+		// the graph barrier goes together with the attachment transitions as one pipeline barrier,
+		// without it the pass waits for everything before it
+		void Execute(vk::CommandBuffer* commandBuffer, const RenderGraphBarrierBatch* graphBarrier = nullptr);
+		// creates the pipeline of the material ahead of the first draw, thread safe once the pass is initialized
+		void CompilePipeline(MaterialPtr material);
 	protected:
 		virtual void InitPass(RenderPassDataTable& dataTable, PassInitContext& initContext) = 0;
 		virtual void ExecutePass(vk::CommandBuffer* commandBuffer, PassExecuteContext& executeContext, RenderPassDataTable& dataTable) = 0;
+		virtual void DeclareResources(RenderGraphPassBuilder& builder, RenderPassDataTable& dataTable) {}
+
+		// transient of round robin images is one copy, sized by the memory the image needs times the count
+		static void DeclareTransientImage(RenderGraphPassBuilder& builder, const HashString& resource, TextureDataPtr image, uint32_t count = 1);
+		static void DeclareTransientBuffer(RenderGraphPassBuilder& builder, const HashString& resource, BufferDataPtr buffer);
 	private:
 		friend class PassInitContext;
 		friend class PassExecuteContext;
@@ -64,6 +64,22 @@ namespace CGE
 		}
 	}
 
+	void UpdateGIProbesPass::DeclareResources(RenderGraphPassBuilder& builder, RenderPassDataTable& dataTable)
+	{
+		builder.Import("screenProbes", ERenderGraphResourceType::RGR_IMAGE);
+		builder.Import("screenIrradiance", ERenderGraphResourceType::RGR_IMAGE);
+
+		builder.Read("depth", ERenderGraphUsage::RGU_SAMPLED, RGS_COMPUTE);
+		builder.Read("gbufferNormals", ERenderGraphUsage::RGU_SAMPLED, RGS_COMPUTE);
+		builder.Read("gbufferVelocity", ERenderGraphUsage::RGU_SAMPLED, RGS_COMPUTE);
+		builder.ReadHistory("depth", ERenderGraphUsage::RGU_SAMPLED, RGS_COMPUTE);
+		builder.ReadHistory("gbufferNormals", ERenderGraphUsage::RGU_SAMPLED, RGS_COMPUTE);
+		builder.ReadHistory("screenProbes", ERenderGraphUsage::RGU_SAMPLED, RGS_COMPUTE);
+		builder.ReadHistory("screenIrradiance", ERenderGraphUsage::RGU_SAMPLED, RGS_COMPUTE);
+		builder.Write("screenProbes", ERenderGraphUsage::RGU_STORAGE, RGS_COMPUTE);
+		builder.Write("screenIrradiance", ERenderGraphUsage::RGU_STORAGE, RGS_COMPUTE);
+	}
+
 	void UpdateGIProbesPass::InitPass(RenderPassDataTable& dataTable, PassInitContext& initContext)
 	{
 		auto depthData = dataTable.GetPassData<DepthPrepassData>();
@@ -42,6 +42,16 @@ namespace CGE
 		m_memRecord.pos.memory.MapCopyUnmap(MemoryMapFlags(), m_memRecord.pos.offset, inSize, inData, 0, inSize);
 	}
 	
+	char* VulkanBuffer::Map(DeviceSize inOffset, DeviceSize inSize)
+	{
+		return reinterpret_cast<char*>(m_memRecord.pos.memory.MapMemory(MemoryMapFlags(), m_memRecord.pos.offset + inOffset, inSize));
+	}
+
+	void VulkanBuffer::Unmap()
+	{
+		m_memRecord.pos.memory.UnmapMemory();
+	}
+	
 	void VulkanBuffer::Destroy()
 	{
 		if (!m_cleanup)
@@ -31,6 +31,9 @@ namespace CGE
 		void Destroy();
 	
 		void CopyTo(DeviceSize inSize, const char* inData, bool pushToTransfer = true);
+		// host visible buffers only, memory of the chunk can't be mapped twice so unmap before mapping anything else
+		char* Map(DeviceSize inOffset, DeviceSize inSize);
+		void Unmap();
 	
 		BufferCopy CreateBufferCopy();
 		BufferMemoryBarrier CreateMemoryBarrier(uint32_t inSrcQueue, uint32_t inDstQueue, AccessFlags inSrcAccessMask, AccessFlags inDstAccessMask);
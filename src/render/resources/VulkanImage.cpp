@@ -1,6 +1,7 @@
 #include "VulkanImage.h"
 #include "core/Engine.h"
 #include "../Renderer.h"
+#include <algorithm>
 
 namespace CGE
 {
@@ -135,6 +136,25 @@ namespace CGE
 	
 		return imageCopy;
 	}
+
+	BufferImageCopy VulkanImage::CreateBufferImageCopy(DeviceSize inBufferOffset, uint32_t inFirstRow, uint32_t inRowsCount)
+	{
+		BufferImageCopy imageCopy = CreateBufferImageCopy();
+		imageCopy.setBufferOffset(inBufferOffset);
+		imageCopy.setImageExtent(Extent3D(m_width, inRowsCount, 1));
+		imageCopy.setImageOffset(Offset3D(0, inFirstRow, 0));
+
+		return imageCopy;
+	}
+
+	BufferImageCopy VulkanImage::CreateBufferImageCopy(DeviceSize inBufferOffset, uint32_t inMip, uint32_t inFirstRow, uint32_t inRowsCount)
+	{
+		BufferImageCopy imageCopy = CreateBufferImageCopy(inBufferOffset, inFirstRow, inRowsCount);
+		imageCopy.setImageExtent(Extent3D(std::max(m_width >> inMip, 1u), inRowsCount, 1));
+		imageCopy.imageSubresource.setMipLevel(inMip);
+
+		return imageCopy;
+	}
 	
 	ImageMemoryBarrier VulkanImage::CreateBarrier(
 		ImageLayout inOldLayout, 
@@ -45,6 +45,10 @@ namespace CGE
 		inline uint32_t GetMips() { return m_mips; }
 
 		BufferImageCopy CreateBufferImageCopy();
+		// copy of rows range of the mip 0, buffer is expected to be tightly packed
+		BufferImageCopy CreateBufferImageCopy(DeviceSize inBufferOffset, uint32_t inFirstRow, uint32_t inRowsCount);
+		// same for any mip, rows are texel rows and have to start at a block boundary for compressed formats
+		BufferImageCopy CreateBufferImageCopy(DeviceSize inBufferOffset, uint32_t inMip, uint32_t inFirstRow, uint32_t inRowsCount);
 	
 		ImageMemoryBarrier CreateBarrier(
 			ImageLayout inOldLayout,
@@ -1,14 +1,28 @@
 #include "render/shader/Shader.h"
 #include <fstream>
 #include <streambuf>
+#include <cstring>
 #include "core/Engine.h"
 #include "render/ShaderRegistry.h"
 #include "render/Renderer.h"
+#include "render/shader/ShaderReflectionCache.h"
+#include "utils/Singleton.h"
 
 namespace CGE
 {
 	namespace vk = VULKAN_HPP_NAMESPACE;
 
+	namespace
+	{
+		static constexpr uint32_t SPIRV_HEADER_WORDS = 5;
+		static constexpr uint32_t OP_NAME = 5;
+		static constexpr uint32_t OP_SPEC_CONSTANT_TRUE = 48;
+		static constexpr uint32_t OP_SPEC_CONSTANT_FALSE = 49;
+		static constexpr uint32_t OP_SPEC_CONSTANT = 50;
+		static constexpr uint32_t OP_DECORATE = 71;
+		static constexpr uint32_t DECORATION_SPEC_ID = 1;
+	}
+
 	Shader::Shader(const HashString& inPath)
 		: Resource(inPath)
 	{
@@ -28,27 +42,53 @@ namespace CGE
 			return true;
 		}
 	
-		std::ifstream file(m_filePath, std::ios::binary);
-		if (!file.is_open()) {
+		if (!ReadCode(m_filePath, m_binary)) {
 			throw std::runtime_error("failed to open file!");
 		}
-		m_binary.clear();
-	
-		file.seekg(0, std::ios::end);
-		size_t size = file.tellg();
-		m_binary.resize(size);
-		file.seekg(0, std::ios::beg);
-	
-		file.read(m_binary.data(), size);
-		file.close();
 	
 		ExtractBindingsInfo();
+		ExtractSpecializationConstants();
 		CreateShaderModule();
 
 		Engine::Get()->GetShaderRegistry()->AddShader(get_shared_from_this<Shader>());
 		return true;
 	}
 	
+	bool Shader::ReadCode(const std::string& inPath, std::vector<char>& outCode)
+	{
+		std::ifstream file(inPath, std::ios::binary);
+		if (!file.is_open()) {
+			return false;
+		}
+		outCode.clear();
+	
+		file.seekg(0, std::ios::end);
+		size_t size = file.tellg();
+		outCode.resize(size);
+		file.seekg(0, std::ios::beg);
+	
+		file.read(outCode.data(), size);
+		// spir-v is made of words
+		return file.good() && (size > 0) && (size % sizeof(uint32_t) == 0);
+	}
+
+	void Shader::Reload(std::vector<char>&& inCode)
+	{
+		DestroyShaderModule();
+		m_binary = std::move(inCode);
+		m_bindings.clear();
+		m_bindingsTypes.clear();
+		m_bindingsNames.clear();
+		m_specializationConstants.clear();
+
+		ExtractBindingsInfo();
+		ExtractSpecializationConstants();
+		CreateShaderModule();
+		m_reloadCount++;
+		// sbt and anything else built from the snapshot of this type has to see the new code
+		ChangedHint();
+	}
+
 	bool Shader::Destroy()
 	{
 		DestroyShaderModule();
@@ -119,53 +159,65 @@ namespace CGE
 		m_shaderModule = Engine::GetRendererInstance()->GetVulkanDevice().GetDevice().createShaderModule(createInfo);
 	}
 	
-	void Shader::ExtractBindingInfo(
-		SPIRV_CROSS_NAMESPACE::SmallVector<SPIRV_CROSS_NAMESPACE::Resource>& inResources, 
-		SPIRV_CROSS_NAMESPACE::Compiler& inCompiler, 
-		DescriptorType inDescriptorType)
-	{	
-		for (SPIRV_CROSS_NAMESPACE::Resource& resource : inResources)
+	void Shader::ExtractBindingsInfo()
+	{
+		ShaderBindingsPtr bindings = Singleton<ShaderReflectionCache>::GetInstance()->GetBindings(m_filePath, m_binary);
+		for (const BindingInfo& info : *bindings)
 		{
-			BindingInfo info;
-	
-			info.set = inCompiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
-			info.binding = inCompiler.get_decoration(resource.id, spv::DecorationBinding);
-			info.name = inCompiler.get_name(resource.id);
-			info.blockName = resource.name;
-			info.descriptorType = inDescriptorType;
-	
-			SPIRV_CROSS_NAMESPACE::SPIRType type = inCompiler.get_type(resource.type_id);
-	
-			info.vectorSize = type.vecsize;
-			info.numColumns = type.columns;
-	
-			info.arrayDimensions.resize(type.array.size());
-			for (uint64_t index = 0; index < type.array.size(); index++)
-			{
-				info.arrayDimensions[index] = type.array[index];
-			}
-			printf("Resource %s with block name %s at set = %u, binding = %u\n", info.name.GetString().c_str(), info.blockName.GetString().c_str(), info.set, info.binding);
-	
 			// populate internal structures
 			m_bindings.push_back(info);
-			m_bindingsTypes[inDescriptorType].push_back(info);
+			m_bindingsTypes[info.descriptorType].push_back(info);
 			m_bindingsNames[info.name] = info;
 		}
 	}
-	
-	void Shader::ExtractBindingsInfo()
+
+	void Shader::ExtractSpecializationConstants()
 	{
-		SPIRV_CROSS_NAMESPACE::Compiler spirv(reinterpret_cast<const uint32_t*>(m_binary.data()), m_binary.size() / sizeof(uint32_t));
-		SPIRV_CROSS_NAMESPACE::ShaderResources resources = spirv.get_shader_resources();
-	
-		ExtractBindingInfo(resources.uniform_buffers, spirv, DescriptorType::eUniformBuffer);
-		ExtractBindingInfo(resources.storage_buffers, spirv, DescriptorType::eStorageBuffer);
-		ExtractBindingInfo(resources.separate_samplers, spirv, DescriptorType::eSampler);
-		ExtractBindingInfo(resources.separate_images, spirv, DescriptorType::eSampledImage);
-		ExtractBindingInfo(resources.storage_images, spirv, DescriptorType::eStorageImage);
-		ExtractBindingInfo(resources.acceleration_structures, spirv, DescriptorType::eAccelerationStructureKHR);
-		// rejected sibling
-		ExtractBindingInfo(resources.sampled_images, spirv, DescriptorType::eCombinedImageSampler);
+		const uint32_t* words = reinterpret_cast<const uint32_t*>(m_binary.data());
+		size_t wordCount = m_binary.size() / sizeof(uint32_t);
+
+		std::unordered_map<uint32_t, std::string> names;
+		std::unordered_map<uint32_t, uint32_t> specIds;
+		std::unordered_map<uint32_t, uint32_t> sizes;
+		for (size_t index = SPIRV_HEADER_WORDS; index < wordCount; )
+		{
+			uint32_t opcode = words[index] & 0xffff;
+			uint32_t length = words[index] >> 16;
+			if ((length == 0) || (index + length > wordCount))
+			{
+				break;
+			}
+
+			if ((opcode == OP_NAME) && (length > 2))
+			{
+				// nul terminated literal, padded to words
+				const char* name = reinterpret_cast<const char*>(words + index + 2);
+				names[words[index + 1]] = std::string(name, strnlen(name, (length - 2) * sizeof(uint32_t)));
+			}
+			else if ((opcode == OP_DECORATE) && (length > 3) && (words[index + 2] == DECORATION_SPEC_ID))
+			{
+				specIds[words[index + 1]] = words[index + 3];
+			}
+			else if ((opcode == OP_SPEC_CONSTANT_TRUE) || (opcode == OP_SPEC_CONSTANT_FALSE))
+			{
+				sizes[words[index + 2]] = sizeof(VkBool32);
+			}
+			else if ((opcode == OP_SPEC_CONSTANT) && (length > 3))
+			{
+				sizes[words[index + 2]] = (length - 3) * sizeof(uint32_t);
+			}
+			index += length;
+		}
+
+		for (auto& pair : specIds)
+		{
+			auto nameIt = names.find(pair.first);
+			auto sizeIt = sizes.find(pair.first);
+			if ((nameIt != names.end()) && !nameIt->second.empty() && (sizeIt != sizes.end()))
+			{
+				m_specializationConstants[nameIt->second] = { pair.second, sizeIt->second };
+			}
+		}
 	}
-	
+
 }
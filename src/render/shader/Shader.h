@@ -56,6 +56,14 @@ namespace CGE
 		}
 	};
 	
+	// specialization constant declared by the shader, features of a material find it by name
+	struct SpecializationConstantInfo
+	{
+		uint32_t constantId;
+		// bytes of the default value, bools are VkBool32
+		uint32_t size;
+	};
+
 	class Shader : public Resource
 	{
 	public:
@@ -64,6 +72,12 @@ namespace CGE
 	
 		virtual bool Create() override;
 		virtual bool Destroy() override;
+		// spir-v binary of a file, safe to call from any thread
+		static bool ReadCode(const std::string& inPath, std::vector<char>& outCode);
+		// replaces code, bindings and module in place, nothing may use the old module anymore
+		void Reload(std::vector<char>&& inCode);
+		// bumped by every reload, users holding bindings compare it to know they're stale
+		uint32_t GetReloadCount() const { return m_reloadCount; }
 	
 		ShaderModule GetShaderModule();
 		void DestroyShaderModule();
@@ -76,21 +90,23 @@ namespace CGE
 		BindingInfo& GetBinding(HashString name);
 		std::unordered_map<HashString, BindingInfo>& GetBindingsNames() { return m_bindingsNames; }
 		std::unordered_map<DescriptorType, std::vector<BindingInfo>>& GetBindingsTypes() { return m_bindingsTypes; }
+		const std::unordered_map<std::string, SpecializationConstantInfo>& GetSpecializationConstants() const { return m_specializationConstants; }
 	protected:
 		std::string m_filePath;
 		std::vector<char> m_binary;
 		std::vector<BindingInfo> m_bindings;
 		std::unordered_map<DescriptorType, std::vector<BindingInfo>> m_bindingsTypes;
 		std::unordered_map<HashString, BindingInfo> m_bindingsNames;
+		std::unordered_map<std::string, SpecializationConstantInfo> m_specializationConstants;
 	
 		ShaderModule m_shaderModule;
+		uint32_t m_reloadCount = 0;
 	
 		void CreateShaderModule();
-		void ExtractBindingInfo(
-			SPIRV_CROSS_NAMESPACE::SmallVector<SPIRV_CROSS_NAMESPACE::Resource>& inResources, 
-			SPIRV_CROSS_NAMESPACE::Compiler& inCompiler,
-			DescriptorType inDescriptorType);
+		// reflection goes through ShaderReflectionCache, a blob seen before doesn't touch SPIRV-Cross
 		void ExtractBindingsInfo();
+		// a single pass over the instructions for names and SpecId decorations, no need for SPIRV-Cross
+		void ExtractSpecializationConstants();
 	};
 	
 	typedef std::shared_ptr<Shader> ShaderPtr;
@@ -230,6 +230,30 @@ namespace CGE
 		}
 	}
 
+	uint32_t ShaderBindingTable::GetStageIndex(RtShaderPtr shader, const ShaderFeatures& features)
+	{
+		ShaderSpecializationPtr specialization = Singleton<ShaderPermutationCache>::GetInstance()->GetSpecialization(shader.get(), features);
+		if (!specialization)
+		{
+			return m_shaderStagesIndices[shader->GetResourceId()];
+		}
+
+		// materials with the same features share the specialized stage
+		HashString stageKey = shader->GetResourceId().GetString() + "#" + std::to_string(features.GetHash());
+		auto it = m_shaderStagesIndices.find(stageKey);
+		if (it != m_shaderStagesIndices.end())
+		{
+			return it->second;
+		}
+
+		vk::PipelineShaderStageCreateInfo stageInfo = m_stages[m_shaderStagesIndices[shader->GetResourceId()]];
+		stageInfo.setPSpecializationInfo(&specialization->info);
+		uint32_t index = static_cast<uint32_t>(m_stages.size());
+		m_stages.push_back(stageInfo);
+		m_shaderStagesIndices[stageKey] = index;
+		return index;
+	}
+
 	void ShaderBindingTable::FillGeneralShaderGroups(const std::vector<RtShaderPtr>& shaders, std::vector<vk::RayTracingShaderGroupCreateInfoKHR>& groups)
 	{
 		for (RtShaderPtr shader : shaders)
@@ -262,9 +286,10 @@ namespace CGE
 		vk::RayTracingShaderGroupCreateInfoKHR groupInfo;
 		groupInfo.setType(type);
 		groupInfo.setGeneralShader(VK_SHADER_UNUSED_KHR);
-		groupInfo.setIntersectionShader(intersect ? m_shaderStagesIndices[intersect->GetResourceId()] : VK_SHADER_UNUSED_KHR);
-		groupInfo.setAnyHitShader(anyHit ? m_shaderStagesIndices[anyHit->GetResourceId()] : VK_SHADER_UNUSED_KHR);
-		groupInfo.setClosestHitShader(closestHit ? m_shaderStagesIndices[closestHit->GetResourceId()] : VK_SHADER_UNUSED_KHR);
+		const ShaderFeatures& features = rtMaterial->GetFeatures();
+		groupInfo.setIntersectionShader(intersect ? GetStageIndex(intersect, features) : VK_SHADER_UNUSED_KHR);
+		groupInfo.setAnyHitShader(anyHit ? GetStageIndex(anyHit, features) : VK_SHADER_UNUSED_KHR);
+		groupInfo.setClosestHitShader(closestHit ? GetStageIndex(closestHit, features) : VK_SHADER_UNUSED_KHR);
 
 		return groupInfo;
 	}
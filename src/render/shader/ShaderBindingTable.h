@@ -65,6 +65,8 @@ namespace CGE
 		// sbt buffer
 		BufferDataPtr m_sbtBuffer;
 
+		// index of the stage running the shader with the features, specialized stages are added on first use
+		uint32_t GetStageIndex(RtShaderPtr shader, const ShaderFeatures& features);
 		void FillGeneralShaderGroups(const std::vector<RtShaderPtr>& shaders, std::vector<vk::RayTracingShaderGroupCreateInfoKHR>& groups);
 		vk::RayTracingShaderGroupCreateInfoKHR CreateGroupForMaterial(RtMaterialPtr rtMaterial);
 	};
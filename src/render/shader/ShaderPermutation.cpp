@@ -0,0 +1,151 @@
+#include "render/shader/ShaderPermutation.h"
+#include "render/shader/Shader.h"
+#include <cstring>
+#include <cstdio>
+
+namespace CGE
+{
+	namespace
+	{
+		static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+		static constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+		void HashBytes(uint64_t& ioHash, const void* inData, size_t inSize)
+		{
+			const uint8_t* bytes = static_cast<const uint8_t*>(inData);
+			for (size_t index = 0; index < inSize; index++)
+			{
+				ioHash ^= bytes[index];
+				ioHash *= FNV_PRIME;
+			}
+		}
+	}
+
+	void ShaderFeatures::Set(const std::string& inName, uint32_t inValue)
+	{
+		m_values[inName] = inValue;
+	}
+
+	void ShaderFeatures::Set(const std::string& inName, int32_t inValue)
+	{
+		m_values[inName] = static_cast<uint32_t>(inValue);
+	}
+
+	void ShaderFeatures::Set(const std::string& inName, float inValue)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &inValue, sizeof(bits));
+		m_values[inName] = bits;
+	}
+
+	void ShaderFeatures::Set(const std::string& inName, bool inValue)
+	{
+		m_values[inName] = inValue ? VK_TRUE : VK_FALSE;
+	}
+
+	void ShaderFeatures::Remove(const std::string& inName)
+	{
+		m_values.erase(inName);
+	}
+
+	uint64_t ShaderFeatures::GetHash() const
+	{
+		if (m_values.empty())
+		{
+			return 0;
+		}
+
+		uint64_t hash = FNV_OFFSET_BASIS;
+		for (auto& pair : m_values)
+		{
+			// name terminator keeps "ab"=1 apart from "a" followed by "b"
+			HashBytes(hash, pair.first.c_str(), pair.first.size() + 1);
+			HashBytes(hash, &pair.second, sizeof(pair.second));
+		}
+		return hash;
+	}
+
+	ShaderPermutationCache::ShaderPermutationCache()
+	{
+	}
+
+	ShaderPermutationCache::~ShaderPermutationCache()
+	{
+	}
+
+	ShaderSpecializationPtr ShaderPermutationCache::GetSpecialization(Shader* inShader, const ShaderFeatures& inFeatures)
+	{
+		if (!inShader || inFeatures.IsEmpty())
+		{
+			return nullptr;
+		}
+
+		uint64_t key = FNV_OFFSET_BASIS;
+		HashString shaderId = inShader->GetResourceId();
+		const std::string& path = shaderId.GetString();
+		uint32_t reloadCount = inShader->GetReloadCount();
+		uint64_t featuresHash = inFeatures.GetHash();
+		HashBytes(key, path.c_str(), path.size() + 1);
+		HashBytes(key, &reloadCount, sizeof(reloadCount));
+		HashBytes(key, &featuresHash, sizeof(featuresHash));
+
+		std::scoped_lock<std::mutex> lock(m_mutex);
+		m_stats.requests++;
+		auto it = m_specializations.find(key);
+		if (it != m_specializations.end())
+		{
+			return it->second;
+		}
+
+		// building is a few map lookups, cheaper than letting two jobs race for it
+		ShaderSpecializationPtr specialization = Build(inShader, inFeatures);
+		m_specializations[key] = specialization;
+		specialization ? m_stats.built++ : m_stats.unspecialized++;
+		return specialization;
+	}
+
+	void ShaderPermutationCache::Clear()
+	{
+		std::scoped_lock<std::mutex> lock(m_mutex);
+		m_specializations.clear();
+	}
+
+	ShaderPermutationStats ShaderPermutationCache::GetStats()
+	{
+		std::scoped_lock<std::mutex> lock(m_mutex);
+		return m_stats;
+	}
+
+	void ShaderPermutationCache::PrintStats()
+	{
+		ShaderPermutationStats stats = GetStats();
+		std::printf("shader permutations: %u built, %u without matching constants, %u requests\n", stats.built, stats.unspecialized, stats.requests);
+	}
+
+	ShaderSpecializationPtr ShaderPermutationCache::Build(Shader* inShader, const ShaderFeatures& inFeatures)
+	{
+		std::shared_ptr<ShaderSpecialization> specialization = std::make_shared<ShaderSpecialization>();
+		const auto& constants = inShader->GetSpecializationConstants();
+		for (auto& pair : inFeatures.GetValues())
+		{
+			auto it = constants.find(pair.first);
+			// only 32 bit constants, features are single words
+			if ((it == constants.end()) || (it->second.size != sizeof(uint32_t)))
+			{
+				continue;
+			}
+			uint32_t offset = static_cast<uint32_t>(specialization->data.size() * sizeof(uint32_t));
+			specialization->entries.push_back(vk::SpecializationMapEntry(it->second.constantId, offset, sizeof(uint32_t)));
+			specialization->data.push_back(pair.second);
+		}
+		if (specialization->entries.empty())
+		{
+			return nullptr;
+		}
+
+		specialization->info.setMapEntries(specialization->entries);
+		specialization->info.setDataSize(specialization->data.size() * sizeof(uint32_t));
+		specialization->info.setPData(specialization->data.data());
+		return specialization;
+	}
+}
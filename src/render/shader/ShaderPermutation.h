@@ -0,0 +1,78 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "vulkan/vulkan.hpp"
+
+namespace CGE
+{
+	class Shader;
+
+	// Feature keys of a material. A key names a specialization constant of the material shaders and its value
+	// is folded into the pipeline by the driver, so a feature is a branch compiled out instead of a uniform or
+	// one more spir-v file. Shaders not declaring a key just ignore it.
+	class ShaderFeatures
+	{
+	public:
+		void Set(const std::string& inName, uint32_t inValue);
+		void Set(const std::string& inName, int32_t inValue);
+		void Set(const std::string& inName, float inValue);
+		void Set(const std::string& inName, bool inValue);
+		void Remove(const std::string& inName);
+
+		bool IsEmpty() const { return m_values.empty(); }
+		// 0 without features, a material without any keeps the hash it had before
+		uint64_t GetHash() const;
+		const std::map<std::string, uint32_t>& GetValues() const { return m_values; }
+	private:
+		// values as constant words, sorted by name so the hash doesn't depend on the order of setting them
+		std::map<std::string, uint32_t> m_values;
+	};
+
+	// specialization info of one permutation, it points into the entries and data next to it
+	struct ShaderSpecialization
+	{
+		std::vector<vk::SpecializationMapEntry> entries;
+		std::vector<uint32_t> data;
+		vk::SpecializationInfo info;
+	};
+
+	typedef std::shared_ptr<const ShaderSpecialization> ShaderSpecializationPtr;
+
+	struct ShaderPermutationStats
+	{
+		uint32_t requests = 0;
+		uint32_t built = 0;
+		uint32_t unspecialized = 0;
+	};
+
+	// Permutations of shaders by features, built on first use and shared by every material asking for the same
+	// shader and features. The key is the shader path, its reload count and the features hash, so a reloaded
+	// shader gets its constant ids looked up again. Entries live until Clear, stage infos may point at them
+	// from any pipeline compile job. Thread safe.
+	class ShaderPermutationCache
+	{
+	public:
+		ShaderPermutationCache();
+		~ShaderPermutationCache();
+
+		// nullptr when the shader declares none of the features, the stage goes unspecialized then
+		ShaderSpecializationPtr GetSpecialization(Shader* inShader, const ShaderFeatures& inFeatures);
+		// pipelines built with the specializations must not be in creation anymore
+		void Clear();
+
+		ShaderPermutationStats GetStats();
+		void PrintStats();
+	private:
+		std::mutex m_mutex;
+		std::unordered_map<uint64_t, ShaderSpecializationPtr> m_specializations;
+		ShaderPermutationStats m_stats;
+
+		static ShaderSpecializationPtr Build(Shader* inShader, const ShaderFeatures& inFeatures);
+	};
+}
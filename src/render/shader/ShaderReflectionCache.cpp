@@ -0,0 +1,259 @@
+#include "render/shader/ShaderReflectionCache.h"
+#include "utils/MappedFile.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+namespace CGE
+{
+	namespace
+	{
+		static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+		static constexpr uint64_t FNV_PRIME = 1099511628211ull;
+		static const std::string CACHE_EXTENSION = ".reflection";
+
+		typedef std::chrono::high_resolution_clock Clock;
+
+		double GetElapsedMs(Clock::time_point inStart)
+		{
+			return std::chrono::duration<double, std::milli>(Clock::now() - inStart).count();
+		}
+
+		void ExtractBindings(
+			SPIRV_CROSS_NAMESPACE::SmallVector<SPIRV_CROSS_NAMESPACE::Resource>& inResources,
+			SPIRV_CROSS_NAMESPACE::Compiler& inCompiler,
+			DescriptorType inDescriptorType,
+			std::vector<BindingInfo>& outBindings)
+		{
+			for (SPIRV_CROSS_NAMESPACE::Resource& resource : inResources)
+			{
+				BindingInfo info;
+
+				info.set = inCompiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
+				info.binding = inCompiler.get_decoration(resource.id, spv::DecorationBinding);
+				info.name = inCompiler.get_name(resource.id);
+				info.blockName = resource.name;
+				info.descriptorType = inDescriptorType;
+
+				SPIRV_CROSS_NAMESPACE::SPIRType type = inCompiler.get_type(resource.type_id);
+
+				info.vectorSize = type.vecsize;
+				info.numColumns = type.columns;
+
+				info.arrayDimensions.resize(type.array.size());
+				for (uint64_t index = 0; index < type.array.size(); index++)
+				{
+					info.arrayDimensions[index] = type.array[index];
+				}
+
+				outBindings.push_back(info);
+			}
+		}
+	}
+
+	ShaderReflectionCache::ShaderReflectionCache()
+	{
+	}
+
+	ShaderReflectionCache::~ShaderReflectionCache()
+	{
+	}
+
+	ShaderBindingsPtr ShaderReflectionCache::GetBindings(const std::string& inPath, const std::vector<char>& inCode)
+	{
+		Clock::time_point hashStart = Clock::now();
+		uint64_t codeHash = HashCode(inCode);
+		double hashMs = GetElapsedMs(hashStart);
+
+		{
+			std::scoped_lock<std::mutex> lock(m_mutex);
+			m_stats.hashMs += hashMs;
+			auto it = m_bindings.find(codeHash);
+			if ((it != m_bindings.end()) && (it->second.codeSize == inCode.size()))
+			{
+				m_stats.memoryHits++;
+				return it->second.bindings;
+			}
+		}
+
+		// file io and reflection are done unlocked, two threads racing for the same blob just do it twice
+		std::string cachePath = inPath + CACHE_EXTENSION;
+		std::shared_ptr<std::vector<BindingInfo>> bindings = std::make_shared<std::vector<BindingInfo>>();
+		Clock::time_point diskStart = Clock::now();
+		bool diskHit = ReadFile(cachePath, codeHash, inCode.size(), *bindings);
+		double diskMs = GetElapsedMs(diskStart);
+		double reflectMs = 0.0;
+		if (!diskHit)
+		{
+			Clock::time_point reflectStart = Clock::now();
+			*bindings = Reflect(inCode);
+			reflectMs = GetElapsedMs(reflectStart);
+
+			diskStart = Clock::now();
+			WriteFile(cachePath, codeHash, inCode.size(), *bindings);
+			diskMs += GetElapsedMs(diskStart);
+		}
+
+		std::scoped_lock<std::mutex> lock(m_mutex);
+		m_stats.diskHits += diskHit ? 1 : 0;
+		m_stats.reflected += diskHit ? 0 : 1;
+		m_stats.diskMs += diskMs;
+		m_stats.reflectMs += reflectMs;
+		CachedBindings& cached = m_bindings[codeHash];
+		if (!cached.bindings || (cached.codeSize != inCode.size()))
+		{
+			cached.codeSize = inCode.size();
+			cached.bindings = bindings;
+		}
+		return cached.bindings;
+	}
+
+	uint64_t ShaderReflectionCache::HashCode(const std::vector<char>& inCode)
+	{
+		uint64_t hash = FNV_OFFSET_BASIS ^ VERSION;
+		for (char byte : inCode)
+		{
+			hash ^= static_cast<uint8_t>(byte);
+			hash *= FNV_PRIME;
+		}
+		return hash;
+	}
+
+	std::vector<BindingInfo> ShaderReflectionCache::Reflect(const std::vector<char>& inCode)
+	{
+		SPIRV_CROSS_NAMESPACE::Compiler spirv(reinterpret_cast<const uint32_t*>(inCode.data()), inCode.size() / sizeof(uint32_t));
+		SPIRV_CROSS_NAMESPACE::ShaderResources resources = spirv.get_shader_resources();
+
+		std::vector<BindingInfo> bindings;
+		ExtractBindings(resources.uniform_buffers, spirv, DescriptorType::eUniformBuffer, bindings);
+		ExtractBindings(resources.storage_buffers, spirv, DescriptorType::eStorageBuffer, bindings);
+		ExtractBindings(resources.separate_samplers, spirv, DescriptorType::eSampler, bindings);
+		ExtractBindings(resources.separate_images, spirv, DescriptorType::eSampledImage, bindings);
+		ExtractBindings(resources.storage_images, spirv, DescriptorType::eStorageImage, bindings);
+		ExtractBindings(resources.acceleration_structures, spirv, DescriptorType::eAccelerationStructureKHR, bindings);
+		// rejected sibling
+		ExtractBindings(resources.sampled_images, spirv, DescriptorType::eCombinedImageSampler, bindings);
+		return bindings;
+	}
+
+	ShaderReflectionStats ShaderReflectionCache::GetStats()
+	{
+		std::scoped_lock<std::mutex> lock(m_mutex);
+		return m_stats;
+	}
+
+	void ShaderReflectionCache::PrintStats()
+	{
+		ShaderReflectionStats stats = GetStats();
+		std::printf("shader reflection: %u reflected in %f ms, %u from disk in %f ms, %u memory hits, hashing %f ms\n",
+			stats.reflected, stats.reflectMs, stats.diskHits, stats.diskMs, stats.memoryHits, stats.hashMs);
+	}
+
+	bool ShaderReflectionCache::ReadFile(const std::string& inPath, uint64_t inCodeHash, uint64_t inCodeSize, std::vector<BindingInfo>& outBindings)
+	{
+		MappedFile file;
+		if (!file.Open(inPath) || (file.GetSize() < sizeof(CacheFileHeader)))
+		{
+			return false;
+		}
+
+		const CacheFileHeader* header = reinterpret_cast<const CacheFileHeader*>(file.GetData());
+		if ((header->magic != MAGIC) || (header->version != VERSION) || (header->codeHash != inCodeHash) || (header->codeSize != inCodeSize))
+		{
+			return false;
+		}
+		uint64_t bindingsOffset = sizeof(CacheFileHeader);
+		uint64_t dimensionsOffset = bindingsOffset + sizeof(CacheFileBinding) * uint64_t(header->bindingCount);
+		uint64_t stringsOffset = dimensionsOffset + sizeof(uint32_t) * uint64_t(header->dimensionCount);
+		if (stringsOffset + header->stringsSize != file.GetSize())
+		{
+			return false;
+		}
+
+		const CacheFileBinding* bindings = reinterpret_cast<const CacheFileBinding*>(file.GetData() + bindingsOffset);
+		const uint32_t* dimensions = reinterpret_cast<const uint32_t*>(file.GetData() + dimensionsOffset);
+		const char* strings = reinterpret_cast<const char*>(file.GetData() + stringsOffset);
+		outBindings.clear();
+		outBindings.reserve(header->bindingCount);
+		for (uint32_t index = 0; index < header->bindingCount; index++)
+		{
+			const CacheFileBinding& binding = bindings[index];
+			if ((uint64_t(binding.nameOffset) + binding.nameSize > header->stringsSize) ||
+				(uint64_t(binding.blockNameOffset) + binding.blockNameSize > header->stringsSize) ||
+				(uint64_t(binding.firstDimension) + binding.dimensionCount > header->dimensionCount))
+			{
+				return false;
+			}
+
+			BindingInfo info;
+			info.set = binding.set;
+			info.binding = binding.binding;
+			info.vectorSize = binding.vectorSize;
+			info.numColumns = binding.numColumns;
+			info.descriptorType = static_cast<DescriptorType>(binding.descriptorType);
+			info.name = std::string(strings + binding.nameOffset, binding.nameSize);
+			info.blockName = std::string(strings + binding.blockNameOffset, binding.blockNameSize);
+			info.arrayDimensions.assign(dimensions + binding.firstDimension, dimensions + binding.firstDimension + binding.dimensionCount);
+			outBindings.push_back(info);
+		}
+		return true;
+	}
+
+	bool ShaderReflectionCache::WriteFile(const std::string& inPath, uint64_t inCodeHash, uint64_t inCodeSize, const std::vector<BindingInfo>& inBindings)
+	{
+		std::vector<CacheFileBinding> bindings;
+		std::vector<uint32_t> dimensions;
+		std::string strings;
+		for (const BindingInfo& info : inBindings)
+		{
+			CacheFileBinding binding = {};
+			binding.set = info.set;
+			binding.binding = info.binding;
+			binding.vectorSize = info.vectorSize;
+			binding.numColumns = info.numColumns;
+			binding.descriptorType = static_cast<uint32_t>(info.descriptorType);
+			binding.nameOffset = static_cast<uint32_t>(strings.size());
+			binding.nameSize = static_cast<uint32_t>(info.name.GetString().size());
+			strings += info.name.GetString();
+			binding.blockNameOffset = static_cast<uint32_t>(strings.size());
+			binding.blockNameSize = static_cast<uint32_t>(info.blockName.GetString().size());
+			strings += info.blockName.GetString();
+			binding.firstDimension = static_cast<uint32_t>(dimensions.size());
+			binding.dimensionCount = static_cast<uint32_t>(info.arrayDimensions.size());
+			dimensions.insert(dimensions.end(), info.arrayDimensions.begin(), info.arrayDimensions.end());
+			bindings.push_back(binding);
+		}
+
+		CacheFileHeader header = {};
+		header.magic = MAGIC;
+		header.version = VERSION;
+		header.codeHash = inCodeHash;
+		header.codeSize = inCodeSize;
+		header.bindingCount = static_cast<uint32_t>(bindings.size());
+		header.dimensionCount = static_cast<uint32_t>(dimensions.size());
+		header.stringsSize = static_cast<uint32_t>(strings.size());
+
+		// written aside and moved in place, readers never see a half written table
+		std::string tempPath = inPath + ".tmp";
+		{
+			std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+			if (!stream)
+			{
+				return false;
+			}
+			stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			stream.write(reinterpret_cast<const char*>(bindings.data()), sizeof(CacheFileBinding) * bindings.size());
+			stream.write(reinterpret_cast<const char*>(dimensions.data()), sizeof(uint32_t) * dimensions.size());
+			stream.write(strings.data(), strings.size());
+			if (!stream)
+			{
+				stream.close();
+				std::remove(tempPath.c_str());
+				return false;
+			}
+		}
+
+		std::remove(inPath.c_str());
+		return std::rename(tempPath.c_str(), inPath.c_str()) == 0;
+	}
+}
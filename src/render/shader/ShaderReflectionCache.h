@@ -0,0 +1,84 @@
+#pragma once
+
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "Shader.h"
+
+namespace CGE
+{
+	typedef std::shared_ptr<const std::vector<BindingInfo>> ShaderBindingsPtr;
+
+	struct ShaderReflectionStats
+	{
+		uint32_t memoryHits = 0;
+		uint32_t diskHits = 0;
+		uint32_t reflected = 0;
+		double hashMs = 0.0;
+		double diskMs = 0.0;
+		double reflectMs = 0.0;
+	};
+
+	// Binding tables of spir-v blobs keyed by a hash of the code. Every blob is reflected once per process,
+	// the result is also written next to the .spv as a small binary table, so later runs don't start
+	// SPIRV-Cross at all unless the code changed. Thread safe.
+	class ShaderReflectionCache
+	{
+	public:
+		static constexpr uint32_t MAGIC = 0x52454743; // CGER
+		static constexpr uint32_t VERSION = 1;
+
+		ShaderReflectionCache();
+		~ShaderReflectionCache();
+
+		ShaderBindingsPtr GetBindings(const std::string& inPath, const std::vector<char>& inCode);
+		static uint64_t HashCode(const std::vector<char>& inCode);
+		static std::vector<BindingInfo> Reflect(const std::vector<char>& inCode);
+
+		ShaderReflectionStats GetStats();
+		void PrintStats();
+	private:
+		struct CacheFileHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint64_t codeHash;
+			uint64_t codeSize;
+			uint32_t bindingCount;
+			uint32_t dimensionCount;
+			uint32_t stringsSize;
+			uint32_t padding;
+		};
+
+		struct CacheFileBinding
+		{
+			int32_t set;
+			int32_t binding;
+			uint32_t vectorSize;
+			uint32_t numColumns;
+			uint32_t descriptorType;
+			uint32_t nameOffset;
+			uint32_t nameSize;
+			uint32_t blockNameOffset;
+			uint32_t blockNameSize;
+			uint32_t firstDimension;
+			uint32_t dimensionCount;
+		};
+
+		struct CachedBindings
+		{
+			uint64_t codeSize;
+			ShaderBindingsPtr bindings;
+		};
+
+		std::mutex m_mutex;
+		std::unordered_map<uint64_t, CachedBindings> m_bindings;
+		ShaderReflectionStats m_stats;
+
+		static bool ReadFile(const std::string& inPath, uint64_t inCodeHash, uint64_t inCodeSize, std::vector<BindingInfo>& outBindings);
+		static bool WriteFile(const std::string& inPath, uint64_t inCodeHash, uint64_t inCodeSize, const std::vector<BindingInfo>& inBindings);
+	};
+}
@@ -4,6 +4,7 @@
 #include "../objects/VulkanDevice.h"
 #include "utils/ResourceUtils.h"
 #include "data/Texture2D.h"
+#include <algorithm>
 
 namespace CGE
 {
@@ -31,100 +32,176 @@ namespace CGE
 
 	void ShaderResourceMapper::AddSampledImage(HashString name, TextureDataPtr texture)
 	{
-		AddResource<TextureDataPtr>(vk::DescriptorType::eSampledImage, name, { texture });
+		AddResource(name, ResourceList{ vk::DescriptorType::eSampledImage, { texture } });
 	}
 
 	void ShaderResourceMapper::AddSampledImage(uint32_t set, uint32_t binding, TextureDataPtr texture)
 	{
-		AddResource<TextureDataPtr>(vk::DescriptorType::eSampledImage, set, binding, { texture });
+		AddResource(set, binding, ResourceList{ vk::DescriptorType::eSampledImage, { texture } });
 	}
 
 	void ShaderResourceMapper::AddSampledImageArray(HashString name, const std::vector<TextureDataPtr>& textures)
 	{
-		AddResource<TextureDataPtr>(vk::DescriptorType::eSampledImage, name, textures);
+		AddResource(name, ResourceList{ vk::DescriptorType::eSampledImage, textures });
 	}
 
 	void ShaderResourceMapper::AddStorageImage(HashString name, TextureDataPtr texture)
 	{
-		AddResource<TextureDataPtr>(vk::DescriptorType::eStorageImage, name, { texture });
+		AddResource(name, ResourceList{ vk::DescriptorType::eStorageImage, { texture } });
 	}
 
 	void ShaderResourceMapper::AddStorageImage(uint32_t set, uint32_t binding, TextureDataPtr texture)
 	{
-		AddResource<TextureDataPtr>(vk::DescriptorType::eStorageImage, set, binding, { texture });
+		AddResource(set, binding, ResourceList{ vk::DescriptorType::eStorageImage, { texture } });
 	}
 
 	void ShaderResourceMapper::AddStorageImageArray(HashString name, const std::vector<TextureDataPtr>& textures)
 	{
-		AddResource<TextureDataPtr>(vk::DescriptorType::eStorageImage, name, textures);
+		AddResource(name, ResourceList{ vk::DescriptorType::eStorageImage, textures });
 	}
 
 	void ShaderResourceMapper::AddUniformBuffer(HashString name, BufferDataPtr buffer)
 	{
-		AddResource<BufferDataPtr>(vk::DescriptorType::eUniformBuffer, name, { buffer });
+		AddResource(name, ResourceList{ vk::DescriptorType::eUniformBuffer, {}, { buffer } });
 	}
 
 	void ShaderResourceMapper::AddUniformBuffer(uint32_t set, uint32_t binding, BufferDataPtr buffer)
 	{
-		AddResource<BufferDataPtr>(vk::DescriptorType::eUniformBuffer, set, binding, { buffer });
+		AddResource(set, binding, ResourceList{ vk::DescriptorType::eUniformBuffer, {}, { buffer } });
 	}
 
 	void ShaderResourceMapper::AddUniformBufferArray(HashString name, const std::vector<BufferDataPtr>& buffers)
 	{
-		AddResource<BufferDataPtr>(vk::DescriptorType::eUniformBuffer, name, buffers);
+		AddResource(name, ResourceList{ vk::DescriptorType::eUniformBuffer, {}, buffers });
+	}
+
+	void ShaderResourceMapper::AddUniformBufferRange(HashString name, BufferDataPtr buffer, vk::DeviceSize offset, vk::DeviceSize range)
+	{
+		AddResource(name, ResourceList{ vk::DescriptorType::eUniformBuffer, {}, { buffer }, {}, offset, range });
 	}
 
 	void ShaderResourceMapper::AddStorageBuffer(HashString name, BufferDataPtr buffer)
 	{
-		AddResource<BufferDataPtr>(vk::DescriptorType::eStorageBuffer, name, { buffer });
+		AddResource(name, ResourceList{ vk::DescriptorType::eStorageBuffer, {}, { buffer } });
 	}
 
 	void ShaderResourceMapper::AddStorageBuffer(uint32_t set, uint32_t binding, BufferDataPtr buffer)
 	{
-		AddResource<BufferDataPtr>(vk::DescriptorType::eStorageBuffer, set, binding, { buffer });
+		AddResource(set, binding, ResourceList{ vk::DescriptorType::eStorageBuffer, {}, { buffer } });
 	}
 
 	void ShaderResourceMapper::AddStorageBufferArray(HashString name, const std::vector<BufferDataPtr>& buffers)
 	{
-		AddResource<BufferDataPtr>(vk::DescriptorType::eStorageBuffer, name, buffers);
+		AddResource(name, ResourceList{ vk::DescriptorType::eStorageBuffer, {}, buffers });
+	}
+
+	void ShaderResourceMapper::AddStorageBufferRange(HashString name, BufferDataPtr buffer, vk::DeviceSize offset, vk::DeviceSize range)
+	{
+		AddResource(name, ResourceList{ vk::DescriptorType::eStorageBuffer, {}, { buffer }, {}, offset, range });
 	}
 
 	void ShaderResourceMapper::AddAccelerationStructure(HashString name, vk::AccelerationStructureKHR accelerationStructure)
 	{
-		AddResource<vk::AccelerationStructureKHR>(vk::DescriptorType::eAccelerationStructureKHR, name, { accelerationStructure });
+		AddResource(name, ResourceList{ vk::DescriptorType::eAccelerationStructureKHR, {}, {}, { accelerationStructure } });
 	}
 
 	void ShaderResourceMapper::AddAccelerationStructure(uint32_t set, uint32_t binding, vk::AccelerationStructureKHR accelerationStructure)
 	{
-		AddResource<vk::AccelerationStructureKHR>(vk::DescriptorType::eAccelerationStructureKHR, set, binding, { accelerationStructure });
+		AddResource(set, binding, ResourceList{ vk::DescriptorType::eAccelerationStructureKHR, {}, {}, { accelerationStructure } });
 	}
 
 	void ShaderResourceMapper::AddAccelerationStructureArray(HashString name, const std::vector<vk::AccelerationStructureKHR>& accelerationStructures)
 	{
-		AddResource<vk::AccelerationStructureKHR>(vk::DescriptorType::eAccelerationStructureKHR, name, accelerationStructures);
+		AddResource(name, ResourceList{ vk::DescriptorType::eAccelerationStructureKHR, {}, {}, accelerationStructures });
 	}
 
 	void ShaderResourceMapper::Update()
 	{
 		VulkanDevice* device = &Engine::GetRendererInstance()->GetVulkanDevice();
 
-		for (VulkanDescriptorSet& set : m_sets)
+		// reloaded shaders could have different layouts, both sets and template go
+		if (HaveShadersChanged())
 		{
-			set.Destroy();
+			Destroy();
+			m_templateDirty = true;
 		}
-		m_sets.clear();
-		m_nativeSets.clear();
-		// collect all data
-		m_sets = VulkanDescriptorSet::Create(device, m_shaders);
-		m_nativeSets.resize(m_sets.size());
-		for (uint32_t idx = 0; idx < m_sets.size(); ++idx)
+		if (m_sets.empty())
+		{
+			m_sets = VulkanDescriptorSet::Create(device, m_shaders);
+			m_nativeSets.resize(m_sets.size());
+			for (uint32_t idx = 0; idx < m_sets.size(); ++idx)
+			{
+				m_nativeSets[idx] = m_sets[idx].GetSet();
+			}
+		}
+		if (m_templateDirty)
+		{
+			CompileTemplate();
+		}
+		WriteTemplate();
+
+		if (!m_writes.empty())
+		{
+			device->GetDevice().updateDescriptorSets(static_cast<uint32_t>(m_writes.size()), m_writes.data(), 0, nullptr);
+		}
+	}
+
+	void ShaderResourceMapper::SetResources(ResourceList& outList, ResourceList&& inList)
+	{
+		// handles only go into the compiled writes, a different type or count changes the writes themselves
+		if ((outList.type != inList.type) || (outList.GetCount() != inList.GetCount()))
+		{
+			m_templateDirty = true;
+		}
+		outList = std::move(inList);
+	}
+
+	void ShaderResourceMapper::AddResource(HashString name, ResourceList&& inList)
+	{
+		auto it = m_resourcesNames.find(name);
+		if (it == m_resourcesNames.end())
 		{
-			m_nativeSets[idx] = m_sets[idx].GetSet();
+			m_templateDirty = true;
+			it = m_resourcesNames.emplace(name, ResourceList{ inList.type }).first;
 		}
+		SetResources(it->second, std::move(inList));
+	}
 
+	void ShaderResourceMapper::AddResource(uint32_t set, uint32_t binding, ResourceList&& inList)
+	{
+		auto it = m_resourcesBindings.find({ set, binding });
+		if (it == m_resourcesBindings.end())
+		{
+			m_templateDirty = true;
+			it = m_resourcesBindings.emplace(std::make_pair(set, binding), ResourceList{ inList.type }).first;
+		}
+		SetResources(it->second, std::move(inList));
+	}
+
+	bool ShaderResourceMapper::HaveShadersChanged() const
+	{
+		if (m_templateShaders.size() != m_shaders.size())
+		{
+			return true;
+		}
+		for (uint32_t idx = 0; idx < m_shaders.size(); ++idx)
+		{
+			Shader* shader = m_shaders[idx].get();
+			if ((m_templateShaders[idx].first != shader) || (shader && (m_templateShaders[idx].second != shader->GetReloadCount())))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void ShaderResourceMapper::CompileTemplate()
+	{
+		m_templateShaders.clear();
 		m_bindingsNames.clear();
 		for (ShaderPtr shader : m_shaders)
 		{
+			m_templateShaders.emplace_back(shader.get(), shader ? shader->GetReloadCount() : 0);
 			if (!shader)
 			{
 				continue;
@@ -135,116 +212,150 @@ namespace CGE
 			}
 		}
 
-		// remap names to sets and bindings
+		struct TemplateEntry
+		{
+			const ResourceList* resources;
+			uint32_t set;
+			uint32_t binding;
+			vk::DescriptorType type;
+		};
+		std::vector<TemplateEntry> entries;
+		// explicit bindings take whatever type they were added with, named ones the type the shaders declare
+		for (auto& pair : m_resourcesBindings)
+		{
+			entries.push_back({ &pair.second, pair.first.first, pair.first.second, pair.second.type });
+		}
 		for (auto& pair : m_resourcesNames)
 		{
-			if (m_bindingsNames.find(pair.first) != m_bindingsNames.end())
+			auto bindingIt = m_bindingsNames.find(pair.first);
+			if (bindingIt != m_bindingsNames.end() && bindingIt->second.isValid())
 			{
-				BindingInfo info = m_bindingsNames[pair.first];
-				m_resourcesTable[info.descriptorType].push_back({ pair.second, info.set, info.binding });
+				const BindingInfo& info = bindingIt->second;
+				entries.push_back({ &pair.second, static_cast<uint32_t>(info.set), static_cast<uint32_t>(info.binding), info.descriptorType });
 			}
 		}
 
-		// make writes
-		std::vector<vk::WriteDescriptorSet> writes;
-		for (auto& pair : m_resourcesTable)
+		m_slots.clear();
+		m_writes.clear();
+		m_imageInfos.clear();
+		m_bufferInfos.clear();
+		m_accelerationStructures.clear();
+		m_accelerationWrites.clear();
+
+		// counted first, so info arrays never grow after writes took pointers into them
+		uint32_t imageCount = 0;
+		uint32_t bufferCount = 0;
+		uint32_t accelerationCount = 0;
+		uint32_t accelerationWritesCount = 0;
+		auto isUsable = [this](const TemplateEntry& entry)
 		{
-			for (ResourceBindingRecord& rec : pair.second)
+			if ((entry.set >= m_sets.size()) || (entry.resources->GetCount() == 0))
 			{
-				vk::WriteDescriptorSet write;
-				switch (pair.first)
-				{
-				case vk::DescriptorType::eSampledImage:
-					std::vector<vk::DescriptorImageInfo>* sampledImageInfo;
-					sampledImageInfo = new std::vector<vk::DescriptorImageInfo>();
-					m_writeInfos[pair.first].push_back(reinterpret_cast<char*>(sampledImageInfo));
-					write = ResourceUtils::CreateWriteDescriptor(
-						std::any_cast<std::vector<TextureDataPtr>&>(rec.resources),
-						pair.first,
-						rec.binding,
-						vk::ImageLayout::eShaderReadOnlyOptimal,
-						*sampledImageInfo
-					);
-					break;
-				case vk::DescriptorType::eStorageImage:
-					std::vector<vk::DescriptorImageInfo>* storageImageInfo;
-					storageImageInfo = new std::vector<vk::DescriptorImageInfo>();
-					m_writeInfos[pair.first].push_back(reinterpret_cast<char*>(storageImageInfo));
-					write = ResourceUtils::CreateWriteDescriptor(
-						std::any_cast<std::vector<TextureDataPtr>&>(rec.resources),
-						pair.first,
-						rec.binding,
-						vk::ImageLayout::eGeneral,
-						*storageImageInfo
-					);
-					break;
-				case vk::DescriptorType::eUniformBuffer:
-					std::vector<vk::DescriptorBufferInfo>* uniformBuffInfo;
-					uniformBuffInfo = new std::vector<vk::DescriptorBufferInfo>();
-					m_writeInfos[pair.first].push_back(reinterpret_cast<char*>(uniformBuffInfo));
-					write = ResourceUtils::CreateWriteDescriptor(
-						std::any_cast<std::vector<BufferDataPtr>&>(rec.resources),
-						pair.first,
-						rec.binding,
-						*uniformBuffInfo
-					);
-					break;
-				case vk::DescriptorType::eStorageBuffer:
-					std::vector<vk::DescriptorBufferInfo>* storageBuffInfo;
-					storageBuffInfo = new std::vector<vk::DescriptorBufferInfo>();
-					m_writeInfos[pair.first].push_back(reinterpret_cast<char*>(storageBuffInfo));
-					write = ResourceUtils::CreateWriteDescriptor(
-						std::any_cast<std::vector<BufferDataPtr>&>(rec.resources),
-						pair.first,
-						rec.binding,
-						*storageBuffInfo
-					);
-					break;
-				case vk::DescriptorType::eAccelerationStructureKHR:
-					vk::WriteDescriptorSetAccelerationStructureKHR* accelStructWrite;
-					accelStructWrite = new vk::WriteDescriptorSetAccelerationStructureKHR();
-					m_writeInfos[pair.first].push_back(reinterpret_cast<char*>(accelStructWrite));
-					write = ResourceUtils::CreateWriteDescriptor(
-						std::any_cast<std::vector<vk::AccelerationStructureKHR>&>(rec.resources),
-						pair.first,
-						rec.binding,
-						*accelStructWrite
-					);
-					break;
-				}
-				write.setDstSet(m_sets[rec.set].GetSet());
-				writes.push_back(write);
+				return false;
 			}
+			switch (entry.type)
+			{
+			case vk::DescriptorType::eSampledImage:
+			case vk::DescriptorType::eStorageImage:
+			case vk::DescriptorType::eCombinedImageSampler:
+				return !entry.resources->textures.empty();
+			case vk::DescriptorType::eUniformBuffer:
+			case vk::DescriptorType::eStorageBuffer:
+				return !entry.resources->buffers.empty();
+			case vk::DescriptorType::eAccelerationStructureKHR:
+				return !entry.resources->accelerationStructures.empty();
+			default:
+				return false;
+			}
+		};
+		entries.erase(std::remove_if(entries.begin(), entries.end(), [&isUsable](const TemplateEntry& entry) { return !isUsable(entry); }), entries.end());
+		for (const TemplateEntry& entry : entries)
+		{
+			imageCount += static_cast<uint32_t>(entry.resources->textures.size());
+			bufferCount += static_cast<uint32_t>(entry.resources->buffers.size());
+			accelerationCount += static_cast<uint32_t>(entry.resources->accelerationStructures.size());
+			accelerationWritesCount += entry.resources->accelerationStructures.empty() ? 0 : 1;
 		}
+		m_imageInfos.resize(imageCount);
+		m_bufferInfos.resize(bufferCount);
+		m_accelerationStructures.resize(accelerationCount);
+		m_accelerationWrites.resize(accelerationWritesCount);
 
-		device->GetDevice().updateDescriptorSets(static_cast<uint32_t>( writes.size() ), writes.data(), 0, nullptr);
+		uint32_t imageOffset = 0;
+		uint32_t bufferOffset = 0;
+		uint32_t accelerationOffset = 0;
+		uint32_t accelerationWriteIndex = 0;
+		for (const TemplateEntry& entry : entries)
+		{
+			uint32_t count = entry.resources->GetCount();
+			vk::WriteDescriptorSet write;
+			write.setDstBinding(entry.binding);
+			write.setDescriptorType(entry.type);
+			write.setDescriptorCount(count);
 
-		for (auto& pair : m_writeInfos)
+			WriteSlot slot{ entry.resources, entry.set, 0 };
+			if (!entry.resources->textures.empty())
+			{
+				slot.infoOffset = imageOffset;
+				write.setPImageInfo(m_imageInfos.data() + imageOffset);
+				imageOffset += count;
+			}
+			else if (!entry.resources->buffers.empty())
+			{
+				slot.infoOffset = bufferOffset;
+				write.setPBufferInfo(m_bufferInfos.data() + bufferOffset);
+				bufferOffset += count;
+			}
+			else
+			{
+				slot.infoOffset = accelerationOffset;
+				vk::WriteDescriptorSetAccelerationStructureKHR& accelerationWrite = m_accelerationWrites[accelerationWriteIndex++];
+				accelerationWrite.setAccelerationStructureCount(count);
+				accelerationWrite.setPAccelerationStructures(m_accelerationStructures.data() + accelerationOffset);
+				write.setPNext(&accelerationWrite);
+				accelerationOffset += count;
+			}
+			m_slots.push_back(slot);
+			m_writes.push_back(write);
+		}
+
+		m_templateDirty = false;
+	}
+
+	void ShaderResourceMapper::WriteTemplate()
+	{
+		for (uint32_t idx = 0; idx < m_slots.size(); ++idx)
 		{
-			for (char* info : pair.second)
+			const WriteSlot& slot = m_slots[idx];
+			vk::WriteDescriptorSet& write = m_writes[idx];
+			write.setDstSet(m_sets[slot.set].GetSet());
+
+			const ResourceList& resources = *slot.resources;
+			vk::ImageLayout layout = write.descriptorType == vk::DescriptorType::eStorageImage ? vk::ImageLayout::eGeneral : vk::ImageLayout::eShaderReadOnlyOptimal;
+			for (uint32_t resIdx = 0; resIdx < resources.textures.size(); ++resIdx)
+			{
+				m_imageInfos[slot.infoOffset + resIdx] = resources.textures[resIdx]->GetDescriptorInfo(layout);
+			}
+			for (uint32_t resIdx = 0; resIdx < resources.buffers.size(); ++resIdx)
 			{
-				switch (pair.first)
+				vk::DescriptorBufferInfo& bufferInfo = m_bufferInfos[slot.infoOffset + resIdx];
+				bufferInfo = resources.buffers[resIdx]->GetBuffer().GetDescriptorInfo();
+				if (resources.bufferRange != VK_WHOLE_SIZE)
 				{
-				case vk::DescriptorType::eSampledImage:
-				case vk::DescriptorType::eStorageImage:
-					std::vector<vk::DescriptorImageInfo>* sampledImageInfo;
-					sampledImageInfo = reinterpret_cast<std::vector<vk::DescriptorImageInfo>*>(info);
-					delete sampledImageInfo;
-					break;
-				case vk::DescriptorType::eUniformBuffer:
-				case vk::DescriptorType::eStorageBuffer:
-					std::vector<vk::DescriptorBufferInfo>* bufferInfo;
-					bufferInfo = reinterpret_cast<std::vector<vk::DescriptorBufferInfo>*>(info);
-					delete bufferInfo;
-					break;
-				case vk::DescriptorType::eAccelerationStructureKHR:
-					vk::WriteDescriptorSetAccelerationStructureKHR* accelStructInfo;
-					accelStructInfo = reinterpret_cast<vk::WriteDescriptorSetAccelerationStructureKHR*>(info);
-					delete accelStructInfo;
+					bufferInfo.setOffset(resources.bufferOffset);
+					bufferInfo.setRange(resources.bufferRange);
 				}
 			}
+			std::copy(resources.accelerationStructures.begin(), resources.accelerationStructures.end(), m_accelerationStructures.begin() + slot.infoOffset);
 		}
-		m_writeInfos.clear();
+	}
+
+	std::vector<VulkanDescriptorSet> ShaderResourceMapper::ReleaseDescriptorSets()
+	{
+		std::vector<VulkanDescriptorSet> sets;
+		sets.swap(m_sets);
+		m_nativeSets.clear();
+		return sets;
 	}
 
 	void ShaderResourceMapper::Destroy()
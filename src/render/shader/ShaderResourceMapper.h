@@ -2,9 +2,9 @@
 #define __SHADER_RESOURCE_MAPPER_H__
 
 #include <vector>
+#include <map>
 #include "Shader.h"
 #include "../objects/VulkanDescriptorSet.h"
-#include <any>
 #include "data/TextureData.h"
 #include "RtShader.h"
 #include "data/BufferData.h"
@@ -39,48 +39,68 @@ namespace CGE
 		void AddUniformBuffer(HashString name, BufferDataPtr buffer);
 		void AddUniformBuffer(uint32_t set, uint32_t binding, BufferDataPtr buffer);
 		void AddUniformBufferArray(HashString name, const std::vector<BufferDataPtr>& buffers);
+		// a block of a shared buffer, material constants arena ones
+		void AddUniformBufferRange(HashString name, BufferDataPtr buffer, vk::DeviceSize offset, vk::DeviceSize range);
 		void AddStorageBuffer(HashString name, BufferDataPtr buffer);
 		void AddStorageBuffer(uint32_t set, uint32_t binding, BufferDataPtr buffer);
 		void AddStorageBufferArray(HashString name, const std::vector<BufferDataPtr>& buffers);
+		void AddStorageBufferRange(HashString name, BufferDataPtr buffer, vk::DeviceSize offset, vk::DeviceSize range);
 		void AddAccelerationStructure(HashString name, vk::AccelerationStructureKHR accelerationStructure);
 		void AddAccelerationStructure(uint32_t set, uint32_t binding, vk::AccelerationStructureKHR accelerationStructure);
 		void AddAccelerationStructureArray(HashString name, const std::vector<vk::AccelerationStructureKHR>& accelerationStructures);
 
+		// sets are allocated when there are none, names are matched to bindings only when shaders or the set of
+		// resources changed, otherwise it's refilling handles into the compiled writes and one update call
 		void Update();
 		void Destroy();
+		// hands the sets over without destroying them, they could still be used by frames in flight
+		std::vector<VulkanDescriptorSet> ReleaseDescriptorSets();
 	private:
-		struct ResourceBindingRecord
+		struct ResourceList
 		{
-			std::any resources;
-			int32_t set;
-			int32_t binding;
+			vk::DescriptorType type;
+			std::vector<TextureDataPtr> textures;
+			std::vector<BufferDataPtr> buffers;
+			std::vector<vk::AccelerationStructureKHR> accelerationStructures;
+			// part of a single buffer bound, the whole buffer when the range is VK_WHOLE_SIZE
+			vk::DeviceSize bufferOffset = 0;
+			vk::DeviceSize bufferRange = VK_WHOLE_SIZE;
+
+			uint32_t GetCount() const { return static_cast<uint32_t>(textures.size() + buffers.size() + accelerationStructures.size()); }
+		};
+
+		// one write of the compiled template, resource lists are never erased so the pointer holds
+		struct WriteSlot
+		{
+			const ResourceList* resources;
+			uint32_t set;
+			uint32_t infoOffset;
 		};
 
 		std::vector<ShaderPtr> m_shaders;
 		std::vector<VulkanDescriptorSet> m_sets;
 		std::vector<vk::DescriptorSet> m_nativeSets;
 
-		std::unordered_map<HashString, std::any> m_resourcesNames;
-		std::unordered_map<vk::DescriptorType, std::vector<char*>> m_writeInfos;
-		std::unordered_map<vk::DescriptorType, std::vector<ResourceBindingRecord>> m_resourcesTable;
-
+		std::unordered_map<HashString, ResourceList> m_resourcesNames;
+		std::map<std::pair<uint32_t, uint32_t>, ResourceList> m_resourcesBindings;
 		std::unordered_map<HashString, BindingInfo> m_bindingsNames;
 
-		template<typename T>
-		void AddResource(vk::DescriptorType type, HashString name, std::vector<T> resources)
-		{
-			m_resourcesNames[name] = resources;
-		}
-		template<typename T>
-		void AddResource(vk::DescriptorType type, uint32_t set, uint32_t binding, std::vector<T> resources)
-		{
-			m_resourcesTable[type].push_back({ resources, static_cast<int32_t>( set ), static_cast<int32_t>( binding ) });
-		}
-		template<typename T>
-		T GetResource(HashString name)
-		{
-			return std::any_cast<T>(m_resourcesNames[name]);
-		}
+		// compiled template and the shaders it was compiled for
+		bool m_templateDirty = true;
+		std::vector<std::pair<Shader*, uint32_t>> m_templateShaders;
+		std::vector<WriteSlot> m_slots;
+		std::vector<vk::WriteDescriptorSet> m_writes;
+		std::vector<vk::DescriptorImageInfo> m_imageInfos;
+		std::vector<vk::DescriptorBufferInfo> m_bufferInfos;
+		std::vector<vk::AccelerationStructureKHR> m_accelerationStructures;
+		std::vector<vk::WriteDescriptorSetAccelerationStructureKHR> m_accelerationWrites;
+
+		void SetResources(ResourceList& outList, ResourceList&& inList);
+		void AddResource(HashString name, ResourceList&& inList);
+		void AddResource(uint32_t set, uint32_t binding, ResourceList&& inList);
+		bool HaveShadersChanged() const;
+		void CompileTemplate();
+		void WriteTemplate();
 	};
 
 }
@@ -6,6 +6,7 @@
 #include "camera/CameraObject.h"
 #include "mesh/MeshObject.h"
 #include "import/MeshImporter.h"
+#include "import/ImportedMesh.h"
 #include "render/TransferList.h"
 #include "data/DataManager.h"
 #include "render/DataStructures.h"
@@ -13,12 +14,16 @@
 #include "async/ThreadPool.h"
 #include "async/Job.h"
 #include <iostream>
+#include <algorithm>
+#include <unordered_set>
 #include "messages/MessageHandler.h"
 #include "messages/MessageBus.h"
 #include "messages/MessageSubscriber.h"
 #include "core/ObjectPool.h"
 #include "scene/Octree.h"
 #include "utils/Math3D.h"
+#include "utils/Singleton.h"
+#include "render/TextureStreamer.h"
 
 namespace CGE
 {
@@ -47,6 +52,23 @@ namespace CGE
 		return FrustumIntersectSlow(object, aabb);
 	}
 
+	//-----------------------------------------------------------------------------------------------------------------
+
+	// material textures are assumed to be spread over the mesh bounds, meshes without lods count as unit sized
+	void RequestStreamedTextures(MeshComponentPtr meshComponent, const glm::mat4& transform, const glm::vec3& viewLocation, float projectionScale, uint64_t frame)
+	{
+		float scale = std::max(glm::length(glm::vec3(transform[0])), std::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+		glm::vec3 center = glm::vec3(transform[3]);
+		float radius = 0.5f * scale;
+		if (meshComponent->lodSet)
+		{
+			center = glm::vec3(transform * glm::vec4(meshComponent->lodSet->GetBoundsCenter(), 1.0f));
+			radius = meshComponent->lodSet->GetBoundsRadius() * scale;
+		}
+		float distance = std::max(glm::length(center - viewLocation) - radius, 0.0f);
+		Singleton<TextureStreamer>::GetInstance()->RequestMaterial(meshComponent->material, 2.0f * radius, distance, projectionScale, frame);
+	}
+
 	//-----------------------------------------------------------------------------------------------------------------
 	//-----------------------------------------------------------------------------------------------------------------
 	//-----------------------------------------------------------------------------------------------------------------
@@ -143,34 +165,40 @@ namespace CGE
 		//}
 		m_modelMatrices.resize(g_GlobalTransformDataSize);
 		m_previousModelMatrices.resize(g_GlobalTransformDataSize);
-	
-		TransferList* tl = TransferList::GetInstance();
+		m_transformMaterialIndices.resize(g_GlobalTransformDataSize);
 	
 		//Texture2DPtr albedo = DataManager::RequestResourceType<Texture2D>("content/meshes/gun/Textures/Cerberus_A.tga", false, true, false);
 		//Texture2DPtr normal = DataManager::RequestResourceType<Texture2D>("content/meshes/gun/Textures/Cerberus_N.tga", false, true, true);
 		//Texture2DPtr albedo = DataManager::RequestResourceType<Texture2D>("content/meshes/uv_base.png", false, true, false);
-		Texture2DPtr white = DataManager::RequestResourceType<Texture2D>("content/textures/white.png", false, true, false);
-		Texture2DPtr red = DataManager::RequestResourceType<Texture2D>("content/textures/red.png", false, true, false);
-		Texture2DPtr green = DataManager::RequestResourceType<Texture2D>("content/textures/green.png", false, true, false);
-		Texture2DPtr albedo = DataManager::RequestResourceType<Texture2D>("content/meshes/root/Aset_wood_root_M_rkswd_4K_Albedo.jpg", false, true, false, true);
-		Texture2DPtr normal = DataManager::RequestResourceType<Texture2D>("content/meshes/root/Aset_wood_root_M_rkswd_4K_Normal_LOD0.jpg", false, true, true, true);
-		Texture2DPtr flatNormal = DataManager::RequestResourceType<Texture2D>("content/textures/normals_flat.png", false, true, true, true);
-		tl->PushImage(white);
-		tl->PushImage(red);
-		tl->PushImage(green);
-		tl->PushImage(albedo);
-		tl->PushImage(normal);
-		tl->PushImage(flatNormal);
+		// decoded or cooked on the workers meanwhile, the scene joins each request where it needs the resource
+		DataManager* dataManager = DataManager::GetInstance();
+		ResourceRequest<Texture2D> whiteRequest = DataManager::RequestResourceTypeAsync<Texture2D>("content/textures/white.png", false, true, false);
+		ResourceRequest<Texture2D> redRequest = DataManager::RequestResourceTypeAsync<Texture2D>("content/textures/red.png", false, true, false);
+		ResourceRequest<Texture2D> greenRequest = DataManager::RequestResourceTypeAsync<Texture2D>("content/textures/green.png", false, true, false);
+		ResourceRequest<Texture2D> albedoRequest = DataManager::RequestResourceTypeAsync<Texture2D>("content/meshes/root/Aset_wood_root_M_rkswd_4K_Albedo.jpg", false, true, false, true);
+		ResourceRequest<Texture2D> normalRequest = DataManager::RequestResourceTypeAsync<Texture2D>("content/meshes/root/Aset_wood_root_M_rkswd_4K_Normal_LOD0.jpg", false, true, true, true);
+		ResourceRequest<Texture2D> flatNormalRequest = DataManager::RequestResourceTypeAsync<Texture2D>("content/textures/normals_flat.png", false, true, true, true);
+		ResourceRequest<ImportedMesh> woodRequest = DataManager::RequestResourceTypeAsync<ImportedMesh>("./content/meshes/root/Aset_wood_root_M_rkswd_LOD0.FBX", false, 4u);
+		// images are pushed to the transfer list by the requests themselves
+		Texture2DPtr white = dataManager->CompleteRequest(whiteRequest);
+		Texture2DPtr red = dataManager->CompleteRequest(redRequest);
+		Texture2DPtr green = dataManager->CompleteRequest(greenRequest);
+		Texture2DPtr albedo = dataManager->CompleteRequest(albedoRequest);
+		Texture2DPtr normal = dataManager->CompleteRequest(normalRequest);
+		Texture2DPtr flatNormal = dataManager->CompleteRequest(flatNormalRequest);
 	
 		//------------------------------------------------------------------------------------------------------------------------------------------------------
 		//------------------------------------------------------------------------------------------------------------------------------------------------------
 		// materials
+		// gbuffer materials are bindless, a block of two texture indices
+		MaterialParameterLayoutPtr gbufferLayout = std::make_shared<MaterialParameterLayout>(MaterialParameterLayout().AddTexture("albedo").AddTexture("normal"));
 
 		MaterialPtr mat = DataManager::RequestResourceType<Material>(
 			"default",
 			"content/shaders/GBufferVert.spv",
 			"content/shaders/GBufferFrag.spv"
 			);
+		mat->SetParameterLayout(gbufferLayout);
 		mat->SetTexture("albedo", white);
 		mat->SetTexture("normal", flatNormal);
 		mat->LoadResources();
@@ -180,6 +208,7 @@ namespace CGE
 			"content/shaders/GBufferVert.spv",
 			"content/shaders/GBufferFrag.spv"
 			);
+		woodMat->SetParameterLayout(gbufferLayout);
 		woodMat->SetTexture("albedo", albedo);
 		woodMat->SetTexture("normal", normal);
 		woodMat->LoadResources();
@@ -189,6 +218,7 @@ namespace CGE
 			"content/shaders/GBufferVert.spv",
 			"content/shaders/GBufferFrag.spv"
 			);
+		mat_red->SetParameterLayout(gbufferLayout);
 		mat_red->SetTexture("albedo", red);
 		mat_red->SetTexture("normal", normal);
 		mat_red->LoadResources();
@@ -198,6 +228,7 @@ namespace CGE
 			"content/shaders/GBufferVert.spv",
 			"content/shaders/GBufferFrag.spv"
 			);
+		mat_green->SetParameterLayout(gbufferLayout);
 		mat_green->SetTexture("albedo", green);
 		mat_green->SetTexture("normal", normal);
 		mat_green->LoadResources();
@@ -269,11 +300,13 @@ namespace CGE
 	
 		{
 			RtMaterialPtr rtMat1 = DataManager::RequestResourceType<RtMaterial>("rt_mat1");
-			rtMat1->SetShader(ERtShaderType::RST_CLOSEST_HIT, "content/shaders/RayClosestHitDefault1.spv", "main");
+			rtMat1->SetShader(ERtShaderType::RST_CLOSEST_HIT, "content/shaders/RayClosestHitDefault.spv", "main");
 			rtMat1->LoadResources();
 
 			RtMaterialPtr rtMat2 = DataManager::RequestResourceType<RtMaterial>("rt_mat2");
-			rtMat2->SetShader(ERtShaderType::RST_CLOSEST_HIT, "content/shaders/RayClosestHitDefault2.spv", "main");
+			rtMat2->SetShader(ERtShaderType::RST_CLOSEST_HIT, "content/shaders/RayClosestHitDefault.spv", "main");
+			rtMat2->SetFeature("HIT_COLOR_R", 0.0f);
+			rtMat2->SetFeature("HIT_COLOR_G", 1.0f);
 			rtMat2->LoadResources();
 
 			//{
@@ -291,15 +324,13 @@ namespace CGE
 			//}
 
 			{
-				MeshImporter woodImporter;
 				//importer.Import("./content/meshes/gun/Cerberus_LP.FBX");
-				woodImporter.Import("./content/meshes/root/Aset_wood_root_M_rkswd_LOD0.FBX");
 				//importer.Import("./content/meshes/cube/cube.fbx");
 				//importer.Import("./content/meshes/rooms/room_01.fbx");
-				for (unsigned int MeshIndex = 0; MeshIndex < woodImporter.GetMeshes().size(); MeshIndex++)
+				ImportedMeshPtr woodMesh = dataManager->CompleteRequest(woodRequest);
+				for (unsigned int MeshIndex = 0; woodMesh && (MeshIndex < woodMesh->GetLodSets().size()); MeshIndex++)
 				{
-					MeshDataPtr meshData = woodImporter.GetMeshes()[MeshIndex];
-					meshData->CreateBuffer();
+					MeshLodSetPtr lodSet = woodMesh->GetLodSets()[MeshIndex];
 
 					float width = 500.0f;
 					float depth = 500.0f;
@@ -313,7 +344,7 @@ namespace CGE
 							float randomZ = std::rand() / float(RAND_MAX);
 
 							MeshObjectPtr mo3 = ObjectBase::NewObject<MeshObject>();
-							mo3->GetMeshComponent()->meshData = meshData;
+							mo3->GetMeshComponent()->SetLodSet(lodSet);
 							mo3->transform.SetLocation({ -width * 0.5f + (indexX * width / float(countX - 1)), -5.0f, -1.0 * indexY * depth / float(countY - 1) });
 							//mo3->transform.SetLocation({ 0.0f, 0.0f, 0.0f });
 							mo3->transform.SetRotation({ randomZ * 180.0f, 0.0f, 90.0 });
@@ -363,6 +394,18 @@ namespace CGE
 			m_sceneTree->AddObject(objPtr);
 		}
 		m_sceneTree->Update();
+
+		// pipelines of every material known by now are compiled ahead instead of on their first draw
+		std::vector<MaterialPtr> materials;
+		std::set<HashString> materialHashes;
+		for (MeshComponentPtr meshComponent : GetSceneComponentsCast<MeshComponent>())
+		{
+			if (meshComponent->material && materialHashes.insert(meshComponent->material->GetHash()).second)
+			{
+				materials.push_back(meshComponent->material);
+			}
+		}
+		renderer->CompilePipelines(materials);
 	}
 
 	//-----------------------------------------------------------------------------------------------------------------
@@ -408,15 +451,37 @@ namespace CGE
 		m_shadersList.clear();
 		m_shaderToMaterial.clear();
 		m_materialToMeshData.clear();
+		m_materialToGpuMeshData.clear();
 		m_matToMeshToTransform.clear();
+		m_matToMeshToGpuTransform.clear();
 		m_materialToMeshDataToIndex.clear();
+		m_matToMeshToDrawRanges.clear();
 	
+		m_drawnTriangleCount = 0;
+
+		// bindless materials on pooled meshes go to the gpu culling, instances past its capacity stay on the cpu path
+		bool gpuDriven = Engine::GetRendererInstance()->IsGpuDrivenDraws();
+		uint32_t gpuInstanceCount = 0;
+		std::unordered_set<HashString> gpuShaders;
+
+		uint64_t frame = Engine::GetInstance()->GetFrameCount();
+		CameraComponentPtr camera = GetSceneComponent<CameraComponent>(m_primaryPack);
+		glm::vec3 viewLocation = camera->GetParent()->transform.GetLocation();
+		float projectionScale = MeshLodSet::GetProjectionScale(camera->GetFov(), static_cast<float>(Engine::GetRendererInstance()->GetHeight()));
+		MeshletCuller meshletCuller(camera->CalculateProjectionMatrix() * camera->CalculateViewMatrix(), viewLocation, m_occlusionDepth);
+
 		const Class& meshDataClass = Class::Get<MeshComponent>();
 		std::vector<MeshComponentPtr> meshes = GetSceneComponentsCast<MeshComponent>(m_frustumPack);
 		for (MeshComponentPtr meshComponent : meshes)
 		{
+			auto& transform = meshComponent->GetParent()->transform;
+			MatrixPair pair;
+			pair.previousMatrix = transform.GetMemorizedTransformMatrix();
+			pair.matrix = transform.CalculateMatrix();
+
 			MaterialPtr material = meshComponent->material;
-			MeshDataPtr meshData = meshComponent->meshData;
+			MeshDataPtr meshData = meshComponent->SelectMeshData(pair.matrix, viewLocation, projectionScale);
+			RequestStreamedTextures(meshComponent, pair.matrix, viewLocation, projectionScale, frame);
 
 			HashString shaderHash = material->GetShaderHash();
 			HashString materialId = material->GetResourceId();
@@ -426,37 +491,100 @@ namespace CGE
 			{
 				m_shadersList.push_back(shaderHash);
 			}
-			if (m_materialToMeshData.find(materialId) == m_materialToMeshData.end())
+			if ((m_matToMeshToTransform.find(materialId) == m_matToMeshToTransform.end()) && (m_matToMeshToGpuTransform.find(materialId) == m_matToMeshToGpuTransform.end()))
 			{
 				m_shaderToMaterial[shaderHash].push_back(material);
+				material->UpdateStreamedTextures(frame);
 			}
-			if (m_matToMeshToTransform[materialId].find(meshDataId) == m_matToMeshToTransform[materialId].end())
+
+			// decided per instance, one that would overflow the culling buffers or need a batch past the last one stays on the cpu path
+			uint32_t gpuCost = meshData->HasMeshlets() ? static_cast<uint32_t>(meshData->GetMeshlets().size()) : 1;
+			bool gpuDrawn = gpuDriven && material->IsBindless() && meshData->IsInGeometryPool()
+				&& (gpuInstanceCount + gpuCost <= g_GpuDrawInstancesSize)
+				&& ((gpuShaders.find(shaderHash) != gpuShaders.end()) || (gpuShaders.size() < g_GpuDrawBatchesSize));
+			if (gpuDrawn)
 			{
-				m_materialToMeshData[materialId].push_back(meshData);
+				std::vector<MatrixPair>& gpuTransforms = m_matToMeshToGpuTransform[materialId][meshDataId];
+				if (gpuTransforms.empty())
+				{
+					m_materialToGpuMeshData[materialId].push_back(meshData);
+				}
+				gpuTransforms.emplace_back(pair);
+				gpuShaders.insert(shaderHash);
+				// upper bound, the culling pass drops its share on the gpu
+				gpuInstanceCount += gpuCost;
+				m_drawnTriangleCount += meshData->GetIndexCount() / 3;
+			}
+			else
+			{
+				// the instance keeps its transform slot even with every meshlet culled, motion vectors need the previous matrix
+				std::vector<MatrixPair>& meshTransforms = m_matToMeshToTransform[materialId][meshDataId];
+				if (meshTransforms.empty())
+				{
+					m_materialToMeshData[materialId].push_back(meshData);
+				}
+				if (meshData->HasMeshlets())
+				{
+					std::vector<MeshDrawRange>& drawRanges = m_matToMeshToDrawRanges[materialId][meshDataId];
+					size_t firstRange = drawRanges.size();
+					meshletCuller.Cull(meshData->GetMeshlets(), pair.matrix, static_cast<uint32_t>(meshTransforms.size()), drawRanges);
+					for (size_t rangeIndex = firstRange; rangeIndex < drawRanges.size(); rangeIndex++)
+					{
+						m_drawnTriangleCount += drawRanges[rangeIndex].indexCount / 3;
+					}
+				}
+				else
+				{
+					m_drawnTriangleCount += meshData->GetIndexCount() / 3;
+				}
+				meshTransforms.emplace_back(pair);
 			}
-
-			auto& transform = meshComponent->GetParent()->transform;
-			MatrixPair pair;
-			pair.previousMatrix = transform.GetMemorizedTransformMatrix();
-			pair.matrix = transform.CalculateMatrix();
-
-			m_matToMeshToTransform[materialId][meshDataId].emplace_back(pair);
 
 			transform.MemorizeTransformMatrix();
 		}
+		m_meshletCullStats = meshletCuller.GetStats();
 
+		m_drawCommands.Clear();
+		m_shaderToDrawBatch.clear();
 		uint32_t counter = 0;
 		for (HashString& shaderHash : m_shadersList)
 		{
 			for (MaterialPtr material : m_shaderToMaterial[shaderHash])
 			{
-				for (MeshDataPtr meshData : m_materialToMeshData[material->GetResourceId()])
+				HashString materialId = material->GetResourceId();
+				uint32_t materialIndex = material->IsBindless() ? material->GetBindlessIndex() : 0;
+				for (MeshDataPtr meshData : m_materialToMeshData[materialId])
 				{
-					m_materialToMeshDataToIndex[material->GetResourceId()][meshData->GetResourceId()] = counter;
-					for (auto& matrixPair : m_matToMeshToTransform[material->GetResourceId()][meshData->GetResourceId()])
+					m_materialToMeshDataToIndex[materialId][meshData->GetResourceId()] = counter;
+					for (auto& matrixPair : m_matToMeshToTransform[materialId][meshData->GetResourceId()])
 					{
 						m_modelMatrices[counter] = matrixPair.matrix;
 						m_previousModelMatrices[counter] = matrixPair.previousMatrix;
+						m_transformMaterialIndices[counter] = materialIndex;
+						++counter;
+					}
+				}
+				// every instance is a draw command of its own, the first instance of the command is the transform slot
+				for (MeshDataPtr meshData : m_materialToGpuMeshData[materialId])
+				{
+					if (m_shaderToDrawBatch.find(shaderHash) == m_shaderToDrawBatch.end())
+					{
+						m_shaderToDrawBatch[shaderHash] = m_drawCommands.BeginBatch();
+					}
+					GeometryRange range = meshData->GetPoolRange();
+					for (auto& matrixPair : m_matToMeshToGpuTransform[materialId][meshData->GetResourceId()])
+					{
+						m_modelMatrices[counter] = matrixPair.matrix;
+						m_previousModelMatrices[counter] = matrixPair.previousMatrix;
+						m_transformMaterialIndices[counter] = materialIndex;
+						if (meshData->HasMeshlets())
+						{
+							m_drawCommands.AddMeshlets(meshData->GetMeshlets(), range.firstIndex, static_cast<int32_t>(range.firstVertex), counter);
+						}
+						else
+						{
+							m_drawCommands.AddMesh(range.firstIndex, range.indexCount, static_cast<int32_t>(range.firstVertex), meshData->GetBoundingSphere(), counter);
+						}
 						++counter;
 					}
 				}
@@ -12,6 +12,8 @@
 #include "common/HashString.h"
 #include "glm/fwd.hpp"
 #include "glm/detail/type_mat4x4.hpp"
+#include "scene/mesh/MeshletCuller.h"
+#include "render/DrawCommandBuilder.h"
 
 namespace CGE
 {
@@ -98,9 +100,23 @@ namespace CGE
 		inline std::unordered_map<HashString, std::vector<MeshDataPtr>>& GetMaterialToMeshData() { return m_materialToMeshData; }
 		inline std::unordered_map<HashString, std::vector<MatrixPair>>& GetMeshDataToTransform(const HashString& materialId) { return m_matToMeshToTransform[materialId]; }
 		inline std::unordered_map<HashString, uint32_t>& GetMeshDataToIndex(const HashString& materialId) { return m_materialToMeshDataToIndex[materialId]; }
+		// visible meshlet ranges of meshes carrying meshlets, meshes missing here are drawn whole and instanced
+		inline std::unordered_map<HashString, std::vector<MeshDrawRange>>& GetMeshDataToDrawRanges(const HashString& materialId) { return m_matToMeshToDrawRanges[materialId]; }
 		inline std::vector<glm::mat4>& GetModelMatrices() { return m_modelMatrices; }
 		inline std::vector<glm::mat4>& GetPreviousModelMatrices() { return m_previousModelMatrices; }
+		// bindless material index per transform slot, 0 for materials with their own sets
+		inline std::vector<uint32_t>& GetTransformMaterialIndices() { return m_transformMaterialIndices; }
+		// bindless materials on pooled meshes when the renderer draws on the gpu, instances past the culling capacity stay in GetMaterialToMeshData
+		inline std::unordered_map<HashString, std::vector<MeshDataPtr>>& GetMaterialToGpuMeshData() { return m_materialToGpuMeshData; }
+		// culling instances of gpu drawn meshes, a batch per shader
+		inline const DrawCommandBuilder& GetDrawCommands() { return m_drawCommands; }
+		inline std::unordered_map<HashString, uint32_t>& GetShaderToDrawBatch() { return m_shaderToDrawBatch; }
 		inline uint32_t GetRelevantMatricesCount() { return m_relevantMatricesCount; }
+		// triangles of the selected lods over all instances in frustum, culled meshlets excluded
+		inline uint64_t GetDrawnTriangleCount() { return m_drawnTriangleCount; }
+		inline const MeshletCullStats& GetMeshletCullStats() { return m_meshletCullStats; }
+		// depth of an earlier frame for meshlet occlusion culling, null disables it
+		inline void SetOcclusionDepth(DepthPyramidPtr inDepthPyramid) { m_occlusionDepth = inDepthPyramid; }
 	
 		void PerFrameUpdate();
 
@@ -128,11 +144,20 @@ namespace CGE
 		std::vector<HashString> m_shadersList;
 		std::unordered_map<HashString, std::vector<MaterialPtr>> m_shaderToMaterial;
 		std::unordered_map<HashString, std::vector<MeshDataPtr>> m_materialToMeshData;
+		std::unordered_map<HashString, std::vector<MeshDataPtr>> m_materialToGpuMeshData;
 		std::unordered_map<HashString, std::unordered_map<HashString, std::vector<MatrixPair>>> m_matToMeshToTransform;
+		std::unordered_map<HashString, std::unordered_map<HashString, std::vector<MatrixPair>>> m_matToMeshToGpuTransform;
 		std::unordered_map<HashString, std::unordered_map<HashString, uint32_t>> m_materialToMeshDataToIndex;
+		std::unordered_map<HashString, std::unordered_map<HashString, std::vector<MeshDrawRange>>> m_matToMeshToDrawRanges;
 		std::vector<glm::mat4> m_modelMatrices;
 		std::vector<glm::mat4> m_previousModelMatrices;
+		std::vector<uint32_t> m_transformMaterialIndices;
 		uint32_t m_relevantMatricesCount;
+		DrawCommandBuilder m_drawCommands;
+		std::unordered_map<HashString, uint32_t> m_shaderToDrawBatch;
+		uint64_t m_drawnTriangleCount = 0;
+		DepthPyramidPtr m_occlusionDepth;
+		MeshletCullStats m_meshletCullStats;
 
 		void GatherObjectsInFrustum();
 
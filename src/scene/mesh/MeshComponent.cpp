@@ -35,6 +35,21 @@ namespace CGE
 		meshData = inMeshData;
 	}
 	
+	void MeshComponent::SetLodSet(MeshLodSetPtr inLodSet)
+	{
+		lodSet = inLodSet;
+		meshData = lodSet->GetLod(0).meshData;
+	}
+
+	MeshDataPtr MeshComponent::SelectMeshData(const glm::mat4& inTransform, const glm::vec3& inViewLocation, float inProjectionScale)
+	{
+		if (!lodSet)
+		{
+			return meshData;
+		}
+		return lodSet->GetLod(lodSet->SelectLod(inTransform, inViewLocation, inProjectionScale)).meshData;
+	}
+	
 	void MeshComponent::SetMaterial(MaterialPtr inMaterial)
 	{
 		material = inMaterial;
@@ -3,6 +3,7 @@
 #include "scene/SceneObjectComponent.h"
 #include <vector>
 #include "data/MeshData.h"
+#include "data/MeshLodSet.h"
 #include "data/Material.h"
 #include "data/RtMaterial.h"
 
@@ -12,6 +13,8 @@ namespace CGE
 	{
 	public:
 		MeshDataPtr meshData;
+		// optional, meshData stays the full detail level used for ray tracing
+		MeshLodSetPtr lodSet;
 		MaterialPtr material;
 		RtMaterialPtr rtMaterial;
 		bool castShadows = true;
@@ -20,6 +23,9 @@ namespace CGE
 		virtual ~MeshComponent();
 	
 		void SetMeshData(MeshDataPtr inMeshData);
+		void SetLodSet(MeshLodSetPtr inLodSet);
+		// mesh to rasterize for the given view, falls back to meshData without a lod set
+		MeshDataPtr SelectMeshData(const glm::mat4& inTransform, const glm::vec3& inViewLocation, float inProjectionScale);
 		void SetMaterial(MaterialPtr inMaterial);
 		void SetRtMaterial(RtMaterialPtr inRtMaterial);
 	
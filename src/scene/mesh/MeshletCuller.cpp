@@ -0,0 +1,214 @@
+#include "scene/mesh/MeshletCuller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace CGE
+{
+	namespace
+	{
+		// relative difference of the transform axis lengths still treated as uniform scale
+		static constexpr float UNIFORM_SCALE_TOLERANCE = 0.01f;
+		static constexpr float MIN_CLIP_W = 1e-5f;
+
+		// Gribb and Hartmann extraction for [0, 1] clip depth, planes of a model view projection are in model space
+		void ExtractPlanes(const glm::mat4& inMatrix, glm::vec4* outPlanes)
+		{
+			glm::vec4 rows[4];
+			for (uint32_t row = 0; row < 4; row++)
+			{
+				rows[row] = glm::vec4(inMatrix[0][row], inMatrix[1][row], inMatrix[2][row], inMatrix[3][row]);
+			}
+			outPlanes[0] = rows[3] + rows[0];
+			outPlanes[1] = rows[3] - rows[0];
+			outPlanes[2] = rows[3] + rows[1];
+			outPlanes[3] = rows[3] - rows[1];
+			outPlanes[4] = rows[2];
+			outPlanes[5] = rows[3] - rows[2];
+			for (uint32_t plane = 0; plane < 6; plane++)
+			{
+				outPlanes[plane] /= glm::length(glm::vec3(outPlanes[plane]));
+			}
+		}
+
+		bool IsSphereInPlanes(const glm::vec4* inPlanes, const glm::vec3& inCenter, float inRadius)
+		{
+			for (uint32_t plane = 0; plane < 6; plane++)
+			{
+				if (glm::dot(glm::vec3(inPlanes[plane]), inCenter) + inPlanes[plane].w < -inRadius)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// facing is only preserved by rotation, translation and uniform scale, mirroring flips the winding
+		bool IsSimilarityTransform(const glm::mat4& inTransform)
+		{
+			glm::mat3 basis(inTransform);
+			float scaleX = glm::length(basis[0]);
+			float scaleY = glm::length(basis[1]);
+			float scaleZ = glm::length(basis[2]);
+			float maxScale = std::max(scaleX, std::max(scaleY, scaleZ));
+			float minScale = std::min(scaleX, std::min(scaleY, scaleZ));
+			return (glm::determinant(basis) > 0.0f) && (maxScale - minScale <= maxScale * UNIFORM_SCALE_TOLERANCE);
+		}
+
+		bool IsConeBackfacing(const Meshlet& inMeshlet, const glm::vec3& inViewLocation)
+		{
+			glm::vec3 offset = inMeshlet.center - inViewLocation;
+			return glm::dot(offset, inMeshlet.coneAxis) >= inMeshlet.coneCutoff * glm::length(offset) + inMeshlet.radius;
+		}
+	}
+
+	void MeshletCullStats::Append(const MeshletCullStats& inOther)
+	{
+		testedMeshlets += inOther.testedMeshlets;
+		frustumCulled += inOther.frustumCulled;
+		coneCulled += inOther.coneCulled;
+		occlusionCulled += inOther.occlusionCulled;
+		drawRanges += inOther.drawRanges;
+	}
+
+	void DepthPyramid::Build(const float* inDepth, uint32_t inWidth, uint32_t inHeight, const glm::mat4& inViewProjection)
+	{
+		m_levels.clear();
+		m_viewProjection = inViewProjection;
+		if ((inWidth == 0) || (inHeight == 0))
+		{
+			return;
+		}
+
+		m_levels.push_back({ inWidth, inHeight, std::vector<float>(inDepth, inDepth + static_cast<size_t>(inWidth) * inHeight) });
+		while ((m_levels.back().width > 1) || (m_levels.back().height > 1))
+		{
+			const Level& source = m_levels.back();
+			Level level = { (source.width + 1) / 2, (source.height + 1) / 2, {} };
+			level.depth.resize(static_cast<size_t>(level.width) * level.height);
+			// odd edges are clamped, so every source texel lands in exactly the texel at half its coordinates
+			for (uint32_t y = 0; y < level.height; y++)
+			{
+				uint32_t sourceY0 = y * 2;
+				uint32_t sourceY1 = std::min(sourceY0 + 1, source.height - 1);
+				for (uint32_t x = 0; x < level.width; x++)
+				{
+					uint32_t sourceX0 = x * 2;
+					uint32_t sourceX1 = std::min(sourceX0 + 1, source.width - 1);
+					level.depth[static_cast<size_t>(y) * level.width + x] = std::max(
+						std::max(source.depth[static_cast<size_t>(sourceY0) * source.width + sourceX0], source.depth[static_cast<size_t>(sourceY0) * source.width + sourceX1]),
+						std::max(source.depth[static_cast<size_t>(sourceY1) * source.width + sourceX0], source.depth[static_cast<size_t>(sourceY1) * source.width + sourceX1]));
+				}
+			}
+			m_levels.push_back(std::move(level));
+		}
+	}
+
+	bool DepthPyramid::IsOccluded(const glm::vec2& inUvMin, const glm::vec2& inUvMax, float inNearestDepth) const
+	{
+		if (m_levels.empty())
+		{
+			return false;
+		}
+
+		// texel rect on the full resolution level, a level down halves the coordinates
+		const Level& base = m_levels[0];
+		glm::vec2 size(static_cast<float>(base.width), static_cast<float>(base.height));
+		glm::vec2 texelMin = glm::clamp(glm::floor(inUvMin * size), glm::vec2(0.0f), size - 1.0f);
+		glm::vec2 texelMax = glm::clamp(glm::floor(inUvMax * size), glm::vec2(0.0f), size - 1.0f);
+		float extent = std::max(texelMax.x - texelMin.x, texelMax.y - texelMin.y) + 1.0f;
+		uint32_t levelIndex = std::min(static_cast<uint32_t>(std::ceil(std::log2(extent))), GetLevelCount() - 1);
+
+		const Level& level = m_levels[levelIndex];
+		uint32_t x0 = static_cast<uint32_t>(texelMin.x) >> levelIndex;
+		uint32_t x1 = static_cast<uint32_t>(texelMax.x) >> levelIndex;
+		uint32_t y0 = static_cast<uint32_t>(texelMin.y) >> levelIndex;
+		uint32_t y1 = static_cast<uint32_t>(texelMax.y) >> levelIndex;
+		float farthest = 0.0f;
+		for (uint32_t y = y0; y <= y1; y++)
+		{
+			for (uint32_t x = x0; x <= x1; x++)
+			{
+				farthest = std::max(farthest, level.depth[static_cast<size_t>(y) * level.width + x]);
+			}
+		}
+		return inNearestDepth > farthest;
+	}
+
+	MeshletCuller::MeshletCuller(const glm::mat4& inViewProjection, const glm::vec3& inViewLocation, DepthPyramidPtr inDepthPyramid /*= nullptr*/)
+		: m_viewProjection(inViewProjection)
+		, m_viewLocation(inViewLocation)
+		, m_depthPyramid(inDepthPyramid && inDepthPyramid->IsValid() ? inDepthPyramid : nullptr)
+	{
+	}
+
+	void MeshletCuller::Cull(const std::vector<Meshlet>& inMeshlets, const glm::mat4& inTransform, uint32_t inInstance, std::vector<MeshDrawRange>& outRanges)
+	{
+		glm::vec4 planes[6];
+		ExtractPlanes(m_viewProjection * inTransform, planes);
+		bool testCones = IsSimilarityTransform(inTransform);
+		glm::vec3 localViewLocation = glm::vec3(glm::inverse(inTransform) * glm::vec4(m_viewLocation, 1.0f));
+		glm::mat4 pyramidTransform = m_depthPyramid ? m_depthPyramid->GetViewProjection() * inTransform : glm::mat4(1.0f);
+
+		// ranges from a previous instance or mesh are never extended
+		size_t firstRange = outRanges.size();
+		for (const Meshlet& meshlet : inMeshlets)
+		{
+			m_stats.testedMeshlets++;
+			if (!IsSphereInPlanes(planes, meshlet.center, meshlet.radius))
+			{
+				m_stats.frustumCulled++;
+				continue;
+			}
+			if (testCones && IsConeBackfacing(meshlet, localViewLocation))
+			{
+				m_stats.coneCulled++;
+				continue;
+			}
+			if (m_depthPyramid && IsOccluded(meshlet, pyramidTransform))
+			{
+				m_stats.occlusionCulled++;
+				continue;
+			}
+
+			if ((outRanges.size() > firstRange) && (outRanges.back().firstIndex + outRanges.back().indexCount == meshlet.firstIndex))
+			{
+				outRanges.back().indexCount += meshlet.triangleCount * 3;
+				continue;
+			}
+			outRanges.push_back({ meshlet.firstIndex, meshlet.triangleCount * 3, inInstance });
+			m_stats.drawRanges++;
+		}
+	}
+
+	// screen rect and nearest depth of the sphere bounding box, anything crossing the near plane is kept
+	bool MeshletCuller::IsOccluded(const Meshlet& inMeshlet, const glm::mat4& inPyramidTransform) const
+	{
+		glm::vec2 uvMin(std::numeric_limits<float>::max());
+		glm::vec2 uvMax(std::numeric_limits<float>::lowest());
+		float nearestDepth = std::numeric_limits<float>::max();
+		for (uint32_t corner = 0; corner < 8; corner++)
+		{
+			glm::vec3 offset(
+				(corner & 1) ? inMeshlet.radius : -inMeshlet.radius,
+				(corner & 2) ? inMeshlet.radius : -inMeshlet.radius,
+				(corner & 4) ? inMeshlet.radius : -inMeshlet.radius);
+			glm::vec4 clip = inPyramidTransform * glm::vec4(inMeshlet.center + offset, 1.0f);
+			if (clip.w < MIN_CLIP_W)
+			{
+				return false;
+			}
+			glm::vec3 ndc = glm::vec3(clip) / clip.w;
+			glm::vec2 uv = glm::vec2(ndc) * 0.5f + 0.5f;
+			uvMin = glm::min(uvMin, uv);
+			uvMax = glm::max(uvMax, uv);
+			nearestDepth = std::min(nearestDepth, ndc.z);
+		}
+		if ((uvMax.x < 0.0f) || (uvMax.y < 0.0f) || (uvMin.x > 1.0f) || (uvMin.y > 1.0f) || (nearestDepth < 0.0f))
+		{
+			return false;
+		}
+		return m_depthPyramid->IsOccluded(uvMin, uvMax, nearestDepth);
+	}
+}
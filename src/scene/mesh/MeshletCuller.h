@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "data/Meshlet.h"
+
+namespace CGE
+{
+	// one indexed draw of a mesh index range for one instance, instance is relative to the mesh transform offset
+	struct MeshDrawRange
+	{
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		uint32_t instance;
+	};
+
+	struct MeshletCullStats
+	{
+		uint64_t testedMeshlets = 0;
+		uint64_t frustumCulled = 0;
+		uint64_t coneCulled = 0;
+		uint64_t occlusionCulled = 0;
+		uint64_t drawRanges = 0;
+
+		uint64_t GetVisibleMeshlets() const { return testedMeshlets - frustumCulled - coneCulled - occlusionCulled; }
+		void Append(const MeshletCullStats& inOther);
+	};
+
+	// Max reduced depth mips of an already rendered frame together with the view projection it was rendered
+	// with. Depth is expected in [0, 1] with 1 at the far plane.
+	class DepthPyramid
+	{
+	public:
+		void Build(const float* inDepth, uint32_t inWidth, uint32_t inHeight, const glm::mat4& inViewProjection);
+
+		bool IsValid() const { return !m_levels.empty(); }
+		uint32_t GetLevelCount() const { return static_cast<uint32_t>(m_levels.size()); }
+		const glm::mat4& GetViewProjection() const { return m_viewProjection; }
+		// true when every texel under the uv rect is closer than inNearestDepth
+		bool IsOccluded(const glm::vec2& inUvMin, const glm::vec2& inUvMax, float inNearestDepth) const;
+	private:
+		struct Level
+		{
+			uint32_t width;
+			uint32_t height;
+			std::vector<float> depth;
+		};
+
+		std::vector<Level> m_levels;
+		glm::mat4 m_viewProjection = glm::mat4(1.0f);
+	};
+
+	typedef std::shared_ptr<DepthPyramid> DepthPyramidPtr;
+
+	// Frustum, backface cone and optional depth pyramid tests of meshlets for one view. Frustum and cone run
+	// in mesh space, so bounds are never transformed.
+	class MeshletCuller
+	{
+	public:
+		MeshletCuller(const glm::mat4& inViewProjection, const glm::vec3& inViewLocation, DepthPyramidPtr inDepthPyramid = nullptr);
+
+		// appends draw ranges of the visible meshlets, neighbouring ones are merged into one range
+		void Cull(const std::vector<Meshlet>& inMeshlets, const glm::mat4& inTransform, uint32_t inInstance, std::vector<MeshDrawRange>& outRanges);
+		const MeshletCullStats& GetStats() const { return m_stats; }
+	private:
+		glm::mat4 m_viewProjection;
+		glm::vec3 m_viewLocation;
+		DepthPyramidPtr m_depthPyramid;
+		MeshletCullStats m_stats;
+
+		bool IsOccluded(const Meshlet& inMeshlet, const glm::mat4& inPyramidTransform) const;
+	};
+}
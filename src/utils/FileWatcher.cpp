@@ -0,0 +1,248 @@
+#include "utils/FileWatcher.h"
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace CGE
+{
+
+	namespace
+	{
+		bool GetWriteTime(const std::string& inPath, std::filesystem::file_time_type& outTime)
+		{
+			std::error_code error;
+			outTime = std::filesystem::last_write_time(inPath, error);
+			return !error;
+		}
+	}
+
+	FileWatcher::FileWatcher()
+	{
+#ifndef _WIN32
+		m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+	}
+
+	FileWatcher::~FileWatcher()
+	{
+		for (auto& pair : m_directories)
+		{
+			CloseDirectory(pair.second);
+		}
+#ifndef _WIN32
+		if (m_inotify >= 0)
+		{
+			close(m_inotify);
+		}
+#endif
+	}
+
+	bool FileWatcher::Watch(const std::string& inPath)
+	{
+		if (m_files.find(inPath) != m_files.end())
+		{
+			return true;
+		}
+
+		WatchedFile file;
+		if (!GetWriteTime(inPath, file.writeTime))
+		{
+			return false;
+		}
+		std::error_code error;
+		file.directory = std::filesystem::absolute(inPath, error).parent_path().lexically_normal().string();
+		if (error)
+		{
+			return false;
+		}
+		file.pendingTime = file.writeTime;
+
+		auto dirIt = m_directories.find(file.directory);
+		if (dirIt == m_directories.end())
+		{
+			WatchedDirectory directory;
+			if (!OpenDirectory(file.directory, directory))
+			{
+				return false;
+			}
+			dirIt = m_directories.emplace(file.directory, directory).first;
+		}
+		dirIt->second.filesCount++;
+		m_files[inPath] = file;
+		return true;
+	}
+
+	void FileWatcher::Unwatch(const std::string& inPath)
+	{
+		auto it = m_files.find(inPath);
+		if (it == m_files.end())
+		{
+			return;
+		}
+
+		auto dirIt = m_directories.find(it->second.directory);
+		if ((dirIt != m_directories.end()) && (--dirIt->second.filesCount == 0))
+		{
+			CloseDirectory(dirIt->second);
+			m_directories.erase(dirIt);
+		}
+		m_settling.erase(std::remove(m_settling.begin(), m_settling.end(), inPath), m_settling.end());
+		m_files.erase(it);
+	}
+
+	bool FileWatcher::IsWatched(const std::string& inPath) const
+	{
+		return m_files.find(inPath) != m_files.end();
+	}
+
+	std::vector<std::string> FileWatcher::Poll()
+	{
+		ReadNotifications();
+
+		Clock::time_point now = Clock::now();
+		for (auto& pair : m_files)
+		{
+			WatchedFile& file = pair.second;
+			std::filesystem::file_time_type writeTime;
+			if (!m_directories[file.directory].dirty || !GetWriteTime(pair.first, writeTime))
+			{
+				continue;
+			}
+			if ((writeTime != file.writeTime) && (writeTime != file.pendingTime))
+			{
+				if (file.pendingTime == file.writeTime)
+				{
+					m_settling.push_back(pair.first);
+				}
+				file.pendingTime = writeTime;
+				file.pendingSince = now;
+			}
+		}
+		for (auto& pair : m_directories)
+		{
+			pair.second.dirty = false;
+		}
+
+		// still being written files are checked again every poll until the write time holds
+		std::vector<std::string> changed;
+		auto it = m_settling.begin();
+		while (it != m_settling.end())
+		{
+			WatchedFile& file = m_files[*it];
+			std::filesystem::file_time_type writeTime;
+			if (GetWriteTime(*it, writeTime) && (writeTime != file.pendingTime))
+			{
+				file.pendingTime = writeTime;
+				file.pendingSince = now;
+			}
+			else if (now - file.pendingSince >= SETTLE_TIME)
+			{
+				file.writeTime = file.pendingTime;
+				changed.push_back(*it);
+				it = m_settling.erase(it);
+				continue;
+			}
+			++it;
+		}
+		return changed;
+	}
+
+#ifdef _WIN32
+
+	bool FileWatcher::OpenDirectory(const std::string& inDirectory, WatchedDirectory& outDirectory)
+	{
+		HANDLE handle = FindFirstChangeNotificationA(inDirectory.c_str(), FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+		if (handle == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		outDirectory.handle = handle;
+		return true;
+	}
+
+	void FileWatcher::CloseDirectory(WatchedDirectory& inDirectory)
+	{
+		if (inDirectory.handle)
+		{
+			FindCloseChangeNotification(static_cast<HANDLE>(inDirectory.handle));
+			inDirectory.handle = nullptr;
+		}
+	}
+
+	void FileWatcher::ReadNotifications()
+	{
+		for (auto& pair : m_directories)
+		{
+			HANDLE handle = static_cast<HANDLE>(pair.second.handle);
+			if (WaitForSingleObject(handle, 0) == WAIT_OBJECT_0)
+			{
+				pair.second.dirty = true;
+				FindNextChangeNotification(handle);
+			}
+		}
+	}
+
+#else
+
+	bool FileWatcher::OpenDirectory(const std::string& inDirectory, WatchedDirectory& outDirectory)
+	{
+		if (m_inotify < 0)
+		{
+			return false;
+		}
+		int handle = inotify_add_watch(m_inotify, inDirectory.c_str(), IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+		if (handle < 0)
+		{
+			return false;
+		}
+		outDirectory.handle = handle;
+		return true;
+	}
+
+	void FileWatcher::CloseDirectory(WatchedDirectory& inDirectory)
+	{
+		if (inDirectory.handle >= 0)
+		{
+			inotify_rm_watch(m_inotify, inDirectory.handle);
+			inDirectory.handle = -1;
+		}
+	}
+
+	void FileWatcher::ReadNotifications()
+	{
+		if (m_inotify < 0)
+		{
+			return;
+		}
+
+		alignas(inotify_event) char buffer[4096];
+		while (true)
+		{
+			ssize_t size = read(m_inotify, buffer, sizeof(buffer));
+			if (size <= 0)
+			{
+				break;
+			}
+			for (ssize_t offset = 0; offset < size; )
+			{
+				const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+				for (auto& pair : m_directories)
+				{
+					pair.second.dirty |= pair.second.handle == event->wd;
+				}
+				offset += sizeof(inotify_event) + event->len;
+			}
+		}
+	}
+
+#endif
+
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <filesystem>
+#include <unordered_map>
+
+namespace CGE
+{
+	// Watches single files through change notifications on their directories, inotify on linux and change
+	// handles on windows. A notification only marks the directory, files are compared by write time, so
+	// editors saving through a temporary file and renaming it are fine. Polled from one thread.
+	class FileWatcher
+	{
+	public:
+		// a file is reported once its write time stopped changing for this long, half written files are skipped
+		static constexpr std::chrono::milliseconds SETTLE_TIME = std::chrono::milliseconds(200);
+
+		FileWatcher();
+		~FileWatcher();
+
+		bool Watch(const std::string& inPath);
+		void Unwatch(const std::string& inPath);
+		bool IsWatched(const std::string& inPath) const;
+		// files changed and settled since the last call
+		std::vector<std::string> Poll();
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		struct WatchedFile
+		{
+			std::string directory;
+			std::filesystem::file_time_type writeTime;
+			// write time seen by the last check and when it was seen, nothing is pending while it equals writeTime
+			std::filesystem::file_time_type pendingTime;
+			Clock::time_point pendingSince;
+		};
+
+		struct WatchedDirectory
+		{
+#ifdef _WIN32
+			void* handle = nullptr;
+#else
+			int handle = -1;
+#endif
+			uint32_t filesCount = 0;
+			bool dirty = false;
+		};
+
+		std::unordered_map<std::string, WatchedFile> m_files;
+		std::unordered_map<std::string, WatchedDirectory> m_directories;
+		std::vector<std::string> m_settling;
+#ifndef _WIN32
+		int m_inotify = -1;
+#endif
+
+		bool OpenDirectory(const std::string& inDirectory, WatchedDirectory& outDirectory);
+		void CloseDirectory(WatchedDirectory& inDirectory);
+		void ReadNotifications();
+
+		FileWatcher(const FileWatcher& inOther) = delete;
+		void operator=(const FileWatcher& inOther) = delete;
+	};
+}
@@ -0,0 +1,132 @@
+#include "utils/MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace CGE
+{
+
+	MappedFile::MappedFile()
+	{
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+#ifdef _WIN32
+
+	bool MappedFile::Open(const std::string& inPath)
+	{
+		Close();
+
+		HANDLE file = CreateFileA(inPath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		m_file = file;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || (size.QuadPart == 0))
+		{
+			Close();
+			return false;
+		}
+		m_size = static_cast<uint64_t>(size.QuadPart);
+
+		m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (m_mapping == nullptr)
+		{
+			Close();
+			return false;
+		}
+
+		m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+		if (m_data == nullptr)
+		{
+			Close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (m_data)
+		{
+			UnmapViewOfFile(m_data);
+			m_data = nullptr;
+		}
+		if (m_mapping)
+		{
+			CloseHandle(m_mapping);
+			m_mapping = nullptr;
+		}
+		if (m_file)
+		{
+			CloseHandle(m_file);
+			m_file = nullptr;
+		}
+		m_size = 0;
+	}
+
+#else
+
+	bool MappedFile::Open(const std::string& inPath)
+	{
+		Close();
+
+		m_file = open(inPath.c_str(), O_RDONLY);
+		if (m_file < 0)
+		{
+			return false;
+		}
+
+		struct stat fileStat;
+		if ((fstat(m_file, &fileStat) != 0) || (fileStat.st_size == 0))
+		{
+			Close();
+			return false;
+		}
+		m_size = static_cast<uint64_t>(fileStat.st_size);
+
+		void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+		if (data == MAP_FAILED)
+		{
+			Close();
+			return false;
+		}
+		m_data = static_cast<const uint8_t*>(data);
+
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (m_data)
+		{
+			munmap(const_cast<uint8_t*>(m_data), m_size);
+			m_data = nullptr;
+		}
+		if (m_file >= 0)
+		{
+			close(m_file);
+			m_file = -1;
+		}
+		m_size = 0;
+	}
+
+#endif
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+namespace CGE
+{
+	// Read only memory mapped file, contents are paged in by the OS on access
+	class MappedFile
+	{
+	public:
+		MappedFile();
+		~MappedFile();
+
+		bool Open(const std::string& inPath);
+		void Close();
+
+		bool IsOpen() const { return m_data != nullptr; }
+		const uint8_t* GetData() const { return m_data; }
+		uint64_t GetSize() const { return m_size; }
+	private:
+		const uint8_t* m_data = nullptr;
+		uint64_t m_size = 0;
+#ifdef _WIN32
+		void* m_file = nullptr;
+		void* m_mapping = nullptr;
+#else
+		int m_file = -1;
+#endif
+
+		MappedFile(const MappedFile& inOther) = delete;
+		void operator=(const MappedFile& inOther) = delete;
+	};
+}
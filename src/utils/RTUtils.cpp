@@ -11,10 +11,11 @@ namespace CGE
 		vk::AccelerationStructureGeometryTrianglesDataKHR trisData;
 		trisData.setVertexFormat(vk::Format::eR32G32B32Sfloat);
 		trisData.setVertexStride(sizeof(Vertex));
-		trisData.setVertexData(meshData->GetVertexBuffer()->GetDeviceAddress());
+		// pooled meshes are a range of the shared buffers, the build reads them in place
+		trisData.setVertexData(meshData->GetVertexBuffer()->GetDeviceAddress() + static_cast<vk::DeviceAddress>(meshData->GetBaseVertex()) * sizeof(Vertex));
 		trisData.setMaxVertex(meshData->GetVertexCount());
 		trisData.setIndexType(vk::IndexType::eUint32);
-		trisData.setIndexData(meshData->GetIndexBuffer()->GetDeviceAddress());
+		trisData.setIndexData(meshData->GetIndexBuffer()->GetDeviceAddress() + static_cast<vk::DeviceAddress>(meshData->GetFirstIndex()) * sizeof(uint32_t));
 		trisData.setTransformData({}); // identity
 
 		return trisData;
@@ -87,7 +88,7 @@ namespace CGE
 		pipelineInfo.setFlags({});
 		pipelineInfo.setLayout(layout);
 
-		auto pipelineResult = Engine::GetRendererInstance()->GetDevice().createRayTracingPipelineKHR(nullptr, nullptr, pipelineInfo);
+		auto pipelineResult = Engine::GetRendererInstance()->GetDevice().createRayTracingPipelineKHR(nullptr, Engine::GetRendererInstance()->GetVulkanDevice().GetPipelineCache(), pipelineInfo);
 		if (pipelineResult.result != vk::Result::eSuccess)
 		{
 			return nullptr;
@@ -0,0 +1,103 @@
+#include "utils/RangeAllocator.h"
+#include <algorithm>
+
+namespace CGE
+{
+
+	RangeAllocator::RangeAllocator(uint64_t inCapacity, uint64_t inAlignment)
+	{
+		Reset(inCapacity, inAlignment);
+	}
+
+	void RangeAllocator::Reset(uint64_t inCapacity, uint64_t inAlignment)
+	{
+		m_alignment = std::max<uint64_t>(inAlignment, 1);
+		// a tail smaller than the alignment could never be handed out
+		m_capacity = inCapacity - inCapacity % m_alignment;
+		m_allocatedBytes = 0;
+		m_highWatermark = 0;
+		m_freeRanges.clear();
+		m_allocations.clear();
+		m_pendingRanges.clear();
+		if (m_capacity > 0)
+		{
+			m_freeRanges[0] = m_capacity;
+		}
+	}
+
+	uint64_t RangeAllocator::Allocate(uint64_t inSize)
+	{
+		uint64_t size = (std::max<uint64_t>(inSize, 1) + m_alignment - 1) / m_alignment * m_alignment;
+		for (auto it = m_freeRanges.begin(); it != m_freeRanges.end(); ++it)
+		{
+			if (it->second < size)
+			{
+				continue;
+			}
+			// offsets and sizes are all multiples of the alignment, the rest of the range stays aligned
+			uint64_t offset = it->first;
+			uint64_t rest = it->second - size;
+			m_freeRanges.erase(it);
+			if (rest > 0)
+			{
+				m_freeRanges[offset + size] = rest;
+			}
+
+			m_allocations[offset] = size;
+			m_allocatedBytes += size;
+			m_highWatermark = std::max(m_highWatermark, offset + size);
+			return offset;
+		}
+		return INVALID_OFFSET;
+	}
+
+	void RangeAllocator::Free(uint64_t inOffset, uint64_t inFrame)
+	{
+		// double frees would hand the same range out twice
+		auto it = m_allocations.find(inOffset);
+		if (it == m_allocations.end())
+		{
+			return;
+		}
+		m_allocatedBytes -= it->second;
+		m_pendingRanges.push_back({ inOffset, it->second, inFrame });
+		m_allocations.erase(it);
+	}
+
+	void RangeAllocator::Collect(uint64_t inFrame, uint64_t inLatency)
+	{
+		// frees come in frame order, the queue is sorted
+		while (!m_pendingRanges.empty() && (m_pendingRanges.front().frame + inLatency <= inFrame))
+		{
+			AddFreeRange(m_pendingRanges.front().offset, m_pendingRanges.front().size);
+			m_pendingRanges.pop_front();
+		}
+	}
+
+	uint64_t RangeAllocator::GetSize(uint64_t inOffset) const
+	{
+		auto it = m_allocations.find(inOffset);
+		return it != m_allocations.end() ? it->second : 0;
+	}
+
+	void RangeAllocator::AddFreeRange(uint64_t inOffset, uint64_t inSize)
+	{
+		auto next = m_freeRanges.lower_bound(inOffset);
+		if ((next != m_freeRanges.end()) && (inOffset + inSize == next->first))
+		{
+			inSize += next->second;
+			next = m_freeRanges.erase(next);
+		}
+		if (next != m_freeRanges.begin())
+		{
+			auto previous = std::prev(next);
+			if (previous->first + previous->second == inOffset)
+			{
+				previous->second += inSize;
+				return;
+			}
+		}
+		m_freeRanges[inOffset] = inSize;
+	}
+
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <map>
+#include <deque>
+#include <cstdint>
+#include <unordered_map>
+
+namespace CGE
+{
+	// Hands out aligned byte ranges of a fixed size buffer, first fit over free ranges merged with their
+	// neighbours. Like SlotAllocator, freed ranges come back only after a number of frames, so frames in
+	// flight never read a range that was already given to someone else.
+	class RangeAllocator
+	{
+	public:
+		static constexpr uint64_t INVALID_OFFSET = UINT64_MAX;
+
+		RangeAllocator(uint64_t inCapacity = 0, uint64_t inAlignment = 1);
+
+		// forgets all ranges, nothing allocated before may be freed afterwards
+		void Reset(uint64_t inCapacity, uint64_t inAlignment);
+		// size is rounded up to the alignment, INVALID_OFFSET when no free range is big enough
+		uint64_t Allocate(uint64_t inSize);
+		// the range comes back on the first Collect at least inLatency frames after inFrame
+		void Free(uint64_t inOffset, uint64_t inFrame);
+		void Collect(uint64_t inFrame, uint64_t inLatency);
+
+		bool IsAllocated(uint64_t inOffset) const { return m_allocations.find(inOffset) != m_allocations.end(); }
+		// aligned size of an allocated range, 0 for anything else
+		uint64_t GetSize(uint64_t inOffset) const;
+		uint64_t GetCapacity() const { return m_capacity; }
+		uint64_t GetAlignment() const { return m_alignment; }
+		uint64_t GetAllocatedBytes() const { return m_allocatedBytes; }
+		// no byte at or above this one was ever handed out
+		uint64_t GetHighWatermark() const { return m_highWatermark; }
+	private:
+		struct PendingRange
+		{
+			uint64_t offset;
+			uint64_t size;
+			uint64_t frame;
+		};
+
+		uint64_t m_capacity = 0;
+		uint64_t m_alignment = 1;
+		uint64_t m_allocatedBytes = 0;
+		uint64_t m_highWatermark = 0;
+		// offset - size, never two touching ranges
+		std::map<uint64_t, uint64_t> m_freeRanges;
+		std::unordered_map<uint64_t, uint64_t> m_allocations;
+		std::deque<PendingRange> m_pendingRanges;
+
+		void AddFreeRange(uint64_t inOffset, uint64_t inSize);
+	};
+}
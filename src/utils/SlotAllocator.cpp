@@ -0,0 +1,65 @@
+#include "utils/SlotAllocator.h"
+
+namespace CGE
+{
+
+	SlotAllocator::SlotAllocator(uint32_t inCapacity)
+	{
+		Reset(inCapacity);
+	}
+
+	void SlotAllocator::Reset(uint32_t inCapacity)
+	{
+		m_capacity = inCapacity;
+		m_nextSlot = 0;
+		m_allocatedCount = 0;
+		m_freeSlots.clear();
+		m_pendingSlots.clear();
+		m_allocated.assign(inCapacity, false);
+	}
+
+	uint32_t SlotAllocator::Allocate()
+	{
+		uint32_t slot;
+		if (!m_freeSlots.empty())
+		{
+			slot = m_freeSlots.back();
+			m_freeSlots.pop_back();
+		}
+		else if (m_nextSlot < m_capacity)
+		{
+			slot = m_nextSlot++;
+		}
+		else
+		{
+			return INVALID_SLOT;
+		}
+
+		m_allocated[slot] = true;
+		m_allocatedCount++;
+		return slot;
+	}
+
+	void SlotAllocator::Free(uint32_t inSlot, uint64_t inFrame)
+	{
+		// double frees would hand the same slot out twice
+		if (!IsAllocated(inSlot))
+		{
+			return;
+		}
+		m_allocated[inSlot] = false;
+		m_allocatedCount--;
+		m_pendingSlots.push_back({ inSlot, inFrame });
+	}
+
+	void SlotAllocator::Collect(uint64_t inFrame, uint64_t inLatency)
+	{
+		// frees come in frame order, the queue is sorted
+		while (!m_pendingSlots.empty() && (m_pendingSlots.front().frame + inLatency <= inFrame))
+		{
+			m_freeSlots.push_back(m_pendingSlots.front().slot);
+			m_pendingSlots.pop_front();
+		}
+	}
+
+}
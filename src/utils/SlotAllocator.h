@@ -0,0 +1,46 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <cstdint>
+
+namespace CGE
+{
+	// Hands out indices of a fixed size array, descriptor array elements or blocks of a buffer. Freed
+	// indices are reused only after a number of frames, so frames in flight never see a slot pointing at
+	// something else than what they were recorded with. Most recently returned slots go out first.
+	class SlotAllocator
+	{
+	public:
+		static constexpr uint32_t INVALID_SLOT = UINT32_MAX;
+
+		SlotAllocator(uint32_t inCapacity = 0);
+
+		// forgets all slots, nothing allocated before may be freed afterwards
+		void Reset(uint32_t inCapacity);
+		// INVALID_SLOT once all slots are taken or waiting
+		uint32_t Allocate();
+		// the slot comes back on the first Collect at least inLatency frames after inFrame
+		void Free(uint32_t inSlot, uint64_t inFrame);
+		void Collect(uint64_t inFrame, uint64_t inLatency);
+
+		bool IsAllocated(uint32_t inSlot) const { return (inSlot < m_allocated.size()) && m_allocated[inSlot]; }
+		uint32_t GetCapacity() const { return m_capacity; }
+		uint32_t GetAllocatedCount() const { return m_allocatedCount; }
+		// no slot at or above this one was ever handed out
+		uint32_t GetHighWatermark() const { return m_nextSlot; }
+	private:
+		struct PendingSlot
+		{
+			uint32_t slot;
+			uint64_t frame;
+		};
+
+		uint32_t m_capacity = 0;
+		uint32_t m_nextSlot = 0;
+		uint32_t m_allocatedCount = 0;
+		std::vector<uint32_t> m_freeSlots;
+		std::deque<PendingSlot> m_pendingSlots;
+		std::vector<bool> m_allocated;
+	};
+}
@@ -0,0 +1,198 @@
+#include "TestFramework.h"
+#include "import/BlockCompression.h"
+
+#include <cmath>
+#include <cstring>
+
+using namespace CGE;
+
+namespace
+{
+	static constexpr uint32_t IMAGE_SIZE = 128;
+	static constexpr uint32_t CHANNELS_COUNT = 4;
+	static constexpr float PI = 3.14159265f;
+
+	// encoder quality floors for the test images, measured values sit 2 to 3 dB above these
+	static constexpr double MIN_BC1_PSNR = 37.0;
+	static constexpr double MIN_BC4_PSNR = 50.0;
+	static constexpr double MIN_BC5_PSNR = 48.0;
+	static constexpr double MIN_BC7_PSNR = 38.0;
+
+	typedef void(*EncodeFunction)(const uint8_t*, uint8_t*);
+	typedef void(*DecodeFunction)(const uint8_t*, uint8_t*);
+
+	uint8_t ToUnorm(float inValue)
+	{
+		return static_cast<uint8_t>(std::lround(std::fmin(std::fmax(inValue, 0.0f), 1.0f) * 255.0f));
+	}
+
+	// deterministic hash noise, the same image on every platform
+	float GetNoise(uint32_t inX, uint32_t inY)
+	{
+		uint32_t hash = inX * 73856093u ^ inY * 19349663u;
+		hash = (hash ^ (hash >> 13)) * 1274126177u;
+		return static_cast<float>(hash & 0xffff) / 65535.0f;
+	}
+
+	// smooth color gradients with some waves and a bit of grain, roughly what photographed albedo looks like
+	std::vector<uint8_t> MakeAlbedo()
+	{
+		std::vector<uint8_t> pixels(IMAGE_SIZE * IMAGE_SIZE * CHANNELS_COUNT);
+		for (uint32_t y = 0; y < IMAGE_SIZE; y++)
+		{
+			for (uint32_t x = 0; x < IMAGE_SIZE; x++)
+			{
+				float u = static_cast<float>(x) / IMAGE_SIZE;
+				float v = static_cast<float>(y) / IMAGE_SIZE;
+				float wave = 0.5f + 0.5f * std::sin(u * 6.0f * PI) * std::cos(v * 4.0f * PI);
+				float grain = (GetNoise(x, y) - 0.5f) * 0.04f;
+				uint8_t* pixel = &pixels[(y * IMAGE_SIZE + x) * CHANNELS_COUNT];
+				pixel[0] = ToUnorm(0.2f + 0.6f * u + grain);
+				pixel[1] = ToUnorm(0.3f + 0.4f * wave + grain);
+				pixel[2] = ToUnorm(0.6f - 0.4f * v + grain);
+				pixel[3] = ToUnorm(0.5f + 0.5f * std::sin((u + v) * 2.0f * PI));
+			}
+		}
+		return pixels;
+	}
+
+	// tangent space normals of a bumpy surface packed to [0, 1]
+	std::vector<uint8_t> MakeNormals()
+	{
+		std::vector<uint8_t> pixels(IMAGE_SIZE * IMAGE_SIZE * CHANNELS_COUNT);
+		for (uint32_t y = 0; y < IMAGE_SIZE; y++)
+		{
+			for (uint32_t x = 0; x < IMAGE_SIZE; x++)
+			{
+				float u = static_cast<float>(x) / IMAGE_SIZE;
+				float v = static_cast<float>(y) / IMAGE_SIZE;
+				float dx = 0.4f * std::cos(u * 8.0f * PI) * std::sin(v * 2.0f * PI);
+				float dy = 0.4f * std::sin(u * 2.0f * PI) * std::cos(v * 8.0f * PI);
+				float length = std::sqrt(dx * dx + dy * dy + 1.0f);
+				uint8_t* pixel = &pixels[(y * IMAGE_SIZE + x) * CHANNELS_COUNT];
+				pixel[0] = ToUnorm(0.5f + 0.5f * dx / length);
+				pixel[1] = ToUnorm(0.5f + 0.5f * dy / length);
+				pixel[2] = ToUnorm(0.5f + 0.5f / length);
+				pixel[3] = 255;
+			}
+		}
+		return pixels;
+	}
+
+	// every block goes through the codec, inBlockChannels is 1 for single channel formats reading red
+	std::vector<uint8_t> RoundTrip(const std::vector<uint8_t>& inPixels, EncodeFunction inEncode, DecodeFunction inDecode, uint32_t inBlockChannels)
+	{
+		std::vector<uint8_t> decoded(inPixels.size(), 0);
+		uint8_t source[BlockCompression::BLOCK_PIXELS * CHANNELS_COUNT];
+		uint8_t result[BlockCompression::BLOCK_PIXELS * CHANNELS_COUNT];
+		uint8_t block[16];
+		for (uint32_t blockY = 0; blockY < IMAGE_SIZE; blockY += BlockCompression::BLOCK_DIMENSION)
+		{
+			for (uint32_t blockX = 0; blockX < IMAGE_SIZE; blockX += BlockCompression::BLOCK_DIMENSION)
+			{
+				for (uint32_t pixel = 0; pixel < BlockCompression::BLOCK_PIXELS; pixel++)
+				{
+					uint32_t x = blockX + pixel % BlockCompression::BLOCK_DIMENSION;
+					uint32_t y = blockY + pixel / BlockCompression::BLOCK_DIMENSION;
+					const uint8_t* input = &inPixels[(y * IMAGE_SIZE + x) * CHANNELS_COUNT];
+					std::memcpy(source + pixel * inBlockChannels, input, inBlockChannels);
+				}
+				std::memset(result, 0, sizeof(result));
+				inEncode(source, block);
+				inDecode(block, result);
+				for (uint32_t pixel = 0; pixel < BlockCompression::BLOCK_PIXELS; pixel++)
+				{
+					uint32_t x = blockX + pixel % BlockCompression::BLOCK_DIMENSION;
+					uint32_t y = blockY + pixel / BlockCompression::BLOCK_DIMENSION;
+					std::memcpy(&decoded[(y * IMAGE_SIZE + x) * CHANNELS_COUNT], result + pixel * inBlockChannels, inBlockChannels);
+				}
+			}
+		}
+		return decoded;
+	}
+
+	double GetPsnr(const std::vector<uint8_t>& inReference, const std::vector<uint8_t>& inPixels, uint32_t inChannelsCount)
+	{
+		double error = 0.0;
+		size_t count = 0;
+		for (size_t index = 0; index < inReference.size(); index += CHANNELS_COUNT)
+		{
+			for (uint32_t channel = 0; channel < inChannelsCount; channel++)
+			{
+				double difference = static_cast<double>(inReference[index + channel]) - inPixels[index + channel];
+				error += difference * difference;
+				count++;
+			}
+		}
+		return error == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / (error / count));
+	}
+}
+
+TEST_CASE(BlockCompressionBC1Psnr)
+{
+	std::vector<uint8_t> albedo = MakeAlbedo();
+	double psnr = GetPsnr(albedo, RoundTrip(albedo, &BlockCompression::EncodeBC1, &BlockCompression::DecodeBC1, CHANNELS_COUNT), 3);
+	CHECK_MESSAGE(psnr >= MIN_BC1_PSNR, psnr << " dB");
+}
+
+TEST_CASE(BlockCompressionBC4Psnr)
+{
+	std::vector<uint8_t> albedo = MakeAlbedo();
+	double psnr = GetPsnr(albedo, RoundTrip(albedo, &BlockCompression::EncodeBC4, &BlockCompression::DecodeBC4, 1), 1);
+	CHECK_MESSAGE(psnr >= MIN_BC4_PSNR, psnr << " dB");
+}
+
+TEST_CASE(BlockCompressionBC5Psnr)
+{
+	std::vector<uint8_t> normals = MakeNormals();
+	double psnr = GetPsnr(normals, RoundTrip(normals, &BlockCompression::EncodeBC5, &BlockCompression::DecodeBC5, CHANNELS_COUNT), 2);
+	CHECK_MESSAGE(psnr >= MIN_BC5_PSNR, psnr << " dB");
+}
+
+TEST_CASE(BlockCompressionBC7Psnr)
+{
+	std::vector<uint8_t> albedo = MakeAlbedo();
+	double psnr = GetPsnr(albedo, RoundTrip(albedo, &BlockCompression::EncodeBC7, &BlockCompression::DecodeBC7, CHANNELS_COUNT), 4);
+	CHECK_MESSAGE(psnr >= MIN_BC7_PSNR, psnr << " dB");
+}
+
+TEST_CASE(BlockCompressionSolidBlocks)
+{
+	// a single color has to survive every format up to endpoint quantization
+	uint8_t rgba[BlockCompression::BLOCK_PIXELS * CHANNELS_COUNT];
+	for (uint32_t pixel = 0; pixel < BlockCompression::BLOCK_PIXELS; pixel++)
+	{
+		rgba[pixel * CHANNELS_COUNT + 0] = 200;
+		rgba[pixel * CHANNELS_COUNT + 1] = 100;
+		rgba[pixel * CHANNELS_COUNT + 2] = 40;
+		rgba[pixel * CHANNELS_COUNT + 3] = 255;
+	}
+	uint8_t block[16];
+	uint8_t decoded[BlockCompression::BLOCK_PIXELS * CHANNELS_COUNT];
+
+	BlockCompression::EncodeBC7(rgba, block);
+	BlockCompression::DecodeBC7(block, decoded);
+	for (uint32_t index = 0; index < BlockCompression::BLOCK_PIXELS * CHANNELS_COUNT; index++)
+	{
+		CHECK(std::abs(static_cast<int>(decoded[index]) - rgba[index]) <= 1);
+	}
+
+	BlockCompression::EncodeBC1(rgba, block);
+	BlockCompression::DecodeBC1(block, decoded);
+	for (uint32_t pixel = 0; pixel < BlockCompression::BLOCK_PIXELS; pixel++)
+	{
+		for (uint32_t channel = 0; channel < 3; channel++)
+		{
+			// 565 endpoints, interpolation gets within a couple of steps of the lost bits
+			CHECK(std::abs(static_cast<int>(decoded[pixel * CHANNELS_COUNT + channel]) - rgba[pixel * CHANNELS_COUNT + channel]) <= 4);
+		}
+	}
+
+	BlockCompression::EncodeBC5(rgba, block);
+	BlockCompression::DecodeBC5(block, decoded);
+	for (uint32_t pixel = 0; pixel < BlockCompression::BLOCK_PIXELS; pixel++)
+	{
+		CHECK(decoded[pixel * CHANNELS_COUNT + 0] == 200);
+		CHECK(decoded[pixel * CHANNELS_COUNT + 1] == 100);
+	}
+}
@@ -0,0 +1,277 @@
+#include "TestFramework.h"
+#include "import/MeshletBuilder.h"
+#include "scene/mesh/MeshletCuller.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace CGE;
+
+namespace
+{
+	static constexpr float BOUNDS_EPSILON = 1e-4f;
+	static constexpr float PI = 3.14159265f;
+
+	struct TestMesh
+	{
+		std::vector<glm::vec3> positions;
+		std::vector<uint32_t> indices;
+		std::vector<Meshlet> meshlets;
+
+		void Build()
+		{
+			meshlets = MeshletBuilder::Build(indices.data(), indices.size(), positions.data(), static_cast<uint32_t>(positions.size()), sizeof(glm::vec3));
+		}
+	};
+
+	// quads on the z = 0 plane, every triangle faces +z
+	TestMesh MakeGrid(uint32_t inQuads, float inSpacing)
+	{
+		TestMesh mesh;
+		for (uint32_t y = 0; y <= inQuads; y++)
+		{
+			for (uint32_t x = 0; x <= inQuads; x++)
+			{
+				mesh.positions.push_back(glm::vec3(x * inSpacing, y * inSpacing, 0.0f));
+			}
+		}
+		for (uint32_t y = 0; y < inQuads; y++)
+		{
+			for (uint32_t x = 0; x < inQuads; x++)
+			{
+				uint32_t v00 = y * (inQuads + 1) + x;
+				uint32_t v10 = v00 + 1;
+				uint32_t v01 = v00 + inQuads + 1;
+				uint32_t v11 = v01 + 1;
+				mesh.indices.insert(mesh.indices.end(), { v00, v10, v11, v00, v11, v01 });
+			}
+		}
+		mesh.Build();
+		return mesh;
+	}
+
+	// outward facing uv sphere, poles are fans
+	TestMesh MakeSphere(uint32_t inSegments, uint32_t inRings, float inRadius)
+	{
+		TestMesh mesh;
+		for (uint32_t ring = 0; ring <= inRings; ring++)
+		{
+			float theta = PI * ring / inRings;
+			for (uint32_t segment = 0; segment < inSegments; segment++)
+			{
+				float phi = 2.0f * PI * segment / inSegments;
+				mesh.positions.push_back(inRadius * glm::vec3(std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta)));
+			}
+		}
+		for (uint32_t ring = 0; ring < inRings; ring++)
+		{
+			for (uint32_t segment = 0; segment < inSegments; segment++)
+			{
+				uint32_t v00 = ring * inSegments + segment;
+				uint32_t v10 = ring * inSegments + (segment + 1) % inSegments;
+				uint32_t v01 = v00 + inSegments;
+				uint32_t v11 = v10 + inSegments;
+				if (ring != 0)
+				{
+					mesh.indices.insert(mesh.indices.end(), { v00, v01, v10 });
+				}
+				if (ring != inRings - 1)
+				{
+					mesh.indices.insert(mesh.indices.end(), { v10, v01, v11 });
+				}
+			}
+		}
+		mesh.Build();
+		return mesh;
+	}
+
+	std::vector<std::array<uint32_t, 3>> GetSortedTriangles(const std::vector<uint32_t>& inIndices)
+	{
+		std::vector<std::array<uint32_t, 3>> triangles;
+		for (size_t index = 0; index < inIndices.size(); index += 3)
+		{
+			triangles.push_back({ inIndices[index], inIndices[index + 1], inIndices[index + 2] });
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	uint32_t CountVisibleIndices(const std::vector<MeshDrawRange>& inRanges)
+	{
+		uint32_t count = 0;
+		for (const MeshDrawRange& range : inRanges)
+		{
+			count += range.indexCount;
+		}
+		return count;
+	}
+
+	glm::mat4 MakeViewProjection(const glm::vec3& inLocation, const glm::vec3& inTarget, float inFov)
+	{
+		glm::mat4 projection = glm::perspective(glm::radians(inFov), 1.0f, 0.1f, 1000.0f);
+		return projection * glm::lookAt(inLocation, inTarget, glm::vec3(0.0f, 1.0f, 0.0f));
+	}
+}
+
+TEST_CASE(MeshletLimits)
+{
+	TestMesh mesh = MakeGrid(64, 1.0f);
+	std::vector<std::array<uint32_t, 3>> sourceTriangles = GetSortedTriangles(mesh.indices);
+	mesh.meshlets = MeshletBuilder::Build(mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), static_cast<uint32_t>(mesh.positions.size()), sizeof(glm::vec3));
+
+	CHECK(!mesh.meshlets.empty());
+	uint32_t nextIndex = 0;
+	for (const Meshlet& meshlet : mesh.meshlets)
+	{
+		CHECK(meshlet.firstIndex == nextIndex);
+		CHECK(meshlet.triangleCount > 0);
+		CHECK(meshlet.triangleCount <= MeshletBuilder::MAX_TRIANGLES);
+		CHECK(meshlet.vertexCount <= MeshletBuilder::MAX_VERTICES);
+
+		std::vector<uint32_t> unique(mesh.indices.begin() + meshlet.firstIndex, mesh.indices.begin() + meshlet.firstIndex + meshlet.triangleCount * 3);
+		std::sort(unique.begin(), unique.end());
+		CHECK(meshlet.vertexCount == static_cast<uint32_t>(std::unique(unique.begin(), unique.end()) - unique.begin()));
+		nextIndex += meshlet.triangleCount * 3;
+	}
+	CHECK(nextIndex == mesh.indices.size());
+	// triangles are only reordered, corner order is kept so the winding doesn't change
+	CHECK(GetSortedTriangles(mesh.indices) == sourceTriangles);
+	// a grid packs well, meshlets half empty on average mean growth got stuck
+	CHECK_MESSAGE(mesh.meshlets.size() * MeshletBuilder::MAX_TRIANGLES / 2 <= mesh.indices.size() / 3, mesh.meshlets.size() << " meshlets");
+
+	std::vector<uint32_t> indices = { 0, 1 };
+	CHECK(MeshletBuilder::Build(indices.data(), indices.size(), mesh.positions.data(), 3, sizeof(glm::vec3)).empty());
+}
+
+TEST_CASE(MeshletBounds)
+{
+	TestMesh mesh = MakeSphere(48, 24, 2.0f);
+	CHECK(!mesh.meshlets.empty());
+	for (const Meshlet& meshlet : mesh.meshlets)
+	{
+		for (uint32_t index = meshlet.firstIndex; index < meshlet.firstIndex + meshlet.triangleCount * 3; index++)
+		{
+			float distance = glm::length(mesh.positions[mesh.indices[index]] - meshlet.center);
+			CHECK_MESSAGE(distance <= meshlet.radius * (1.0f + BOUNDS_EPSILON), distance << " outside of " << meshlet.radius);
+		}
+		CHECK(meshlet.radius <= 2.0f * 2.0f);
+	}
+}
+
+TEST_CASE(MeshletNormalCone)
+{
+	TestMesh sphere = MakeSphere(48, 24, 2.0f);
+	uint32_t conesCount = 0;
+	for (const Meshlet& meshlet : sphere.meshlets)
+	{
+		CHECK(meshlet.coneCutoff >= 0.0f);
+		CHECK(meshlet.coneCutoff <= 1.0f);
+		if (meshlet.coneCutoff >= 1.0f)
+		{
+			continue;
+		}
+		conesCount++;
+		CHECK(std::abs(glm::length(meshlet.coneAxis) - 1.0f) < BOUNDS_EPSILON);
+		float minDot = std::sqrt(1.0f - meshlet.coneCutoff * meshlet.coneCutoff);
+		for (uint32_t index = meshlet.firstIndex; index < meshlet.firstIndex + meshlet.triangleCount * 3; index += 3)
+		{
+			glm::vec3 p0 = sphere.positions[sphere.indices[index + 0]];
+			glm::vec3 p1 = sphere.positions[sphere.indices[index + 1]];
+			glm::vec3 p2 = sphere.positions[sphere.indices[index + 2]];
+			glm::vec3 normal = glm::normalize(glm::cross(p1 - p0, p2 - p0));
+			CHECK_MESSAGE(glm::dot(normal, meshlet.coneAxis) >= minDot - BOUNDS_EPSILON, glm::dot(normal, meshlet.coneAxis) << " below " << minDot);
+		}
+	}
+	// small patches of a sphere are close to flat, most of them should get a cone
+	CHECK_MESSAGE(conesCount * 2 > sphere.meshlets.size(), conesCount << " cones of " << sphere.meshlets.size());
+
+	TestMesh grid = MakeGrid(16, 1.0f);
+	for (const Meshlet& meshlet : grid.meshlets)
+	{
+		CHECK(meshlet.coneCutoff < BOUNDS_EPSILON);
+		CHECK(glm::dot(meshlet.coneAxis, glm::vec3(0.0f, 0.0f, 1.0f)) > 1.0f - BOUNDS_EPSILON);
+	}
+}
+
+TEST_CASE(MeshletConeCulling)
+{
+	TestMesh grid = MakeGrid(16, 1.0f);
+	glm::vec3 center(8.0f, 8.0f, 0.0f);
+	uint32_t allIndices = static_cast<uint32_t>(grid.indices.size());
+
+	// in front of the triangles everything is kept and merged into a single range
+	glm::vec3 front = center + glm::vec3(0.0f, 0.0f, 40.0f);
+	MeshletCuller frontCuller(MakeViewProjection(front, center, 60.0f), front);
+	std::vector<MeshDrawRange> ranges;
+	frontCuller.Cull(grid.meshlets, glm::mat4(1.0f), 3, ranges);
+	CHECK(frontCuller.GetStats().coneCulled == 0);
+	CHECK(frontCuller.GetStats().frustumCulled == 0);
+	CHECK(ranges.size() == 1);
+	CHECK(CountVisibleIndices(ranges) == allIndices);
+	CHECK(!ranges.empty() && ranges[0].instance == 3);
+
+	glm::vec3 back = center - glm::vec3(0.0f, 0.0f, 40.0f);
+	MeshletCuller backCuller(MakeViewProjection(back, center, 60.0f), back);
+	ranges.clear();
+	backCuller.Cull(grid.meshlets, glm::mat4(1.0f), 0, ranges);
+	CHECK(backCuller.GetStats().coneCulled == grid.meshlets.size());
+	CHECK(ranges.empty());
+
+	// mirroring flips the winding, cones can't be trusted and nothing is rejected by them
+	glm::mat4 mirror = glm::translate(glm::mat4(1.0f), glm::vec3(16.0f, 0.0f, 0.0f)) * glm::scale(glm::mat4(1.0f), glm::vec3(-1.0f, 1.0f, 1.0f));
+	MeshletCuller mirrorCuller(MakeViewProjection(back, center, 60.0f), back);
+	ranges.clear();
+	mirrorCuller.Cull(grid.meshlets, mirror, 0, ranges);
+	CHECK(mirrorCuller.GetStats().coneCulled == 0);
+	CHECK(CountVisibleIndices(ranges) == allIndices);
+}
+
+TEST_CASE(MeshletFrustumCulling)
+{
+	TestMesh grid = MakeGrid(64, 1.0f);
+	glm::vec3 center(32.0f, 32.0f, 0.0f);
+	glm::vec3 location = center + glm::vec3(0.0f, 0.0f, 20.0f);
+
+	MeshletCuller awayCuller(MakeViewProjection(location, location + glm::vec3(0.0f, 0.0f, 1.0f), 60.0f), location);
+	std::vector<MeshDrawRange> ranges;
+	awayCuller.Cull(grid.meshlets, glm::mat4(1.0f), 0, ranges);
+	CHECK(awayCuller.GetStats().frustumCulled == grid.meshlets.size());
+	CHECK(ranges.empty());
+
+	// narrow view of the middle of the grid, the test is conservative so anything with its center on screen stays
+	glm::mat4 viewProjection = MakeViewProjection(location, center, 30.0f);
+	MeshletCuller culler(viewProjection, location);
+	ranges.clear();
+	culler.Cull(grid.meshlets, glm::mat4(1.0f), 0, ranges);
+	const MeshletCullStats& stats = culler.GetStats();
+	CHECK(stats.testedMeshlets == grid.meshlets.size());
+	CHECK(stats.frustumCulled > 0);
+	CHECK(stats.GetVisibleMeshlets() > 0);
+	CHECK(stats.drawRanges == ranges.size());
+	for (const Meshlet& meshlet : grid.meshlets)
+	{
+		glm::vec4 clip = viewProjection * glm::vec4(meshlet.center, 1.0f);
+		glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		if ((std::abs(ndc.x) > 1.0f) || (std::abs(ndc.y) > 1.0f))
+		{
+			continue;
+		}
+		bool drawn = std::any_of(ranges.begin(), ranges.end(), [&meshlet](const MeshDrawRange& inRange)
+			{
+				return (meshlet.firstIndex >= inRange.firstIndex) && (meshlet.firstIndex < inRange.firstIndex + inRange.indexCount);
+			});
+		CHECK(drawn);
+	}
+
+	// everything on screen
+	glm::vec3 far = center + glm::vec3(0.0f, 0.0f, 200.0f);
+	MeshletCuller wideCuller(MakeViewProjection(far, center, 60.0f), far);
+	ranges.clear();
+	wideCuller.Cull(grid.meshlets, glm::mat4(1.0f), 0, ranges);
+	CHECK(wideCuller.GetStats().frustumCulled == 0);
+	CHECK(CountVisibleIndices(ranges) == grid.indices.size());
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <cstdint>
+
+namespace CGE
+{
+	// Bare bones test registry. TEST_CASE bodies register themselves before main, a failed CHECK is reported
+	// without stopping the case, so one run shows everything that broke.
+	class TestRegistry
+	{
+	public:
+		typedef void(*TestFunction)();
+
+		static TestRegistry& Get();
+
+		void Add(const char* inName, TestFunction inFunction);
+		void Fail(const char* inFile, int inLine, const std::string& inMessage);
+		// returns the count of failed cases
+		uint32_t RunAll();
+	private:
+		struct TestCase
+		{
+			const char* name;
+			TestFunction function;
+		};
+
+		std::vector<TestCase> m_cases;
+		uint32_t m_caseFailures = 0;
+	};
+
+	struct TestRegistrar
+	{
+		TestRegistrar(const char* inName, TestRegistry::TestFunction inFunction)
+		{
+			TestRegistry::Get().Add(inName, inFunction);
+		}
+	};
+}
+
+#define TEST_CASE(name) \
+	static void name(); \
+	static CGE::TestRegistrar name##Registrar(#name, &name); \
+	static void name()
+
+#define CHECK(condition) \
+	do { if (!(condition)) { CGE::TestRegistry::Get().Fail(__FILE__, __LINE__, #condition); } } while (false)
+
+// message is streamed, e.g. CHECK_MESSAGE(psnr > 30.0, "psnr " << psnr)
+#define CHECK_MESSAGE(condition, message) \
+	do { if (!(condition)) { std::ostringstream stream; stream << #condition << ": " << message; CGE::TestRegistry::Get().Fail(__FILE__, __LINE__, stream.str()); } } while (false)
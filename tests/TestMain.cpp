@@ -0,0 +1,42 @@
+#include "TestFramework.h"
+
+#include <iostream>
+
+namespace CGE
+{
+	TestRegistry& TestRegistry::Get()
+	{
+		static TestRegistry registry;
+		return registry;
+	}
+
+	void TestRegistry::Add(const char* inName, TestFunction inFunction)
+	{
+		m_cases.push_back({ inName, inFunction });
+	}
+
+	void TestRegistry::Fail(const char* inFile, int inLine, const std::string& inMessage)
+	{
+		std::cout << "  " << inFile << "(" << inLine << "): " << inMessage << std::endl;
+		m_caseFailures++;
+	}
+
+	uint32_t TestRegistry::RunAll()
+	{
+		uint32_t failedCases = 0;
+		for (const TestCase& testCase : m_cases)
+		{
+			m_caseFailures = 0;
+			testCase.function();
+			std::cout << (m_caseFailures == 0 ? "[ OK ] " : "[FAIL] ") << testCase.name << std::endl;
+			failedCases += m_caseFailures != 0 ? 1 : 0;
+		}
+		std::cout << m_cases.size() - failedCases << " of " << m_cases.size() << " cases passed" << std::endl;
+		return failedCases;
+	}
+}
+
+int main()
+{
+	return CGE::TestRegistry::Get().RunAll() == 0 ? 0 : 1;
+}
@@ -0,0 +1,187 @@
+#include "TestFramework.h"
+#include "render/TextureResidencyPolicy.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace CGE;
+
+namespace
+{
+	static constexpr uint32_t TEXTURE_SIZE = 2048;
+	static constexpr uint32_t MIP_COUNT = 12;
+	static constexpr uint32_t OBJECTS_COUNT = 16;
+	static constexpr float OBJECT_SPACING = 20.0f;
+	static constexpr float OBJECT_SIZE = 4.0f;
+	// camera flies along the row of objects this far to the side of it
+	static constexpr float PATH_OFFSET = 5.0f;
+	static constexpr float PATH_START = -10.0f;
+	static constexpr float PATH_END = OBJECT_SPACING * (OBJECTS_COUNT - 1);
+	static constexpr float VIEW_DISTANCE = 100.0f;
+	// 1080p with 60 degrees vertical fov
+	static constexpr float PROJECTION_SCALE = 935.3f;
+	// frames spent at the end of the path, longer than the eviction latency
+	static constexpr uint64_t SETTLE_FRAMES = TextureResidencyPolicy::EVICT_LATENCY * 2;
+
+	std::vector<uint64_t> GetMipSizes()
+	{
+		std::vector<uint64_t> sizes;
+		for (uint32_t mip = 0; mip < MIP_COUNT; mip++)
+		{
+			uint64_t size = std::max(TEXTURE_SIZE >> mip, 1u);
+			sizes.push_back(size * size * 4);
+		}
+		return sizes;
+	}
+
+	uint64_t GetFootprint(const std::vector<uint64_t>& inMipSizes, uint32_t inMip)
+	{
+		uint64_t bytes = 0;
+		for (uint32_t mip = inMip; mip < inMipSizes.size(); mip++)
+		{
+			bytes += inMipSizes[mip];
+		}
+		return bytes;
+	}
+
+	float GetDistance(uint32_t inObject, float inCameraX)
+	{
+		return std::hypot(inObject * OBJECT_SPACING - inCameraX, PATH_OFFSET);
+	}
+
+	uint32_t GetRequiredMip(uint32_t inObject, float inCameraX)
+	{
+		return TextureResidencyPolicy::GetRequiredMip(TEXTURE_SIZE, OBJECT_SIZE, GetDistance(inObject, inCameraX), PROJECTION_SCALE);
+	}
+
+	struct PathResult
+	{
+		std::vector<uint64_t> ids;
+		uint32_t tailMip = 0;
+		uint32_t finestResident = MIP_COUNT;
+		float cameraX = PATH_START;
+	};
+
+	// moves the camera a unit per frame and completes every change in the frame it was issued, checking the
+	// budgets along the way
+	PathResult RunCameraPath(TextureResidencyPolicy& inPolicy)
+	{
+		PathResult result;
+		std::vector<uint64_t> mipSizes = GetMipSizes();
+		result.tailMip = TextureResidencyPolicy::GetTailMip(TEXTURE_SIZE, TEXTURE_SIZE, MIP_COUNT);
+		for (uint32_t object = 0; object < OBJECTS_COUNT; object++)
+		{
+			result.ids.push_back(inPolicy.AddTexture(mipSizes, result.tailMip));
+		}
+
+		uint64_t pathFrames = static_cast<uint64_t>(PATH_END - PATH_START);
+		for (uint64_t frame = 1; frame <= pathFrames + SETTLE_FRAMES; frame++)
+		{
+			result.cameraX = std::min(PATH_START + frame, PATH_END);
+			for (uint32_t object = 0; object < OBJECTS_COUNT; object++)
+			{
+				float distance = GetDistance(object, result.cameraX);
+				if (distance < VIEW_DISTANCE)
+				{
+					inPolicy.RequestMip(result.ids[object], GetRequiredMip(object, result.cameraX), OBJECT_SIZE * PROJECTION_SCALE / distance, frame);
+				}
+			}
+
+			uint64_t streamInBytes = 0;
+			uint32_t streamInCount = 0;
+			for (const MipResidencyChange& change : inPolicy.Update(frame))
+			{
+				uint32_t residentMip = inPolicy.GetResidentMip(change.id);
+				CHECK(change.mip != residentMip);
+				CHECK(change.mip <= result.tailMip);
+				CHECK(change.uploadBytes == GetFootprint(mipSizes, change.mip));
+				if (change.mip < residentMip)
+				{
+					// streaming never skips levels
+					CHECK(change.mip + 1 == residentMip);
+					streamInBytes += change.uploadBytes;
+					streamInCount++;
+				}
+				inPolicy.CompleteChange(change.id);
+				CHECK(!inPolicy.IsPending(change.id));
+				result.finestResident = std::min(result.finestResident, inPolicy.GetResidentMip(change.id));
+			}
+			// a single level is let through over the budget so it can't starve
+			CHECK_MESSAGE((inPolicy.GetFrameUploadBudget() == 0) || (streamInCount <= 1) || (streamInBytes <= inPolicy.GetFrameUploadBudget()),
+				"frame " << frame << " uploads " << streamInBytes);
+			CHECK_MESSAGE((inPolicy.GetMemoryBudget() == 0) || (inPolicy.GetResidentBytes() <= inPolicy.GetMemoryBudget()),
+				"frame " << frame << " keeps " << inPolicy.GetResidentBytes());
+		}
+		return result;
+	}
+}
+
+TEST_CASE(TextureResidencyRequiredMip)
+{
+	// a texel per pixel is mip 0, every doubling of the distance is a level down
+	CHECK(TextureResidencyPolicy::GetRequiredMip(1024, 1.0f, 1.0f, 1024.0f) == 0);
+	CHECK(TextureResidencyPolicy::GetRequiredMip(1024, 1.0f, 2.0f, 1024.0f) == 1);
+	CHECK(TextureResidencyPolicy::GetRequiredMip(1024, 1.0f, 3.9f, 1024.0f) == 1);
+	CHECK(TextureResidencyPolicy::GetRequiredMip(1024, 1.0f, 8.0f, 1024.0f) == 3);
+	CHECK(TextureResidencyPolicy::GetRequiredMip(1024, 1.0f, 0.5f, 1024.0f) == 0);
+	CHECK(TextureResidencyPolicy::GetTailMip(2048, 2048, 12) == 4);
+	CHECK(TextureResidencyPolicy::GetTailMip(2048, 512, 12) == 4);
+	CHECK(TextureResidencyPolicy::GetTailMip(64, 64, 7) == 0);
+}
+
+TEST_CASE(TextureResidencyCameraPathUnlimited)
+{
+	TextureResidencyPolicy policy;
+	PathResult result = RunCameraPath(policy);
+
+	CHECK(result.finestResident < result.tailMip);
+	for (uint32_t object = 0; object < OBJECTS_COUNT; object++)
+	{
+		uint32_t residentMip = policy.GetResidentMip(result.ids[object]);
+		if (GetDistance(object, result.cameraX) < VIEW_DISTANCE)
+		{
+			// nothing holds streaming back, every visible texture ends up with exactly what it needs
+			uint32_t requiredMip = std::min(GetRequiredMip(object, result.cameraX), result.tailMip);
+			CHECK_MESSAGE(residentMip == requiredMip, "object " << object << " mip " << residentMip << " required " << requiredMip);
+		}
+		else
+		{
+			// passed long ago, detail went back to the tail
+			CHECK_MESSAGE(residentMip == result.tailMip, "object " << object << " mip " << residentMip);
+		}
+	}
+}
+
+TEST_CASE(TextureResidencyCameraPathBudget)
+{
+	std::vector<uint64_t> mipSizes = GetMipSizes();
+	uint32_t tailMip = TextureResidencyPolicy::GetTailMip(TEXTURE_SIZE, TEXTURE_SIZE, MIP_COUNT);
+	uint64_t tailBytes = GetFootprint(mipSizes, tailMip);
+	// the path ends next to the last object with the one before it in view, the budget is a byte short of
+	// what the two of them need, so detail has to go somewhere
+	uint32_t closest = OBJECTS_COUNT - 1;
+	uint32_t closestMip = std::min(GetRequiredMip(closest, PATH_END), tailMip);
+	uint32_t nextMip = std::min(GetRequiredMip(closest - 1, PATH_END), tailMip);
+	uint64_t memoryBudget = tailBytes * OBJECTS_COUNT + GetFootprint(mipSizes, closestMip) + GetFootprint(mipSizes, nextMip) - tailBytes * 2 - 1;
+	TextureResidencyPolicy policy(memoryBudget, mipSizes[1]);
+	PathResult result = RunCameraPath(policy);
+
+	CHECK(policy.GetResidentBytes() <= memoryBudget);
+	CHECK(result.finestResident < tailMip);
+	CHECK(policy.GetResidentMip(result.ids[0]) == tailMip);
+	bool dropped = false;
+	for (uint32_t object = 0; object < OBJECTS_COUNT; object++)
+	{
+		// budget only ever takes detail away, it never adds more than asked for
+		uint32_t residentMip = policy.GetResidentMip(result.ids[object]);
+		uint32_t requiredMip = std::min(GetRequiredMip(object, result.cameraX), tailMip);
+		CHECK(residentMip >= requiredMip);
+		dropped |= residentMip > requiredMip;
+		// and closer objects never end up with less detail than the ones further away
+		if (object + 1 < OBJECTS_COUNT)
+		{
+			CHECK_MESSAGE(residentMip >= policy.GetResidentMip(result.ids[object + 1]), "object " << object << " mip " << residentMip);
+		}
+	}
+	CHECK(dropped);
+}
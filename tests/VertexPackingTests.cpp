@@ -0,0 +1,132 @@
+#include "TestFramework.h"
+#include "data/VertexPacking.h"
+
+#include <cmath>
+#include <random>
+
+using namespace CGE;
+
+namespace
+{
+	static constexpr uint32_t VERTEX_COUNT = 20000;
+
+	struct VertexGenerator
+	{
+		std::mt19937 random{ 12345 };
+
+		float Uniform(float inMin, float inMax)
+		{
+			return std::uniform_real_distribution<float>(inMin, inMax)(random);
+		}
+
+		glm::vec3 Direction()
+		{
+			glm::vec3 direction;
+			do
+			{
+				direction = glm::vec3(Uniform(-1.0f, 1.0f), Uniform(-1.0f, 1.0f), Uniform(-1.0f, 1.0f));
+			} while ((glm::dot(direction, direction) > 1.0f) || (glm::dot(direction, direction) < 1e-4f));
+			return glm::normalize(direction);
+		}
+
+		// orthonormal frame with either handedness, positions and uvs in the given ranges
+		UnpackedVertex Vertex(const glm::vec3& inMin, const glm::vec3& inMax, float inTexCoordRange)
+		{
+			UnpackedVertex vertex;
+			vertex.position = glm::vec3(Uniform(inMin.x, inMax.x), Uniform(inMin.y, inMax.y), Uniform(inMin.z, inMax.z));
+			vertex.normal = Direction();
+			vertex.tangent = glm::normalize(glm::cross(vertex.normal, Direction()));
+			vertex.bitangent = glm::cross(vertex.normal, vertex.tangent) * (Uniform(-1.0f, 1.0f) < 0.0f ? -1.0f : 1.0f);
+			vertex.texCoord = glm::vec2(Uniform(-inTexCoordRange, inTexCoordRange), Uniform(-inTexCoordRange, inTexCoordRange));
+			return vertex;
+		}
+	};
+
+	float GetAngle(const glm::vec3& inFirst, const glm::vec3& inSecond)
+	{
+		return std::atan2(glm::length(glm::cross(inFirst, inSecond)), glm::dot(inFirst, inSecond));
+	}
+}
+
+TEST_CASE(VertexPackingErrorBounds)
+{
+	glm::vec3 boundsMin(-37.0f, 0.5f, -2.0f);
+	glm::vec3 boundsMax(12.0f, 250.0f, 2.0f);
+	VertexQuantization quantization = VertexQuantization::FromBounds(boundsMin, boundsMax);
+	VertexGenerator generator;
+
+	// round trip error is measured here on its own rather than trusting MeasureError
+	VertexPackingError worst;
+	for (uint32_t index = 0; index < VERTEX_COUNT; index++)
+	{
+		UnpackedVertex vertex = generator.Vertex(boundsMin, boundsMax, 8.0f);
+		UnpackedVertex unpacked = VertexPacking::Unpack(VertexPacking::Pack(vertex, quantization), quantization);
+
+		glm::vec3 positionError = glm::abs(unpacked.position - vertex.position) / quantization.extent;
+		worst.position = std::max(worst.position, std::max(positionError.x, std::max(positionError.y, positionError.z)));
+		worst.normal = std::max(worst.normal, GetAngle(vertex.normal, unpacked.normal));
+		worst.tangent = std::max(worst.tangent, GetAngle(vertex.tangent, unpacked.tangent));
+		glm::vec2 texCoordError = glm::abs(unpacked.texCoord - vertex.texCoord) / glm::max(glm::abs(vertex.texCoord), glm::vec2(1.0f));
+		worst.texCoord = std::max(worst.texCoord, std::max(texCoordError.x, texCoordError.y));
+		worst.bitangentFlips += glm::dot(vertex.bitangent, unpacked.bitangent) < 0.0f ? 1 : 0;
+
+		CHECK(VertexPacking::MeasureError(vertex, quantization).IsWithinBounds());
+	}
+	CHECK_MESSAGE(worst.position <= VertexPacking::POSITION_ERROR_BOUND, worst.position);
+	CHECK_MESSAGE(worst.normal <= VertexPacking::DIRECTION_ERROR_BOUND, worst.normal);
+	CHECK_MESSAGE(worst.tangent <= VertexPacking::DIRECTION_ERROR_BOUND, worst.tangent);
+	CHECK_MESSAGE(worst.texCoord <= VertexPacking::TEXCOORD_ERROR_BOUND, worst.texCoord);
+	CHECK(worst.bitangentFlips == 0);
+	CHECK(worst.IsWithinBounds());
+}
+
+TEST_CASE(VertexPackingBoundsCorners)
+{
+	glm::vec3 boundsMin(-1.0f, -2.0f, -3.0f);
+	glm::vec3 boundsMax(4.0f, 5.0f, 6.0f);
+	VertexQuantization quantization = VertexQuantization::FromBounds(boundsMin, boundsMax);
+	for (uint32_t corner = 0; corner < 8; corner++)
+	{
+		UnpackedVertex vertex;
+		vertex.position = glm::vec3((corner & 1) ? boundsMax.x : boundsMin.x, (corner & 2) ? boundsMax.y : boundsMin.y, (corner & 4) ? boundsMax.z : boundsMin.z);
+		vertex.normal = glm::vec3(0.0f, 0.0f, (corner & 1) ? 1.0f : -1.0f);
+		vertex.tangent = glm::vec3(1.0f, 0.0f, 0.0f);
+		vertex.bitangent = glm::cross(vertex.normal, vertex.tangent);
+		vertex.texCoord = glm::vec2(0.0f, 1.0f);
+		CHECK_MESSAGE(VertexPacking::MeasureError(vertex, quantization).IsWithinBounds(), "corner " << corner);
+	}
+
+	// flat meshes still get a valid quantization along the collapsed axis
+	VertexQuantization flat = VertexQuantization::FromBounds(glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f));
+	UnpackedVertex vertex{ glm::vec3(0.5f, 1.0f, 0.25f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(0.5f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f) };
+	UnpackedVertex unpacked = VertexPacking::Unpack(VertexPacking::Pack(vertex, flat), flat);
+	CHECK(std::abs(unpacked.position.y - 1.0f) < 1e-5f);
+}
+
+TEST_CASE(VertexPackingOctahedral)
+{
+	const glm::vec3 axes[] = {
+		glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f)
+	};
+	for (const glm::vec3& axis : axes)
+	{
+		glm::vec2 encoded = VertexPacking::OctahedralEncode(axis);
+		CHECK((std::abs(encoded.x) <= 1.0f) && (std::abs(encoded.y) <= 1.0f));
+		CHECK(GetAngle(VertexPacking::OctahedralDecode(encoded), axis) < 1e-6f);
+	}
+}
+
+TEST_CASE(VertexPackingOutOfBounds)
+{
+	// half floats top out at 65504, such uvs have to be reported
+	VertexQuantization quantization = VertexQuantization::FromBounds(glm::vec3(-1.0f), glm::vec3(1.0f));
+	UnpackedVertex vertex{ glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(70000.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) };
+	CHECK(!VertexPacking::MeasureError(vertex, quantization).IsWithinBounds());
+
+	// position outside the quantization bounds gets clamped
+	vertex.texCoord = glm::vec2(0.0f);
+	vertex.position = glm::vec3(3.0f, 0.0f, 0.0f);
+	CHECK(!VertexPacking::MeasureError(vertex, quantization).IsWithinBounds());
+}